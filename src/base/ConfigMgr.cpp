@@ -81,6 +81,10 @@ ConfigMgr::ConfigMgr()
     addOption("scr", "vsyncmode", "auto");
     addOption("scr", "videoaccel", "true");
     addOption("scr", "imgcachesize", "-1,-1");
+    addOption("scr", "imgdiskcachedir", "");
+    addOption("scr", "imgdiskcachesize", "512");
+    addOption("scr", "texuploadbudget", "0");
+    addOption("scr", "readbackbuffers", "2");
     
     addSubsys("aud");
     addOption("aud", "channels", "2");
@@ -103,6 +107,14 @@ ConfigMgr::ConfigMgr()
     addOption("touch", "area", "0, 0");
     addOption("touch", "offset", "0, 0");
 
+    addSubsys("video");
+    addOption("video", "framepool", "false");
+    addOption("video", "decoderthreads", "1");
+    addOption("video", "sharetolerance", "100");
+
+    addSubsys("threads");
+    addOption("threads", "numworkers", "0");
+
     m_sFName = "avgrc";
     loadFile(getGlobalConfigDir()+m_sFName);
     char * pHome = getenv("HOME");
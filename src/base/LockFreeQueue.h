@@ -0,0 +1,324 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _LockFreeQueue_H_
+#define _LockFreeQueue_H_
+
+#include "../api.h"
+#include "Exception.h"
+
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace avg {
+
+// Bounded ring buffer with the same interface as Queue. Push and pop don't take locks;
+// the mutex is only used to put threads to sleep in blocking calls when the queue is
+// empty or full.
+// In SPSC mode, exactly one thread may push and exactly one thread may pop or peek.
+// MPMC mode allows any number of pushing and popping threads, but peek() is not
+// supported.
+// maxSize is rounded up to the next power of two.
+template<class QElement>
+class AVG_TEMPLATE_API LockFreeQueue
+{
+public:
+    typedef boost::shared_ptr<QElement> QElementPtr;
+    enum Mode {SPSC, MPMC};
+
+    LockFreeQueue(int maxSize, Mode mode=SPSC);
+    virtual ~LockFreeQueue();
+
+    bool empty() const;
+    QElementPtr pop(bool bBlock = true);
+    void clear();
+    void push(const QElementPtr& pElem);
+    QElementPtr peek(bool bBlock = true) const;
+    int size() const;
+    int getMaxSize() const;
+    Mode getMode() const;
+
+private:
+    struct Slot {
+        boost::atomic<unsigned> m_Seq;
+        QElementPtr m_pElem;
+    };
+
+    bool tryPush(const QElementPtr& pElem);
+    bool tryPop(QElementPtr& pElem);
+    bool isFull() const;
+    void wait(bool bWaitForSpace, int& numSpins) const;
+    void notify() const;
+
+    Slot* m_pSlots;
+    unsigned m_Mask;
+    Mode m_Mode;
+
+    // Producer and consumer indexes live on separate cache lines so the two sides
+    // don't invalidate each other's caches on every operation.
+    char m_Pad0[64];
+    boost::atomic<unsigned> m_Tail;
+    char m_Pad1[64];
+    boost::atomic<unsigned> m_Head;
+    char m_Pad2[64];
+
+    mutable boost::atomic<int> m_NumWaiters;
+    mutable boost::mutex m_Mutex;
+    mutable boost::condition m_Cond;
+};
+
+template<class QElement>
+LockFreeQueue<QElement>::LockFreeQueue(int maxSize, Mode mode)
+    : m_Mode(mode),
+      m_Tail(0),
+      m_Head(0),
+      m_NumWaiters(0)
+{
+    AVG_ASSERT(maxSize > 0);
+    unsigned capacity = 1;
+    while (capacity < unsigned(maxSize)) {
+        capacity <<= 1;
+    }
+    m_Mask = capacity-1;
+    m_pSlots = new Slot[capacity];
+    for (unsigned i=0; i<capacity; ++i) {
+        m_pSlots[i].m_Seq.store(i, boost::memory_order_relaxed);
+    }
+}
+
+template<class QElement>
+LockFreeQueue<QElement>::~LockFreeQueue()
+{
+    delete[] m_pSlots;
+}
+
+template<class QElement>
+bool LockFreeQueue<QElement>::empty() const
+{
+    return size() == 0;
+}
+
+template<class QElement>
+typename LockFreeQueue<QElement>::QElementPtr LockFreeQueue<QElement>::pop(bool bBlock)
+{
+    QElementPtr pElem;
+    int numSpins = 0;
+    while (!tryPop(pElem)) {
+        if (!bBlock) {
+            return QElementPtr();
+        }
+        wait(false, numSpins);
+    }
+    notify();
+    return pElem;
+}
+
+template<class QElement>
+void LockFreeQueue<QElement>::clear()
+{
+    QElementPtr pElem;
+    do {
+        pElem = pop(false);
+    } while (pElem);
+}
+
+template<class QElement>
+typename LockFreeQueue<QElement>::QElementPtr LockFreeQueue<QElement>::peek(bool bBlock)
+        const
+{
+    AVG_ASSERT(m_Mode == SPSC);
+    int numSpins = 0;
+    while (empty()) {
+        if (!bBlock) {
+            return QElementPtr();
+        }
+        wait(false, numSpins);
+    }
+    unsigned head = m_Head.load(boost::memory_order_relaxed);
+    return m_pSlots[head & m_Mask].m_pElem;
+}
+
+template<class QElement>
+void LockFreeQueue<QElement>::push(const QElementPtr& pElem)
+{
+    assert(pElem);
+    int numSpins = 0;
+    while (!tryPush(pElem)) {
+        wait(true, numSpins);
+    }
+    notify();
+}
+
+template<class QElement>
+int LockFreeQueue<QElement>::size() const
+{
+    // Approximate if other threads are modifying the queue concurrently.
+    unsigned head = m_Head.load(boost::memory_order_acquire);
+    unsigned tail = m_Tail.load(boost::memory_order_acquire);
+    int size = int(tail-head);
+    if (size < 0) {
+        return 0;
+    }
+    if (size > getMaxSize()) {
+        return getMaxSize();
+    }
+    return size;
+}
+
+template<class QElement>
+int LockFreeQueue<QElement>::getMaxSize() const
+{
+    return int(m_Mask+1);
+}
+
+template<class QElement>
+typename LockFreeQueue<QElement>::Mode LockFreeQueue<QElement>::getMode() const
+{
+    return m_Mode;
+}
+
+template<class QElement>
+bool LockFreeQueue<QElement>::tryPush(const QElementPtr& pElem)
+{
+    if (m_Mode == SPSC) {
+        unsigned tail = m_Tail.load(boost::memory_order_relaxed);
+        unsigned head = m_Head.load(boost::memory_order_acquire);
+        if (tail-head > m_Mask) {
+            return false;
+        }
+        m_pSlots[tail & m_Mask].m_pElem = pElem;
+        m_Tail.store(tail+1, boost::memory_order_release);
+        return true;
+    } else {
+        // Each slot carries a sequence number that tells producers and consumers
+        // whose turn it is (see Dmitry Vyukov's bounded MPMC queue).
+        unsigned pos = m_Tail.load(boost::memory_order_relaxed);
+        Slot* pSlot;
+        while (true) {
+            pSlot = &m_pSlots[pos & m_Mask];
+            unsigned seq = pSlot->m_Seq.load(boost::memory_order_acquire);
+            int diff = int(seq-pos);
+            if (diff == 0) {
+                if (m_Tail.compare_exchange_weak(pos, pos+1,
+                        boost::memory_order_relaxed))
+                {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_Tail.load(boost::memory_order_relaxed);
+            }
+        }
+        pSlot->m_pElem = pElem;
+        pSlot->m_Seq.store(pos+1, boost::memory_order_release);
+        return true;
+    }
+}
+
+template<class QElement>
+bool LockFreeQueue<QElement>::tryPop(QElementPtr& pElem)
+{
+    if (m_Mode == SPSC) {
+        unsigned head = m_Head.load(boost::memory_order_relaxed);
+        unsigned tail = m_Tail.load(boost::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+        Slot& slot = m_pSlots[head & m_Mask];
+        pElem = slot.m_pElem;
+        slot.m_pElem.reset();
+        m_Head.store(head+1, boost::memory_order_release);
+        return true;
+    } else {
+        unsigned pos = m_Head.load(boost::memory_order_relaxed);
+        Slot* pSlot;
+        while (true) {
+            pSlot = &m_pSlots[pos & m_Mask];
+            unsigned seq = pSlot->m_Seq.load(boost::memory_order_acquire);
+            int diff = int(seq-(pos+1));
+            if (diff == 0) {
+                if (m_Head.compare_exchange_weak(pos, pos+1,
+                        boost::memory_order_relaxed))
+                {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_Head.load(boost::memory_order_relaxed);
+            }
+        }
+        pElem = pSlot->m_pElem;
+        pSlot->m_pElem.reset();
+        pSlot->m_Seq.store(pos+m_Mask+1, boost::memory_order_release);
+        return true;
+    }
+}
+
+template<class QElement>
+bool LockFreeQueue<QElement>::isFull() const
+{
+    return size() == getMaxSize();
+}
+
+template<class QElement>
+void LockFreeQueue<QElement>::wait(bool bWaitForSpace, int& numSpins) const
+{
+    // The other side usually catches up within a few timeslices, so yield for a while
+    // before going to sleep.
+    if (numSpins < 16) {
+        numSpins++;
+        boost::this_thread::yield();
+        return;
+    }
+    // Registering as waiter and re-checking the queue state under the lock pairs with
+    // the fence in notify(), so a concurrent push or pop can't be missed.
+    boost::unique_lock<boost::mutex> lock(m_Mutex);
+    m_NumWaiters.fetch_add(1, boost::memory_order_seq_cst);
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+    if (bWaitForSpace) {
+        if (isFull()) {
+            m_Cond.wait(lock);
+        }
+    } else {
+        if (empty()) {
+            m_Cond.wait(lock);
+        }
+    }
+    m_NumWaiters.fetch_sub(1, boost::memory_order_relaxed);
+}
+
+template<class QElement>
+void LockFreeQueue<QElement>::notify() const
+{
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+    if (m_NumWaiters.load(boost::memory_order_relaxed) > 0) {
+        boost::unique_lock<boost::mutex> lock(m_Mutex);
+        m_Cond.notify_all();
+    }
+}
+
+}
+#endif
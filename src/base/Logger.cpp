@@ -23,8 +23,10 @@
 #include "Exception.h"
 #include "StandardLogSink.h"
 #include "OSHelper.h"
+#include "TimeSource.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 
 #ifdef _WIN32
 #include <Winsock2.h>
@@ -63,25 +65,105 @@ namespace avg {
     const category_t Logger::category::VIDEO = UTF8String("VIDEO");
 
 namespace {
-    Logger* s_pLogger = 0;
+    boost::atomic<Logger*> s_pLogger(0);
     boost::mutex s_logMutex;
     boost::mutex s_traceMutex;
     boost::mutex s_sinkMutex;
     boost::mutex s_removeStdSinkMutex;
+    boost::mutex s_asyncMutex;
 }
 
 boost::mutex Logger::m_CategoryMutex;
 
+// Size of the per-thread ring buffers in async mode. Must be a power of two.
+#define LOG_RING_SIZE 1024
+
+struct Logger::LogRecord
+{
+    tm m_Time;
+    unsigned m_Millis;
+    category_t m_Category;
+    severity_t m_Severity;
+    UTF8String m_sMsg;
+};
+
+// Single producer, single consumer ring of records. Records are reused, so the strings
+// in them keep their buffers and logging doesn't allocate once the ring is warm.
+class Logger::LogRecordRing
+{
+public:
+    LogRecordRing()
+        : m_Records(LOG_RING_SIZE),
+          m_Head(0),
+          m_Tail(0)
+    {
+    }
+
+    // Producer side: Returns 0 if the ring is full.
+    LogRecord* getFreeRecord()
+    {
+        unsigned tail = m_Tail.load(boost::memory_order_relaxed);
+        if (tail-m_Head.load(boost::memory_order_acquire) == LOG_RING_SIZE) {
+            return 0;
+        }
+        return &m_Records[tail % LOG_RING_SIZE];
+    }
+
+    void push()
+    {
+        // seq_cst so the sink thread either sees the record or is seen waiting.
+        m_Tail.store(m_Tail.load(boost::memory_order_relaxed)+1);
+    }
+
+    // Consumer side: Returns 0 if the ring is empty.
+    LogRecord* front()
+    {
+        unsigned head = m_Head.load(boost::memory_order_relaxed);
+        if (head == m_Tail.load(boost::memory_order_acquire)) {
+            return 0;
+        }
+        return &m_Records[head % LOG_RING_SIZE];
+    }
+
+    void pop()
+    {
+        m_Head.store(m_Head.load(boost::memory_order_relaxed)+1,
+                boost::memory_order_release);
+    }
+
+    bool empty() const
+    {
+        return m_Head.load(boost::memory_order_acquire) == m_Tail.load();
+    }
+
+private:
+    std::vector<LogRecord> m_Records;
+    boost::atomic<unsigned> m_Head;
+    boost::atomic<unsigned> m_Tail;
+};
+
 Logger * Logger::get()
 {
-    lock_guard lock(s_logMutex);
-    if (!s_pLogger) {
-        s_pLogger = new Logger;
+    Logger* pLogger = s_pLogger.load(boost::memory_order_acquire);
+    if (!pLogger) {
+        lock_guard lock(s_logMutex);
+        pLogger = s_pLogger.load(boost::memory_order_relaxed);
+        if (!pLogger) {
+            pLogger = new Logger;
+            s_pLogger.store(pLogger, boost::memory_order_release);
+        }
     }
-    return s_pLogger;
+    return pLogger;
 }
 
 Logger::Logger()
+    : m_pCategoryIDs(new CategoryIDMap),
+      m_bAsync(false),
+      m_NumDroppedMessages(0),
+      m_NumReportedDrops(0),
+      m_pSinkThread(0),
+      m_bStopSinkThread(false),
+      m_bSinkWaiting(false)
 {
     m_Severity = severity::WARNING;
     string sEnvSeverity;
@@ -120,10 +202,18 @@ Logger::Logger()
         m_pStdSink = LogSinkPtr(new StandardLogSink);
         addLogSink(m_pStdSink);
     }
+    if (getEnv("AVG_LOG_ASYNC", sDummy)) {
+        setAsync(true);
+    }
 }
 
 Logger::~Logger()
 {
+    setAsync(false);
+    delete m_pCategoryIDs.load();
+    for (unsigned i = 0; i < m_pOldCategoryIDs.size(); ++i) {
+        delete m_pOldCategoryIDs[i];
+    }
 }
 
 void Logger::addLogSink(const LogSinkPtr& logSink)
@@ -151,47 +241,113 @@ void Logger::removeStdLogSink()
     }
 }
 
+void Logger::addStdLogSink()
+{
+    lock_guard lock(s_removeStdSinkMutex);
+    if (!m_pStdSink) {
+        m_pStdSink = LogSinkPtr(new StandardLogSink);
+        addLogSink(m_pStdSink);
+    }
+}
+
 category_t Logger::configureCategory(category_t category, severity_t severity)
 {
     lock_guard lock(m_CategoryMutex);
     severity = (severity == Logger::severity::NONE) ? m_Severity : severity;
     UTF8String sCategory = boost::to_upper_copy(string(category));
-    CatToSeverityMap::iterator it;
-    it = m_CategorySeverities.find(sCategory);
-    if ( it != m_CategorySeverities.end()) {
-        m_CategorySeverities.erase(sCategory);
+    const CategoryIDMap* pIDs = m_pCategoryIDs.load(boost::memory_order_relaxed);
+    CategoryIDMap::const_iterator it = pIDs->find(sCategory);
+    int id;
+    if (it == pIDs->end()) {
+        id = int(m_CategoryNames.size());
+        if (id >= MAX_CATEGORIES) {
+            throw Exception(AVG_ERR_INVALID_ARGS, "Too many log categories.");
+        }
+        m_CategoryNames.push_back(sCategory);
+        m_CategorySeverities[id].store(severity, boost::memory_order_relaxed);
+        CategoryIDMap* pNewIDs = new CategoryIDMap(*pIDs);
+        (*pNewIDs)[sCategory] = id;
+        m_pOldCategoryIDs.push_back(const_cast<CategoryIDMap*>(pIDs));
+        m_pCategoryIDs.store(pNewIDs, boost::memory_order_release);
+    } else {
+        id = it->second;
+        m_CategorySeverities[id].store(severity, boost::memory_order_relaxed);
     }
-    pair<const category_t, const severity_t> element(sCategory, severity);
-    m_CategorySeverities.insert(element);
     return sCategory;
 }
 
 CatToSeverityMap Logger::getCategories()
 {
-    return m_CategorySeverities;
+    lock_guard lock(m_CategoryMutex);
+    CatToSeverityMap categories;
+    for (unsigned i = 0; i < m_CategoryNames.size(); ++i) {
+        categories.insert(pair<const category_t, const severity_t>(m_CategoryNames[i],
+                m_CategorySeverities[i].load(boost::memory_order_relaxed)));
+    }
+    return categories;
+}
+
+int Logger::getCategoryID(const category_t& category) const
+{
+    const CategoryIDMap* pIDs = m_pCategoryIDs.load(boost::memory_order_acquire);
+    CategoryIDMap::const_iterator it = pIDs->find(category);
+    if (it == pIDs->end()) {
+        string msg("Unknown category: " + category);
+        throw Exception(AVG_ERR_INVALID_ARGS, msg);
+    }
+    return it->second;
+}
+
+void Logger::setAsync(bool bAsync)
+{
+    lock_guard lock(s_asyncMutex);
+    if (bAsync == m_bAsync) {
+        return;
+    }
+    if (bAsync) {
+        m_bStopSinkThread = false;
+        m_bAsync = true;
+        m_pSinkThread = new boost::thread(boost::bind(&Logger::runAsyncSink, this));
+    } else {
+        m_bAsync = false;
+        {
+            lock_guard sinkLock(m_SinkMutex);
+            m_bStopSinkThread = true;
+            m_SinkCond.notify_one();
+        }
+        m_pSinkThread->join();
+        delete m_pSinkThread;
+        m_pSinkThread = 0;
+        flush();
+    }
+}
+
+bool Logger::isAsync() const
+{
+    return m_bAsync;
+}
+
+void Logger::flush()
+{
+    while (drainRecords()) {}
+}
+
+unsigned Logger::getNumDroppedMessages() const
+{
+    return m_NumDroppedMessages;
 }
 
 void Logger::trace(const UTF8String& sMsg, const category_t& category,
         severity_t severity) const
 {
-    lock_guard lock(s_traceMutex);
-    struct tm* pTime;
-    #ifdef _WIN32
-    __int64 now;
-    _time64(&now);
-    pTime = _localtime64(&now);
-    DWORD tms = timeGetTime();
-    unsigned millis = unsigned(tms % 1000);
-    #else
-    struct timeval time;
-    gettimeofday(&time, NULL);
-    pTime = localtime(&time.tv_sec);
-    unsigned millis = time.tv_usec/1000;
-    #endif
-    lock_guard lockHandler(s_sinkMutex);
-    std::vector<LogSinkPtr>::const_iterator it;
-    for(it=m_pSinks.begin(); it!=m_pSinks.end(); ++it){
-        (*it)->logMessage(pTime, millis, category, severity, sMsg);
+    if (m_bAsync.load(boost::memory_order_relaxed)) {
+        pushRecord(sMsg, category, severity);
+    } else {
+        lock_guard lock(s_traceMutex);
+        tm time;
+        unsigned millis;
+        getLocalTime(time, millis);
+        passToSinks(&time, millis, category, severity, sMsg);
     }
 }
 
@@ -228,6 +384,130 @@ void Logger::log(const UTF8String& msg, const category_t& category,
     }
 }
 
+void Logger::getLocalTime(tm& time, unsigned& millis)
+{
+    #ifdef _WIN32
+    __int64 now;
+    _time64(&now);
+    _localtime64_s(&time, &now);
+    DWORD tms = timeGetTime();
+    millis = unsigned(tms % 1000);
+    #else
+    struct timeval curTime;
+    gettimeofday(&curTime, NULL);
+    localtime_r(&curTime.tv_sec, &time);
+    millis = curTime.tv_usec/1000;
+    #endif
+}
+
+void Logger::passToSinks(const tm* pTime, unsigned millis, const category_t& category,
+        severity_t severity, const UTF8String& sMsg) const
+{
+    lock_guard lockHandler(s_sinkMutex);
+    std::vector<LogSinkPtr>::const_iterator it;
+    for(it=m_pSinks.begin(); it!=m_pSinks.end(); ++it){
+        (*it)->logMessage(pTime, millis, category, severity, sMsg);
+    }
+}
+
+void Logger::pushRecord(const UTF8String& sMsg, const category_t& category,
+        severity_t severity) const
+{
+    LogRecordRingPtr* ppRing = m_pThreadRing.get();
+    if (!ppRing) {
+        // First message from this thread.
+        ppRing = new LogRecordRingPtr(new LogRecordRing);
+        m_pThreadRing.reset(ppRing);
+        lock_guard lock(m_RingsMutex);
+        m_pRings.push_back(*ppRing);
+    }
+    LogRecordRing& ring = **ppRing;
+    LogRecord* pRecord = ring.getFreeRecord();
+    if (!pRecord) {
+        m_NumDroppedMessages++;
+        return;
+    }
+    getLocalTime(pRecord->m_Time, pRecord->m_Millis);
+    pRecord->m_Category = category;
+    pRecord->m_Severity = severity;
+    pRecord->m_sMsg = sMsg;
+    ring.push();
+    if (m_bSinkWaiting.load()) {
+        lock_guard lock(m_SinkMutex);
+        m_SinkCond.notify_one();
+    }
+}
+
+void Logger::runAsyncSink()
+{
+    while (!m_bStopSinkThread) {
+        if (!drainRecords()) {
+            boost::mutex::scoped_lock lock(m_SinkMutex);
+            m_bSinkWaiting.store(true);
+            // Producers that pushed before m_bSinkWaiting was set didn't notify.
+            if (!m_bStopSinkThread && !hasRecords()) {
+                m_SinkCond.wait(lock);
+            }
+            m_bSinkWaiting.store(false);
+        }
+    }
+}
+
+bool Logger::drainRecords()
+{
+    lock_guard lock(m_DrainMutex);
+    vector<LogRecordRingPtr> pRings;
+    {
+        lock_guard ringsLock(m_RingsMutex);
+        pRings = m_pRings;
+    }
+    bool bDrained = false;
+    for (unsigned i = 0; i < pRings.size(); ++i) {
+        LogRecord* pRecord;
+        while ((pRecord = pRings[i]->front())) {
+            passToSinks(&pRecord->m_Time, pRecord->m_Millis, pRecord->m_Category,
+                    pRecord->m_Severity, pRecord->m_sMsg);
+            pRings[i]->pop();
+            bDrained = true;
+        }
+    }
+    {
+        // Forget the rings of threads that have ended.
+        lock_guard ringsLock(m_RingsMutex);
+        pRings.clear();
+        for (unsigned i = 0; i < m_pRings.size(); ) {
+            if (m_pRings[i].use_count() == 1 && m_pRings[i]->empty()) {
+                m_pRings.erase(m_pRings.begin()+i);
+            } else {
+                ++i;
+            }
+        }
+    }
+    unsigned numDropped = m_NumDroppedMessages;
+    if (numDropped != m_NumReportedDrops) {
+        stringstream ss;
+        ss << numDropped-m_NumReportedDrops << 
+                " log messages dropped because the log buffer was full.";
+        m_NumReportedDrops = numDropped;
+        tm time;
+        unsigned millis;
+        getLocalTime(time, millis);
+        passToSinks(&time, millis, category::NONE, severity::WARNING, ss.str());
+    }
+    return bDrained;
+}
+
+bool Logger::hasRecords() const
+{
+    lock_guard lock(m_RingsMutex);
+    for (unsigned i = 0; i < m_pRings.size(); ++i) {
+        if (!m_pRings[i]->empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void Logger::setupCategory()
 {
     configureCategory(category::NONE);
@@ -29,6 +29,9 @@
 #include "../api.h"
 
 #include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/thread/condition.hpp>
 #include <boost/functional/hash.hpp>
 #include <boost/unordered_map.hpp>
 
@@ -85,10 +88,22 @@ public:
     void addLogSink(const LogSinkPtr& logSink);
     void removeLogSink(const LogSinkPtr& logSink);
     void removeStdLogSink();
+    void addStdLogSink();
 
     category_t configureCategory(category_t category,
             severity_t severity=severity::NONE);
     CatToSeverityMap getCategories();
+    int getCategoryID(const category_t& category) const;
+
+    // In async mode, trace() only copies the message into a per-thread ring buffer of
+    // preallocated records. A background thread passes the messages to the sinks.
+    // Messages are dropped if a ring buffer is full. Can also be enabled by setting
+    // AVG_LOG_ASYNC.
+    void setAsync(bool bAsync);
+    bool isAsync() const;
+    // Passes all buffered messages to the sinks.
+    void flush();
+    unsigned getNumDroppedMessages() const;
 
     void trace(const UTF8String& sMsg, const category_t& category,
             severity_t severity) const;
@@ -105,29 +120,76 @@ public:
     void log(const UTF8String& msg, const category_t& category=category::APP,
             severity_t severity=severity::INFO) const;
 
+    // Neither version takes a lock.
     inline bool shouldLog(const category_t& category, severity_t severity) const {
-        lock_guard lock(m_CategoryMutex);
-        try {
-            severity_t targetSeverity = m_CategorySeverities.at(category);
-            return (targetSeverity <= severity);
-        } catch (out_of_range e){
-            string msg("Unknown category: " + category);
-            throw Exception(AVG_ERR_INVALID_ARGS, msg);
-        }
+        return shouldLog(getCategoryID(category), severity);
+    }
+
+    inline bool shouldLog(int categoryID, severity_t severity) const {
+        return m_CategorySeverities[categoryID].load(boost::memory_order_relaxed) <= 
+                severity;
     }
 
 private:
     Logger();
     void setupCategory();
 
+    struct LogRecord;
+    class LogRecordRing;
+    typedef boost::shared_ptr<LogRecordRing> LogRecordRingPtr;
+    typedef boost::unordered_map<category_t, int> CategoryIDMap;
+
+    static void getLocalTime(tm& time, unsigned& millis);
+    void passToSinks(const tm* pTime, unsigned millis, const category_t& category,
+            severity_t severity, const UTF8String& sMsg) const;
+    void pushRecord(const UTF8String& sMsg, const category_t& category,
+            severity_t severity) const;
+    void runAsyncSink();
+    bool drainRecords();
+    bool hasRecords() const;
+
     std::vector<LogSinkPtr> m_pSinks;
     LogSinkPtr m_pStdSink;
-    CatToSeverityMap m_CategorySeverities;
     severity_t m_Severity;
     static boost::mutex m_CategoryMutex;
+
+    // Category lookups read an immutable snapshot of the name to id map and an array
+    // of severities indexed by id. configureCategory() publishes a new snapshot; old
+    // ones are kept alive because other threads may still be reading them.
+    static const int MAX_CATEGORIES = 256;
+    boost::atomic<const CategoryIDMap*> m_pCategoryIDs;
+    std::vector<CategoryIDMap*> m_pOldCategoryIDs;
+    std::vector<category_t> m_CategoryNames;
+    boost::atomic<severity_t> m_CategorySeverities[MAX_CATEGORIES];
+
+    boost::atomic<bool> m_bAsync;
+    mutable boost::thread_specific_ptr<LogRecordRingPtr> m_pThreadRing;
+    mutable std::vector<LogRecordRingPtr> m_pRings;
+    mutable boost::mutex m_RingsMutex;
+    mutable boost::atomic<unsigned> m_NumDroppedMessages;
+    unsigned m_NumReportedDrops;
+    boost::mutex m_DrainMutex;
+    boost::thread* m_pSinkThread;
+    boost::atomic<bool> m_bStopSinkThread;
+    // The sink thread sleeps on m_SinkCond when there is nothing to do. Producers
+    // only take the mutex if m_bSinkWaiting is set.
+    mutable boost::atomic<bool> m_bSinkWaiting;
+    mutable boost::mutex m_SinkMutex;
+    mutable boost::condition m_SinkCond;
 };
 
+// category must be the same every time the statement is executed, since its id is
+// only looked up the first time. Use AVG_TRACE_DYNAMIC for categories that vary.
 #define AVG_TRACE(category, severity, sMsg) { \
+static const int avgTraceCategoryID = Logger::get()->getCategoryID(category); \
+if (Logger::get()->shouldLog(avgTraceCategoryID, severity)) { \
+    std::stringstream tmp(std::stringstream::in | std::stringstream::out); \
+    tmp << sMsg; \
+    Logger::get()->trace(tmp.str(), category, severity); \
+    }\
+}\
+
+#define AVG_TRACE_DYNAMIC(category, severity, sMsg) { \
 if (Logger::get()->shouldLog(category, severity)) { \
     std::stringstream tmp(std::stringstream::in | std::stringstream::out); \
     tmp << sMsg; \
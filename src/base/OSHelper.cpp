@@ -41,6 +41,13 @@
 #include <string.h>
 #endif
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
 #include <stdlib.h>
 #include <iostream>
 #include <sstream>
@@ -332,4 +339,47 @@ int getOSXMajorVersion()
     return major;
 }
 #endif
+
+bool reallyCpuHasAVX2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) {
+        return false;
+    }
+    __cpuid(regs, 1);
+    // The os must support the avx registers (OSXSAVE and AVX bits).
+    if ((regs[2] & (3 << 27)) != (3 << 27) || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, 0) < 7) {
+        return false;
+    }
+    __cpuid(1, eax, ebx, ecx, edx);
+    if ((ecx & (3 << 27)) != (3 << 27)) {
+        return false;
+    }
+    unsigned xcr0Lo, xcr0Hi;
+    __asm__ ("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+    if ((xcr0Lo & 6) != 6) {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool cpuHasAVX2()
+{
+    static bool bHasAVX2 = reallyCpuHasAVX2(); // only called once for speed reasons.
+    return bHasAVX2;
+}
+
 }
@@ -47,6 +47,9 @@ AVG_API std::string convertUTF8ToFilename(const std::string & sName);
 int getOSXMajorVersion();
 #endif
 
+// True if the cpu and the os support AVX2 instructions.
+AVG_API bool cpuHasAVX2();
+
 }
 
 #endif 
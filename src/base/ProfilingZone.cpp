@@ -31,7 +31,8 @@ ProfilingZone::ProfilingZone(const ProfilingZoneID& zoneID)
       m_AvgTime(0),
       m_NumFrames(0),
       m_Indent(0),
-      m_ZoneID(zoneID)
+      m_ZoneID(zoneID),
+      m_bKeepFrameTimes(false)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
 }
@@ -46,15 +47,32 @@ void ProfilingZone::restart()
     m_NumFrames = 0;
     m_AvgTime = 0;
     m_TimeSum = 0;
+    m_FrameTimes.clear();
 }
 
 void ProfilingZone::reset()
 {
     m_NumFrames++;
     m_AvgTime = (m_AvgTime*(m_NumFrames-1)+m_TimeSum)/m_NumFrames;
+    if (m_bKeepFrameTimes) {
+        m_FrameTimes.push_back(m_TimeSum);
+    }
     m_TimeSum = 0;
 }
 
+void ProfilingZone::enableFrameTimeHistory(bool bEnable)
+{
+    m_bKeepFrameTimes = bEnable;
+    if (!bEnable) {
+        m_FrameTimes.clear();
+    }
+}
+
+const vector<long long>& ProfilingZone::getFrameTimes() const
+{
+    return m_FrameTimes;
+}
+
 long long ProfilingZone::getUSecs() const
 {
     return m_TimeSum;
@@ -26,6 +26,8 @@
 #include "ProfilingZoneID.h"
 #include "TimeSource.h"
 
+#include <vector>
+
 namespace avg {
 
 class AVG_API ProfilingZone
@@ -44,6 +46,9 @@ public:
         m_TimeSum += TimeSource::get()->getCurrentMicrosecs()-m_StartTime;
     };
     void reset();
+    // If enabled, reset() also stores the time spent in the zone in the last frame.
+    void enableFrameTimeHistory(bool bEnable);
+    const std::vector<long long>& getFrameTimes() const;
     long long getUSecs() const;
     long long getAvgUSecs() const;
     void setIndentLevel(int indent);
@@ -58,6 +63,8 @@ private:
     int m_NumFrames;
     int m_Indent;
     const ProfilingZoneID& m_ZoneID;
+    bool m_bKeepFrameTimes;
+    std::vector<long long> m_FrameTimes;
 };
 
 }
@@ -29,11 +29,23 @@
 #include <boost/shared_ptr.hpp>
 
 #include <deque>
+#include <vector>
+#include <algorithm>
 
 namespace avg {
 
 typedef boost::unique_lock<boost::mutex> unique_lock;
 
+// Gets notified when elements are pushed to or popped from a Queue. Used to wake up
+// workers that run on the TaskScheduler instead of waiting on the queue. Called with the
+// queue locked, so implementations must not access the queue.
+class AVG_API IQueueListener
+{
+public:
+    virtual ~IQueueListener() {};
+    virtual void onQueueChanged() = 0;
+};
+
 template<class QElement>
 class AVG_TEMPLATE_API Queue 
 {
@@ -47,17 +59,26 @@ public:
     QElementPtr pop(bool bBlock = true);
     void clear();
     void push(const QElementPtr& pElem);
+    // Returns false instead of blocking if the queue is full.
+    bool tryPush(const QElementPtr& pElem);
     QElementPtr peek(bool bBlock = true) const;
     int size() const;
     int getMaxSize() const;
 
+    void addPushListener(IQueueListener* pListener);
+    void addPopListener(IQueueListener* pListener);
+    void removeListener(IQueueListener* pListener);
+
 private:
     QElementPtr getFrontElement(bool bBlock, unique_lock& Lock) const;
+    void notifyListeners(const std::vector<IQueueListener*>& pListeners);
 
     std::deque<QElementPtr> m_pElements;
     mutable boost::mutex m_Mutex;
     mutable boost::condition m_Cond;
     int m_MaxSize;
+    std::vector<IQueueListener*> m_pPushListeners;
+    std::vector<IQueueListener*> m_pPopListeners;
 };
 
 template<class QElement>
@@ -86,6 +107,7 @@ typename Queue<QElement>::QElementPtr Queue<QElement>::pop(bool bBlock)
     if (pElem) {
         m_pElements.pop_front();
         m_Cond.notify_one();
+        notifyListeners(m_pPopListeners);
     }
     return pElem;
 }
@@ -122,6 +144,21 @@ void Queue<QElement>::push(const QElementPtr& pElem)
     }
     m_pElements.push_back(pElem);
     m_Cond.notify_one();
+    notifyListeners(m_pPushListeners);
+}
+
+template<class QElement>
+bool Queue<QElement>::tryPush(const QElementPtr& pElem)
+{
+    assert(pElem);
+    unique_lock lock(m_Mutex);
+    if (m_pElements.size() == (unsigned)m_MaxSize) {
+        return false;
+    }
+    m_pElements.push_back(pElem);
+    m_Cond.notify_one();
+    notifyListeners(m_pPushListeners);
+    return true;
 }
 
 template<class QElement>
@@ -138,6 +175,38 @@ int Queue<QElement>::getMaxSize() const
     return m_MaxSize;
 }
 
+template<class QElement>
+void Queue<QElement>::addPushListener(IQueueListener* pListener)
+{
+    unique_lock lock(m_Mutex);
+    m_pPushListeners.push_back(pListener);
+}
+
+template<class QElement>
+void Queue<QElement>::addPopListener(IQueueListener* pListener)
+{
+    unique_lock lock(m_Mutex);
+    m_pPopListeners.push_back(pListener);
+}
+
+template<class QElement>
+void Queue<QElement>::removeListener(IQueueListener* pListener)
+{
+    unique_lock lock(m_Mutex);
+    m_pPushListeners.erase(std::remove(m_pPushListeners.begin(), m_pPushListeners.end(),
+            pListener), m_pPushListeners.end());
+    m_pPopListeners.erase(std::remove(m_pPopListeners.begin(), m_pPopListeners.end(),
+            pListener), m_pPopListeners.end());
+}
+
+template<class QElement>
+void Queue<QElement>::notifyListeners(const std::vector<IQueueListener*>& pListeners)
+{
+    for (unsigned i=0; i<pListeners.size(); ++i) {
+        pListeners[i]->onQueueChanged();
+    }
+}
+
 template<class QElement>
 typename Queue<QElement>::QElementPtr 
         Queue<QElement>::getFrontElement(bool bBlock, unique_lock& lock) const
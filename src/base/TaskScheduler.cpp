@@ -0,0 +1,254 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "TaskScheduler.h"
+
+#include "ConfigMgr.h"
+#include "Exception.h"
+#include "ThreadHelper.h"
+#include "ThreadProfiler.h"
+#include "TimeSource.h"
+#include "StringHelper.h"
+
+#include <boost/bind.hpp>
+
+#include <stdlib.h>
+#include <climits>
+
+using namespace std;
+
+namespace avg {
+
+TaskScheduler* TaskScheduler::s_pTaskScheduler = 0;
+boost::thread_specific_ptr<int> TaskScheduler::s_pWorkerIndex;
+
+void deleteTaskScheduler()
+{
+    delete TaskScheduler::s_pTaskScheduler;
+    TaskScheduler::s_pTaskScheduler = 0;
+}
+
+TaskScheduler* TaskScheduler::get()
+{
+    if (!s_pTaskScheduler) {
+        int numWorkers = getConfiguredNumWorkers();
+        if (numWorkers <= 0) {
+            // The main thread has a core to itself (see setAffinityMask()).
+            numWorkers = max(1, int(boost::thread::hardware_concurrency())-1);
+        }
+        s_pTaskScheduler = new TaskScheduler(numWorkers);
+        atexit(deleteTaskScheduler);
+    }
+    return s_pTaskScheduler;
+}
+
+int TaskScheduler::getConfiguredNumWorkers()
+{
+    int numWorkers = ConfigMgr::get()->getIntOption("threads", "numworkers", 0);
+    if (numWorkers < 0) {
+        numWorkers = max(1, int(boost::thread::hardware_concurrency())-1);
+    }
+    return numWorkers;
+}
+
+TaskScheduler::TaskScheduler(int numWorkers)
+    : m_NextQueue(0),
+      m_NumSleeping(0),
+      m_NextDelayedTime(LLONG_MAX),
+      m_bStop(false)
+{
+    AVG_ASSERT(numWorkers > 0);
+    for (int i=0; i<numWorkers; ++i) {
+        m_pQueues.push_back(new WorkerQueue);
+    }
+    for (int i=0; i<numWorkers; ++i) {
+        m_Workers.create_thread(boost::bind(&TaskScheduler::runWorker, this, i));
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    stop();
+}
+
+void TaskScheduler::submit(const Task& task)
+{
+    int i = getCurWorkerIndex();
+    if (i == -1) {
+        i = m_NextQueue.fetch_add(1) % m_pQueues.size();
+    }
+    pushTask(*m_pQueues[i], task);
+    wakeWorker();
+}
+
+void TaskScheduler::submitDelayed(const Task& task, int delayMillisecs)
+{
+    long long time = TimeSource::get()->getCurrentMillisecs()+delayMillisecs;
+    boost::unique_lock<boost::mutex> lock(m_Mutex);
+    m_DelayedTasks.insert(make_pair(time, task));
+    if (time < m_NextDelayedTime) {
+        m_NextDelayedTime = time;
+        // Sleeping workers need to recalculate their timeout.
+        m_Cond.notify_one();
+    }
+}
+
+int TaskScheduler::getNumWorkers() const
+{
+    return m_pQueues.size();
+}
+
+void TaskScheduler::stop()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(m_Mutex);
+        m_bStop = true;
+        m_Cond.notify_all();
+    }
+    m_Workers.join_all();
+    m_DelayedTasks.clear();
+    for (unsigned i=0; i<m_pQueues.size(); ++i) {
+        delete m_pQueues[i];
+    }
+    m_pQueues.clear();
+}
+
+void TaskScheduler::runWorker(int workerIndex)
+{
+    s_pWorkerIndex.reset(new int(workerIndex));
+    setAffinityMask(false);
+    ThreadProfiler* pProfiler = ThreadProfiler::get();
+    pProfiler->setName("Worker "+toString(workerIndex));
+    pProfiler->start();
+    Task task;
+    while (!m_bStop) {
+        if (getTask(workerIndex, task)) {
+            task();
+            task = Task();
+        } else {
+            boost::unique_lock<boost::mutex> lock(m_Mutex);
+            m_NumSleeping.fetch_add(1);
+            if (!m_bStop && !hasTasks()) {
+                long long nextTime = m_NextDelayedTime;
+                if (nextTime == LLONG_MAX) {
+                    m_Cond.wait(lock);
+                } else {
+                    long long now = TimeSource::get()->getCurrentMillisecs();
+                    if (nextTime > now) {
+                        m_Cond.timed_wait(lock,
+                                boost::posix_time::milliseconds(nextTime-now));
+                    }
+                }
+            }
+            m_NumSleeping.fetch_sub(1);
+        }
+    }
+    pProfiler->dumpStatistics();
+    pProfiler->kill();
+}
+
+bool TaskScheduler::getTask(int workerIndex, Task& task)
+{
+    if (m_NextDelayedTime <= TimeSource::get()->getCurrentMillisecs()) {
+        queueDueTasks(workerIndex);
+    }
+    if (popTask(*m_pQueues[workerIndex], false, task)) {
+        return true;
+    }
+    int numQueues = m_pQueues.size();
+    for (int i=1; i<numQueues; ++i) {
+        if (popTask(*m_pQueues[(workerIndex+i)%numQueues], true, task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::popTask(WorkerQueue& queue, bool bSteal, Task& task)
+{
+    // Workers process their own queue in FIFO order so resubmitted tasks take turns.
+    // Thieves take the most recently queued task from the back.
+    boost::unique_lock<boost::mutex> lock(queue.m_Mutex);
+    if (queue.m_Tasks.empty()) {
+        return false;
+    }
+    if (bSteal) {
+        task = queue.m_Tasks.back();
+        queue.m_Tasks.pop_back();
+    } else {
+        task = queue.m_Tasks.front();
+        queue.m_Tasks.pop_front();
+    }
+    return true;
+}
+
+void TaskScheduler::pushTask(WorkerQueue& queue, const Task& task)
+{
+    boost::unique_lock<boost::mutex> lock(queue.m_Mutex);
+    queue.m_Tasks.push_back(task);
+}
+
+bool TaskScheduler::hasTasks()
+{
+    for (unsigned i=0; i<m_pQueues.size(); ++i) {
+        boost::unique_lock<boost::mutex> lock(m_pQueues[i]->m_Mutex);
+        if (!m_pQueues[i]->m_Tasks.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::queueDueTasks(int workerIndex)
+{
+    boost::unique_lock<boost::mutex> lock(m_Mutex);
+    long long now = TimeSource::get()->getCurrentMillisecs();
+    multimap<long long, Task>::iterator it = m_DelayedTasks.begin();
+    while (it != m_DelayedTasks.end() && it->first <= now) {
+        pushTask(*m_pQueues[workerIndex], it->second);
+        m_DelayedTasks.erase(it++);
+    }
+    if (m_DelayedTasks.empty()) {
+        m_NextDelayedTime = LLONG_MAX;
+    } else {
+        m_NextDelayedTime = m_DelayedTasks.begin()->first;
+    }
+}
+
+void TaskScheduler::wakeWorker()
+{
+    if (m_NumSleeping > 0) {
+        boost::unique_lock<boost::mutex> lock(m_Mutex);
+        m_Cond.notify_one();
+    }
+}
+
+int TaskScheduler::getCurWorkerIndex() const
+{
+    int* pIndex = s_pWorkerIndex.get();
+    if (pIndex) {
+        return *pIndex;
+    } else {
+        return -1;
+    }
+}
+
+}
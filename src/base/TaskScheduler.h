@@ -0,0 +1,97 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _TaskScheduler_H_
+#define _TaskScheduler_H_
+
+#include "../api.h"
+
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/atomic.hpp>
+
+#include <vector>
+#include <deque>
+#include <map>
+
+namespace avg {
+
+// Fixed pool of worker threads that executes short tasks. Each worker has its own task
+// queue; workers that run out of tasks steal from the other queues. Tasks submitted
+// from a worker thread go to that worker's queue.
+// Tasks must not block for long periods, since that takes a worker away from all other
+// clients. Tasks that need to wait for something should resubmit themselves with
+// submitDelayed() instead.
+class AVG_API TaskScheduler
+{
+public:
+    typedef boost::function<void()> Task;
+
+    static TaskScheduler* get();
+    // Number of workers as configured in avgrc. 0 means that worker objects should run on
+    // their own threads instead of on the scheduler.
+    static int getConfiguredNumWorkers();
+    virtual ~TaskScheduler();
+
+    void submit(const Task& task);
+    void submitDelayed(const Task& task, int delayMillisecs);
+    int getNumWorkers() const;
+
+private:
+    TaskScheduler(int numWorkers);
+    void stop();
+
+    struct WorkerQueue {
+        boost::mutex m_Mutex;
+        std::deque<Task> m_Tasks;
+    };
+
+    void runWorker(int workerIndex);
+    bool getTask(int workerIndex, Task& task);
+    bool popTask(WorkerQueue& queue, bool bSteal, Task& task);
+    void pushTask(WorkerQueue& queue, const Task& task);
+    bool hasTasks();
+    void queueDueTasks(int workerIndex);
+    void wakeWorker();
+    int getCurWorkerIndex() const;
+
+    std::vector<WorkerQueue*> m_pQueues;
+    boost::thread_group m_Workers;
+    boost::atomic<unsigned> m_NextQueue;
+
+    mutable boost::mutex m_Mutex;
+    boost::condition m_Cond;
+    boost::atomic<int> m_NumSleeping;
+    std::multimap<long long, Task> m_DelayedTasks;
+    boost::atomic<long long> m_NextDelayedTime;
+    boost::atomic<bool> m_bStop;
+
+    static TaskScheduler* s_pTaskScheduler;
+    static boost::thread_specific_ptr<int> s_pWorkerIndex;
+    friend void deleteTaskScheduler();
+};
+
+}
+
+#endif
@@ -25,10 +25,14 @@
 #include "Exception.h"
 #include "ProfilingZone.h"
 #include "ScopeTimer.h"
+#include "StringHelper.h"
+#include "TimeSource.h"
 
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 using namespace boost;
@@ -37,6 +41,19 @@ namespace avg {
     
 thread_specific_ptr<ThreadProfiler*> ThreadProfiler::s_pInstance;
 
+volatile bool ThreadProfiler::s_bTracingEnabled = false;
+volatile bool ThreadProfiler::s_bKeepFrameTimes = false;
+int ThreadProfiler::s_TraceRingSize = 0;
+boost::mutex ThreadProfiler::s_ProfilersMutex;
+vector<ThreadProfiler*> ThreadProfiler::s_pProfilers;
+int ThreadProfiler::s_NextThreadID = 1;
+boost::mutex ThreadProfiler::s_TraceNamesMutex;
+map<string, int> ThreadProfiler::s_TraceNameIDs;
+vector<string> ThreadProfiler::s_TraceNames;
+boost::mutex ThreadProfiler::s_TraceWriterMutex;
+boost::thread* ThreadProfiler::s_pTraceWriterThread = 0;
+bool ThreadProfiler::s_bWritingTrace = false;
+
 ThreadProfiler* ThreadProfiler::get() 
 {
     if (s_pInstance.get() == 0) {
@@ -54,23 +71,37 @@ void ThreadProfiler::kill()
 
 ThreadProfiler::ThreadProfiler()
     : m_sName(""),
-      m_LogCategory(Logger::category::PROFILE)
+      m_LogCategory(Logger::category::PROFILE),
+      m_TraceNameID(getTraceNameID("")),
+      m_TraceRingPos(0),
+      m_bTraceRingFull(false)
 {
     m_bRunning = false;
-    ScopeTimer::enableTimers(Logger::get()->shouldLog(m_LogCategory,
-            Logger::severity::INFO));
+    ScopeTimer::enableTimers(s_bTracingEnabled || s_bKeepFrameTimes ||
+            Logger::get()->shouldLog(m_LogCategory, Logger::severity::INFO));
+
+    boost::mutex::scoped_lock lock(s_ProfilersMutex);
+    m_ThreadID = s_NextThreadID;
+    s_NextThreadID++;
+    s_pProfilers.push_back(this);
 }
 
 ThreadProfiler::~ThreadProfiler() 
 {
+    boost::mutex::scoped_lock lock(s_ProfilersMutex);
+    s_pProfilers.erase(find(s_pProfilers.begin(), s_pProfilers.end(), this));
 }
 
 void ThreadProfiler::setLogCategory(category_t category)
 {
-    AVG_ASSERT(!m_bRunning);
     m_LogCategory = category;
 }
 
+category_t ThreadProfiler::getLogCategory() const
+{
+    return m_LogCategory;
+}
+
 void ThreadProfiler::start()
 {
     m_bRunning = true;
@@ -84,7 +115,7 @@ void ThreadProfiler::restart()
     }
 }
 
-void ThreadProfiler::startZone(const ProfilingZoneID& zoneID)
+void ThreadProfiler::startZoneTimer(const ProfilingZoneID& zoneID)
 {
     ZoneMap::iterator it = m_ZoneMap.find(&zoneID);
     // Duplicated code to avoid instantiating a new smart pointer when it's not
@@ -100,7 +131,7 @@ void ThreadProfiler::startZone(const ProfilingZoneID& zoneID)
     }
 }
 
-void ThreadProfiler::stopZone(const ProfilingZoneID& zoneID)
+void ThreadProfiler::stopZoneTimer(const ProfilingZoneID& zoneID)
 {
     ZoneMap::iterator it = m_ZoneMap.find(&zoneID);
     ProfilingZonePtr& pZone = it->second;
@@ -111,20 +142,21 @@ void ThreadProfiler::stopZone(const ProfilingZoneID& zoneID)
 void ThreadProfiler::dumpStatistics()
 {
     if (!m_Zones.empty()) {
-        AVG_TRACE(m_LogCategory, Logger::severity::INFO, "Thread " << m_sName);
-        AVG_TRACE(m_LogCategory, Logger::severity::INFO,
+        AVG_TRACE_DYNAMIC(m_LogCategory, Logger::severity::INFO, 
+                "Thread " << m_sName);
+        AVG_TRACE_DYNAMIC(m_LogCategory, Logger::severity::INFO,
                 "Zone name                          Avg. time");
-        AVG_TRACE(m_LogCategory, Logger::severity::INFO,
+        AVG_TRACE_DYNAMIC(m_LogCategory, Logger::severity::INFO,
                 "---------                          ---------");
 
         ZoneVector::iterator it;
         for (it = m_Zones.begin(); it != m_Zones.end(); ++it) {
-            AVG_TRACE(m_LogCategory, Logger::severity::INFO,
+            AVG_TRACE_DYNAMIC(m_LogCategory, Logger::severity::INFO,
                     std::setw(35) << std::left 
                     << ((*it)->getIndentString()+(*it)->getName())
                     << std::setw(9) << std::right << (*it)->getAvgUSecs());
         }
-        AVG_TRACE(m_LogCategory, Logger::severity::INFO, "");
+        AVG_TRACE_DYNAMIC(m_LogCategory, Logger::severity::INFO, "");
     }
 }
 
@@ -141,6 +173,28 @@ int ThreadProfiler::getNumZones()
     return m_Zones.size();
 }
 
+void ThreadProfiler::enableFrameTimeHistory(bool bEnable)
+{
+    s_bKeepFrameTimes = bEnable;
+    ZoneVector::iterator it;
+    for (it = m_Zones.begin(); it != m_Zones.end(); ++it) {
+        (*it)->enableFrameTimeHistory(bEnable);
+    }
+    // Zones are only timed if timers are enabled.
+    ScopeTimer::enableTimers(bEnable || s_bTracingEnabled || 
+            Logger::get()->shouldLog(m_LogCategory, Logger::severity::INFO));
+}
+
+ThreadProfiler::FrameTimeMap ThreadProfiler::getFrameTimes() const
+{
+    FrameTimeMap frameTimes;
+    ZoneVector::const_iterator it;
+    for (it = m_Zones.begin(); it != m_Zones.end(); ++it) {
+        frameTimes[(*it)->getName()] = (*it)->getFrameTimes();
+    }
+    return frameTimes;
+}
+
 const std::string& ThreadProfiler::getName() const
 {
     return m_sName;
@@ -148,13 +202,224 @@ const std::string& ThreadProfiler::getName() const
 
 void ThreadProfiler::setName(const std::string& sName)
 {
+    // Scheduled WorkerThreads rename the thread for every slice they run.
+    int nameID = getTraceNameID(sName);
+    boost::mutex::scoped_lock lock(m_TraceMutex);
     m_sName = sName;
+    m_TraceNameID = nameID;
+}
+
+void ThreadProfiler::enableTracing(bool bEnable, int ringSize)
+{
+    AVG_ASSERT(ringSize > 0);
+    {
+        boost::mutex::scoped_lock lock(s_ProfilersMutex);
+        s_TraceRingSize = ringSize;
+        s_bTracingEnabled = bEnable;
+    }
+    ThreadProfiler* pProfiler = get();
+    ScopeTimer::enableTimers(bEnable || s_bKeepFrameTimes ||
+            Logger::get()->shouldLog(pProfiler->m_LogCategory, Logger::severity::INFO));
+}
+
+bool ThreadProfiler::isTracingEnabled()
+{
+    return s_bTracingEnabled;
+}
+
+void ThreadProfiler::writeTrace(const std::string& sFilename)
+{
+    // Take the rings of all threads before writing, so no thread has to wait for 
+    // the file.
+    vector<ThreadTrace> traces;
+    {
+        boost::mutex::scoped_lock lock(s_ProfilersMutex);
+        traces.resize(s_pProfilers.size());
+        for (unsigned i = 0; i < s_pProfilers.size(); ++i) {
+            traces[i].m_Ring.resize(s_TraceRingSize);
+            s_pProfilers[i]->swapTraceRing(traces[i]);
+        }
+    }
+    vector<string> names;
+    {
+        boost::mutex::scoped_lock lock(s_TraceNamesMutex);
+        names = s_TraceNames;
+    }
+
+    ofstream os(sFilename.c_str());
+    if (!os) {
+        throw Exception(AVG_ERR_FILEIO, 
+                "Could not open '" + sFilename + "' for writing trace.");
+    }
+    os << "{\"traceEvents\":[";
+    bool bFirstEvent = true;
+    int nextTrackID = 1;
+    for (unsigned i = 0; i < traces.size(); ++i) {
+        writeThreadTrace(os, traces[i], names, nextTrackID, bFirstEvent);
+    }
+    os << "\n]}\n";
+    if (!os) {
+        throw Exception(AVG_ERR_FILEIO, "Error writing trace to '" + sFilename + "'.");
+    }
+}
+
+bool ThreadProfiler::writeTraceAsync(const std::string& sFilename)
+{
+    boost::mutex::scoped_lock lock(s_TraceWriterMutex);
+    if (s_bWritingTrace) {
+        return false;
+    }
+    if (s_pTraceWriterThread) {
+        // Done writing, so this doesn't block.
+        s_pTraceWriterThread->join();
+        delete s_pTraceWriterThread;
+    }
+    s_bWritingTrace = true;
+    s_pTraceWriterThread = new boost::thread(&ThreadProfiler::traceWriterThread, 
+            sFilename);
+    return true;
+}
+
+void ThreadProfiler::waitForTraceWriter()
+{
+    boost::mutex::scoped_lock lock(s_TraceWriterMutex);
+    if (s_pTraceWriterThread) {
+        lock.unlock();
+        s_pTraceWriterThread->join();
+        lock.lock();
+        delete s_pTraceWriterThread;
+        s_pTraceWriterThread = 0;
+    }
+}
+
+void ThreadProfiler::addTraceEvent(const ProfilingZoneID* pZoneID, char phase, 
+        int frameNum)
+{
+    // Only contended while a trace writer swaps the ring.
+    boost::mutex::scoped_lock lock(m_TraceMutex);
+    if (m_TraceRing.size() != unsigned(s_TraceRingSize)) {
+        m_TraceRing.resize(s_TraceRingSize);
+        m_TraceRingPos = 0;
+        m_bTraceRingFull = false;
+    }
+    TraceEvent& event = m_TraceRing[m_TraceRingPos];
+    event.m_pZoneID = pZoneID;
+    event.m_Time = TimeSource::get()->getCurrentMicrosecs();
+    event.m_FrameNum = frameNum;
+    event.m_NameID = m_TraceNameID;
+    event.m_Phase = phase;
+    m_TraceRingPos++;
+    if (m_TraceRingPos == m_TraceRing.size()) {
+        m_TraceRingPos = 0;
+        m_bTraceRingFull = true;
+    }
+}
+
+void ThreadProfiler::swapTraceRing(ThreadTrace& trace)
+{
+    trace.m_ThreadID = m_ThreadID;
+    boost::mutex::scoped_lock lock(m_TraceMutex);
+    if (m_TraceRing.empty()) {
+        // Nothing recorded in this thread, so there's no need to hand it a ring.
+        trace.m_RingPos = 0;
+        trace.m_bRingFull = false;
+    } else {
+        m_TraceRing.swap(trace.m_Ring);
+        trace.m_RingPos = m_TraceRingPos;
+        trace.m_bRingFull = m_bTraceRingFull;
+        m_TraceRingPos = 0;
+        m_bTraceRingFull = false;
+    }
+}
+
+void ThreadProfiler::writeThreadTrace(ostream& os, const ThreadTrace& trace,
+        const vector<string>& names, int& nextTrackID, bool& bFirstEvent)
+{
+    unsigned numEvents = trace.m_RingPos;
+    unsigned startPos = 0;
+    if (trace.m_bRingFull) {
+        numEvents = trace.m_Ring.size();
+        startPos = trace.m_RingPos;
+    }
+    // One track per thread name, each with its own nesting depth. Ends of zones whose
+    // start has already been overwritten are skipped.
+    map<int, int> trackIDs;
+    map<int, int> depths;
+    for (unsigned i = 0; i < numEvents; ++i) {
+        const TraceEvent& event = trace.m_Ring[(startPos+i) % trace.m_Ring.size()];
+        int trackID;
+        map<int, int>::iterator it = trackIDs.find(event.m_NameID);
+        if (it == trackIDs.end()) {
+            trackID = nextTrackID;
+            nextTrackID++;
+            trackIDs[event.m_NameID] = trackID;
+            string sName = names[event.m_NameID];
+            if (sName == "") {
+                sName = "Thread "+toString(trace.m_ThreadID);
+            }
+            if (!bFirstEvent) {
+                os << ",";
+            }
+            bFirstEvent = false;
+            os << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" 
+                    << trackID << ",\"args\":{\"name\":\"" << sName << "\"}}";
+        } else {
+            trackID = it->second;
+        }
+        int& depth = depths[event.m_NameID];
+        switch (event.m_Phase) {
+            case 'B':
+                depth++;
+                os << ",\n{\"name\":\"" << event.m_pZoneID->getName() 
+                        << "\",\"ph\":\"B\"";
+                break;
+            case 'E':
+                if (depth == 0) {
+                    continue;
+                }
+                depth--;
+                os << ",\n{\"ph\":\"E\"";
+                break;
+            case 'i':
+                os << ",\n{\"name\":\"Frame " << event.m_FrameNum 
+                        << "\",\"ph\":\"i\",\"s\":\"g\"";
+                break;
+            default:
+                AVG_ASSERT(false);
+        }
+        os << ",\"ts\":" << event.m_Time << ",\"pid\":1,\"tid\":" << trackID << "}";
+    }
+}
+
+void ThreadProfiler::traceWriterThread(const std::string& sFilename)
+{
+    try {
+        writeTrace(sFilename);
+    } catch (const Exception& e) {
+        AVG_LOG_ERROR("Could not write trace: " << e.getStr());
+    }
+    boost::mutex::scoped_lock lock(s_TraceWriterMutex);
+    s_bWritingTrace = false;
 }
 
+int ThreadProfiler::getTraceNameID(const std::string& sName)
+{
+    boost::mutex::scoped_lock lock(s_TraceNamesMutex);
+    map<string, int>::iterator it = s_TraceNameIDs.find(sName);
+    if (it == s_TraceNameIDs.end()) {
+        int nameID = s_TraceNames.size();
+        s_TraceNames.push_back(sName);
+        s_TraceNameIDs[sName] = nameID;
+        return nameID;
+    } else {
+        return it->second;
+    }
+}
 
 ProfilingZonePtr ThreadProfiler::addZone(const ProfilingZoneID& zoneID)
 {
     ProfilingZonePtr pZone(new ProfilingZone(zoneID));
+    pZone->enableFrameTimeHistory(s_bKeepFrameTimes);
     m_ZoneMap[&zoneID] = pZone;
     ZoneVector::iterator it;
     int parentIndent = -2;
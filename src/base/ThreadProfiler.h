@@ -28,8 +28,11 @@
 #include <boost/thread.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/tss.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <vector>
+#include <map>
+#include <string>
 #if defined(_WIN32) || defined(_LIBCPP_VERSION)
 #include <unordered_map>
 #else
@@ -52,20 +55,88 @@ public:
     ThreadProfiler();
     virtual ~ThreadProfiler();
     void setLogCategory(category_t category);
+    category_t getLogCategory() const;
  
     void start();
     void restart();
-    void startZone(const ProfilingZoneID& zoneID);
-    void stopZone(const ProfilingZoneID& zoneID);
+    void startZone(const ProfilingZoneID& zoneID)
+    {
+        if (s_bTracingEnabled) {
+            addTraceEvent(&zoneID, 'B', 0);
+        }
+        startZoneTimer(zoneID);
+    }
+
+    void stopZone(const ProfilingZoneID& zoneID)
+    {
+        stopZoneTimer(zoneID);
+        if (s_bTracingEnabled) {
+            addTraceEvent(&zoneID, 'E', 0);
+        }
+    }
+
     void dumpStatistics();
     void reset();
     int getNumZones();
 
+    // Per-frame zone times in microseconds, for percentile statistics in benchmarks.
+    typedef std::map<std::string, std::vector<long long> > FrameTimeMap;
+    void enableFrameTimeHistory(bool bEnable);
+    FrameTimeMap getFrameTimes() const;
+
     const std::string& getName() const;
     void setName(const std::string& sName);
 
+    // Timeline tracing: If enabled, every zone start and stop in every thread is
+    // recorded in a per-thread ring buffer of ringSize events. Recording an event
+    // locks the ring's mutex, which is uncontended except for the moment a writer
+    // swaps the ring out. writeTrace() takes the rings of all threads and dumps them
+    // in Chrome trace format (chrome://tracing, Perfetto). Recording starts over
+    // with empty rings afterwards. Events are tagged with the thread name current
+    // when they were recorded, and every name a thread had gets a track of its own.
+    // That way, scheduled WorkerThreads show up separately even if they share a 
+    // thread.
+    static void enableTracing(bool bEnable, int ringSize);
+    static bool isTracingEnabled();
+    static void writeTrace(const std::string& sFilename);
+    // Like writeTrace(), but runs in a separate thread. Returns false without doing
+    // anything if the previous trace is still being written.
+    static bool writeTraceAsync(const std::string& sFilename);
+    static void waitForTraceWriter();
+    void addFrameMarker(int frameNum)
+    {
+        if (s_bTracingEnabled) {
+            addTraceEvent(0, 'i', frameNum);
+        }
+    }
+
 private:
     ProfilingZonePtr addZone(const ProfilingZoneID& zoneID);
+    void startZoneTimer(const ProfilingZoneID& zoneID);
+    void stopZoneTimer(const ProfilingZoneID& zoneID);
+
+    struct TraceEvent {
+        // 0 for frame markers.
+        const ProfilingZoneID* m_pZoneID;
+        long long m_Time;
+        int m_FrameNum;
+        int m_NameID;
+        char m_Phase;
+    };
+    // The events of one thread, taken out of its ring by a trace writer.
+    struct ThreadTrace {
+        int m_ThreadID;
+        std::vector<TraceEvent> m_Ring;
+        unsigned m_RingPos;
+        bool m_bRingFull;
+    };
+    void addTraceEvent(const ProfilingZoneID* pZoneID, char phase, int frameNum);
+    void swapTraceRing(ThreadTrace& trace);
+    static void writeThreadTrace(std::ostream& os, const ThreadTrace& trace, 
+            const std::vector<std::string>& names, int& nextTrackID, bool& bFirstEvent);
+    static int getTraceNameID(const std::string& sName);
+    static void traceWriterThread(const std::string& sFilename);
+
     std::string m_sName;
 
 #if defined(_WIN32) || defined(_LIBCPP_VERSION)
@@ -80,7 +151,30 @@ private:
     bool m_bRunning;
     category_t m_LogCategory;
 
+    int m_ThreadID;
+    // Protects the ring and the name.
+    boost::mutex m_TraceMutex;
+    int m_TraceNameID;
+    std::vector<TraceEvent> m_TraceRing;
+    unsigned m_TraceRingPos;
+    bool m_bTraceRingFull;
+
     static boost::thread_specific_ptr<ThreadProfiler*> s_pInstance;
+
+    static volatile bool s_bTracingEnabled;
+    // Global because zone timing can only be switched on and off for all threads.
+    static volatile bool s_bKeepFrameTimes;
+    static int s_TraceRingSize;
+    static boost::mutex s_ProfilersMutex;
+    static std::vector<ThreadProfiler*> s_pProfilers;
+    static int s_NextThreadID;
+    static boost::mutex s_TraceNamesMutex;
+    static std::map<std::string, int> s_TraceNameIDs;
+    static std::vector<std::string> s_TraceNames;
+
+    static boost::mutex s_TraceWriterMutex;
+    static boost::thread* s_pTraceWriterThread;
+    static bool s_bWritingTrace;
 };
 
 }
@@ -31,6 +31,10 @@
 #include <Mmsystem.h>
 #else
 #include <sys/time.h>
+#include <time.h>
+#endif
+#ifdef __APPLE__
+#include <mach/mach.h>
 #endif
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -96,6 +100,36 @@ long long TimeSource::getCurrentMicrosecs()
 #endif
 }
 
+long long TimeSource::getThreadCPUMicrosecs()
+{
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime);
+    // FILETIMEs are in 100 ns units.
+    long long kernel = ((long long)kernelTime.dwHighDateTime << 32) + 
+            kernelTime.dwLowDateTime;
+    long long user = ((long long)userTime.dwHighDateTime << 32) + userTime.dwLowDateTime;
+    return (kernel+user)/10;
+#else
+#ifdef __APPLE__
+    mach_port_t thread = mach_thread_self();
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    kern_return_t rc = thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info,
+            &count);
+    mach_port_deallocate(mach_task_self(), thread);
+    assert(rc == KERN_SUCCESS);
+    return ((long long)info.user_time.seconds+info.system_time.seconds)*1000000 + 
+            info.user_time.microseconds+info.system_time.microseconds;
+#else
+    struct timespec now;
+    int rc = clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    assert(rc == 0);
+    return ((long long)now.tv_sec)*1000000+now.tv_nsec/1000;
+#endif
+#endif
+}
+
 void TimeSource::sleepUntil(long long targetTime)
 {
     long long now = getCurrentMillisecs();
@@ -41,6 +41,8 @@ public:
    
     long long getCurrentMillisecs();
     long long getCurrentMicrosecs();
+    // CPU time used by the calling thread.
+    long long getThreadCPUMicrosecs();
     
     void sleepUntil(long long targetTime);
 
@@ -0,0 +1,166 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _WorkerHandle_H_
+#define _WorkerHandle_H_
+
+#include "../api.h"
+#include "TaskScheduler.h"
+#include "Queue.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/bind.hpp>
+#include <boost/atomic.hpp>
+
+namespace avg {
+
+// Handle to a running WorkerThread. Depending on the threads:numworkers setting in
+// avgrc, startWorkerThread() either gives the worker its own OS thread or runs it in
+// slices on the shared TaskScheduler.
+class AVG_API WorkerHandle
+{
+public:
+    virtual ~WorkerHandle() {};
+    virtual void join() = 0;
+};
+
+typedef boost::shared_ptr<WorkerHandle> WorkerHandlePtr;
+
+class AVG_API OSThreadHandle: public WorkerHandle
+{
+public:
+    OSThreadHandle(boost::thread* pThread)
+        : m_pThread(pThread)
+    {
+    }
+
+    virtual ~OSThreadHandle()
+    {
+        delete m_pThread;
+    }
+
+    virtual void join()
+    {
+        m_pThread->join();
+    }
+
+private:
+    boost::thread* m_pThread;
+};
+
+// Idle workers aren't polled. They are parked until one of the queues they listen to
+// changes.
+template<class WORKER>
+class AVG_TEMPLATE_API ScheduledWorkerHandle: public WorkerHandle, public IQueueListener,
+        public boost::enable_shared_from_this<ScheduledWorkerHandle<WORKER> >
+{
+public:
+    ScheduledWorkerHandle(const WORKER& worker)
+        : m_Worker(worker),
+          m_bFinished(false),
+          m_bParked(false),
+          m_bWakeRequested(false)
+    {
+    }
+
+    void start()
+    {
+        m_Worker.addQueueListener(this);
+        TaskScheduler::get()->submit(getSliceTask());
+    }
+
+    virtual void onQueueChanged()
+    {
+        m_bWakeRequested = true;
+        unpark();
+    }
+
+    virtual void join()
+    {
+        boost::unique_lock<boost::mutex> lock(m_Mutex);
+        while (!m_bFinished) {
+            m_Cond.wait(lock);
+        }
+    }
+
+private:
+    TaskScheduler::Task getSliceTask()
+    {
+        return boost::bind(&ScheduledWorkerHandle::runSlice, this->shared_from_this());
+    }
+
+    void runSlice()
+    {
+        m_bWakeRequested = false;
+        bool bRunning = m_Worker.runSlice();
+        if (!bRunning) {
+            // No notifications may arrive once the owner has joined.
+            m_Worker.removeQueueListener(this);
+            boost::unique_lock<boost::mutex> lock(m_Mutex);
+            m_bFinished = true;
+            m_Cond.notify_all();
+        } else if (m_Worker.isIdle()) {
+            m_bParked = true;
+            // A queue might have changed after the worker looked at it.
+            if (m_bWakeRequested) {
+                unpark();
+            }
+        } else {
+            TaskScheduler::get()->submit(getSliceTask());
+        }
+    }
+
+    void unpark()
+    {
+        bool bParked = true;
+        if (m_bParked.compare_exchange_strong(bParked, false)) {
+            TaskScheduler::get()->submit(getSliceTask());
+        }
+    }
+
+    WORKER m_Worker;
+    boost::mutex m_Mutex;
+    boost::condition m_Cond;
+    bool m_bFinished;
+    boost::atomic<bool> m_bParked;
+    boost::atomic<bool> m_bWakeRequested;
+};
+
+template<class WORKER>
+WorkerHandlePtr startWorkerThread(const WORKER& worker)
+{
+    if (TaskScheduler::getConfiguredNumWorkers() > 0) {
+        boost::shared_ptr<ScheduledWorkerHandle<WORKER> > pHandle(
+                new ScheduledWorkerHandle<WORKER>(worker));
+        pHandle->start();
+        return pHandle;
+    } else {
+        return WorkerHandlePtr(new OSThreadHandle(new boost::thread(worker)));
+    }
+}
+
+}
+
+#endif
@@ -50,12 +50,30 @@ public:
     virtual ~WorkerThread();
     void operator()();
 
+    // Runs one iteration of the thread loop. Used when the thread is executed in
+    // slices on the TaskScheduler instead of on its own OS thread. Returns false once
+    // the thread has terminated.
+    bool runSlice();
+    bool isIdle() const;
+
+    // Registers a listener that is notified whenever an idle scheduled thread might have
+    // something to do again. Derived threads that wait on queues other than the command
+    // queue add the listener to those queues as well.
+    virtual void addQueueListener(IQueueListener* pListener);
+    virtual void removeQueueListener(IQueueListener* pListener);
+
     void waitForCommand();
     void stop();
 
 protected:
     int getNumCmdsInQueue() const;
 
+    // When running on the TaskScheduler, work() must not block. Instead, it should
+    // call setIdle() and return. The thread runs again once one of the queues it
+    // listens to changes.
+    bool isScheduled() const;
+    void setIdle();
+
 private:
     virtual bool init();
     virtual bool work() = 0;
@@ -67,6 +85,9 @@ private:
     bool m_bShouldStop;
     CQueue& m_CmdQ;
     category_t m_LogCategory;
+
+    bool m_bScheduled;
+    bool m_bIdle;
 };
 
 template<class DERIVED_THREAD>
@@ -75,7 +96,9 @@ WorkerThread<DERIVED_THREAD>::WorkerThread(const std::string& sName, CQueue& Cmd
     : m_sName(sName),
       m_bShouldStop(false),
       m_CmdQ(CmdQ),
-      m_LogCategory(logCategory)
+      m_LogCategory(logCategory),
+      m_bScheduled(false),
+      m_bIdle(false)
 {
 }
 
@@ -86,6 +109,8 @@ WorkerThread<DERIVED_THREAD>::WorkerThread(WorkerThread const& other)
     m_sName = other.m_sName;
     m_bShouldStop = other.m_bShouldStop;
     m_LogCategory = other.m_LogCategory;
+    m_bScheduled = other.m_bScheduled;
+    m_bIdle = other.m_bIdle;
 }
 
 template<class DERIVED_THREAD>
@@ -125,11 +150,76 @@ void WorkerThread<DERIVED_THREAD>::operator()()
     }
 }
 
+template<class DERIVED_THREAD>
+bool WorkerThread<DERIVED_THREAD>::runSlice()
+{
+    // The scheduler's worker profiles and logs under this thread's name while the
+    // slice runs.
+    ThreadProfiler* pProfiler = ThreadProfiler::get();
+    std::string sWorkerName = pProfiler->getName();
+    category_t workerCategory = pProfiler->getLogCategory();
+    pProfiler->setName(m_sName);
+    pProfiler->setLogCategory(m_LogCategory);
+    bool bRunning = true;
+    try {
+        if (!m_bScheduled) {
+            m_bScheduled = true;
+            if (!init()) {
+                bRunning = false;
+            }
+        }
+        if (bRunning) {
+            m_bIdle = false;
+            bool bOK = work();
+            if (!bOK) {
+                m_bShouldStop = true;
+            }
+            if (!m_bShouldStop) {
+                processCommands();
+            }
+            if (m_bShouldStop) {
+                deinit();
+                bRunning = false;
+            }
+        }
+    } catch (const Exception& e) {
+        AVG_LOG_ERROR("Uncaught exception in thread " << m_sName << ": " << e.getStr());
+        pProfiler->setName(sWorkerName);
+        pProfiler->setLogCategory(workerCategory);
+        throw;
+    }
+    pProfiler->setName(sWorkerName);
+    pProfiler->setLogCategory(workerCategory);
+    return bRunning;
+}
+
+template<class DERIVED_THREAD>
+bool WorkerThread<DERIVED_THREAD>::isIdle() const
+{
+    return m_bIdle;
+}
+
+template<class DERIVED_THREAD>
+void WorkerThread<DERIVED_THREAD>::addQueueListener(IQueueListener* pListener)
+{
+    m_CmdQ.addPushListener(pListener);
+}
+
+template<class DERIVED_THREAD>
+void WorkerThread<DERIVED_THREAD>::removeQueueListener(IQueueListener* pListener)
+{
+    m_CmdQ.removeListener(pListener);
+}
+
 template<class DERIVED_THREAD>
 void WorkerThread<DERIVED_THREAD>::waitForCommand() 
 {
-    CmdPtr pCmd = m_CmdQ.pop(true);
-    pCmd->execute(dynamic_cast<DERIVED_THREAD*>(this));
+    CmdPtr pCmd = m_CmdQ.pop(!m_bScheduled);
+    if (pCmd) {
+        pCmd->execute(dynamic_cast<DERIVED_THREAD*>(this));
+    } else {
+        setIdle();
+    }
 }
 
 template<class DERIVED_THREAD>
@@ -144,6 +234,18 @@ int WorkerThread<DERIVED_THREAD>::getNumCmdsInQueue() const
     return m_CmdQ.size();
 }
 
+template<class DERIVED_THREAD>
+bool WorkerThread<DERIVED_THREAD>::isScheduled() const
+{
+    return m_bScheduled;
+}
+
+template<class DERIVED_THREAD>
+void WorkerThread<DERIVED_THREAD>::setIdle()
+{
+    m_bIdle = true;
+}
+
 template<class DERIVED_THREAD>
 bool WorkerThread<DERIVED_THREAD>::init()
 {
@@ -155,6 +257,7 @@ void WorkerThread<DERIVED_THREAD>::processCommands()
 {
     CmdPtr pCmd = m_CmdQ.pop(false);
     while (pCmd && !m_bShouldStop) {
+        m_bIdle = false;
         pCmd->execute(dynamic_cast<DERIVED_THREAD*>(this));
         if (!m_bShouldStop) {
             pCmd = m_CmdQ.pop(false);
@@ -21,8 +21,11 @@
 
 #include "DAG.h"
 #include "Queue.h"
+#include "LockFreeQueue.h"
 #include "Command.h"
 #include "WorkerThread.h"
+#include "TaskScheduler.h"
+#include "WorkerHandle.h"
 #include "ObjectCounter.h"
 #include "Triangulate.h"
 #include "GLMHelper.h"
@@ -42,8 +45,12 @@
 #include "TimeSource.h"
 #include "XMLHelper.h"
 #include "Logger.h"
+#include "ThreadProfiler.h"
+#include "ProfilingZoneID.h"
+#include "ScopeTimer.h"
 
 #include <boost/thread/thread.hpp>
+#include <boost/thread/barrier.hpp>
 
 #include <boost/bind.hpp>
 
@@ -260,11 +267,175 @@ private:
     }
 };
 
+class LockFreeQueueTest: public Test
+{
+public:
+    LockFreeQueueTest()
+        : Test("LockFreeQueueTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        runSingleThreadTests(LockFreeQueue<string>::SPSC);
+        runSingleThreadTests(LockFreeQueue<string>::MPMC);
+        runMultiThreadTests();
+    }
+
+private:
+    typedef LockFreeQueue<int> IntQueue;
+    typedef IntQueue::QElementPtr ElemPtr;
+
+    void runSingleThreadTests(LockFreeQueue<string>::Mode mode)
+    {
+        LockFreeQueue<string> q(3, mode);
+        typedef LockFreeQueue<string>::QElementPtr ElemPtr;
+        TEST(q.getMaxSize() == 4);
+        TEST(q.empty());
+        q.push(ElemPtr(new string("1")));
+        TEST(q.size() == 1);
+        TEST(!q.empty());
+        q.push(ElemPtr(new string("2")));
+        q.push(ElemPtr(new string("3")));
+        TEST(q.size() == 3);
+        TEST(*q.pop() == "1");
+        TEST(*q.pop() == "2");
+        q.push(ElemPtr(new string("4")));
+        q.push(ElemPtr(new string("5")));
+        q.push(ElemPtr(new string("6")));
+        TEST(q.size() == 4);
+        TEST(*q.pop() == "3");
+        if (mode == LockFreeQueue<string>::SPSC) {
+            TEST(*q.peek() == "4");
+        }
+        TEST(*q.pop() == "4");
+        q.clear();
+        TEST(q.empty());
+        ElemPtr pElem = q.pop(false);
+        TEST(!pElem);
+    }
+
+    void runMultiThreadTests()
+    {
+        {
+            IntQueue q(8, IntQueue::SPSC);
+            int sum = 0;
+            thread pusher(boost::bind(&pushThread, &q, 1000));
+            thread popper(boost::bind(&popThread, &q, 1000, &sum));
+            pusher.join();
+            popper.join();
+            TEST(q.empty());
+            TEST(sum == 999*1000/2);
+        }
+        {
+            IntQueue q(8, IntQueue::MPMC);
+            int sum1 = 0;
+            int sum2 = 0;
+            thread pusher1(boost::bind(&pushThread, &q, 1000));
+            thread pusher2(boost::bind(&pushThread, &q, 1000));
+            thread popper1(boost::bind(&popThread, &q, 1000, &sum1));
+            thread popper2(boost::bind(&popThread, &q, 1000, &sum2));
+            pusher1.join();
+            pusher2.join();
+            popper1.join();
+            popper2.join();
+            TEST(q.empty());
+            TEST(sum1+sum2 == 999*1000);
+        }
+    }
+
+    static void pushThread(IntQueue* pq, int numPushes)
+    {
+        for (int i=0; i<numPushes; ++i) {
+            pq->push(ElemPtr(new int(i)));
+        }
+    }
+
+    static void popThread(IntQueue* pq, int numPops, int* pSum)
+    {
+        for (int i=0; i<numPops; ++i) {
+            *pSum += *(pq->pop());
+        }
+    }
+};
+
+class QueueBenchmark: public Test
+{
+public:
+    QueueBenchmark()
+        : Test("QueueBenchmark", 2)
+    {
+    }
+
+    void runTests()
+    {
+        const int numElems = 200000;
+        {
+            Queue<int> q(64);
+            runBenchmark("Queue, 1:1", &q, 1, numElems);
+        }
+        {
+            LockFreeQueue<int> q(64, LockFreeQueue<int>::SPSC);
+            runBenchmark("LockFreeQueue SPSC, 1:1", &q, 1, numElems);
+        }
+        {
+            Queue<int> q(64);
+            runBenchmark("Queue, 4:4", &q, 4, numElems);
+        }
+        {
+            LockFreeQueue<int> q(64, LockFreeQueue<int>::MPMC);
+            runBenchmark("LockFreeQueue MPMC, 4:4", &q, 4, numElems);
+        }
+    }
+
+private:
+    template<class QUEUE>
+    void runBenchmark(const string& sName, QUEUE* pq, int numThreads, int numElems)
+    {
+        // Elements are preallocated so the benchmark measures queue overhead only.
+        typedef vector<typename QUEUE::QElementPtr> ElemVector;
+        vector<ElemVector> elems(numThreads);
+        for (int i=0; i<numThreads; ++i) {
+            for (int j=0; j<numElems/numThreads; ++j) {
+                elems[i].push_back(typename QUEUE::QElementPtr(new int(j)));
+            }
+        }
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        thread_group threads;
+        for (int i=0; i<numThreads; ++i) {
+            threads.create_thread(boost::bind(&pushThread<QUEUE>, pq, &elems[i]));
+            threads.create_thread(boost::bind(&popThread<QUEUE>, pq,
+                    numElems/numThreads));
+        }
+        threads.join_all();
+        long long duration = TimeSource::get()->getCurrentMicrosecs()-startTime;
+        cerr << string(m_IndentLevel+6, ' ') << sName << ": "
+                << float(duration*1000)/numElems << " ns/element" << endl;
+        TEST(pq->empty());
+    }
+
+    template<class QUEUE>
+    static void pushThread(QUEUE* pq, vector<typename QUEUE::QElementPtr>* pElems)
+    {
+        for (unsigned i=0; i<pElems->size(); ++i) {
+            pq->push((*pElems)[i]);
+        }
+    }
+
+    template<class QUEUE>
+    static void popThread(QUEUE* pq, int numPops)
+    {
+        for (int i=0; i<numPops; ++i) {
+            pq->pop();
+        }
+    }
+};
+
 class TestWorkerThread: public WorkerThread<TestWorkerThread>
 {
 public:
-    TestWorkerThread(CQueue& cmdQ, int* pNumFuncCalls, int* pIntParam, 
-            string* pStringParam)
+    TestWorkerThread(CQueue& cmdQ, boost::atomic<int>* pNumFuncCalls,
+            boost::atomic<int>* pIntParam, string* pStringParam)
         : WorkerThread<TestWorkerThread>("Thread1", cmdQ),
           m_pNumFuncCalls(pNumFuncCalls),
           m_pIntParam(pIntParam),
@@ -297,8 +468,8 @@ public:
     }
 
 private:
-    int * m_pNumFuncCalls;
-    int * m_pIntParam;
+    boost::atomic<int> * m_pNumFuncCalls;
+    boost::atomic<int> * m_pIntParam;
     std::string * m_pStringParam;
 };
 
@@ -315,8 +486,8 @@ public:
     {
         TestWorkerThread::CQueue cmdQ;
         boost::thread* pTestThread;
-        int numFuncCalls = 0;
-        int intParam = 0;
+        boost::atomic<int> numFuncCalls(0);
+        boost::atomic<int> intParam(0);
         std::string stringParam;
         cmdQ.pushCmd(boost::bind(&TestWorkerThread::doSomething, _1, 23, "foo"));
         cmdQ.pushCmd(boost::bind(&TestWorkerThread::stop, _1));
@@ -331,6 +502,186 @@ public:
 };
 
 
+class TaskSchedulerTest: public Test
+{
+public:
+    TaskSchedulerTest()
+        : Test("TaskSchedulerTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        TaskScheduler* pScheduler = TaskScheduler::get();
+        TEST(pScheduler->getNumWorkers() > 0);
+        {
+            boost::atomic<int> numTasksRun(0);
+            pScheduler->submitDelayed(boost::bind(&incCounter, &numTasksRun), 20);
+            for (int i=0; i<1000; ++i) {
+                pScheduler->submit(boost::bind(&incCounter, &numTasksRun));
+            }
+            waitForCount(numTasksRun, 1001);
+            TEST(numTasksRun == 1001);
+        }
+        {
+            // WorkerThread running in slices. The delay makes sure the thread goes
+            // idle in between.
+            TestWorkerThread::CQueue cmdQ;
+            boost::atomic<int> numFuncCalls(0);
+            boost::atomic<int> intParam(0);
+            std::string stringParam;
+            typedef ScheduledWorkerHandle<TestWorkerThread> Handle;
+            boost::shared_ptr<Handle> pHandle(new Handle(TestWorkerThread(cmdQ,
+                    &numFuncCalls, &intParam, &stringParam)));
+            pHandle->start();
+            cmdQ.pushCmd(boost::bind(&TestWorkerThread::doSomething, _1, 23, "foo"));
+            waitForCount(intParam, 23);
+            msleep(20);
+            // The idle worker is parked, not polled.
+            int numIdleCalls = numFuncCalls;
+            msleep(20);
+            TEST(numFuncCalls == numIdleCalls);
+            // Pushing a command wakes it up.
+            cmdQ.pushCmd(boost::bind(&TestWorkerThread::doSomething, _1, 42, "bar"));
+            waitForCount(intParam, 42);
+            TEST(intParam == 42);
+            cmdQ.pushCmd(boost::bind(&TestWorkerThread::stop, _1));
+            pHandle->join();
+            TEST(stringParam == "bar");
+            TEST(cmdQ.empty());
+        }
+    }
+
+private:
+    static void incCounter(boost::atomic<int>* pCounter)
+    {
+        (*pCounter)++;
+    }
+
+    void waitForCount(const boost::atomic<int>& counter, int count)
+    {
+        for (int i=0; i<500 && counter != count; ++i) {
+            msleep(10);
+        }
+    }
+};
+
+
+static ProfilingZoneID TraceTestProfilingZone("Trace test zone");
+static ProfilingZoneID TraceThreadProfilingZone("Trace test thread zone");
+static ProfilingZoneID FrameTimeTestProfilingZone("Frame time test zone");
+
+class ThreadProfilerTest: public Test
+{
+public:
+    ThreadProfilerTest()
+        : Test("ThreadProfilerTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        string sFilename = "testtrace.json";
+        ThreadProfiler::enableTracing(true, 16);
+        TEST(ThreadProfiler::isTracingEnabled());
+        ThreadProfiler::get()->addFrameMarker(1);
+        for (int i=0; i<20; ++i) {
+            ScopeTimer timer(TraceTestProfilingZone);
+        }
+        {
+            // The second thread's events must be written while it is still running.
+            boost::barrier barrier(2);
+            boost::thread thread(boost::bind(&ThreadProfilerTest::traceThread, 
+                    &barrier));
+            barrier.wait();
+            ThreadProfiler::writeTrace(sFilename);
+            barrier.wait();
+            thread.join();
+        }
+        string sTrace;
+        readWholeFile(sFilename, sTrace);
+        unlink(sFilename.c_str());
+        TEST(sTrace.find("\"traceEvents\"") != string::npos);
+        TEST(countSubstr(sTrace, "Trace test thread zone") == 2);
+        // The slice's events are on a track of their own.
+        TEST(countSubstr(sTrace, "\"name\":\"TraceTestThread\"") == 1);
+        TEST(countSubstr(sTrace, "\"name\":\"TraceTestSlice\"") == 1);
+        // The ring only holds the last 16 events of the main thread, so the frame
+        // marker is gone and every zone start has a matching end.
+        TEST(sTrace.find("Frame 1") == string::npos);
+        TEST(countSubstr(sTrace, "Trace test zone") == 8);
+        TEST(countSubstr(sTrace, "\"E\"") == 10);
+
+        // Writing took the rings, so the next trace only has the events recorded 
+        // since then.
+        {
+            ScopeTimer timer(TraceTestProfilingZone);
+        }
+        TEST(ThreadProfiler::writeTraceAsync(sFilename));
+        ThreadProfiler::waitForTraceWriter();
+        ThreadProfiler::enableTracing(false, 16);
+        readWholeFile(sFilename, sTrace);
+        unlink(sFilename.c_str());
+        TEST(countSubstr(sTrace, "Trace test zone") == 1);
+        TEST(countSubstr(sTrace, "\"E\"") == 1);
+
+        // Threads started after frame time history was enabled must not turn the
+        // zone timers off.
+        ThreadProfiler* pProfiler = ThreadProfiler::get();
+        pProfiler->enableFrameTimeHistory(true);
+        {
+            boost::thread thread(&ThreadProfilerTest::profilerThread);
+            thread.join();
+        }
+        {
+            ScopeTimer timer(FrameTimeTestProfilingZone);
+            msleep(2);
+        }
+        pProfiler->reset();
+        ThreadProfiler::FrameTimeMap frameTimes = pProfiler->getFrameTimes();
+        const vector<long long>& zoneTimes = frameTimes["Frame time test zone"];
+        TEST(zoneTimes.size() == 1);
+        TEST(!zoneTimes.empty() && zoneTimes[0] > 0);
+        pProfiler->enableFrameTimeHistory(false);
+    }
+
+private:
+    static void traceThread(boost::barrier* pBarrier)
+    {
+        ThreadProfiler* pProfiler = ThreadProfiler::get();
+        pProfiler->setName("TraceTestThread");
+        {
+            ScopeTimer timer(TraceThreadProfilingZone);
+        }
+        // Like a WorkerThread slice run by the TaskScheduler.
+        pProfiler->setName("TraceTestSlice");
+        {
+            ScopeTimer timer(TraceThreadProfilingZone);
+        }
+        pProfiler->setName("TraceTestThread");
+        pBarrier->wait();
+        pBarrier->wait();
+        pProfiler->kill();
+    }
+
+    static void profilerThread()
+    {
+        ThreadProfiler::get()->kill();
+    }
+
+    int countSubstr(const string& s, const string& sSubstr)
+    {
+        int count = 0;
+        string::size_type pos = s.find(sSubstr);
+        while (pos != string::npos) {
+            count++;
+            pos = s.find(sSubstr, pos+1);
+        }
+        return count;
+    }
+};
+
+
 class DummyClass
 {
 public:
@@ -520,6 +871,17 @@ public:
 
     void runTests()
     {
+        // Sleeping doesn't use cpu time, busy waiting does.
+        TimeSource* pTimeSource = TimeSource::get();
+        long long cpuTime = pTimeSource->getThreadCPUMicrosecs();
+        msleep(20);
+        TEST(pTimeSource->getThreadCPUMicrosecs()-cpuTime < 10000);
+        cpuTime = pTimeSource->getThreadCPUMicrosecs();
+        long long endTime = pTimeSource->getCurrentMicrosecs()+20000;
+        while (pTimeSource->getCurrentMicrosecs() < endTime) {
+        }
+        TEST(pTimeSource->getThreadCPUMicrosecs()-cpuTime > 10000);
+
         TEST(getAvgLibPath() != "");
 #ifdef __APPLE__
         TEST(getMemoryUsage() != 0);
@@ -951,6 +1313,124 @@ public:
     }
 };
 
+class AsyncLoggerTest: public Test
+{
+public:
+    AsyncLoggerTest()
+      : Test("AsyncLoggerTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        Logger* pLogger = Logger::get();
+        category_t category = pLogger->configureCategory("ASYNC_TEST",
+                Logger::severity::INFO);
+        int id = pLogger->getCategoryID(category);
+        TEST(pLogger->shouldLog(id, Logger::severity::INFO));
+        TEST(!pLogger->shouldLog(id, Logger::severity::DEBUG));
+        TEST_EXCEPTION(pLogger->getCategoryID("UNKNOWN_CAT"), Exception);
+
+        pLogger->removeStdLogSink();
+        boost::shared_ptr<TestLogSink> pSink(new TestLogSink);
+        pLogger->addLogSink(pSink);
+        pLogger->setAsync(true);
+        TEST(pLogger->isAsync());
+        {
+            // Messages from several threads all arrive.
+            boost::thread thread1(boost::bind(&AsyncLoggerTest::logMessages, category, 
+                    100));
+            boost::thread thread2(boost::bind(&AsyncLoggerTest::logMessages, category, 
+                    100));
+            logMessages(category, 100);
+            thread1.join();
+            thread2.join();
+            pLogger->flush();
+            TEST(pSink->getNumMessages() == 300);
+            TEST(pLogger->getNumDroppedMessages() == 0);
+        }
+        {
+            // The sink thread wakes up for new messages without a flush.
+            logMessages(category, 1);
+            for (int i = 0; i < 100 && pSink->getNumMessages() < 301; ++i) {
+                msleep(10);
+            }
+            TEST(pSink->getNumMessages() == 301);
+        }
+        {
+            // Blocking the sink makes the ring buffer overflow.
+            pSink->block();
+            logMessages(category, 10);
+            msleep(20);
+            logMessages(category, 5000);
+            pSink->unblock();
+            pLogger->flush();
+            TEST(pLogger->getNumDroppedMessages() > 0);
+            TEST(pSink->getNumDropWarnings() == 1);
+        }
+        pLogger->setAsync(false);
+        TEST(!pLogger->isAsync());
+        pLogger->removeLogSink(pSink);
+        pLogger->addStdLogSink();
+    }
+
+private:
+    class TestLogSink: public ILogSink
+    {
+    public:
+        TestLogSink()
+            : m_NumMessages(0),
+              m_NumDropWarnings(0)
+        {
+        }
+
+        virtual void logMessage(const tm* pTime, unsigned millis, 
+                const category_t& category, severity_t severity, const UTF8String& sMsg)
+        {
+            boost::mutex::scoped_lock lock(m_Mutex);
+            if (sMsg.find("dropped") != string::npos) {
+                m_NumDropWarnings++;
+            } else {
+                m_NumMessages++;
+            }
+        }
+
+        void block()
+        {
+            m_Mutex.lock();
+        }
+
+        void unblock()
+        {
+            m_Mutex.unlock();
+        }
+
+        int getNumMessages()
+        {
+            boost::mutex::scoped_lock lock(m_Mutex);
+            return m_NumMessages;
+        }
+
+        int getNumDropWarnings()
+        {
+            boost::mutex::scoped_lock lock(m_Mutex);
+            return m_NumDropWarnings;
+        }
+
+    private:
+        boost::mutex m_Mutex;
+        int m_NumMessages;
+        int m_NumDropWarnings;
+    };
+
+    static void logMessages(const category_t& category, int numMessages)
+    {
+        for (int i = 0; i < numMessages; ++i) {
+            AVG_TRACE_DYNAMIC(category, Logger::severity::INFO, "Async message " << i);
+        }
+    }
+};
+
 class BaseTestSuite: public TestSuite
 {
 public:
@@ -959,7 +1439,11 @@ public:
     {
         addTest(TestPtr(new DAGTest));
         addTest(TestPtr(new QueueTest));
+        addTest(TestPtr(new LockFreeQueueTest));
+        addTest(TestPtr(new QueueBenchmark));
         addTest(TestPtr(new WorkerThreadTest));
+        addTest(TestPtr(new TaskSchedulerTest));
+        addTest(TestPtr(new ThreadProfilerTest));
         addTest(TestPtr(new ObjectCounterTest));
         addTest(TestPtr(new GeomTest));
         addTest(TestPtr(new TriangleTest));
@@ -972,6 +1456,7 @@ public:
         addTest(TestPtr(new BacktraceTest));
         addTest(TestPtr(new XmlParserTest));
         addTest(TestPtr(new StandardLoggerTest));
+        addTest(TestPtr(new AsyncLoggerTest));
     }
 };
 
@@ -24,6 +24,7 @@
 #include "Pixel16.h"
 #include "Pixel8.h"
 #include "Filter3x3.h"
+#include "PixelConverter.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
@@ -161,7 +162,7 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
     if (origBmp.getPixelFormat() == m_PF) {
         const unsigned char * pSrc = origBmp.getPixels();
         unsigned char * pDest = m_pBits;
-        int height = min(origBmp.getSize().y, m_Size.y);
+        int height = min(origBmp.getNumLines(), getNumLines());
         int lineLen = min(origBmp.getLineLen(), getLineLen());
         int srcStride = origBmp.getStride();
         for (int y = 0; y < height; ++y) {
@@ -623,8 +624,9 @@ void Bitmap::setPixels(const unsigned char* pPixels, int stride)
     }
     unsigned char* pDestLine = m_pBits;
     const unsigned char* pSrcLine = pPixels;
-    for (int y=0; y<m_Size.y; y++) {
-        memcpy(pDestLine, pSrcLine, getBytesPerPixel()*m_Size.x);
+    int lineLen = getLineLen();
+    for (int y=0; y<getNumLines(); y++) {
+        memcpy(pDestLine, pSrcLine, lineLen);
         pDestLine += m_Stride;
         pSrcLine += stride;
     }
@@ -649,15 +651,26 @@ int Bitmap::getLineLen() const
 {
     if (m_PF == YCbCr411) {
         return int(m_Size.x*1.5);
+    } else if (pixelFormatIsBlockCompressed(m_PF)) {
+        return ((m_Size.x+3)/4)*getBytesPerBlock(m_PF);
     } else {
         return m_Size.x*getBytesPerPixel();
     }
 }
 
+int Bitmap::getNumLines() const
+{
+    if (pixelFormatIsBlockCompressed(m_PF)) {
+        return (m_Size.y+3)/4;
+    } else {
+        return m_Size.y;
+    }
+}
+
 int Bitmap::getMemNeeded() const
 {
     // This assumes a positive value for stride.
-    return m_Stride*m_Size.y;
+    return m_Stride*getNumLines();
 }
 
 bool Bitmap::hasAlpha() const
@@ -1103,6 +1116,10 @@ void Bitmap::dump(bool bDumpPixels) const
 
 int Bitmap::getPreferredStride(int width, PixelFormat pf)
 {
+    if (pixelFormatIsBlockCompressed(pf)) {
+        // Compressed data is uploaded as is, so lines can't be padded.
+        return ((width+3)/4)*getBytesPerBlock(pf);
+    }
     return (((width*avg::getBytesPerPixel(pf))-1)/4+1)*4;
 }
 
@@ -1124,10 +1141,10 @@ void Bitmap::initWithData(unsigned char * pBits, int stride, bool bCopyBits)
     }
     if (bCopyBits) {
         allocBits();
-        if (m_Stride == stride && stride == (m_Size.x*getBytesPerPixel())) {
-            memcpy(m_pBits, pBits, stride*m_Size.y);
+        if (m_Stride == stride && stride == getLineLen()) {
+            memcpy(m_pBits, pBits, size_t(stride)*getNumLines());
         } else {
-            for (int y = 0; y < m_Size.y; ++y) {
+            for (int y = 0; y < getNumLines(); ++y) {
                 memcpy(m_pBits+m_Stride*y, pBits+stride*y, m_Stride);
             }
         }
@@ -1164,113 +1181,7 @@ void Bitmap::allocBits(int stride)
         // Yuck.
         m_pBits = new unsigned char[size_t(m_Stride+1)*(m_Size.y+1)];
     } else {
-        m_pBits = new unsigned char[size_t(m_Stride)*m_Size.y];
-    }
-}
-
-void YUYV422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int width)
-{
-    Pixel32 * pDestPixel = pDestLine;
-    
-    // We need the previous and next values to interpolate between the
-    // sampled u and v values.
-    int v = *(pSrcLine+3);
-    int v0; // Previous v
-    int u;
-    int u1; // Next u;
-    const unsigned char * pSrcPixels = pSrcLine;
-
-    for (int x = 0; x < width/2-1; x++) {
-        // Two pixels at a time.
-        // Source format is YUYV.
-        u = pSrcPixels[1];
-        v0 = v;
-        v = pSrcPixels[3];
-        u1 = pSrcPixels[5];
-
-        YUVtoBGR32Pixel(pDestPixel, pSrcPixels[0], u, (v0+v)/2);
-        YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[2], (u+u1)/2, v);
-
-        pSrcPixels+=4;
-        pDestPixel+=2;
-    }
-    // Last pixels.
-    u = pSrcPixels[1];
-    v0 = v;
-    v = pSrcPixels[3];
-    YUVtoBGR32Pixel(pDestPixel, pSrcPixels[0], u, v0/2+v/2);
-    YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[2], u, v);
-}
- 
-void UYVY422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int width)
-{
-    Pixel32 * pDestPixel = pDestLine;
-    
-    // We need the previous and next values to interpolate between the
-    // sampled u and v values.
-    int v = *(pSrcLine+2);
-    int v0; // Previous v
-    int u;
-    int u1; // Next u;
-    const unsigned char * pSrcPixels = pSrcLine;
-
-    for (int x = 0; x < width/2-1; x++) {
-        // Two pixels at a time.
-        // Source format is UYVY.
-        u = pSrcPixels[0];
-        v0 = v;
-        v = pSrcPixels[2];
-        u1 = pSrcPixels[4];
-
-        YUVtoBGR32Pixel(pDestPixel, pSrcPixels[1], u, (v0+v)/2);
-        YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[3], (u+u1)/2, v);
-
-        pSrcPixels+=4;
-        pDestPixel+=2;
-    }
-    // Last pixels.
-    u = pSrcPixels[0];
-    v0 = v;
-    v = pSrcPixels[2];
-    YUVtoBGR32Pixel(pDestPixel, pSrcPixels[1], u, v0/2+v/2);
-    YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[3], u, v);
-}
- 
-void YUV411toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int width)
-{
-    Pixel32 * pDestPixel = pDestLine;
-    
-    // We need the previous and next values to interpolate between the
-    // sampled u and v values.
-    int v = *(pSrcLine+3);
-    int v0; // Previous v
-    int v1; // Next v;
-    int u;
-    int u1; // Next u;
-    const unsigned char * pSrcPixels = pSrcLine;
-
-    for (int x = 0; x < width/4; x++) {
-        // Four pixels at a time.
-        // Source format is UYYVYY.
-        u = pSrcPixels[0];
-        v0 = v;
-        v = pSrcPixels[3];
-
-        if (x < width/4-1) {
-            u1 = pSrcPixels[6];
-            v1 = pSrcPixels[9];
-        } else {
-            u1 = u;
-            v1 = v;
-        }
-
-        YUVtoBGR32Pixel(pDestPixel, pSrcPixels[1], u, v0/2+v/2);
-        YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[2], (u*3)/4+u1/4, v0/4+(v*3)/4);
-        YUVtoBGR32Pixel(pDestPixel+2, pSrcPixels[4], u/2+u1/2, v);
-        YUVtoBGR32Pixel(pDestPixel+3, pSrcPixels[5], u/4+(u1*3)/4, (v*3)/4+v1/4);
-
-        pSrcPixels+=6;
-        pDestPixel+=4;
+        m_pBits = new unsigned char[size_t(m_Stride)*getNumLines()];
     }
 }
 
@@ -1282,24 +1193,25 @@ void Bitmap::YCbCrtoBGR(const Bitmap& origBmp)
     int height = min(origBmp.getSize().y, m_Size.y);
     int width = min(origBmp.getSize().x, m_Size.x);
     int StrideInPixels = m_Stride/getBytesPerPixel();
+    const PixelConverter* pConverter = PixelConverter::get();
     switch(origBmp.m_PF) {
         case YCbCr422:
             for (int y = 0; y < height; ++y) {
-                UYVY422toBGR32Line(pSrc, pDest, width);
+                pConverter->UYVY422toBGR32Line(pSrc, pDest, width);
                 pDest += StrideInPixels;
                 pSrc += origBmp.getStride();
             }
             break;
         case YUYV422:
             for (int y = 0; y < height; ++y) {
-                YUYV422toBGR32Line(pSrc, pDest, width);
+                pConverter->YUYV422toBGR32Line(pSrc, pDest, width);
                 pDest += StrideInPixels;
                 pSrc += origBmp.getStride();
             }
             break;
         case YCbCr411:
             for (int y = 0; y < height; ++y) {
-                YUV411toBGR32Line(pSrc, pDest, width);
+                pConverter->YUV411toBGR32Line(pSrc, pDest, width);
                 pDest += StrideInPixels;
                 pSrc += origBmp.getStride();
             }
@@ -1310,28 +1222,6 @@ void Bitmap::YCbCrtoBGR(const Bitmap& origBmp)
     }
 }
     
-void YUYV422toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine, int width)
-{
-    const unsigned char * pSrc = pSrcLine;
-    unsigned char * pDest = pDestLine;
-    for (int x = 0; x < width; x++) {
-        *pDest = *pSrc;
-        pDest++;
-        pSrc+=2;
-    }
-}
- 
-void YUV411toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine, int width)
-{
-    const unsigned char * pSrc = pSrcLine;
-    unsigned char * pDest = pDestLine;
-    for (int x = 0; x < width/2; x++) {
-        *pDest++ = *pSrc++;
-        *pDest++ = *pSrc++;
-        pSrc++;
-    }
-}
- 
 void Bitmap::YCbCrtoI8(const Bitmap& origBmp)
 {
     AVG_ASSERT(origBmp.getBytesPerPixel() == 1);
@@ -1339,26 +1229,27 @@ void Bitmap::YCbCrtoI8(const Bitmap& origBmp)
     unsigned char * pDest = m_pBits;
     int height = min(origBmp.getSize().y, m_Size.y);
     int width = min(origBmp.getSize().x, m_Size.x);
+    const PixelConverter* pConverter = PixelConverter::get();
     switch(origBmp.m_PF) {
         case YCbCr422:
             for (int y = 0; y < height; ++y) {
                 // src shifted by one byte to account for UYVY to YUYV 
                 // difference in pixel order.
-                YUYV422toI8Line(pSrc+1, pDest, width);
+                pConverter->YUYV422toI8Line(pSrc+1, pDest, width);
                 pDest += m_Stride;
                 pSrc += origBmp.getStride();
             }
             break;
         case YUYV422:
             for (int y = 0; y < height; ++y) {
-                YUYV422toI8Line(pSrc, pDest, width);
+                pConverter->YUYV422toI8Line(pSrc, pDest, width);
                 pDest += m_Stride;
                 pSrc += origBmp.getStride();
             }
             break;
         case YCbCr411:
             for (int y = 0; y < height; ++y) {
-                YUV411toI8Line(pSrc, pDest, width);
+                pConverter->YUV411toI8Line(pSrc, pDest, width);
                 pDest += m_Stride;
                 pSrc += origBmp.getStride();
             }
@@ -1417,18 +1308,11 @@ void Bitmap::I8toRGB(const Bitmap& origBmp)
     int height = min(origBmp.getSize().y, m_Size.y);
     int width = min(origBmp.getSize().x, m_Size.x);
     if (getBytesPerPixel() == 4) {
-        unsigned int * pDest = (unsigned int *)m_pBits;
-        int destStrideInPixels = m_Stride/getBytesPerPixel();
+        unsigned char * pDest = m_pBits;
+        const PixelConverter* pConverter = PixelConverter::get();
         for (int y = 0; y < height; ++y) {
-            const unsigned char * pSrcPixel = pSrc;
-            unsigned int * pDestPixel = pDest;
-            for (int x = 0; x < width; ++x) {
-                *pDestPixel = (((((255 << 8)+(*pSrcPixel)) << 8)+
-                        *pSrcPixel) << 8) +(*pSrcPixel);
-                pDestPixel ++;
-                pSrcPixel++;
-            }
-            pDest += destStrideInPixels;
+            pConverter->I8toBGR32Line(pSrc, pDest, width);
+            pDest += m_Stride;
             pSrc += origBmp.getStride();
         }
     } else {
@@ -1456,14 +1340,9 @@ void Bitmap::ByteRGBAtoFloatRGBA(const Bitmap& origBmp)
     int height = min(origBmp.getSize().y, m_Size.y);
     int width = min(origBmp.getSize().x, m_Size.x);
     float * pDest = (float *)m_pBits;
+    const PixelConverter* pConverter = PixelConverter::get();
     for (int y = 0; y < height; ++y) {
-        const unsigned char * pSrcPixel = pSrc;
-        float * pDestPixel = pDest;
-        for (int x = 0; x < width*4; ++x) {
-            *pDestPixel = float(*pSrcPixel)/255;
-            pDestPixel ++;
-            pSrcPixel++;
-        }
+        pConverter->ByteToFloatLine(pSrc, pDest, width*4);
         pDest += m_Stride/sizeof(float);
         pSrc += origBmp.getStride();
     }
@@ -1624,6 +1503,7 @@ void Bitmap::BY8toRGBBilinear(const Bitmap& origBmp)
     pDestPixel += destStride + 4 + 1;
     height -= 2;
     width -= 2;
+    const PixelConverter* pConverter = PixelConverter::get();
 
     while (height--) {
         int t0, t1;
@@ -1640,53 +1520,12 @@ void Bitmap::BY8toRGBBilinear(const Bitmap& origBmp)
             pDestPixel += 4;
         }
                 
-        if (blue > 0) {
-            while (pSrcPixel <= pSrcEndBoundary - 2) {
-                t0 = (pSrcPixel[0] + pSrcPixel[2] + pSrcPixel[doubleSrcStride] +
-                      pSrcPixel[doubleSrcStride + 2] + 2) >> 2;
-                t1 = (pSrcPixel[1] + pSrcPixel[srcStride] +
-                      pSrcPixel[srcStride + 2] + pSrcPixel[doubleSrcStride + 1] +
-                      2) >> 2;
-                pDestPixel[-1] = (unsigned char) t0;
-                pDestPixel[0] = (unsigned char) t1;
-                pDestPixel[1] = pSrcPixel[srcStride + 1];
-                pDestPixel[2] = 255; // Alpha channel
-
-                t0 = (pSrcPixel[2] + pSrcPixel[doubleSrcStride + 2] + 1) >> 1;
-                t1 = (pSrcPixel[srcStride + 1] + pSrcPixel[srcStride + 3] +
-                      1) >> 1;
-                pDestPixel[3] = (unsigned char) t0;
-                pDestPixel[4] = pSrcPixel[srcStride + 2];
-                pDestPixel[5] = (unsigned char) t1;
-                pDestPixel[6] = 255; // Alpha channel
-                
-                pSrcPixel += 2;
-                pDestPixel += 8;
-            }
-        } else {
-            while (pSrcPixel <= pSrcEndBoundary - 2) {
-                t0 = (pSrcPixel[0] + pSrcPixel[2] + pSrcPixel[doubleSrcStride] +
-                      pSrcPixel[doubleSrcStride + 2] + 2) >> 2;
-                t1 = (pSrcPixel[1] + pSrcPixel[srcStride] +
-                      pSrcPixel[srcStride + 2] + pSrcPixel[doubleSrcStride + 1] +
-                      2) >> 2;
-                pDestPixel[1] = (unsigned char) t0;
-                pDestPixel[0] = (unsigned char) t1;
-                pDestPixel[-1] = pSrcPixel[srcStride + 1];
-                pDestPixel[2] = 255; // Alpha channel
-
-                t0 = (pSrcPixel[2] + pSrcPixel[doubleSrcStride + 2] + 1) >> 1;
-                t1 = (pSrcPixel[srcStride + 1] + pSrcPixel[srcStride + 3] +
-                      1) >> 1;
-                pDestPixel[5] = (unsigned char) t0;
-                pDestPixel[4] = pSrcPixel[srcStride + 2];
-                pDestPixel[3] = (unsigned char) t1;
-                pDestPixel[6] = 255; // Alpha channel
-                
-                pSrcPixel += 2;
-                pDestPixel += 8;
-            }
-        }
+        // pDestPixel points to the green channel of the pixel.
+        int numPairs = int(pSrcEndBoundary - pSrcPixel)/2;
+        pConverter->BY8toBGR32BilinearPairs(pSrcPixel, srcStride, pDestPixel-1, numPairs,
+                blue > 0);
+        pSrcPixel += numPairs*2;
+        pDestPixel += numPairs*8;
 
         if (pSrcPixel < pSrcEndBoundary) {
             t0 = (pSrcPixel[0] + pSrcPixel[2] + pSrcPixel[doubleSrcStride] +
@@ -1742,17 +1581,26 @@ void createTrueColorCopy<Pixel32, Pixel8>(Bitmap& destBmp, const Bitmap& srcBmp)
     int width = min(srcBmp.getSize().x, destBmp.getSize().x);
     int srcStride = srcBmp.getStride();
     int destStride = destBmp.getStride();
+    const PixelConverter* pConverter = PixelConverter::get();
     for (int y = 0; y < height; ++y) {
-        const unsigned char * pSrcPixel = pSrcLine;
-        unsigned char * pDestPixel = pDestLine;
-        for (int x = 0; x < width; ++x) {
-            pDestPixel[0] =
-            pDestPixel[1] =
-            pDestPixel[2] = *pSrcPixel;
-            pDestPixel[3] = 255;
-            ++pSrcPixel;
-            pDestPixel+=4;
-        }
+        pConverter->I8toBGR32Line(pSrcLine, pDestLine, width);
+        pSrcLine = pSrcLine + srcStride;
+        pDestLine = pDestLine + destStride;
+    }
+}
+
+template<>
+void createTrueColorCopy<Pixel32, Pixel24>(Bitmap& destBmp, const Bitmap& srcBmp)
+{
+    const unsigned char * pSrcLine = srcBmp.getPixels();
+    unsigned char * pDestLine = destBmp.getPixels();
+    int height = min(srcBmp.getSize().y, destBmp.getSize().y);
+    int width = min(srcBmp.getSize().x, destBmp.getSize().x);
+    int srcStride = srcBmp.getStride();
+    int destStride = destBmp.getStride();
+    const PixelConverter* pConverter = PixelConverter::get();
+    for (int y = 0; y < height; ++y) {
+        pConverter->BGR24toBGR32Line(pSrcLine, pDestLine, width);
         pSrcLine = pSrcLine + srcStride;
         pDestLine = pDestLine + destStride;
     }
@@ -1769,22 +1617,9 @@ void createTrueColorCopy<Pixel8, Pixel32>(Bitmap& destBmp, const Bitmap& srcBmp)
     int destStride = destBmp.getStride();
     bool bRedFirst = (srcBmp.getPixelFormat() == R8G8B8A8) || 
             (srcBmp.getPixelFormat() == R8G8B8X8);
+    const PixelConverter* pConverter = PixelConverter::get();
     for (int y = 0; y<height; ++y) {
-        const unsigned char * pSrcPixel = pSrcLine;
-        unsigned char * pDestPixel = pDestLine;
-        if (bRedFirst) {
-            for (int x = 0; x < width; ++x) {
-                *pDestPixel = ((pSrcPixel[0]*54+pSrcPixel[1]*183+pSrcPixel[2]*19)/256);
-                pSrcPixel+=4;
-                ++pDestPixel;
-            }
-        } else {
-            for (int x = 0; x < width; ++x) {
-                *pDestPixel = ((pSrcPixel[0]*19+pSrcPixel[1]*183+pSrcPixel[2]*54)/256);
-                pSrcPixel+=4;
-                ++pDestPixel;
-            }
-        }
+        pConverter->BGR32toI8Line(pSrcLine, pDestLine, width, bRedFirst);
         pSrcLine = pSrcLine + srcStride;
         pDestLine = pDestLine + destStride;
     }
@@ -79,6 +79,9 @@ public:
     const std::string& getName() const;
     int getBytesPerPixel() const;
     int getLineLen() const;
+    // Number of lines of getStride() bytes. In block-compressed bitmaps, each line 
+    // holds a row of 4x4 blocks.
+    int getNumLines() const;
     int getMemNeeded() const;
     bool hasAlpha() const;
     HistogramPtr getHistogram(int stride = 1) const;
@@ -0,0 +1,417 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "BitmapDiskCache.h"
+
+#include "../base/ConfigMgr.h"
+#include "../base/Directory.h"
+#include "../base/DirEntry.h"
+#include "../base/Exception.h"
+#include "../base/FileHelper.h"
+#include "../base/Logger.h"
+#include "../base/ScopeTimer.h"
+#include "../base/StringHelper.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+#define ENTRY_MAGIC "AVGBMPC1"
+#define ENTRY_EXTENSION ".avgbmp"
+// Pixel data starts at a page boundary so it can be mapped directly.
+#define DATA_ALIGNMENT 4096
+
+namespace avg {
+
+struct EntryHeader {
+    char m_Magic[8];
+    int m_PF;
+    int m_Width;
+    int m_Height;
+    int m_Stride;
+    int m_KeyLen;
+    int m_DataOffset;
+};
+
+#ifndef _WIN32
+// Deletes a Bitmap that points into a mapped cache entry and unmaps the entry.
+class MappedEntryDeleter
+{
+public:
+    MappedEntryDeleter(void* pMem, size_t len)
+        : m_pMem(pMem),
+          m_Len(len)
+    {
+    }
+
+    void operator()(Bitmap* pBmp) const
+    {
+        delete pBmp;
+        munmap(m_pMem, m_Len);
+    }
+
+private:
+    void* m_pMem;
+    size_t m_Len;
+};
+#endif
+
+BitmapDiskCache* BitmapDiskCache::s_pBitmapDiskCache = 0;
+bool BitmapDiskCache::s_bInitialized = false;
+
+void deleteBitmapDiskCache()
+{
+    delete BitmapDiskCache::s_pBitmapDiskCache;
+    BitmapDiskCache::s_pBitmapDiskCache = 0;
+}
+
+BitmapDiskCache* BitmapDiskCache::get()
+{
+    if (!s_bInitialized) {
+        s_bInitialized = true;
+        string sDir;
+        ConfigMgr::get()->getStringOption("scr", "imgdiskcachedir", "", sDir);
+        if (sDir != "") {
+            long long maxSize = 
+                    ConfigMgr::get()->getIntOption("scr", "imgdiskcachesize", 512);
+            s_pBitmapDiskCache = new BitmapDiskCache(sDir, maxSize*1024*1024);
+            atexit(deleteBitmapDiskCache);
+        }
+    }
+    return s_pBitmapDiskCache;
+}
+
+BitmapDiskCache::BitmapDiskCache(const string& sDir, long long maxSize)
+    : m_sDir(sDir),
+      m_MaxSize(maxSize),
+      m_CurSize(0),
+      m_TmpCounter(0)
+{
+    Directory dir(m_sDir);
+    if (dir.open(true) != 0) {
+        throw Exception(AVG_ERR_FILEIO, 
+                "Could not open image disk cache directory '"+m_sDir+"'.");
+    }
+    scanDir();
+    boost::mutex::scoped_lock lock(m_Mutex);
+    trim();
+    AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
+            "Image disk cache: " << m_sDir << ", " << m_Entries.size() << " entries, " 
+            << m_CurSize/(1024*1024) << " of " << m_MaxSize/(1024*1024) << " MB used.");
+}
+
+BitmapDiskCache::~BitmapDiskCache()
+{
+}
+
+static ProfilingZoneID LoadProfilingZone("Image disk cache load", true);
+
+BitmapPtr BitmapDiskCache::load(const string& sFilename, PixelFormat pf, 
+        bool bBlueFirst)
+{
+    ScopeTimer timer(LoadProfilingZone);
+    string sKey;
+    string sEntryName;
+    if (!getKey(sFilename, pf, bBlueFirst, sKey, sEntryName)) {
+        return BitmapPtr();
+    }
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        if (m_Entries.find(sEntryName) == m_Entries.end()) {
+            return BitmapPtr();
+        }
+    }
+    BitmapPtr pBmp = loadEntry(m_sDir+"/"+sEntryName, sKey, sFilename);
+    if (pBmp) {
+        touchEntry(sEntryName);
+    }
+    return pBmp;
+}
+
+static ProfilingZoneID SaveProfilingZone("Image disk cache save", true);
+
+void BitmapDiskCache::save(const string& sFilename, PixelFormat pf, bool bBlueFirst,
+        const Bitmap& bmp)
+{
+    ScopeTimer timer(SaveProfilingZone);
+    string sKey;
+    string sEntryName;
+    if (!getKey(sFilename, pf, bBlueFirst, sKey, sEntryName)) {
+        return;
+    }
+    IntPoint size = bmp.getSize();
+    int lineLen = size.x*bmp.getBytesPerPixel();
+    EntryHeader header;
+    memcpy(header.m_Magic, ENTRY_MAGIC, sizeof(header.m_Magic));
+    header.m_PF = bmp.getPixelFormat();
+    header.m_Width = size.x;
+    header.m_Height = size.y;
+    header.m_Stride = lineLen;
+    header.m_KeyLen = int(sKey.length());
+    int headerLen = int(sizeof(EntryHeader))+header.m_KeyLen;
+    header.m_DataOffset = ((headerLen+DATA_ALIGNMENT-1)/DATA_ALIGNMENT)*DATA_ALIGNMENT;
+    long long entrySize = header.m_DataOffset+(long long)(lineLen)*size.y;
+    if (entrySize > m_MaxSize) {
+        return;
+    }
+
+    // Write to a temporary file first so readers never see incomplete entries.
+    string sPath = m_sDir+"/"+sEntryName;
+    string sTmpPath;
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+#ifdef _WIN32
+        int pid = _getpid();
+#else
+        int pid = getpid();
+#endif
+        sTmpPath = sPath+"."+toString(pid)+"_"+toString(m_TmpCounter)+".tmp";
+        m_TmpCounter++;
+    }
+    FILE* pFile = fopen(sTmpPath.c_str(), "wb");
+    if (!pFile) {
+        AVG_LOG_WARNING("Image disk cache: Could not create " << sTmpPath << ".");
+        return;
+    }
+    bool bOk = fwrite(&header, sizeof(header), 1, pFile) == 1;
+    bOk = bOk && fwrite(sKey.c_str(), header.m_KeyLen, 1, pFile) == 1;
+    vector<char> padding(header.m_DataOffset-headerLen, 0);
+    if (!padding.empty()) {
+        bOk = bOk && fwrite(&padding[0], padding.size(), 1, pFile) == 1;
+    }
+    const unsigned char* pLine = bmp.getPixels();
+    for (int y = 0; y < size.y && bOk; ++y) {
+        bOk = fwrite(pLine, lineLen, 1, pFile) == 1;
+        pLine += bmp.getStride();
+    }
+    bOk = (fclose(pFile) == 0) && bOk;
+#ifdef _WIN32
+    if (bOk) {
+        ::remove(sPath.c_str());
+    }
+#endif
+    if (!bOk || rename(sTmpPath.c_str(), sPath.c_str()) != 0) {
+        AVG_LOG_WARNING("Image disk cache: Could not write " << sPath << ".");
+        ::remove(sTmpPath.c_str());
+        return;
+    }
+    boost::mutex::scoped_lock lock(m_Mutex);
+    addEntry(sEntryName, entrySize);
+    trim();
+}
+
+long long BitmapDiskCache::getSize() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_CurSize;
+}
+
+long long BitmapDiskCache::getMaxSize() const
+{
+    return m_MaxSize;
+}
+
+void BitmapDiskCache::clear()
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    while (!m_Entries.empty()) {
+        removeEntry(m_Entries.begin());
+    }
+}
+
+BitmapDiskCache::EntryInfo::EntryInfo()
+    : m_Size(0),
+      m_LastUsed(0)
+{
+}
+
+BitmapDiskCache::EntryInfo::EntryInfo(long long size, long long lastUsed)
+    : m_Size(size),
+      m_LastUsed(lastUsed)
+{
+}
+
+bool BitmapDiskCache::getKey(const string& sFilename, PixelFormat pf, bool bBlueFirst,
+        string& sKey, string& sEntryName) const
+{
+    struct stat fileInfo;
+    if (stat(sFilename.c_str(), &fileInfo) != 0) {
+        return false;
+    }
+    string sAbsFilename = sFilename;
+    if (!isAbsPath(sFilename)) {
+        sAbsFilename = getCWD()+sFilename;
+    }
+    sKey = sAbsFilename+"|"+toString((long long)fileInfo.st_mtime)+"|"
+            +toString((long long)fileInfo.st_size)+"|"+getPixelFormatString(pf)+"|"
+            +toString(bBlueFirst);
+
+    // 64-bit FNV-1a hash of the key. The key itself is stored in the entry and 
+    // compared on load, so collisions are harmless.
+    unsigned long long hash = 14695981039346656037ULL;
+    for (unsigned i = 0; i < sKey.length(); ++i) {
+        hash ^= (unsigned char)(sKey[i]);
+        hash *= 1099511628211ULL;
+    }
+    char szHash[17];
+    sprintf(szHash, "%08x%08x", (unsigned)(hash >> 32), (unsigned)(hash & 0xFFFFFFFF));
+    sEntryName = string(szHash)+ENTRY_EXTENSION;
+    return true;
+}
+
+BitmapPtr BitmapDiskCache::loadEntry(const string& sPath, const string& sKey,
+        const string& sName) const
+{
+    FILE* pFile = fopen(sPath.c_str(), "rb");
+    if (!pFile) {
+        return BitmapPtr();
+    }
+    EntryHeader header;
+    bool bOk = fread(&header, sizeof(header), 1, pFile) == 1 &&
+            memcmp(header.m_Magic, ENTRY_MAGIC, sizeof(header.m_Magic)) == 0 &&
+            header.m_KeyLen == int(sKey.length());
+    if (bOk) {
+        vector<char> storedKey(header.m_KeyLen);
+        bOk = fread(&storedKey[0], header.m_KeyLen, 1, pFile) == 1 &&
+                memcmp(&storedKey[0], sKey.c_str(), header.m_KeyLen) == 0;
+    }
+    PixelFormat pf = PixelFormat(header.m_PF);
+    IntPoint size(header.m_Width, header.m_Height);
+    long long dataLen = (long long)(header.m_Stride)*header.m_Height;
+    bOk = bOk && header.m_Stride >= size.x*int(getBytesPerPixel(pf));
+    BitmapPtr pBmp;
+#ifdef _WIN32
+    if (bOk) {
+        pBmp = BitmapPtr(new Bitmap(size, pf, sName, header.m_Stride));
+        bOk = fseek(pFile, header.m_DataOffset, SEEK_SET) == 0 &&
+                fread(pBmp->getPixels(), size_t(dataLen), 1, pFile) == 1;
+    }
+    fclose(pFile);
+#else
+    size_t mapLen = size_t(header.m_DataOffset+dataLen);
+    if (bOk) {
+        struct stat fileInfo;
+        bOk = fstat(fileno(pFile), &fileInfo) == 0 && 
+                (long long)(fileInfo.st_size) == (long long)mapLen;
+    }
+    if (bOk) {
+        // Private mapping: Changes to the bitmap don't end up in the cache.
+        void* pMem = mmap(0, mapLen, PROT_READ | PROT_WRITE, MAP_PRIVATE, 
+                fileno(pFile), 0);
+        if (pMem == MAP_FAILED) {
+            bOk = false;
+        } else {
+            unsigned char* pBits = (unsigned char*)pMem + header.m_DataOffset;
+            pBmp = BitmapPtr(new Bitmap(size, pf, pBits, header.m_Stride, false, sName),
+                    MappedEntryDeleter(pMem, mapLen));
+        }
+    }
+    fclose(pFile);
+#endif
+    if (!bOk) {
+        AVG_LOG_WARNING("Image disk cache: Ignoring invalid entry " << sPath << ".");
+        return BitmapPtr();
+    }
+    return pBmp;
+}
+
+void BitmapDiskCache::scanDir()
+{
+    Directory dir(m_sDir);
+    dir.open();
+    boost::mutex::scoped_lock lock(m_Mutex);
+    DirEntryPtr pEntry = dir.getNextEntry();
+    while (pEntry) {
+        string sName = pEntry->getName();
+        if (getExtension(sName) == string(ENTRY_EXTENSION).substr(1)) {
+            struct stat fileInfo;
+            if (stat((m_sDir+"/"+sName).c_str(), &fileInfo) == 0) {
+                m_Entries[sName] = EntryInfo(fileInfo.st_size, fileInfo.st_mtime);
+                m_CurSize += fileInfo.st_size;
+            }
+        }
+        pEntry = dir.getNextEntry();
+    }
+}
+
+void BitmapDiskCache::touchEntry(const string& sEntryName)
+{
+    long long now = time(0);
+    boost::mutex::scoped_lock lock(m_Mutex);
+    EntryMap::iterator it = m_Entries.find(sEntryName);
+    if (it != m_Entries.end() && it->second.m_LastUsed != now) {
+        it->second.m_LastUsed = now;
+        // Persist the access time in the file's mtime for the next scanDir().
+        utime((m_sDir+"/"+sEntryName).c_str(), 0);
+    }
+}
+
+void BitmapDiskCache::addEntry(const string& sEntryName, long long size)
+{
+    EntryMap::iterator it = m_Entries.find(sEntryName);
+    if (it != m_Entries.end()) {
+        m_CurSize -= it->second.m_Size;
+    }
+    m_Entries[sEntryName] = EntryInfo(size, time(0));
+    m_CurSize += size;
+}
+
+void BitmapDiskCache::removeEntry(EntryMap::iterator it)
+{
+    ::remove((m_sDir+"/"+it->first).c_str());
+    m_CurSize -= it->second.m_Size;
+    m_Entries.erase(it);
+}
+
+void BitmapDiskCache::trim()
+{
+    if (m_CurSize <= m_MaxSize) {
+        return;
+    }
+    vector<pair<long long, string> > lruEntries;
+    for (EntryMap::iterator it = m_Entries.begin(); it != m_Entries.end(); ++it) {
+        lruEntries.push_back(make_pair(it->second.m_LastUsed, it->first));
+    }
+    sort(lruEntries.begin(), lruEntries.end());
+    for (unsigned i = 0; i < lruEntries.size() && m_CurSize > m_MaxSize; ++i) {
+        removeEntry(m_Entries.find(lruEntries[i].second));
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _BitmapDiskCache_H_
+#define _BitmapDiskCache_H_
+
+#include "../api.h"
+
+#include "Bitmap.h"
+#include "PixelFormat.h"
+
+#include <boost/thread/mutex.hpp>
+
+#include <string>
+#include <map>
+
+namespace avg {
+
+// Persistent on-disk cache of decoded images, configured by the scr:imgdiskcachedir
+// and scr:imgdiskcachesize options in avgrc. Entries are keyed by the source file's
+// path, modification time and size as well as the requested pixel format, so changed
+// source files are decoded again. On platforms that support it, cached images are
+// memory-mapped instead of read. When the cache grows beyond its size limit, the
+// least recently used entries are deleted. Thread-safe.
+class AVG_API BitmapDiskCache {
+public:
+    // Returns 0 if the disk cache is disabled.
+    static BitmapDiskCache* get();
+    BitmapDiskCache(const std::string& sDir, long long maxSize);
+    virtual ~BitmapDiskCache();
+
+    // Returns an empty BitmapPtr if the image isn't cached.
+    BitmapPtr load(const std::string& sFilename, PixelFormat pf, bool bBlueFirst);
+    void save(const std::string& sFilename, PixelFormat pf, bool bBlueFirst,
+            const Bitmap& bmp);
+
+    long long getSize() const;
+    long long getMaxSize() const;
+    void clear();
+
+private:
+    struct EntryInfo {
+        EntryInfo();
+        EntryInfo(long long size, long long lastUsed);
+        long long m_Size;
+        long long m_LastUsed;
+    };
+    typedef std::map<std::string, EntryInfo> EntryMap;
+
+    bool getKey(const std::string& sFilename, PixelFormat pf, bool bBlueFirst,
+            std::string& sKey, std::string& sEntryName) const;
+    BitmapPtr loadEntry(const std::string& sPath, const std::string& sKey,
+            const std::string& sName) const;
+    void scanDir();
+    void touchEntry(const std::string& sEntryName);
+    void addEntry(const std::string& sEntryName, long long size);
+    void removeEntry(EntryMap::iterator it);
+    void trim();
+
+    std::string m_sDir;
+    long long m_MaxSize;
+    long long m_CurSize;
+    int m_TmpCounter;
+    EntryMap m_Entries;
+    mutable boost::mutex m_Mutex;
+
+    static BitmapDiskCache* s_pBitmapDiskCache;
+    static bool s_bInitialized;
+    friend void deleteBitmapDiskCache();
+};
+
+}
+
+#endif
@@ -21,6 +21,7 @@
 
 #include "BitmapLoader.h"
 
+#include "BitmapDiskCache.h"
 #include "PixelFormat.h"
 #include "Filterfliprgb.h"
 
@@ -47,6 +48,8 @@ void BitmapLoader::init(bool bBlueFirst)
         delete s_pBitmapLoader;
     }
     s_pBitmapLoader = new BitmapLoader(bBlueFirst);
+    // Make sure the disk cache is set up before loader threads use it.
+    BitmapDiskCache::get();
 }
 
 BitmapLoader* BitmapLoader::get() 
@@ -93,6 +96,14 @@ static ProfilingZoneID RGBFlipProfilingZone("RGB<->BGR flip", true);
 BitmapPtr BitmapLoader::load(const UTF8String& sFName, PixelFormat pf) const
 {
     AVG_ASSERT(s_pBitmapLoader != 0);
+    BitmapDiskCache* pDiskCache = BitmapDiskCache::get();
+    if (pDiskCache) {
+        BitmapPtr pBmp = pDiskCache->load(sFName, pf, m_bBlueFirst);
+        if (pBmp) {
+            return pBmp;
+        }
+    }
+    PixelFormat requestedPF = pf;
     GError* pError = 0;
     GdkPixbuf* pPixBuf;
     {
@@ -144,6 +155,9 @@ BitmapPtr BitmapLoader::load(const UTF8String& sFName, PixelFormat pf) const
         pBmp->copyPixels(*pSrcBmp);
     }
     g_object_unref(pPixBuf);
+    if (pDiskCache) {
+        pDiskCache->save(sFName, requestedPF, m_bBlueFirst, *pBmp);
+    }
     return pBmp;
 }
 
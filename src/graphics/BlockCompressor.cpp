@@ -0,0 +1,825 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "BlockCompressor.h"
+
+#include "Bitmap.h"
+
+#include "../base/Exception.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace avg {
+
+// Texels are stored as r, g, b, a. Blocks are arrays of 16 texels in row-major order.
+typedef unsigned char Texel[4];
+
+static const int ETC_MODIFIERS[8][2] = {
+    {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}
+};
+
+static const int EAC_MODIFIERS[16][8] = {
+    {-3, -6,  -9, -15, 2, 5, 8, 14},
+    {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5,  -8, -13, 1, 4, 7, 12},
+    {-2, -4,  -6, -13, 1, 3, 5, 12},
+    {-3, -6,  -8, -12, 2, 5, 7, 11},
+    {-3, -7,  -9, -11, 2, 6, 8, 10},
+    {-4, -7,  -8, -11, 3, 6, 7, 10},
+    {-3, -5,  -8, -11, 2, 4, 7, 10},
+    {-2, -6,  -8, -10, 1, 5, 7,  9},
+    {-2, -5,  -8, -10, 1, 4, 7,  9},
+    {-2, -4,  -8, -10, 1, 3, 7,  9},
+    {-2, -5,  -7, -10, 1, 4, 6,  9},
+    {-3, -4,  -7, -10, 2, 3, 6,  9},
+    {-1, -2,  -3, -10, 0, 1, 2,  9},
+    {-4, -6,  -8,  -9, 3, 5, 7,  8},
+    {-3, -5,  -7,  -9, 2, 4, 6,  8}
+};
+
+static inline int clampByte(int i)
+{
+    return i < 0 ? 0 : (i > 255 ? 255 : i);
+}
+
+static inline int sqr(int i)
+{
+    return i*i;
+}
+
+static inline int colorDist(const unsigned char* pColor1, const unsigned char* pColor2)
+{
+    return sqr(pColor1[0]-pColor2[0]) + sqr(pColor1[1]-pColor2[1]) +
+            sqr(pColor1[2]-pColor2[2]);
+}
+
+// ETC blocks number their pixels column by column.
+static inline int getETCPixelIndex(int texel)
+{
+    return (texel%4)*4 + texel/4;
+}
+
+static void writeBigEndian(unsigned long long bits, unsigned char* pDest)
+{
+    for (int i = 0; i < 8; ++i) {
+        pDest[i] = (unsigned char)(bits >> (56-8*i));
+    }
+}
+
+static unsigned long long readBigEndian(const unsigned char* pSrc)
+{
+    unsigned long long bits = 0;
+    for (int i = 0; i < 8; ++i) {
+        bits = (bits << 8) | pSrc[i];
+    }
+    return bits;
+}
+
+// BC1 color blocks, also used in BC3.
+
+static unsigned short packRGB565(const float* pColor)
+{
+    int r = clampByte(int(pColor[0]+0.5f));
+    int g = clampByte(int(pColor[1]+0.5f));
+    int b = clampByte(int(pColor[2]+0.5f));
+    return (unsigned short)((((r*31+127)/255) << 11) | (((g*63+127)/255) << 5) |
+            ((b*31+127)/255));
+}
+
+static void unpackRGB565(unsigned short color, unsigned char* pColor)
+{
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+    pColor[0] = (unsigned char)((r << 3) | (r >> 2));
+    pColor[1] = (unsigned char)((g << 2) | (g >> 4));
+    pColor[2] = (unsigned char)((b << 3) | (b >> 2));
+    pColor[3] = 255;
+}
+
+static void getBC1Palette(unsigned short color0, unsigned short color1, bool b4Colors,
+        Texel* pPalette)
+{
+    unpackRGB565(color0, pPalette[0]);
+    unpackRGB565(color1, pPalette[1]);
+    for (int i = 0; i < 3; ++i) {
+        int c0 = pPalette[0][i];
+        int c1 = pPalette[1][i];
+        if (b4Colors) {
+            pPalette[2][i] = (unsigned char)((2*c0+c1)/3);
+            pPalette[3][i] = (unsigned char)((c0+2*c1)/3);
+        } else {
+            pPalette[2][i] = (unsigned char)((c0+c1)/2);
+            pPalette[3][i] = 0;
+        }
+    }
+    // The rgb variant of BC1 decodes the fourth three-color mode entry to opaque black.
+    pPalette[2][3] = 255;
+    pPalette[3][3] = 255;
+}
+
+static int fitBC1Indices(const Texel* pTexels, unsigned short color0, 
+        unsigned short color1, unsigned char* pIndices)
+{
+    Texel palette[4];
+    getBC1Palette(color0, color1, true, palette);
+    int err = 0;
+    for (int i = 0; i < 16; ++i) {
+        int bestDist = INT_MAX;
+        for (int j = 0; j < 4; ++j) {
+            int dist = colorDist(pTexels[i], palette[j]);
+            if (dist < bestDist) {
+                bestDist = dist;
+                pIndices[i] = (unsigned char)j;
+            }
+        }
+        err += bestDist;
+    }
+    return err;
+}
+
+static void writeBC1Block(unsigned short color0, unsigned short color1, 
+        unsigned char* pIndices, unsigned char* pDest)
+{
+    // Four color mode needs color0 > color1. Swapping the endpoints swaps the 
+    // palette entries 0/1 and 2/3.
+    if (color0 < color1) {
+        swap(color0, color1);
+        for (int i = 0; i < 16; ++i) {
+            pIndices[i] ^= 1;
+        }
+    }
+    unsigned indexBits = 0;
+    if (color0 != color1) {
+        for (int i = 0; i < 16; ++i) {
+            indexBits |= unsigned(pIndices[i]) << (2*i);
+        }
+    }
+    pDest[0] = (unsigned char)(color0 & 0xff);
+    pDest[1] = (unsigned char)(color0 >> 8);
+    pDest[2] = (unsigned char)(color1 & 0xff);
+    pDest[3] = (unsigned char)(color1 >> 8);
+    for (int i = 0; i < 4; ++i) {
+        pDest[4+i] = (unsigned char)(indexBits >> (8*i));
+    }
+}
+
+static void encodeBC1Block(const Texel* pTexels, unsigned char* pDest)
+{
+    float mean[3] = {0, 0, 0};
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            mean[c] += pTexels[i][c];
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        mean[c] /= 16;
+    }
+    float cov[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+    for (int i = 0; i < 16; ++i) {
+        float diff[3];
+        for (int c = 0; c < 3; ++c) {
+            diff[c] = pTexels[i][c]-mean[c];
+        }
+        for (int c = 0; c < 3; ++c) {
+            for (int d = 0; d < 3; ++d) {
+                cov[c][d] += diff[c]*diff[d];
+            }
+        }
+    }
+
+    // Principal axis by power iteration, starting with the channel of max. variance.
+    int maxChannel = 0;
+    for (int c = 1; c < 3; ++c) {
+        if (cov[c][c] > cov[maxChannel][maxChannel]) {
+            maxChannel = c;
+        }
+    }
+    float axis[3] = {cov[0][maxChannel], cov[1][maxChannel], cov[2][maxChannel]};
+    for (int iter = 0; iter < 8; ++iter) {
+        float newAxis[3];
+        float maxComponent = 0;
+        for (int c = 0; c < 3; ++c) {
+            newAxis[c] = cov[c][0]*axis[0] + cov[c][1]*axis[1] + cov[c][2]*axis[2];
+            maxComponent = max(maxComponent, fabsf(newAxis[c]));
+        }
+        if (maxComponent < 1e-6f) {
+            break;
+        }
+        for (int c = 0; c < 3; ++c) {
+            axis[c] = newAxis[c]/maxComponent;
+        }
+    }
+    float len = sqrtf(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+    float minT = 0;
+    float maxT = 0;
+    if (len > 1e-6f) {
+        for (int c = 0; c < 3; ++c) {
+            axis[c] /= len;
+        }
+        for (int i = 0; i < 16; ++i) {
+            float t = 0;
+            for (int c = 0; c < 3; ++c) {
+                t += (pTexels[i][c]-mean[c])*axis[c];
+            }
+            minT = min(minT, t);
+            maxT = max(maxT, t);
+        }
+    }
+    float end0[3];
+    float end1[3];
+    for (int c = 0; c < 3; ++c) {
+        end0[c] = mean[c] + axis[c]*maxT;
+        end1[c] = mean[c] + axis[c]*minT;
+    }
+    unsigned short color0 = packRGB565(end0);
+    unsigned short color1 = packRGB565(end1);
+    unsigned char indices[16];
+    int err = fitBC1Indices(pTexels, color0, color1, indices);
+
+    // One least squares refinement of the endpoints for the chosen indices.
+    static const float WEIGHTS[4] = {1.f, 0.f, 2.f/3, 1.f/3};
+    float aa = 0;
+    float bb = 0;
+    float ab = 0;
+    float ax[3] = {0, 0, 0};
+    float bx[3] = {0, 0, 0};
+    for (int i = 0; i < 16; ++i) {
+        float a = WEIGHTS[indices[i]];
+        float b = 1-a;
+        aa += a*a;
+        bb += b*b;
+        ab += a*b;
+        for (int c = 0; c < 3; ++c) {
+            ax[c] += a*pTexels[i][c];
+            bx[c] += b*pTexels[i][c];
+        }
+    }
+    float det = aa*bb - ab*ab;
+    if (fabsf(det) > 1e-4f) {
+        for (int c = 0; c < 3; ++c) {
+            end0[c] = (ax[c]*bb - bx[c]*ab)/det;
+            end1[c] = (bx[c]*aa - ax[c]*ab)/det;
+        }
+        unsigned short refined0 = packRGB565(end0);
+        unsigned short refined1 = packRGB565(end1);
+        unsigned char refinedIndices[16];
+        int refinedErr = fitBC1Indices(pTexels, refined0, refined1, refinedIndices);
+        if (refinedErr < err) {
+            color0 = refined0;
+            color1 = refined1;
+            memcpy(indices, refinedIndices, 16);
+        }
+    }
+    writeBC1Block(color0, color1, indices, pDest);
+}
+
+static void decodeBC1Block(const unsigned char* pSrc, bool bBC3, Texel* pTexels)
+{
+    unsigned short color0 = (unsigned short)(pSrc[0] | (pSrc[1] << 8));
+    unsigned short color1 = (unsigned short)(pSrc[2] | (pSrc[3] << 8));
+    Texel palette[4];
+    getBC1Palette(color0, color1, bBC3 || color0 > color1, palette);
+    unsigned indexBits = pSrc[4] | (pSrc[5] << 8) | (pSrc[6] << 16) | 
+            (unsigned(pSrc[7]) << 24);
+    for (int i = 0; i < 16; ++i) {
+        memcpy(pTexels[i], palette[(indexBits >> (2*i)) & 3], 4);
+    }
+}
+
+// BC3 alpha blocks.
+
+static void getBC3AlphaPalette(int alpha0, int alpha1, int* pPalette)
+{
+    pPalette[0] = alpha0;
+    pPalette[1] = alpha1;
+    if (alpha0 > alpha1) {
+        for (int i = 2; i < 8; ++i) {
+            pPalette[i] = ((8-i)*alpha0 + (i-1)*alpha1)/7;
+        }
+    } else {
+        for (int i = 2; i < 6; ++i) {
+            pPalette[i] = ((6-i)*alpha0 + (i-1)*alpha1)/5;
+        }
+        pPalette[6] = 0;
+        pPalette[7] = 255;
+    }
+}
+
+static int fitBC3AlphaIndices(const Texel* pTexels, int alpha0, int alpha1,
+        unsigned char* pIndices)
+{
+    int palette[8];
+    getBC3AlphaPalette(alpha0, alpha1, palette);
+    int err = 0;
+    for (int i = 0; i < 16; ++i) {
+        int bestDist = INT_MAX;
+        for (int j = 0; j < 8; ++j) {
+            int dist = sqr(pTexels[i][3]-palette[j]);
+            if (dist < bestDist) {
+                bestDist = dist;
+                pIndices[i] = (unsigned char)j;
+            }
+        }
+        err += bestDist;
+    }
+    return err;
+}
+
+static void encodeBC3AlphaBlock(const Texel* pTexels, unsigned char* pDest)
+{
+    // Eight interpolated values between min and max or six interpolated values plus 
+    // exact 0 and 255, whichever fits better.
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    int minInnerAlpha = 255;
+    int maxInnerAlpha = 0;
+    for (int i = 0; i < 16; ++i) {
+        int alpha = pTexels[i][3];
+        minAlpha = min(minAlpha, alpha);
+        maxAlpha = max(maxAlpha, alpha);
+        if (alpha != 0 && alpha != 255) {
+            minInnerAlpha = min(minInnerAlpha, alpha);
+            maxInnerAlpha = max(maxInnerAlpha, alpha);
+        }
+    }
+    if (minInnerAlpha > maxInnerAlpha) {
+        minInnerAlpha = 0;
+        maxInnerAlpha = 0;
+    }
+    unsigned char indices[16];
+    int alpha0 = maxAlpha;
+    int alpha1 = minAlpha;
+    int err = fitBC3AlphaIndices(pTexels, alpha0, alpha1, indices);
+    unsigned char innerIndices[16];
+    int innerErr = fitBC3AlphaIndices(pTexels, minInnerAlpha, maxInnerAlpha, 
+            innerIndices);
+    if (innerErr < err) {
+        alpha0 = minInnerAlpha;
+        alpha1 = maxInnerAlpha;
+        memcpy(indices, innerIndices, 16);
+    }
+    unsigned long long indexBits = 0;
+    for (int i = 0; i < 16; ++i) {
+        indexBits |= (unsigned long long)(indices[i]) << (3*i);
+    }
+    pDest[0] = (unsigned char)alpha0;
+    pDest[1] = (unsigned char)alpha1;
+    for (int i = 0; i < 6; ++i) {
+        pDest[2+i] = (unsigned char)(indexBits >> (8*i));
+    }
+}
+
+static void decodeBC3AlphaBlock(const unsigned char* pSrc, Texel* pTexels)
+{
+    int palette[8];
+    getBC3AlphaPalette(pSrc[0], pSrc[1], palette);
+    unsigned long long indexBits = 0;
+    for (int i = 0; i < 6; ++i) {
+        indexBits |= (unsigned long long)(pSrc[2+i]) << (8*i);
+    }
+    for (int i = 0; i < 16; ++i) {
+        pTexels[i][3] = (unsigned char)palette[(indexBits >> (3*i)) & 7];
+    }
+}
+
+// ETC2 color blocks in individual and differential mode.
+
+static inline int getETCModifier(int table, int index)
+{
+    int modifier = ETC_MODIFIERS[table][index & 1];
+    return (index & 2) ? -modifier : modifier;
+}
+
+// Finds the best modifier table and indices for the texels of one half block.
+static int fitETCSubblock(const Texel* pTexels, const int* pSubblock, const int* pBase,
+        int& table, unsigned char* pIndices)
+{
+    int bestErr = INT_MAX;
+    for (int t = 0; t < 8; ++t) {
+        int err = 0;
+        unsigned char indices[8];
+        for (int i = 0; i < 8 && err < bestErr; ++i) {
+            const unsigned char* pTexel = pTexels[pSubblock[i]];
+            int bestDist = INT_MAX;
+            for (int j = 0; j < 4; ++j) {
+                int modifier = getETCModifier(t, j);
+                int dist = sqr(clampByte(pBase[0]+modifier) - pTexel[0]) +
+                        sqr(clampByte(pBase[1]+modifier) - pTexel[1]) +
+                        sqr(clampByte(pBase[2]+modifier) - pTexel[2]);
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    indices[i] = (unsigned char)j;
+                }
+            }
+            err += bestDist;
+        }
+        if (err < bestErr) {
+            bestErr = err;
+            table = t;
+            for (int i = 0; i < 8; ++i) {
+                pIndices[pSubblock[i]] = indices[i];
+            }
+        }
+    }
+    return bestErr;
+}
+
+static void getETCSubblocks(bool bFlip, int subblocks[2][8])
+{
+    // Without flip, the block is split into a left and a right half, with flip into a
+    // top and a bottom half.
+    int numTexels[2] = {0, 0};
+    for (int i = 0; i < 16; ++i) {
+        int x = i%4;
+        int y = i/4;
+        int subblock = bFlip ? y/2 : x/2;
+        subblocks[subblock][numTexels[subblock]++] = i;
+    }
+}
+
+static void encodeETC2RGBBlock(const Texel* pTexels, unsigned char* pDest)
+{
+    int bestErr = INT_MAX;
+    unsigned long long bestBits = 0;
+    for (int flip = 0; flip < 2; ++flip) {
+        int subblocks[2][8];
+        getETCSubblocks(flip != 0, subblocks);
+        float avg[2][3];
+        for (int s = 0; s < 2; ++s) {
+            for (int c = 0; c < 3; ++c) {
+                int sum = 0;
+                for (int i = 0; i < 8; ++i) {
+                    sum += pTexels[subblocks[s][i]][c];
+                }
+                avg[s][c] = sum/8.f;
+            }
+        }
+        for (int bDiff = 0; bDiff < 2; ++bDiff) {
+            // Quantized and expanded base colors.
+            int quantized[2][3];
+            int base[2][3];
+            for (int c = 0; c < 3; ++c) {
+                if (bDiff) {
+                    quantized[0][c] = int(avg[0][c]*31/255 + 0.5f);
+                    int diff = int(avg[1][c]*31/255 + 0.5f) - quantized[0][c];
+                    quantized[1][c] = quantized[0][c] + min(max(diff, -4), 3);
+                    for (int s = 0; s < 2; ++s) {
+                        base[s][c] = (quantized[s][c] << 3) | (quantized[s][c] >> 2);
+                    }
+                } else {
+                    for (int s = 0; s < 2; ++s) {
+                        quantized[s][c] = int(avg[s][c]*15/255 + 0.5f);
+                        base[s][c] = (quantized[s][c] << 4) | quantized[s][c];
+                    }
+                }
+            }
+            int tables[2];
+            unsigned char indices[16];
+            int err = fitETCSubblock(pTexels, subblocks[0], base[0], tables[0], indices)
+                    + fitETCSubblock(pTexels, subblocks[1], base[1], tables[1], indices);
+            if (err < bestErr) {
+                bestErr = err;
+                unsigned hiBits = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int shift = 24-8*c;
+                    if (bDiff) {
+                        int diff = quantized[1][c]-quantized[0][c];
+                        hiBits |= (unsigned(quantized[0][c]) << (shift+3)) |
+                                (unsigned(diff & 7) << shift);
+                    } else {
+                        hiBits |= (unsigned(quantized[0][c]) << (shift+4)) |
+                                (unsigned(quantized[1][c]) << shift);
+                    }
+                }
+                hiBits |= (tables[0] << 5) | (tables[1] << 2) | (bDiff << 1) | flip;
+                unsigned loBits = 0;
+                for (int i = 0; i < 16; ++i) {
+                    int pixel = getETCPixelIndex(i);
+                    loBits |= (unsigned(indices[i] >> 1) << (16+pixel)) | 
+                            (unsigned(indices[i] & 1) << pixel);
+                }
+                bestBits = ((unsigned long long)hiBits << 32) | loBits;
+            }
+        }
+    }
+    writeBigEndian(bestBits, pDest);
+}
+
+// Only decodes the modes encodeETC2RGBBlock() generates, i.e. not the ETC2 T, H and 
+// planar modes.
+static void decodeETC2RGBBlock(const unsigned char* pSrc, Texel* pTexels)
+{
+    unsigned long long bits = readBigEndian(pSrc);
+    unsigned hiBits = unsigned(bits >> 32);
+    unsigned loBits = unsigned(bits & 0xffffffff);
+    bool bDiff = (hiBits & 2) != 0;
+    bool bFlip = (hiBits & 1) != 0;
+    int base[2][3];
+    for (int c = 0; c < 3; ++c) {
+        int shift = 24-8*c;
+        if (bDiff) {
+            int color0 = (hiBits >> (shift+3)) & 31;
+            int diff = (hiBits >> shift) & 7;
+            if (diff >= 4) {
+                diff -= 8;
+            }
+            int color1 = min(max(color0+diff, 0), 31);
+            base[0][c] = (color0 << 3) | (color0 >> 2);
+            base[1][c] = (color1 << 3) | (color1 >> 2);
+        } else {
+            int color0 = (hiBits >> (shift+4)) & 15;
+            int color1 = (hiBits >> shift) & 15;
+            base[0][c] = (color0 << 4) | color0;
+            base[1][c] = (color1 << 4) | color1;
+        }
+    }
+    int tables[2] = {int((hiBits >> 5) & 7), int((hiBits >> 2) & 7)};
+    for (int i = 0; i < 16; ++i) {
+        int x = i%4;
+        int y = i/4;
+        int subblock = bFlip ? y/2 : x/2;
+        int pixel = getETCPixelIndex(i);
+        int index = (((loBits >> (16+pixel)) & 1) << 1) | ((loBits >> pixel) & 1);
+        int modifier = getETCModifier(tables[subblock], index);
+        for (int c = 0; c < 3; ++c) {
+            pTexels[i][c] = (unsigned char)clampByte(base[subblock][c]+modifier);
+        }
+        pTexels[i][3] = 255;
+    }
+}
+
+// EAC alpha blocks.
+
+static int fitEACAlpha(const Texel* pTexels, int base, int table, int multiplier,
+        int maxErr, unsigned char* pIndices)
+{
+    int err = 0;
+    for (int i = 0; i < 16 && err < maxErr; ++i) {
+        int bestDist = INT_MAX;
+        for (int j = 0; j < 8; ++j) {
+            int alpha = clampByte(base + EAC_MODIFIERS[table][j]*multiplier);
+            int dist = sqr(alpha-pTexels[i][3]);
+            if (dist < bestDist) {
+                bestDist = dist;
+                pIndices[i] = (unsigned char)j;
+            }
+        }
+        err += bestDist;
+    }
+    return err;
+}
+
+static void encodeEACAlphaBlock(const Texel* pTexels, unsigned char* pDest)
+{
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for (int i = 0; i < 16; ++i) {
+        minAlpha = min(minAlpha, int(pTexels[i][3]));
+        maxAlpha = max(maxAlpha, int(pTexels[i][3]));
+    }
+    // Table 13 has a zero modifier (index 4), which encodes constant alpha exactly.
+    int bestBase = minAlpha;
+    int bestTable = 13;
+    int bestMultiplier = 1;
+    unsigned char bestIndices[16];
+    memset(bestIndices, 4, 16);
+    if (minAlpha != maxAlpha) {
+        int bestErr = INT_MAX;
+        for (int t = 0; t < 16; ++t) {
+            // The modifiers are sorted so that index 3 is the smallest and index 7 the 
+            // largest one. Try the multipliers that approximately span the alpha range.
+            int minModifier = EAC_MODIFIERS[t][3];
+            int maxModifier = EAC_MODIFIERS[t][7];
+            int multiplier = int(float(maxAlpha-minAlpha)/(maxModifier-minModifier)
+                    + 0.5f);
+            for (int m = max(multiplier-1, 1); m <= min(multiplier+1, 15); ++m) {
+                int base = clampByte(int((minAlpha+maxAlpha)/2.f - 
+                        (minModifier+maxModifier)*m/2.f + 0.5f));
+                unsigned char indices[16];
+                int err = fitEACAlpha(pTexels, base, t, m, bestErr, indices);
+                if (err < bestErr) {
+                    bestErr = err;
+                    bestBase = base;
+                    bestTable = t;
+                    bestMultiplier = m;
+                    memcpy(bestIndices, indices, 16);
+                }
+            }
+        }
+    }
+    unsigned long long bits = ((unsigned long long)bestBase << 56) | 
+            ((unsigned long long)bestMultiplier << 52) | 
+            ((unsigned long long)bestTable << 48);
+    for (int i = 0; i < 16; ++i) {
+        int pixel = getETCPixelIndex(i);
+        bits |= (unsigned long long)(bestIndices[i]) << (45-3*pixel);
+    }
+    writeBigEndian(bits, pDest);
+}
+
+static void decodeEACAlphaBlock(const unsigned char* pSrc, Texel* pTexels)
+{
+    unsigned long long bits = readBigEndian(pSrc);
+    int base = int(bits >> 56);
+    int multiplier = int((bits >> 52) & 15);
+    int table = int((bits >> 48) & 15);
+    for (int i = 0; i < 16; ++i) {
+        int pixel = getETCPixelIndex(i);
+        int index = int((bits >> (45-3*pixel)) & 7);
+        pTexels[i][3] = (unsigned char)clampByte(
+                base + EAC_MODIFIERS[table][index]*multiplier);
+    }
+}
+
+// Bitmap access.
+
+static void getChannelOffsets(PixelFormat pf, int* pOffsets)
+{
+    switch (pf) {
+        case R8G8B8A8:
+        case R8G8B8X8:
+            pOffsets[0] = 0;
+            pOffsets[2] = 2;
+            break;
+        case B8G8R8A8:
+        case B8G8R8X8:
+            pOffsets[0] = 2;
+            pOffsets[2] = 0;
+            break;
+        default:
+            AVG_ASSERT(false);
+    }
+    pOffsets[1] = 1;
+    pOffsets[3] = 3;
+}
+
+static bool isRGBA32(PixelFormat pf)
+{
+    return pf == R8G8B8A8 || pf == R8G8B8X8 || pf == B8G8R8A8 || pf == B8G8R8X8;
+}
+
+// Texels outside of the bitmap are filled with copies of the border texels.
+static void readBlock(const Bitmap& bmp, int blockX, int blockY, Texel* pTexels)
+{
+    IntPoint size = bmp.getSize();
+    int offsets[4];
+    getChannelOffsets(bmp.getPixelFormat(), offsets);
+    bool bAlpha = bmp.hasAlpha();
+    for (int y = 0; y < 4; ++y) {
+        int srcY = min(blockY*4+y, size.y-1);
+        const unsigned char* pLine = bmp.getPixels() + srcY*bmp.getStride();
+        for (int x = 0; x < 4; ++x) {
+            int srcX = min(blockX*4+x, size.x-1);
+            const unsigned char* pPixel = pLine + srcX*4;
+            unsigned char* pTexel = pTexels[y*4+x];
+            for (int c = 0; c < 3; ++c) {
+                pTexel[c] = pPixel[offsets[c]];
+            }
+            pTexel[3] = bAlpha ? pPixel[offsets[3]] : 255;
+        }
+    }
+}
+
+static void writeBlock(const Texel* pTexels, int blockX, int blockY, Bitmap& bmp)
+{
+    IntPoint size = bmp.getSize();
+    int offsets[4];
+    getChannelOffsets(bmp.getPixelFormat(), offsets);
+    for (int y = 0; y < 4 && blockY*4+y < size.y; ++y) {
+        unsigned char* pLine = bmp.getPixels() + (blockY*4+y)*bmp.getStride();
+        for (int x = 0; x < 4 && blockX*4+x < size.x; ++x) {
+            unsigned char* pPixel = pLine + (blockX*4+x)*4;
+            const unsigned char* pTexel = pTexels[y*4+x];
+            for (int c = 0; c < 4; ++c) {
+                pPixel[offsets[c]] = pTexel[c];
+            }
+        }
+    }
+}
+
+PixelFormat getBlockCompressedPF(TexCompression compression, bool bAlpha)
+{
+    switch (compression) {
+        case TEXCOMPRESSION_BC:
+            return bAlpha ? BC3 : BC1;
+        case TEXCOMPRESSION_ETC2:
+            return bAlpha ? ETC2_RGBA8 : ETC2_RGB8;
+        default:
+            AVG_ASSERT(false);
+            return NO_PIXELFORMAT;
+    }
+}
+
+BitmapPtr compressBlocks(const Bitmap& srcBmp, TexCompression compression)
+{
+    return compressBlocks(srcBmp, getBlockCompressedPF(compression, srcBmp.hasAlpha()));
+}
+
+BitmapPtr compressBlocks(const Bitmap& srcBmp, PixelFormat destPF)
+{
+    AVG_ASSERT(pixelFormatIsBlockCompressed(destPF));
+    PixelFormat srcPF = srcBmp.getPixelFormat();
+    if (!isRGBA32(srcPF)) {
+        PixelFormat tempPF = pixelFormatIsBlueFirst(srcPF) ? B8G8R8A8 : R8G8B8A8;
+        if (!pixelFormatHasAlpha(srcPF)) {
+            tempPF = pixelFormatIsBlueFirst(srcPF) ? B8G8R8X8 : R8G8B8X8;
+        }
+        Bitmap tempBmp(srcBmp.getSize(), tempPF, "TempBlockCompression");
+        tempBmp.copyPixels(srcBmp);
+        return compressBlocks(tempBmp, destPF);
+    }
+    IntPoint size = srcBmp.getSize();
+    BitmapPtr pDestBmp(new Bitmap(size, destPF, srcBmp.getName()));
+    int blockSize = getBytesPerBlock(destPF);
+    Texel texels[16];
+    for (int blockY = 0; blockY < pDestBmp->getNumLines(); ++blockY) {
+        unsigned char* pDest = pDestBmp->getPixels() + blockY*pDestBmp->getStride();
+        for (int blockX = 0; blockX < (size.x+3)/4; ++blockX) {
+            readBlock(srcBmp, blockX, blockY, texels);
+            switch (destPF) {
+                case BC1:
+                    encodeBC1Block(texels, pDest);
+                    break;
+                case BC3:
+                    encodeBC3AlphaBlock(texels, pDest);
+                    encodeBC1Block(texels, pDest+8);
+                    break;
+                case ETC2_RGB8:
+                    encodeETC2RGBBlock(texels, pDest);
+                    break;
+                case ETC2_RGBA8:
+                    encodeEACAlphaBlock(texels, pDest);
+                    encodeETC2RGBBlock(texels, pDest+8);
+                    break;
+                default:
+                    AVG_ASSERT(false);
+            }
+            pDest += blockSize;
+        }
+    }
+    return pDestBmp;
+}
+
+BitmapPtr decompressBlocks(const Bitmap& srcBmp, PixelFormat destPF)
+{
+    PixelFormat srcPF = srcBmp.getPixelFormat();
+    AVG_ASSERT(pixelFormatIsBlockCompressed(srcPF));
+    AVG_ASSERT(isRGBA32(destPF));
+    IntPoint size = srcBmp.getSize();
+    BitmapPtr pDestBmp(new Bitmap(size, destPF, srcBmp.getName()));
+    int blockSize = getBytesPerBlock(srcPF);
+    Texel texels[16];
+    for (int blockY = 0; blockY < srcBmp.getNumLines(); ++blockY) {
+        const unsigned char* pSrc = srcBmp.getPixels() + blockY*srcBmp.getStride();
+        for (int blockX = 0; blockX < (size.x+3)/4; ++blockX) {
+            switch (srcPF) {
+                case BC1:
+                    decodeBC1Block(pSrc, false, texels);
+                    break;
+                case BC3:
+                    decodeBC1Block(pSrc+8, true, texels);
+                    decodeBC3AlphaBlock(pSrc, texels);
+                    break;
+                case ETC2_RGB8:
+                    decodeETC2RGBBlock(pSrc, texels);
+                    break;
+                case ETC2_RGBA8:
+                    decodeETC2RGBBlock(pSrc+8, texels);
+                    decodeEACAlphaBlock(pSrc, texels);
+                    break;
+                default:
+                    AVG_ASSERT(false);
+            }
+            writeBlock(texels, blockX, blockY, *pDestBmp);
+            pSrc += blockSize;
+        }
+    }
+    return pDestBmp;
+}
+
+}
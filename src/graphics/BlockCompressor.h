@@ -0,0 +1,55 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _BlockCompressor_H_
+#define _BlockCompressor_H_
+
+#include "../api.h"
+
+#include "PixelFormat.h"
+#include "TexInfo.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// CPU encoders and decoders for block-compressed texture formats. The encoders favour
+// speed over quality: BC1 colors are fit along the principal axis and refined once,
+// ETC2 blocks only use the individual and differential modes (which makes ETC2_RGB8 
+// output valid ETC1 data as well).
+
+// Returns the block-compressed format compression uses for a bitmap.
+PixelFormat AVG_API getBlockCompressedPF(TexCompression compression, bool bAlpha);
+
+// Source bitmaps in formats other than 32 bit rgb(a) are converted first.
+BitmapPtr AVG_API compressBlocks(const Bitmap& srcBmp, TexCompression compression);
+BitmapPtr AVG_API compressBlocks(const Bitmap& srcBmp, PixelFormat destPF);
+
+// destPF must be a 32 bit rgb(a) format.
+BitmapPtr AVG_API decompressBlocks(const Bitmap& srcBmp, PixelFormat destPF);
+
+}
+
+#endif
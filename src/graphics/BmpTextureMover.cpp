@@ -52,15 +52,23 @@ BmpTextureMover::~BmpTextureMover()
 void BmpTextureMover::moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex)
 {
     AVG_ASSERT(pBmp->getSize() == tex.getSize());
+    moveBmpToTextureLines(pBmp, tex, 0);
+    tex.generateMipmaps();
+}
+
+void BmpTextureMover::moveBmpToTextureLines(BitmapPtr pBmp, GLTexture& tex, 
+        int startLine)
+{
+    AVG_ASSERT(pBmp->getSize().x == tex.getSize().x);
+    AVG_ASSERT(startLine >= 0 && startLine+pBmp->getSize().y <= tex.getSize().y);
     AVG_ASSERT(getSize() == pBmp->getSize());
     AVG_ASSERT(pBmp->getPixelFormat() == getPF());
     tex.activate(WrapMode());
     unsigned char * pStartPos = pBmp->getPixels();
-    IntPoint size = tex.getSize();
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y,
+    IntPoint size = pBmp->getSize();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, startLine, size.x, size.y,
             tex.getGLFormat(getPF()), tex.getGLType(getPF()), 
             pStartPos);
-    tex.generateMipmaps();
     GLContext::checkError("BmpTextureMover::moveBmpToTexture: glTexSubImage2D()");
 }
 
@@ -35,6 +35,7 @@ public:
     virtual ~BmpTextureMover();
 
     virtual void moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex);
+    virtual void moveBmpToTextureLines(BitmapPtr pBmp, GLTexture& tex, int startLine);
     virtual BitmapPtr moveTextureToBmp(GLTexture& tex, int mipmapLevel=0);
 
 private:
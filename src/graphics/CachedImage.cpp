@@ -28,6 +28,7 @@
 
 #include "BitmapLoader.h"
 #include "Bitmap.h"
+#include "BlockCompressor.h"
 #include "GLContextManager.h"
 #include "MCTexture.h"
 #include "ImageCache.h"
@@ -48,7 +49,37 @@ CachedImage::CachedImage(const std::string& sFilename, TexCompression compressio
     AVG_TRACE(Logger::category::MEMORY, Logger::severity::INFO, "Loading " << sFilename);
     BitmapPtr pBmp = loadBitmap(m_sFilename);
     m_pBmp = applyCompression(pBmp);
-    incBmpRef(m_Compression);
+    incBmpRef();
+}
+
+CachedImage::CachedImage(const CachedImage& srcImage, TexCompression compression)
+    : m_sFilename(srcImage.m_sFilename),
+      m_bUseMipmaps(false),
+      m_Compression(compression),
+      m_BmpRefCount(0),
+      m_TexRefCount(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    AVG_ASSERT(srcImage.m_Compression == TEXCOMPRESSION_NONE);
+    AVG_ASSERT(isBlockCompression(compression));
+    m_pBmp = applyCompression(srcImage.m_pBmp);
+    incBmpRef();
+}
+
+CachedImage::CachedImage(const std::string& sFilename, TexCompression compression,
+        BitmapPtr pBmp)
+    : m_sFilename(sFilename),
+      m_bUseMipmaps(false),
+      m_Compression(compression),
+      m_BmpRefCount(0),
+      m_TexRefCount(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    if (pixelFormatIsBlockCompressed(pBmp->getPixelFormat())) {
+        m_pBmp = pBmp;
+    } else {
+        m_pBmp = applyCompression(pBmp);
+    }
 }
 
 CachedImage::~CachedImage()
@@ -63,18 +94,14 @@ std::string CachedImage::getFilename() const
     return m_sFilename;
 }
 
-void CachedImage::incBmpRef(TexCompression compression)
+TexCompression CachedImage::getCompression() const
+{
+    return m_Compression;
+}
+
+void CachedImage::incBmpRef()
 {
     m_BmpRefCount++;
-    if (compression == TEXCOMPRESSION_NONE && m_Compression == TEXCOMPRESSION_B5G6R5)
-    {
-        // Reload from disk, making sure the cache knows about the size change
-        int oldSize = m_pBmp->getMemNeeded();
-        m_Compression = compression;
-        BitmapPtr pBmp = loadBitmap(m_sFilename);
-        m_pBmp = applyCompression(pBmp);
-        ImageCache::get()->onSizeChange(pBmp->getMemNeeded()-oldSize, STORAGE_CPU);
-    }
 }
 
 void CachedImage::decBmpRef()
@@ -83,7 +110,7 @@ void CachedImage::decBmpRef()
     m_BmpRefCount--;
     AVG_ASSERT(m_TexRefCount <= m_BmpRefCount);
     if (m_BmpRefCount == 0 && m_TexRefCount == 0) {
-        ImageCache::get()->onImageUnused(m_sFilename, STORAGE_CPU);
+        ImageCache::get()->onImageUnused(m_sFilename, m_Compression, STORAGE_CPU);
     }
 }
 
@@ -95,7 +122,7 @@ void CachedImage::incTexRef(bool bUseMipmaps)
         m_bUseMipmaps = bUseMipmaps;
         if (!m_pTex) {
             createTexture();
-            ImageCache::get()->onTexLoad(m_sFilename);
+            ImageCache::get()->onTexLoad(m_sFilename, m_Compression);
         }
     } else if (bUseMipmaps && !m_bUseMipmaps) {
         m_bUseMipmaps = true;
@@ -110,7 +137,7 @@ void CachedImage::decTexRef()
     AVG_ASSERT(m_TexRefCount >= 1);
     m_TexRefCount--;
     if (m_TexRefCount == 0) {
-        ImageCache::get()->onImageUnused(m_sFilename, STORAGE_GPU);
+        ImageCache::get()->onImageUnused(m_sFilename, m_Compression, STORAGE_GPU);
     }
 }
 
@@ -185,6 +212,8 @@ BitmapPtr CachedImage::applyCompression(BitmapPtr pBmp)
         }
         pDestBmp->copyPixels(*pBmp);
         return pDestBmp;
+    } else if (isBlockCompression(m_Compression)) {
+        return compressBlocks(*pBmp, m_Compression);
     } else {
         return pBmp;
     }
@@ -192,7 +221,9 @@ BitmapPtr CachedImage::applyCompression(BitmapPtr pBmp)
 
 void CachedImage::createTexture()
 {
-    m_pTex = GLContextManager::get()->createTextureFromBmp(m_pBmp, m_bUseMipmaps);
+    // Nodes promote the upload once they're visible.
+    m_pTex = GLContextManager::get()->createTextureFromBmp(m_pBmp, m_bUseMipmaps, false,
+            0, GLContextManager::UPLOAD_PREFETCH);
 }
 
 }
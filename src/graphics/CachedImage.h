@@ -45,11 +45,18 @@ class AVG_API CachedImage
         };
 
         CachedImage(const std::string& sFilename, TexCompression compression);
+        // Block-compresses the bitmap of an uncompressed image.
+        CachedImage(const CachedImage& srcImage, TexCompression compression);
+        // Wraps a bitmap that has already been loaded. Starts out unused. Block-
+        // compressed bitmaps are used as they are, all others are compressed.
+        CachedImage(const std::string& sFilename, TexCompression compression, 
+                BitmapPtr pBmp);
         virtual ~CachedImage();
 
         std::string getFilename() const;
+        TexCompression getCompression() const;
 
-        void incBmpRef(TexCompression compression);
+        void incBmpRef();
         void decBmpRef();
         void incTexRef(bool bUseMipmaps);
         void decTexRef();
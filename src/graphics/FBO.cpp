@@ -25,7 +25,7 @@
 #include "GLContext.h"
 #include "Filterfliprgb.h"
 #include "GLTexture.h"
-#include "PBO.h"
+#include "ReadbackRing.h"
 
 #include "../base/Exception.h"
 #include "../base/StringHelper.h"
@@ -136,48 +136,34 @@ BitmapPtr FBO::getImage(int i) const
 }
 
 void FBO::moveToPBO(int i) const
+{
+    AVG_ASSERT(m_pOutputRing);
+    startReadback(*m_pOutputRing, i);
+}
+ 
+BitmapPtr FBO::getImageFromPBO() const
+{
+    AVG_ASSERT(m_pOutputRing);
+    return m_pOutputRing->getImage(true);
+}
+
+ReadbackRingPtr FBO::createReadbackRing(int numBuffers) const
+{
+    return ReadbackRingPtr(new ReadbackRing(getSize(), getPF(), numBuffers));
+}
+
+void FBO::startReadback(ReadbackRing& ring, int i) const
 {
     AVG_ASSERT(GLContext::getCurrent()->getMemoryMode() == MM_PBO);
+    AVG_ASSERT(ring.getSize() == getSize() && ring.getPF() == getPF());
 #ifndef AVG_ENABLE_EGL
     // Get data directly from the FBO using glReadBuffer. At least on NVidia/Linux, this 
     // is faster than reading stuff from the texture.
     copyToDestTexture();
     glproc::BindFramebuffer(GL_FRAMEBUFFER, m_OutputFBO); 
- 
-    m_pOutputPBO->activate(); 
-    GLContext::checkError("FBO::moveToPBO BindBuffer()"); 
     glReadBuffer(GL_COLOR_ATTACHMENT0+i); 
-    GLContext::checkError("FBO::moveToPBO ReadBuffer()"); 
- 
-    IntPoint size = getSize();
-    PixelFormat pf = getPF();
-    glReadPixels(0, 0, size.x, size.y, GLTexture::getGLFormat(pf),  
-            GLTexture::getGLType(pf), 0); 
-    GLContext::checkError("FBO::moveToPBO ReadPixels()");     
-#endif
-}
- 
-BitmapPtr FBO::getImageFromPBO() const
-{
-#ifdef AVG_ENABLE_EGL
-    AVG_ASSERT(false);
-    return BitmapPtr();
-#else
-    AVG_ASSERT(GLContext::getCurrent()->getMemoryMode() == MM_PBO);
-    m_pOutputPBO->activate(); 
-    GLContext::checkError("FBO::getImageFromPBO BindBuffer()"); 
-
-    IntPoint size = getSize();
-    PixelFormat pf = getPF();
-    BitmapPtr pBmp(new Bitmap(size, pf)); 
-    void * pPBOPixels = glproc::MapBuffer(GL_PIXEL_PACK_BUFFER_EXT, GL_READ_ONLY); 
-    GLContext::checkError("FBO::getImageFromPBO MapBuffer()"); 
-    Bitmap PBOBitmap(size, pf, (unsigned char *)pPBOPixels,  
-            size.x*getBytesPerPixel(pf), false); 
-    pBmp->copyPixels(PBOBitmap); 
-    glproc::UnmapBuffer(GL_PIXEL_PACK_BUFFER_EXT); 
-    GLContext::checkError("FBO::getImageFromPBO UnmapBuffer()"); 
-    return pBmp; 
+    GLContext::checkError("FBO::startReadback ReadBuffer()"); 
+    ring.startReadback();
 #endif
 }
 
@@ -198,7 +184,7 @@ void FBO::init()
     }
 #ifndef AVG_ENABLE_EGL
     if (GLContext::getCurrent()->getMemoryMode() == MM_PBO) {
-        m_pOutputPBO = PBOPtr(new PBO(getSize(), getPF(), GL_STREAM_READ));
+        m_pOutputRing = ReadbackRingPtr(new ReadbackRing(getSize(), getPF(), 1));
     }
 #endif
 
@@ -250,7 +236,7 @@ void FBO::init()
             glproc::BindFramebuffer(GL_FRAMEBUFFER, 0);
             glproc::DeleteFramebuffers(1, &m_FBO);
             glproc::DeleteRenderbuffers(1, &m_ColorBuffer);
-            m_pOutputPBO = PBOPtr();
+            m_pOutputRing = ReadbackRingPtr();
             throwMultisampleError();
         }
         GLContext::checkError("FBO::init: RenderbufferStorageMultisample");
@@ -267,7 +253,7 @@ void FBO::init()
                 glproc::BindFramebuffer(GL_FRAMEBUFFER, 0);
                 glproc::DeleteFramebuffers(1, &m_FBO);
                 glproc::DeleteRenderbuffers(1, &m_ColorBuffer);
-                m_pOutputPBO = PBOPtr();
+                m_pOutputRing = ReadbackRingPtr();
                 throwMultisampleError();
             }
             glproc::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, 
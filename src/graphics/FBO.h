@@ -39,10 +39,8 @@ class GLTexture;
 typedef boost::shared_ptr<GLTexture> GLTexturePtr;
 class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
-#ifndef AVG_ENABLE_EGL
-class PBO;
-typedef boost::shared_ptr<PBO> PBOPtr;
-#endif
+class ReadbackRing;
+typedef boost::shared_ptr<ReadbackRing> ReadbackRingPtr;
 
 
 class AVG_API FBO: public FBOInfo
@@ -57,6 +55,9 @@ public:
     BitmapPtr getImage(int i=0) const;
     void moveToPBO(int i=0) const;
     BitmapPtr getImageFromPBO() const;
+    // Asynchronous readback into a ring of PBOs created by createReadbackRing().
+    ReadbackRingPtr createReadbackRing(int numBuffers) const;
+    void startReadback(ReadbackRing& ring, int i=0) const;
     GLTexturePtr getTex(int i=0) const;
 
     static void checkError(const std::string& sContext);
@@ -64,9 +65,7 @@ public:
 private:
     void init();
 
-#ifndef AVG_ENABLE_EGL
-    PBOPtr m_pOutputPBO;
-#endif
+    ReadbackRingPtr m_pOutputRing;
     GLuint m_FBO;
     std::vector<GLTexturePtr> m_pTextures;
     unsigned m_StencilBuffer;
@@ -53,6 +53,7 @@ GLContext::GLContext(const IntPoint& windowSize)
       m_bCheckedMemoryMode(false),
       m_BlendColor(0.f, 0.f, 0.f, 0.f),
       m_BlendMode(BLEND_ADD),
+      m_NumDrawCalls(0),
       m_MajorGLVersion(-1)
 {
     string sVal;
@@ -287,6 +288,16 @@ void GLContext::bindTexture(unsigned unit, unsigned texID)
     }
 }
 
+void GLContext::incNumDrawCalls()
+{
+    m_NumDrawCalls++;
+}
+
+int GLContext::getNumDrawCalls() const
+{
+    return m_NumDrawCalls;
+}
+
 const GLConfig& GLContext::getConfig()
 {
     return m_GLConfig;
@@ -368,6 +379,41 @@ bool GLContext::arePBOsSupported()
     }
 }
 
+bool GLContext::areFencesSupported()
+{
+    if (isGLES()) {
+        return false;
+    } else {
+        return (m_MajorGLVersion > 3 || (m_MajorGLVersion == 3 && m_MinorGLVersion >= 2)
+                || queryOGLExtension("GL_ARB_sync"));
+    }
+}
+
+bool GLContext::isTexCompressionSupported(PixelFormat pf)
+{
+    switch (pf) {
+        case BC1:
+        case BC3:
+            return queryOGLExtension("GL_EXT_texture_compression_s3tc");
+        case ETC2_RGB8:
+        case ETC2_RGBA8:
+            if (isGLES()) {
+                // GLES contexts report version 2.0 here, but ES 3.0 drivers support 
+                // ETC2 anyway.
+                int major = 0;
+                const char* pVersion = (const char*)glGetString(GL_VERSION);
+                sscanf(pVersion, "OpenGL ES %d", &major);
+                return major >= 3;
+            } else {
+                return m_MajorGLVersion > 4 || 
+                        (m_MajorGLVersion == 4 && m_MinorGLVersion >= 3) ||
+                        queryOGLExtension("GL_ARB_ES3_compatibility");
+            }
+        default:
+            return false;
+    }
+}
+
 OGLMemoryMode GLContext::getMemoryMode()
 {
     if (!m_bCheckedMemoryMode) {
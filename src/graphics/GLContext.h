@@ -25,6 +25,7 @@
 
 #include "GLBufferCache.h"
 #include "GLConfig.h"
+#include "PixelFormat.h"
 
 #include "../base/GLMHelper.h"
 
@@ -63,6 +64,10 @@ public:
     bool isBlendModeSupported(BlendMode mode) const;
     void bindTexture(unsigned unit, unsigned texID);
 
+    // Number of glDraw* calls issued in this context so far.
+    void incNumDrawCalls();
+    int getNumDrawCalls() const;
+
     const GLConfig& getConfig();
     void logConfig();
     size_t getVideoMemInstalled();
@@ -70,6 +75,8 @@ public:
     int getMaxTexSize();
     bool usePOTTextures();
     bool arePBOsSupported();
+    bool areFencesSupported();
+    bool isTexCompressionSupported(PixelFormat pf);
     OGLMemoryMode getMemoryMode();
     bool isGLES() const;
     bool isVendor(const std::string& sWantedVendor) const;
@@ -126,6 +133,8 @@ private:
     bool m_bPremultipliedAlpha;
     unsigned m_BoundTextures[16];
 
+    int m_NumDrawCalls;
+
     int m_MajorGLVersion;
     int m_MinorGLVersion;
 
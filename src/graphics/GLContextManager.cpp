@@ -25,6 +25,7 @@
 #include "../base/Logger.h"
 #include "../base/Backtrace.h"
 #include "../base/ScopeTimer.h"
+#include "../base/ConfigMgr.h"
 
 #include "GLTexture.h"
 #include "MCTexture.h"
@@ -62,16 +63,37 @@ bool GLContextManager::isActive()
     return s_pGLContextManager != 0 && (s_pGLContextManager->m_pContexts.size() > 0);
 }
 
+GLContextManager::DeferredTexUpload::DeferredTexUpload(MCTexturePtr pTex, 
+        BitmapPtr pBmp, UploadPriority priority)
+    : m_pTex(pTex),
+      m_pBmp(pBmp),
+      m_Priority(priority),
+      m_NextLine(0),
+      m_NumLines(0)
+{
+}
+
 GLContextManager::GLContextManager()
+    : m_bTexUploadsPlanned(false),
+      m_FrameTexUploadBytes(0),
+      m_MaxFrameTexUploadBytes(0),
+      m_TotalTexUploadBytes(0),
+      m_NumFrames(0),
+      m_NumDeferredFrames(0),
+      m_MaxNumDeferred(0)
 {
 //    AVG_ASSERT(!s_pGLContextManager);
     s_pGLContextManager = this;
+    int budgetKB = ConfigMgr::get()->getIntOption("scr", "texuploadbudget", 0);
+    setTexUploadBudget(budgetKB*1024);
 }
 
 GLContextManager::~GLContextManager()
 {
     m_pPendingTexCreates.clear();
     m_pPendingTexUploads.clear();
+    m_PendingTexLinesUploads.clear();
+    m_DeferredTexUploads.clear();
     m_PendingTexDeletes.clear();
 
     m_pPendingFBOCreates.clear();
@@ -164,20 +186,77 @@ void GLContextManager::createShader(const string& sID)
     pContext->activate();
 }
 
-void GLContextManager::scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp)
+void GLContextManager::scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp,
+        UploadPriority priority)
+{
+    // A new upload replaces a pending deferred one but keeps its priority.
+    DeferredTexUploadList::iterator it;
+    for (it = m_DeferredTexUploads.begin(); it != m_DeferredTexUploads.end(); ++it) {
+        if (it->m_pTex == pTex) {
+            priority = min(priority, it->m_Priority);
+            m_DeferredTexUploads.erase(it);
+            break;
+        }
+    }
+    m_PendingTexLinesUploads.erase(pTex);
+    if (priority == UPLOAD_IMMEDIATE || m_TexUploadBudget == 0) {
+        m_pPendingTexUploads[pTex] = pBmp;
+        pTex->setResident(true);
+    } else {
+        m_pPendingTexUploads.erase(pTex);
+        m_DeferredTexUploads.push_back(DeferredTexUpload(pTex, pBmp, priority));
+        pTex->setResident(false);
+    }
+}
+
+void GLContextManager::scheduleTexLinesUpload(MCTexturePtr pTex, BitmapPtr pBmp,
+        int startLine, int numLines)
 {
-    m_pPendingTexUploads[pTex] = pBmp;
+    AVG_ASSERT(numLines > 0 && startLine+numLines <= pBmp->getSize().y);
+    if (m_pPendingTexUploads.find(pTex) != m_pPendingTexUploads.end()) {
+        // The complete bitmap is uploaded anyway.
+        return;
+    }
+    TexLinesUploadMap::iterator it = m_PendingTexLinesUploads.find(pTex);
+    if (it == m_PendingTexLinesUploads.end()) {
+        TexLinesUpload upload;
+        upload.m_pBmp = pBmp;
+        upload.m_StartLine = startLine;
+        upload.m_EndLine = startLine+numLines;
+        m_PendingTexLinesUploads[pTex] = upload;
+    } else {
+        TexLinesUpload& upload = it->second;
+        AVG_ASSERT(upload.m_pBmp == pBmp);
+        upload.m_StartLine = min(upload.m_StartLine, startLine);
+        upload.m_EndLine = max(upload.m_EndLine, startLine+numLines);
+    }
 }
 
 MCTexturePtr GLContextManager::createTextureFromBmp(BitmapPtr pBmp, bool bMipmap,
-        bool bForcePOT, int potBorderColor)
+        bool bForcePOT, int potBorderColor, UploadPriority priority)
 {
     MCTexturePtr pTex = createTexture(pBmp->getSize(), pBmp->getPixelFormat(), bMipmap,
             bForcePOT, potBorderColor);
-    scheduleTexUpload(pTex, pBmp);
+    scheduleTexUpload(pTex, pBmp, priority);
     return pTex;
 }
 
+void GLContextManager::promoteTexUpload(const MCTexturePtr& pTex)
+{
+    DeferredTexUploadList::iterator it;
+    for (it = m_DeferredTexUploads.begin(); it != m_DeferredTexUploads.end(); ++it) {
+        if (it->m_pTex == pTex) {
+            it->m_Priority = min(it->m_Priority, UPLOAD_VISIBLE);
+            return;
+        }
+    }
+}
+
+int GLContextManager::getNumDeferredTexUploads() const
+{
+    return int(m_DeferredTexUploads.size());
+}
+
 void GLContextManager::deleteTexture(unsigned texID)
 {
     m_PendingTexDeletes.push_back(texID);
@@ -208,6 +287,7 @@ void GLContextManager::uploadData()
 }
 
 static ProfilingZoneID UploadDataProfilingZone("uploadData");
+static ProfilingZoneID DeferredUploadProfilingZone("uploadData: deferred textures");
 
 void GLContextManager::uploadDataForContext()
 {
@@ -237,6 +317,31 @@ void GLContextManager::uploadDataForContext()
         BitmapPtr pBmp = it->second;
         pTex->moveBmpToTexture(pContext, pBmp);
     }
+    TexLinesUploadMap::iterator linesIt;
+    for (linesIt = m_PendingTexLinesUploads.begin(); 
+            linesIt != m_PendingTexLinesUploads.end(); ++linesIt)
+    {
+        const TexLinesUpload& upload = linesIt->second;
+        linesIt->first->moveBmpLinesToTexture(pContext, upload.m_pBmp, 
+                upload.m_StartLine, upload.m_EndLine-upload.m_StartLine);
+    }
+
+    if (!m_bTexUploadsPlanned) {
+        // All contexts need to get the same lines, so this is only done once per frame.
+        planDeferredTexUploads();
+    }
+    if (!m_DeferredTexUploads.empty()) {
+        ScopeTimer deferredTimer(DeferredUploadProfilingZone);
+        DeferredTexUploadList::iterator deferredIt;
+        for (deferredIt = m_DeferredTexUploads.begin(); 
+                deferredIt != m_DeferredTexUploads.end(); ++deferredIt)
+        {
+            if (deferredIt->m_NumLines > 0) {
+                deferredIt->m_pTex->moveBmpLinesToTexture(pContext, deferredIt->m_pBmp,
+                        deferredIt->m_NextLine, deferredIt->m_NumLines);
+            }
+        }
+    }
 
     for (unsigned i=0; i<m_pPendingFBOCreates.size(); ++i) {
         m_pPendingFBOCreates[i]->initForGLContext();
@@ -251,7 +356,21 @@ void GLContextManager::uploadDataForContext()
 void GLContextManager::reset()
 {
     m_pPendingTexCreates.clear();
+    TexUploadMap::iterator it;
+    for (it=m_pPendingTexUploads.begin(); it!=m_pPendingTexUploads.end(); ++it) {
+        m_FrameTexUploadBytes += it->second->getLineLen()*it->second->getNumLines();
+    }
     m_pPendingTexUploads.clear();
+    TexLinesUploadMap::iterator linesIt;
+    for (linesIt = m_PendingTexLinesUploads.begin(); 
+            linesIt != m_PendingTexLinesUploads.end(); ++linesIt)
+    {
+        const TexLinesUpload& upload = linesIt->second;
+        m_FrameTexUploadBytes += upload.m_pBmp->getLineLen()*
+                (upload.m_EndLine-upload.m_StartLine);
+    }
+    m_PendingTexLinesUploads.clear();
+    finishDeferredTexUploads();
     m_PendingTexDeletes.clear();
 
     m_pPendingFBOCreates.clear();
@@ -261,6 +380,57 @@ void GLContextManager::reset()
     m_PendingBufferDeletes.clear();
 }
 
+void GLContextManager::setTexUploadBudget(int bytesPerFrame)
+{
+    AVG_ASSERT(bytesPerFrame >= 0);
+    m_TexUploadBudget = bytesPerFrame;
+    m_TexUploadBytesLeft = bytesPerFrame;
+}
+
+int GLContextManager::getTexUploadBudget() const
+{
+    return m_TexUploadBudget;
+}
+
+void GLContextManager::startFrame()
+{
+    int numDeferred = int(m_DeferredTexUploads.size());
+    if (m_FrameTexUploadBytes > 0 || numDeferred > 0) {
+        AVG_TRACE(Logger::category::PROFILE, Logger::severity::DEBUG,
+                "Texture uploads: " << m_FrameTexUploadBytes/1024 << " KB, " 
+                << numDeferred << " deferred");
+    }
+    m_TotalTexUploadBytes += m_FrameTexUploadBytes;
+    m_MaxFrameTexUploadBytes = max(m_MaxFrameTexUploadBytes, m_FrameTexUploadBytes);
+    if (numDeferred > 0) {
+        m_NumDeferredFrames++;
+        m_MaxNumDeferred = max(m_MaxNumDeferred, numDeferred);
+    }
+    m_NumFrames++;
+    m_FrameTexUploadBytes = 0;
+    m_TexUploadBytesLeft = m_TexUploadBudget;
+}
+
+void GLContextManager::dumpTexUploadStatistics()
+{
+    if (m_NumFrames > 0 && m_TotalTexUploadBytes > 0) {
+        AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                "Texture upload statistics: ");
+        AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                "  Uploaded: " << m_TotalTexUploadBytes/1024 << " KB, " 
+                << m_TotalTexUploadBytes/m_NumFrames/1024 << " KB/frame avg., "
+                << m_MaxFrameTexUploadBytes/1024 << " KB/frame max.");
+        AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                "  Deferred: " << m_NumDeferredFrames << " of " << m_NumFrames 
+                << " frames, max. " << m_MaxNumDeferred << " textures");
+    }
+    m_MaxFrameTexUploadBytes = 0;
+    m_TotalTexUploadBytes = 0;
+    m_NumFrames = 0;
+    m_NumDeferredFrames = 0;
+    m_MaxNumDeferred = 0;
+}
+
 bool GLContextManager::isGLESSupported()
 {
 #if defined __linux__
@@ -274,4 +444,76 @@ bool GLContextManager::isGLESSupported()
 #endif
 }
 
+static int getPixelLinesPerBmpLine(const BitmapPtr& pBmp)
+{
+    if (pixelFormatIsBlockCompressed(pBmp->getPixelFormat())) {
+        return 4;
+    } else {
+        return 1;
+    }
+}
+
+void GLContextManager::planDeferredTexUploads()
+{
+    m_bTexUploadsPlanned = true;
+    // Drop uploads to textures that aren't used anymore.
+    DeferredTexUploadList::iterator it = m_DeferredTexUploads.begin();
+    while (it != m_DeferredTexUploads.end()) {
+        if (it->m_pTex.unique()) {
+            it = m_DeferredTexUploads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    planDeferredTexUploads(UPLOAD_VISIBLE);
+    planDeferredTexUploads(UPLOAD_PREFETCH);
+}
+
+void GLContextManager::planDeferredTexUploads(UploadPriority priority)
+{
+    DeferredTexUploadList::iterator it;
+    for (it = m_DeferredTexUploads.begin(); it != m_DeferredTexUploads.end(); ++it) {
+        if (it->m_Priority != priority) {
+            continue;
+        }
+        int numLines = it->m_pBmp->getSize().y - it->m_NextLine;
+        if (m_TexUploadBudget > 0) {
+            // Bitmap lines, i.e. rows of blocks for block-compressed bitmaps.
+            int linesPerBmpLine = getPixelLinesPerBmpLine(it->m_pBmp);
+            int numBmpLines = (numLines+linesPerBmpLine-1)/linesPerBmpLine;
+            int lineBytes = max(it->m_pBmp->getLineLen(), 1);
+            numBmpLines = min(numBmpLines, m_TexUploadBytesLeft/lineBytes);
+            if (numBmpLines == 0 && m_TexUploadBytesLeft == m_TexUploadBudget) {
+                // Lines bigger than the budget still need to get uploaded sometime.
+                numBmpLines = 1;
+            }
+            if (numBmpLines == 0) {
+                return;
+            }
+            m_TexUploadBytesLeft = max(m_TexUploadBytesLeft-numBmpLines*lineBytes, 0);
+            numLines = min(numLines, numBmpLines*linesPerBmpLine);
+        }
+        it->m_NumLines = numLines;
+    }
+}
+
+void GLContextManager::finishDeferredTexUploads()
+{
+    DeferredTexUploadList::iterator it = m_DeferredTexUploads.begin();
+    while (it != m_DeferredTexUploads.end()) {
+        int linesPerBmpLine = getPixelLinesPerBmpLine(it->m_pBmp);
+        m_FrameTexUploadBytes += (it->m_NumLines+linesPerBmpLine-1)/linesPerBmpLine*
+                it->m_pBmp->getLineLen();
+        it->m_NextLine += it->m_NumLines;
+        it->m_NumLines = 0;
+        if (it->m_NextLine >= it->m_pBmp->getSize().y) {
+            it->m_pTex->setResident(true);
+            it = m_DeferredTexUploads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_bTexUploadsPlanned = false;
+}
+
 }
@@ -28,6 +28,7 @@
 #include "MCShaderParam.h"
 
 #include <map>
+#include <list>
 
 struct SDL_SysWMinfo;
 
@@ -75,9 +76,22 @@ public:
         return pParam;
     }
 
-    void scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp);
+    // IMMEDIATE uploads happen before the next render. VISIBLE and PREFETCH uploads are
+    // spread over several frames if a texture upload budget is set, VISIBLE ones first.
+    // The texture isn't resident until the upload is complete.
+    enum UploadPriority {UPLOAD_IMMEDIATE, UPLOAD_VISIBLE, UPLOAD_PREFETCH};
+
+    void scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp,
+            UploadPriority priority=UPLOAD_IMMEDIATE);
+    // Uploads a part of the bitmap before the next render. Line ranges scheduled for
+    // the same texture in one frame are merged.
+    void scheduleTexLinesUpload(MCTexturePtr pTex, BitmapPtr pBmp, int startLine,
+            int numLines);
     MCTexturePtr createTextureFromBmp(BitmapPtr pBmp, bool bMipmap=false, 
-            bool bForcePOT=false, int potBorderColor=0);
+            bool bForcePOT=false, int potBorderColor=0,
+            UploadPriority priority=UPLOAD_IMMEDIATE);
+    void promoteTexUpload(const MCTexturePtr& pTex);
+    int getNumDeferredTexUploads() const;
     void deleteTexture(unsigned texID);
 
     VertexArrayPtr createVertexArray(int reserveVerts = 0, int reserveIndexes = 0);
@@ -88,16 +102,57 @@ public:
     void uploadDataForContext();
     void reset();
 
+    // Maximum number of bytes of deferred texture data uploaded per frame. 0 means 
+    // no limit.
+    void setTexUploadBudget(int bytesPerFrame);
+    int getTexUploadBudget() const;
+    void startFrame();
+    void dumpTexUploadStatistics();
+
     static bool isGLESSupported();
 
 private:
+    void planDeferredTexUploads();
+    void planDeferredTexUploads(UploadPriority priority);
+    void finishDeferredTexUploads();
+
     std::vector<GLContext*> m_pContexts;
 
     std::vector<MCTexturePtr> m_pPendingTexCreates;
     typedef std::map<MCTexturePtr, BitmapPtr> TexUploadMap;
     TexUploadMap m_pPendingTexUploads;
+    struct TexLinesUpload {
+        BitmapPtr m_pBmp;
+        int m_StartLine;
+        int m_EndLine;
+    };
+    typedef std::map<MCTexturePtr, TexLinesUpload> TexLinesUploadMap;
+    TexLinesUploadMap m_PendingTexLinesUploads;
     std::vector<unsigned> m_PendingTexDeletes;
 
+    struct DeferredTexUpload {
+        DeferredTexUpload(MCTexturePtr pTex, BitmapPtr pBmp, UploadPriority priority);
+
+        MCTexturePtr m_pTex;
+        BitmapPtr m_pBmp;
+        UploadPriority m_Priority;
+        int m_NextLine;
+        // Number of lines uploaded in the current frame.
+        int m_NumLines;
+    };
+    typedef std::list<DeferredTexUpload> DeferredTexUploadList;
+    DeferredTexUploadList m_DeferredTexUploads;
+    bool m_bTexUploadsPlanned;
+    int m_TexUploadBudget;
+    int m_TexUploadBytesLeft;
+
+    int m_FrameTexUploadBytes;
+    int m_MaxFrameTexUploadBytes;
+    long long m_TotalTexUploadBytes;
+    int m_NumFrames;
+    int m_NumDeferredFrames;
+    int m_MaxNumDeferred;
+
     std::vector<MCFBOPtr> m_pPendingFBOCreates;
     std::vector<MCShaderParamPtr> m_pPendingShaderParamCreates;
 
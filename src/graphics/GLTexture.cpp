@@ -80,9 +80,22 @@ void GLTexture::init()
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     IntPoint size = getGLSize();
     PixelFormat pf = getPF();
-    glTexImage2D(GL_TEXTURE_2D, 0, getGLInternalFormat(), size.x, size.y, 0,
-            getGLFormat(pf), getGLType(pf), 0);
-    GLContext::checkError("GLTexture: glTexImage2D()");
+    if (pixelFormatIsBlockCompressed(pf)) {
+        // Not all implementations accept compressed textures without data. Zeroed
+        // blocks decode to (almost) transparent black, so this also takes care of 
+        // the POT border.
+        int texMemNeeded = getMemNeeded();
+        char * pBlocks = new char[texMemNeeded];
+        memset(pBlocks, 0, texMemNeeded);
+        glproc::CompressedTexImage2D(GL_TEXTURE_2D, 0, getGLInternalFormat(), 
+                size.x, size.y, 0, texMemNeeded, pBlocks);
+        GLContext::checkError("GLTexture::init: glCompressedTexImage2D()");
+        delete[] pBlocks;
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, getGLInternalFormat(), size.x, size.y, 0,
+                getGLFormat(pf), getGLType(pf), 0);
+        GLContext::checkError("GLTexture: glTexImage2D()");
+    }
     if (getUseMipmap()) {
         glproc::GenerateMipmap(GL_TEXTURE_2D);
         GLContext::checkError("GLTexture::GLTexture generateMipmap()");
@@ -93,7 +106,7 @@ void GLTexture::init()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_WrapMode.getS());
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_WrapMode.getT());
 
-    if (getUsePOT()) {
+    if (getUsePOT() && !pixelFormatIsBlockCompressed(pf)) {
         // Make sure the texture is transparent and black before loading stuff 
         // into it to avoid garbage at the borders.
         // In the case of UV textures, we set the border color to 128...
@@ -129,17 +142,39 @@ void GLTexture::generateMipmaps()
 
 void GLTexture::moveBmpToTexture(BitmapPtr pBmp)
 {
-    unsigned usage = GL_DYNAMIC_DRAW;
-    if (getPF() == A8 && m_pContext->isVendor("ATI")) {
-        // Workaround for https://github.com/libavg/libavg/issues/687
-        usage = GL_STATIC_DRAW;
+    if (pixelFormatIsBlockCompressed(getPF())) {
+        moveCompressedBmpToTexture(pBmp, 0, pBmp->getSize().y);
+        return;
     }
-    TextureMoverPtr pMover = TextureMover::create(getSize(), getPF(), usage);
+    TextureMoverPtr pMover = TextureMover::create(getSize(), getPF(), getUploadUsage());
     pMover->moveBmpToTexture(pBmp, *this);
 }
 
+void GLTexture::moveBmpLinesToTexture(BitmapPtr pBmp, int startLine, int numLines)
+{
+    IntPoint size = pBmp->getSize();
+    AVG_ASSERT(size == getSize());
+    AVG_ASSERT(numLines > 0 && startLine+numLines <= size.y);
+    if (pixelFormatIsBlockCompressed(getPF())) {
+        moveCompressedBmpToTexture(pBmp, startLine, numLines);
+        return;
+    }
+    BitmapPtr pLinesBmp(new Bitmap(*pBmp, 
+            IntRect(0, startLine, size.x, startLine+numLines)));
+    TextureMoverPtr pMover = TextureMover::create(pLinesBmp->getSize(), getPF(),
+            getUploadUsage());
+    pMover->moveBmpToTextureLines(pLinesBmp, *this, startLine);
+    if (startLine+numLines == size.y) {
+        generateMipmaps();
+    }
+}
+
 BitmapPtr GLTexture::moveTextureToBmp(int mipmapLevel)
 {
+    if (pixelFormatIsBlockCompressed(getPF())) {
+        throw Exception(AVG_ERR_UNSUPPORTED, 
+                "Reading back block-compressed textures is not supported.");
+    }
     TextureMoverPtr pMover = TextureMover::create(getGLSize(), getPF(), GL_DYNAMIC_READ);
     return pMover->moveTextureToBmp(*this, mipmapLevel);
 }
@@ -149,4 +184,36 @@ unsigned GLTexture::getID() const
     return m_TexID;
 }
 
+void GLTexture::moveCompressedBmpToTexture(BitmapPtr pBmp, int startLine, 
+        int numLines)
+{
+    IntPoint size = pBmp->getSize();
+    AVG_ASSERT(size == getSize());
+    AVG_ASSERT(pBmp->getPixelFormat() == getPF());
+    AVG_ASSERT(pBmp->getStride() == pBmp->getLineLen());
+    AVG_ASSERT(startLine%4 == 0);
+    activate(WrapMode());
+    // Sub-images must consist of whole blocks unless they end at the texture border.
+    IntPoint glSize = getGLSize();
+    int width = min(((size.x+3)/4)*4, glSize.x);
+    int endLine = min(((startLine+numLines+3)/4)*4, glSize.y);
+    const unsigned char* pStartPos = pBmp->getPixels() + 
+            (startLine/4)*pBmp->getStride();
+    int dataSize = ((endLine-startLine+3)/4)*pBmp->getStride();
+    glproc::CompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, startLine, width, 
+            endLine-startLine, getGLInternalFormat(), dataSize, pStartPos);
+    GLContext::checkError("GLTexture::moveCompressedBmpToTexture: "
+            "glCompressedTexSubImage2D()");
+}
+
+unsigned GLTexture::getUploadUsage() const
+{
+    if (getPF() == A8 && m_pContext->isVendor("ATI")) {
+        // Workaround for https://github.com/libavg/libavg/issues/687
+        return GL_STATIC_DRAW;
+    } else {
+        return GL_DYNAMIC_DRAW;
+    }
+}
+
 }
@@ -48,11 +48,18 @@ public:
     void generateMipmaps();
 
     void moveBmpToTexture(BitmapPtr pBmp);
+    // Uploads numLines lines of pBmp, starting at startLine. Mipmaps are generated
+    // when the last line has been uploaded. Block-compressed bitmaps can only be 
+    // uploaded in whole rows of blocks, so startLine must be a multiple of 4 for them.
+    void moveBmpLinesToTexture(BitmapPtr pBmp, int startLine, int numLines);
     BitmapPtr moveTextureToBmp(int mipmapLevel=0);
 
     unsigned getID() const;
 
 private:
+    unsigned getUploadUsage() const;
+    void moveCompressedBmpToTexture(BitmapPtr pBmp, int startLine, int numLines);
+
     GLContext* m_pContext;
 
     WrapMode m_WrapMode;
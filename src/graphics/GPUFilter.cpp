@@ -32,6 +32,7 @@
 #include "MCTexture.h"
 #include "GLTexture.h"
 #include "TextureMover.h"
+#include "ReadbackRing.h"
 
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
@@ -135,6 +136,28 @@ BitmapPtr GPUFilter::getImage(GLContext* pContext) const
     return m_pFBOs[0]->getImage(pContext);
 }
 
+void GPUFilter::startImageReadback(GLContext* pContext)
+{
+    if (!m_pReadbackRing) {
+        m_pReadbackRing = ReadbackRingPtr(new ReadbackRing(m_DestRect.size(), m_PFDest,
+                ReadbackRing::getDefaultNumBuffers()));
+    }
+    m_pFBOs[0]->startReadback(pContext, *m_pReadbackRing);
+}
+
+BitmapPtr GPUFilter::getReadbackImage(bool bWait)
+{
+    if (!m_pReadbackRing) {
+        return BitmapPtr();
+    }
+    return m_pReadbackRing->getImage(bWait);
+}
+
+bool GPUFilter::isReadbackFull() const
+{
+    return m_pReadbackRing && m_pReadbackRing->isFull();
+}
+
 FBOPtr GPUFilter::getFBO(GLContext* pContext, int i)
 {
     return m_pFBOs[i]->getCurFBO(pContext);
@@ -174,6 +197,7 @@ void GPUFilter::setDimensions(const IntPoint& srcSize, const IntRect& destRect)
             m_pFBOs.push_back(pFBO);
         }
         m_DestRect = destRect;
+        m_pReadbackRing = ReadbackRingPtr();
         bProjectionChanged = true;
     }
     if (m_bStandalone && srcSize != m_SrcSize) {
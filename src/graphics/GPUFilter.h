@@ -43,6 +43,8 @@ typedef boost::shared_ptr<GLTexture> GLTexturePtr;
 class TextureMover;
 typedef boost::shared_ptr<TextureMover> TextureMoverPtr;
 class GLContext;
+class ReadbackRing;
+typedef boost::shared_ptr<ReadbackRing> ReadbackRingPtr;
 
 class AVG_API GPUFilter: public Filter
 {
@@ -58,6 +60,11 @@ public:
     virtual void applyOnGPU(GLContext* pContext, GLTexturePtr pSrcTex) = 0;
     GLTexturePtr getDestTex(GLContext* pContext, int i=0) const;
     BitmapPtr getImage(GLContext* pContext) const;
+    // Asynchronous version of getImage(): Returns images of earlier 
+    // startImageReadback() calls in order once they're available.
+    void startImageReadback(GLContext* pContext);
+    BitmapPtr getReadbackImage(bool bWait);
+    bool isReadbackFull() const;
     FBOPtr getFBO(GLContext* pContext, int i=0);
 
     const IntRect& getDestRect() const;
@@ -87,6 +94,7 @@ private:
     IntPoint m_SrcSize;
     IntRect m_DestRect;
     ImagingProjectionPtr m_pProjection;
+    ReadbackRingPtr m_pReadbackRing;
 
     bool m_bIsInitialized;
 };
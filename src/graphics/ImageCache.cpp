@@ -97,17 +97,28 @@ long long ImageCache::getMemUsed(CachedImage::StorageType st)
 CachedImagePtr ImageCache::getImage(const std::string& sFilename,
         TexCompression compression)
 {
-    ImageMap::iterator it = m_pImageMap.find(sFilename);
+    ImageMap::iterator it = m_pImageMap.find(ImageKey(sFilename, compression));
     CachedImagePtr pImg;
     if (it == m_pImageMap.end()) {
-        pImg = CachedImagePtr(new CachedImage(sFilename, compression));
+        // Block-compressed versions of cached (e.g. prefetched) images are compressed
+        // from the uncompressed version instead of being loaded again.
+        ImageMap::iterator srcIt = m_pImageMap.end();
+        if (isBlockCompression(compression)) {
+            srcIt = m_pImageMap.find(ImageKey(sFilename, TEXCOMPRESSION_NONE));
+        }
+        if (srcIt == m_pImageMap.end()) {
+            pImg = CachedImagePtr(new CachedImage(sFilename, compression));
+        } else {
+            pImg = CachedImagePtr(new CachedImage(**srcIt->second, compression));
+        }
         m_pLRUList.push_front(pImg);
-        m_pImageMap.insert(make_pair(sFilename, m_pLRUList.begin()));
+        m_pImageMap.insert(make_pair(ImageKey(sFilename, compression), 
+                m_pLRUList.begin()));
         m_CPUCacheUsed += pImg->getMemUsed(CachedImage::STORAGE_CPU);
         checkCPUUnload();
     } else {
         pImg = *(it->second);
-        pImg->incBmpRef(compression);
+        pImg->incBmpRef();
         // Move item to front of list
         m_pLRUList.splice(m_pLRUList.begin(), m_pLRUList, it->second);
     }
@@ -115,24 +126,51 @@ CachedImagePtr ImageCache::getImage(const std::string& sFilename,
     return pImg;
 }
 
-void ImageCache::onTexLoad(const std::string& sFilename)
+void ImageCache::addImage(const std::string& sFilename, TexCompression compression,
+        BitmapPtr pBmp)
 {
-    CachedImagePtr pImg = *(m_pImageMap[sFilename]);
+    if (hasImage(sFilename, compression)) {
+        return;
+    }
+    CachedImagePtr pImg(new CachedImage(sFilename, compression, pBmp));
+    // Insert as most recently used of the unused images.
+    LRUListType::iterator itPos = m_pLRUList.begin();
+    while (itPos != m_pLRUList.end() && 
+            (*itPos)->getRefCount(CachedImage::STORAGE_CPU) != 0)
+    {
+        itPos++;
+    }
+    LRUListType::iterator it = m_pLRUList.insert(itPos, pImg);
+    m_pImageMap.insert(make_pair(ImageKey(sFilename, compression), it));
+    m_CPUCacheUsed += pImg->getMemUsed(CachedImage::STORAGE_CPU);
+    checkCPUUnload();
+}
+
+bool ImageCache::hasImage(const std::string& sFilename, TexCompression compression) 
+        const
+{
+    return m_pImageMap.find(ImageKey(sFilename, compression)) != m_pImageMap.end();
+}
+
+void ImageCache::onTexLoad(const std::string& sFilename, TexCompression compression)
+{
+    ImageMap::iterator it = m_pImageMap.find(ImageKey(sFilename, compression));
+    AVG_ASSERT(it != m_pImageMap.end());
+    CachedImagePtr pImg = *(it->second);
     m_GPUCacheUsed += pImg->getMemUsed(CachedImage::STORAGE_GPU);
-    ImageMap::iterator it = m_pImageMap.find(sFilename);
     // Move item to front of list
-    if (it != m_pImageMap.end()) {
-        m_pLRUList.splice(m_pLRUList.begin(), m_pLRUList, it->second);
-    }
+    m_pLRUList.splice(m_pLRUList.begin(), m_pLRUList, it->second);
     checkGPUUnload();
 }
 
-void ImageCache::onImageUnused(const std::string& sFilename, CachedImage::StorageType st)
+void ImageCache::onImageUnused(const std::string& sFilename, TexCompression compression,
+        CachedImage::StorageType st)
 {
     // Move image to first pos with use count == 0
     // This is currently O(n). If that becomes an issue, we need to remember the first
     // unused image for both CPU and GPU.
-    LRUListType::iterator itOldPos = m_pImageMap.find(sFilename)->second;
+    LRUListType::iterator itOldPos = 
+            m_pImageMap.find(ImageKey(sFilename, compression))->second;
     LRUListType::iterator itNewPos = itOldPos;
     itNewPos++;
     while (itNewPos != m_pLRUList.end() &&
@@ -197,7 +235,7 @@ void ImageCache::checkCPUUnload()
     while (m_CPUCacheUsed > m_CPUCacheCapacity) {
         CachedImagePtr pImg = *(m_pLRUList.rbegin());
         if (pImg->getRefCount(CachedImage::STORAGE_CPU) == 0) {
-            m_pImageMap.erase(pImg->getFilename());
+            m_pImageMap.erase(ImageKey(pImg->getFilename(), pImg->getCompression()));
             m_pLRUList.pop_back();
             m_CPUCacheUsed -= pImg->getMemUsed(CachedImage::STORAGE_CPU);
             m_GPUCacheUsed -= pImg->getMemUsed(CachedImage::STORAGE_GPU);
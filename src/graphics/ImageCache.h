@@ -30,8 +30,10 @@
 #include "TexInfo.h"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/functional/hash.hpp>
 #include <string>
 #include <list>
+#include <utility>
 
 #ifdef _WIN32
 #include <unordered_map>
@@ -53,10 +55,17 @@ class AVG_API ImageCache
         void setCapacity(long long cpuCapacity, long long gpuCapacity);
         long long getCapacity(CachedImage::StorageType st);
         long long getMemUsed(CachedImage::StorageType st);
+        // Images are cached per file and compression, so differently compressed 
+        // versions of a file can be in use at the same time.
         CachedImagePtr getImage(const std::string& sFilename,
                 TexCompression compression);
-        void onTexLoad(const std::string& sFilename);
-        void onImageUnused(const std::string& sFilename, CachedImage::StorageType st);
+        // Adds an image that was loaded in the background as unused but cached.
+        void addImage(const std::string& sFilename, TexCompression compression, 
+                BitmapPtr pBmp);
+        bool hasImage(const std::string& sFilename, TexCompression compression) const;
+        void onTexLoad(const std::string& sFilename, TexCompression compression);
+        void onImageUnused(const std::string& sFilename, TexCompression compression,
+                CachedImage::StorageType st);
         void onSizeChange(int sizeDiff, CachedImage::StorageType st);
         int getNumCPUImages() const;
         int getNumGPUImages() const;
@@ -78,10 +87,13 @@ class AVG_API ImageCache
         // 3) Images that are unused but cached.
         // The third partition is sorted by LRU.
         LRUListType m_pLRUList;
+        typedef std::pair<std::string, TexCompression> ImageKey;
 #ifdef __APPLE__
-        typedef boost::unordered_map<std::string, LRUListType::iterator> ImageMap;
+        typedef boost::unordered_map<ImageKey, LRUListType::iterator, 
+                boost::hash<ImageKey> > ImageMap;
 #else
-        typedef std::tr1::unordered_map<std::string, LRUListType::iterator> ImageMap;
+        typedef std::tr1::unordered_map<ImageKey, LRUListType::iterator, 
+                boost::hash<ImageKey> > ImageMap;
 #endif
         ImageMap m_pImageMap;
 
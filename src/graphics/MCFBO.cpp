@@ -109,6 +109,11 @@ BitmapPtr MCFBO::getImageFromPBO(GLContext* pContext) const
     return getCurFBO(pContext)->getImageFromPBO();
 }
 
+void MCFBO::startReadback(GLContext* pContext, ReadbackRing& ring, int i) const
+{
+    getCurFBO(pContext)->startReadback(ring, i);
+}
+
 MCTexturePtr MCFBO::getTex(int i) const
 {
     return m_pTextures[i];
@@ -44,6 +44,7 @@ typedef boost::shared_ptr<MCTexture> MCTexturePtr;
 class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 class GLContext;
+class ReadbackRing;
 
 class AVG_API MCFBO: public FBOInfo
 {
@@ -61,6 +62,7 @@ public:
     BitmapPtr getImage(GLContext* pContext, int i=0) const;
     void moveToPBO(GLContext* pContext, int i=0) const;
     BitmapPtr getImageFromPBO(GLContext* pContext) const;
+    void startReadback(GLContext* pContext, ReadbackRing& ring, int i=0) const;
     MCTexturePtr getTex(int i=0) const;
 
 private:
@@ -42,7 +42,8 @@ using namespace std;
 MCTexture::MCTexture(const IntPoint& size, PixelFormat pf, bool bMipmap, bool bForcePOT,
         int potBorderColor)
     : TexInfo(size, pf, bMipmap, usePOT(bForcePOT, bMipmap), potBorderColor),
-      m_bIsDirty(true)
+      m_bIsDirty(true),
+      m_bIsResident(true)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
 }
@@ -65,6 +66,13 @@ void MCTexture::moveBmpToTexture(GLContext* pContext, BitmapPtr pBmp)
     m_bIsDirty = true;
 }
 
+void MCTexture::moveBmpLinesToTexture(GLContext* pContext, BitmapPtr pBmp,
+        int startLine, int numLines)
+{
+    getTex(pContext)->moveBmpLinesToTexture(pBmp, startLine, numLines);
+    m_bIsDirty = true;
+}
+
 void MCTexture::setDirty()
 {
     m_bIsDirty = true;
@@ -80,6 +88,16 @@ void MCTexture::resetDirty()
     m_bIsDirty = false;
 }
 
+bool MCTexture::isResident() const
+{
+    return m_bIsResident;
+}
+
+void MCTexture::setResident(bool bResident)
+{
+    m_bIsResident = bResident;
+}
+
 const GLTexturePtr& MCTexture::getTex(GLContext* pContext) const
 {
     TexMap::const_iterator it = m_pTextures.find(pContext);
@@ -53,6 +53,8 @@ public:
     void initForGLContext(GLContext* pContext);
 
     void moveBmpToTexture(GLContext* pContext, BitmapPtr pBmp);
+    void moveBmpLinesToTexture(GLContext* pContext, BitmapPtr pBmp, int startLine,
+            int numLines);
 
     const GLTexturePtr& getTex(GLContext* pContext) const;
 
@@ -60,6 +62,11 @@ public:
     bool isDirty() const;
     void resetDirty();
 
+    // False while a deferred upload to the texture is pending. Textures that aren't
+    // resident have undefined contents and shouldn't be rendered.
+    bool isResident() const;
+    void setResident(bool bResident);
+
 private:
 #ifdef __APPLE__
     typedef boost::unordered_map<GLContext*, GLTexturePtr> TexMap;
@@ -69,6 +76,7 @@ private:
     TexMap m_pTextures;
 
     bool m_bIsDirty;
+    bool m_bIsResident;
 };
 
 typedef boost::shared_ptr<MCTexture> MCTexturePtr;
@@ -53,6 +53,9 @@ namespace glproc {
     PFNGLDRAWBUFFERSPROC DrawBuffers;
     PFNGLDRAWRANGEELEMENTSPROC DrawRangeElements;
     PFNGLGETOBJECTPARAMETERIVARBPROC GetObjectParameteriv;
+    PFNGLFENCESYNCPROC FenceSync;
+    PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+    PFNGLDELETESYNCPROC DeleteSync;
 #endif
     PFNGLGENBUFFERSPROC GenBuffers;
     PFNGLBUFFERDATAPROC BufferData;
@@ -87,6 +90,8 @@ namespace glproc {
     PFNGLBLENDCOLORPROC BlendColor;
     PFNGLACTIVETEXTUREPROC ActiveTexture;
     PFNGLGENERATEMIPMAPPROC GenerateMipmap;
+    PFNGLCOMPRESSEDTEXIMAGE2DPROC CompressedTexImage2D;
+    PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC CompressedTexSubImage2D;
 
     PFNGLCHECKFRAMEBUFFERSTATUSPROC CheckFramebufferStatus;
     PFNGLGENFRAMEBUFFERSPROC GenFramebuffers;
@@ -377,6 +382,10 @@ namespace glproc {
         ActiveTexture = (PFNGLACTIVETEXTUREPROC)getFuzzyProcAddress("glActiveTexture");
         GenerateMipmap = (PFNGLGENERATEMIPMAPPROC)getFuzzyProcAddress
                 ("glGenerateMipmap");
+        CompressedTexImage2D = (PFNGLCOMPRESSEDTEXIMAGE2DPROC)
+                getFuzzyProcAddress("glCompressedTexImage2D");
+        CompressedTexSubImage2D = (PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC)
+                getFuzzyProcAddress("glCompressedTexSubImage2D");
         
         CheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSPROC)
                 getFuzzyProcAddress("glCheckFramebufferStatus");
@@ -415,6 +424,9 @@ namespace glproc {
                 getFuzzyProcAddress("glDrawRangeElements");
         DebugMessageCallback = (PFNGLDEBUGMESSAGECALLBACKARBPROC)
                 getFuzzyProcAddress("glDebugMessageCallback");
+        FenceSync = (PFNGLFENCESYNCPROC)getFuzzyProcAddress("glFenceSync");
+        ClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)getFuzzyProcAddress("glClientWaitSync");
+        DeleteSync = (PFNGLDELETESYNCPROC)getFuzzyProcAddress("glDeleteSync");
 #endif
         VertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC)
                 getFuzzyProcAddress("glVertexAttribPointer");
@@ -68,6 +68,20 @@
     #define GPU_MEMORY_INFO_EVICTED_MEMORY_NVX            0x904B
 #endif
 
+// Block-compressed texture formats. Not all GL headers define all of them.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_RGB_S3TC_DXT1_EXT               0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT              0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+    #define GL_COMPRESSED_RGB8_ETC2                       0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+    #define GL_COMPRESSED_RGBA8_ETC2_EAC                  0x9278
+#endif
+
 #include <string>
 
 #ifndef APIENTRY
@@ -185,6 +199,9 @@ namespace glproc {
     extern AVG_API PFNGLDRAWRANGEELEMENTSPROC DrawRangeElements;
     extern AVG_API PFNGLBLITFRAMEBUFFERPROC BlitFramebuffer;
     extern AVG_API PFNGLGETOBJECTPARAMETERIVARBPROC GetObjectParameteriv;
+    extern AVG_API PFNGLFENCESYNCPROC FenceSync;
+    extern AVG_API PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+    extern AVG_API PFNGLDELETESYNCPROC DeleteSync;
 #endif
     extern AVG_API PFNGLDEBUGMESSAGECALLBACKPROC DebugMessageCallback;
     extern AVG_API PFNGLDELETEBUFFERSPROC DeleteBuffers;
@@ -217,6 +234,8 @@ namespace glproc {
     extern AVG_API PFNGLBLENDCOLORPROC BlendColor;
     extern AVG_API PFNGLACTIVETEXTUREPROC ActiveTexture;
     extern AVG_API PFNGLGENERATEMIPMAPPROC GenerateMipmap;
+    extern AVG_API PFNGLCOMPRESSEDTEXIMAGE2DPROC CompressedTexImage2D;
+    extern AVG_API PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC CompressedTexSubImage2D;
 
     extern AVG_API PFNGLCHECKFRAMEBUFFERSTATUSPROC CheckFramebufferStatus;
     extern AVG_API PFNGLGENFRAMEBUFFERSPROC GenFramebuffers;
@@ -77,6 +77,14 @@ int PBO::getID() const
 void PBO::moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex)
 {
     AVG_ASSERT(pBmp->getSize() == tex.getSize());
+    moveBmpToTextureLines(pBmp, tex, 0);
+    tex.generateMipmaps();
+}
+
+void PBO::moveBmpToTextureLines(BitmapPtr pBmp, GLTexture& tex, int startLine)
+{
+    AVG_ASSERT(pBmp->getSize().x == tex.getSize().x);
+    AVG_ASSERT(startLine >= 0 && startLine+pBmp->getSize().y <= tex.getSize().y);
     AVG_ASSERT(getSize() == pBmp->getSize());
     AVG_ASSERT(pBmp->getPixelFormat() == getPF());
     AVG_ASSERT(tex.getPF() == getPF());
@@ -90,7 +98,7 @@ void PBO::moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex)
     glproc::UnmapBuffer(GL_PIXEL_UNPACK_BUFFER_EXT);
     GLContext::checkError("PBO::moveBmpToTexture: UnmapBuffer()");
 
-    moveToTexture(tex);
+    moveToTexture(tex, startLine);
 }
 
 BitmapPtr PBO::moveTextureToBmp(GLTexture& tex, int mipmapLevel)
@@ -121,6 +129,20 @@ void PBO::moveTextureToPBO(GLTexture& tex, int mipmapLevel)
     }
 }
 
+void PBO::moveFramebufferToPBO()
+{
+    AVG_ASSERT(isReadPBO());
+    glproc::BindBuffer(GL_PIXEL_PACK_BUFFER_EXT, m_PBOID);
+    GLContext::checkError("PBO::moveFramebufferToPBO BindBuffer()");
+    IntPoint size = getSize();
+    glReadPixels(0, 0, size.x, size.y, GLTexture::getGLFormat(getPF()),
+            GLTexture::getGLType(getPF()), 0);
+    GLContext::checkError("PBO::moveFramebufferToPBO: glReadPixels()");
+    glproc::BindBuffer(GL_PIXEL_PACK_BUFFER_EXT, 0);
+    m_ActiveSize = size;
+    m_BufferStride = size.x;
+}
+
 BitmapPtr PBO::movePBOToBmp() const
 {
     AVG_ASSERT(isReadPBO());
@@ -156,7 +178,7 @@ bool PBO::isReadPBO() const
     }
 }
 
-void PBO::moveToTexture(GLTexture& tex)
+void PBO::moveToTexture(GLTexture& tex, int startLine)
 {
     AVG_ASSERT(!isReadPBO());
     IntPoint size = tex.getSize();
@@ -177,11 +199,10 @@ void PBO::moveToTexture(GLTexture& tex)
         glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     }
 #endif
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y,
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, startLine, size.x, size.y,
             GLTexture::getGLFormat(getPF()), GLTexture::getGLType(getPF()), 0);
     GLContext::checkError("PBO::setImage: glTexSubImage2D()");
     glproc::BindBuffer(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
-    tex.generateMipmaps();
 }
 
 unsigned PBO::getMemNeeded() const
@@ -44,16 +44,19 @@ public:
     void activate();
 
     void moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex);
+    virtual void moveBmpToTextureLines(BitmapPtr pBmp, GLTexture& tex, int startLine);
     virtual BitmapPtr moveTextureToBmp(GLTexture& tex, int mipmapLevel=0);
 
     void moveTextureToPBO(GLTexture& tex, int mipmapLevel=0);
+    // Reads the current read buffer of the bound framebuffer.
+    void moveFramebufferToPBO();
     BitmapPtr movePBOToBmp() const;
 
     bool isReadPBO() const;
     int getID() const;
 
 private:
-    void moveToTexture(GLTexture& tex);
+    void moveToTexture(GLTexture& tex, int startLine);
     unsigned getMemNeeded() const;
     unsigned getStride() const;
     unsigned getTarget() const;
@@ -0,0 +1,315 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "PixelConverter.h"
+#include "SIMDPixelConverter.h"
+#include "Pixel32.h"
+
+#include "../base/Logger.h"
+#include "../base/OSHelper.h"
+
+#include <boost/thread/once.hpp>
+
+using namespace std;
+
+namespace avg {
+
+// The converters are used from decoder threads, so initialization needs to be
+// thread-safe.
+static vector<const PixelConverter*> s_pConverters;
+static const PixelConverter* s_pConverter = 0;
+static boost::once_flag s_ConvertersInitFlag = BOOST_ONCE_INIT;
+
+static void initConverters()
+{
+    // Sorted by speed.
+    s_pConverters.push_back(new PixelConverter);
+#ifdef AVG_ENABLE_SSE2_CONVERSION
+    s_pConverters.push_back(new SSE2PixelConverter);
+#endif
+#ifdef AVG_ENABLE_AVX2_CONVERSION
+    if (cpuHasAVX2()) {
+        s_pConverters.push_back(new AVX2PixelConverter);
+    }
+#endif
+#ifdef AVG_ENABLE_NEON_CONVERSION
+    s_pConverters.push_back(new NEONPixelConverter);
+#endif
+    s_pConverter = s_pConverters.back();
+    AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO, 
+            "Pixel format conversion: " << s_pConverter->getName());
+}
+
+const PixelConverter* PixelConverter::get()
+{
+    boost::call_once(initConverters, s_ConvertersInitFlag);
+    return s_pConverter;
+}
+
+const vector<const PixelConverter*>& PixelConverter::getAvailable()
+{
+    boost::call_once(initConverters, s_ConvertersInitFlag);
+    return s_pConverters;
+}
+
+PixelConverter::PixelConverter()
+{
+}
+
+PixelConverter::~PixelConverter()
+{
+}
+
+const char* PixelConverter::getName() const
+{
+    return "scalar";
+}
+
+void PixelConverter::YUYV422toBGR32Line(const unsigned char* pSrcLine, 
+        Pixel32* pDestLine, int width) const
+{
+    YUV422toBGR32Pixels(pSrcLine, pDestLine, width, 0, 0, 1, 3);
+}
+
+void PixelConverter::UYVY422toBGR32Line(const unsigned char* pSrcLine, 
+        Pixel32* pDestLine, int width) const
+{
+    YUV422toBGR32Pixels(pSrcLine, pDestLine, width, 0, 1, 0, 2);
+}
+
+void PixelConverter::YUV411toBGR32Line(const unsigned char* pSrcLine, 
+        Pixel32* pDestLine, int width) const
+{
+    Pixel32 * pDestPixel = pDestLine;
+    
+    // We need the previous and next values to interpolate between the
+    // sampled u and v values.
+    int v = *(pSrcLine+3);
+    int v0; // Previous v
+    int v1; // Next v;
+    int u;
+    int u1; // Next u;
+    const unsigned char * pSrcPixels = pSrcLine;
+
+    for (int x = 0; x < width/4; x++) {
+        // Four pixels at a time.
+        // Source format is UYYVYY.
+        u = pSrcPixels[0];
+        v0 = v;
+        v = pSrcPixels[3];
+
+        if (x < width/4-1) {
+            u1 = pSrcPixels[6];
+            v1 = pSrcPixels[9];
+        } else {
+            u1 = u;
+            v1 = v;
+        }
+
+        YUVtoBGR32Pixel(pDestPixel, pSrcPixels[1], u, v0/2+v/2);
+        YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[2], (u*3)/4+u1/4, v0/4+(v*3)/4);
+        YUVtoBGR32Pixel(pDestPixel+2, pSrcPixels[4], u/2+u1/2, v);
+        YUVtoBGR32Pixel(pDestPixel+3, pSrcPixels[5], u/4+(u1*3)/4, (v*3)/4+v1/4);
+
+        pSrcPixels+=6;
+        pDestPixel+=4;
+    }
+}
+
+void PixelConverter::YUYV422toI8Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    const unsigned char * pSrc = pSrcLine;
+    unsigned char * pDest = pDestLine;
+    for (int x = 0; x < width; x++) {
+        *pDest = *pSrc;
+        pDest++;
+        pSrc+=2;
+    }
+}
+
+void PixelConverter::YUV411toI8Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    const unsigned char * pSrc = pSrcLine;
+    unsigned char * pDest = pDestLine;
+    for (int x = 0; x < width/2; x++) {
+        *pDest++ = *pSrc++;
+        *pDest++ = *pSrc++;
+        pSrc++;
+    }
+}
+
+void PixelConverter::I8toBGR32Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    const unsigned char * pSrcPixel = pSrcLine;
+    unsigned char * pDestPixel = pDestLine;
+    for (int x = 0; x < width; ++x) {
+        pDestPixel[0] =
+        pDestPixel[1] =
+        pDestPixel[2] = *pSrcPixel;
+        pDestPixel[3] = 255;
+        ++pSrcPixel;
+        pDestPixel+=4;
+    }
+}
+
+void PixelConverter::BGR24toBGR32Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    const unsigned char * pSrcPixel = pSrcLine;
+    unsigned char * pDestPixel = pDestLine;
+    for (int x = 0; x < width; ++x) {
+        pDestPixel[0] = pSrcPixel[0];
+        pDestPixel[1] = pSrcPixel[1];
+        pDestPixel[2] = pSrcPixel[2];
+        pDestPixel[3] = 255;
+        pSrcPixel+=3;
+        pDestPixel+=4;
+    }
+}
+
+void PixelConverter::BGR32toI8Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width, bool bRedFirst) const
+{
+    const unsigned char * pSrcPixel = pSrcLine;
+    unsigned char * pDestPixel = pDestLine;
+    if (bRedFirst) {
+        for (int x = 0; x < width; ++x) {
+            *pDestPixel = ((pSrcPixel[0]*54+pSrcPixel[1]*183+pSrcPixel[2]*19)/256);
+            pSrcPixel+=4;
+            ++pDestPixel;
+        }
+    } else {
+        for (int x = 0; x < width; ++x) {
+            *pDestPixel = ((pSrcPixel[0]*19+pSrcPixel[1]*183+pSrcPixel[2]*54)/256);
+            pSrcPixel+=4;
+            ++pDestPixel;
+        }
+    }
+}
+
+void PixelConverter::ByteToFloatLine(const unsigned char* pSrcLine, float* pDestLine,
+        int numValues) const
+{
+    for (int x = 0; x < numValues; ++x) {
+        pDestLine[x] = float(pSrcLine[x])/255;
+    }
+}
+
+void PixelConverter::BY8toBGR32BilinearPairs(const unsigned char* pSrc, int srcStride,
+        unsigned char* pDest, int numPairs, bool bBlueFirst) const
+{
+    const int doubleSrcStride = srcStride * 2;
+    const unsigned char* pSrcPixel = pSrc;
+    // Points to the green component of the first pixel.
+    unsigned char* pDestPixel = pDest + 1;
+    int t0, t1;
+    if (bBlueFirst) {
+        for (int i = 0; i < numPairs; ++i) {
+            t0 = (pSrcPixel[0] + pSrcPixel[2] + pSrcPixel[doubleSrcStride] +
+                  pSrcPixel[doubleSrcStride + 2] + 2) >> 2;
+            t1 = (pSrcPixel[1] + pSrcPixel[srcStride] +
+                  pSrcPixel[srcStride + 2] + pSrcPixel[doubleSrcStride + 1] +
+                  2) >> 2;
+            pDestPixel[-1] = (unsigned char) t0;
+            pDestPixel[0] = (unsigned char) t1;
+            pDestPixel[1] = pSrcPixel[srcStride + 1];
+            pDestPixel[2] = 255; // Alpha channel
+
+            t0 = (pSrcPixel[2] + pSrcPixel[doubleSrcStride + 2] + 1) >> 1;
+            t1 = (pSrcPixel[srcStride + 1] + pSrcPixel[srcStride + 3] +
+                  1) >> 1;
+            pDestPixel[3] = (unsigned char) t0;
+            pDestPixel[4] = pSrcPixel[srcStride + 2];
+            pDestPixel[5] = (unsigned char) t1;
+            pDestPixel[6] = 255; // Alpha channel
+            
+            pSrcPixel += 2;
+            pDestPixel += 8;
+        }
+    } else {
+        for (int i = 0; i < numPairs; ++i) {
+            t0 = (pSrcPixel[0] + pSrcPixel[2] + pSrcPixel[doubleSrcStride] +
+                  pSrcPixel[doubleSrcStride + 2] + 2) >> 2;
+            t1 = (pSrcPixel[1] + pSrcPixel[srcStride] +
+                  pSrcPixel[srcStride + 2] + pSrcPixel[doubleSrcStride + 1] +
+                  2) >> 2;
+            pDestPixel[1] = (unsigned char) t0;
+            pDestPixel[0] = (unsigned char) t1;
+            pDestPixel[-1] = pSrcPixel[srcStride + 1];
+            pDestPixel[2] = 255; // Alpha channel
+
+            t0 = (pSrcPixel[2] + pSrcPixel[doubleSrcStride + 2] + 1) >> 1;
+            t1 = (pSrcPixel[srcStride + 1] + pSrcPixel[srcStride + 3] +
+                  1) >> 1;
+            pDestPixel[5] = (unsigned char) t0;
+            pDestPixel[4] = pSrcPixel[srcStride + 2];
+            pDestPixel[3] = (unsigned char) t1;
+            pDestPixel[6] = 255; // Alpha channel
+            
+            pSrcPixel += 2;
+            pDestPixel += 8;
+        }
+    }
+}
+
+void PixelConverter::YUV422toBGR32Pixels(const unsigned char* pSrcLine, 
+        Pixel32* pDestLine, int width, int startPair, int yPos, int uPos, int vPos)
+{
+    Pixel32 * pDestPixel = pDestLine + startPair*2;
+    const unsigned char * pSrcPixels = pSrcLine + startPair*4;
+    
+    // We need the previous and next values to interpolate between the
+    // sampled u and v values.
+    int v; 
+    if (startPair == 0) {
+        v = pSrcLine[vPos];
+    } else {
+        v = pSrcPixels[vPos-4];
+    }
+    int v0; // Previous v
+    int u;
+    int u1; // Next u;
+
+    for (int x = startPair; x < width/2-1; x++) {
+        // Two pixels at a time.
+        u = pSrcPixels[uPos];
+        v0 = v;
+        v = pSrcPixels[vPos];
+        u1 = pSrcPixels[uPos+4];
+
+        YUVtoBGR32Pixel(pDestPixel, pSrcPixels[yPos], u, (v0+v)/2);
+        YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[yPos+2], (u+u1)/2, v);
+
+        pSrcPixels+=4;
+        pDestPixel+=2;
+    }
+    // Last pixels.
+    u = pSrcPixels[uPos];
+    v0 = v;
+    v = pSrcPixels[vPos];
+    YUVtoBGR32Pixel(pDestPixel, pSrcPixels[yPos], u, v0/2+v/2);
+    YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[yPos+2], u, v);
+}
+
+}
@@ -0,0 +1,84 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _PixelConverter_H_
+#define _PixelConverter_H_
+
+#include "../api.h"
+
+#include <vector>
+
+namespace avg {
+
+class Pixel32;
+
+// Line-by-line pixel format conversions used by Bitmap::copyPixels(). This class holds
+// the scalar reference implementations. Subclasses override them with SIMD versions,
+// which must produce bit-identical results. get() returns the fastest converter the
+// cpu supports.
+class AVG_API PixelConverter
+{
+public:
+    static const PixelConverter* get();
+    // All converters that run on this cpu, starting with the scalar reference.
+    static const std::vector<const PixelConverter*>& getAvailable();
+
+    PixelConverter();
+    virtual ~PixelConverter();
+    virtual const char* getName() const;
+
+    // Chroma is interpolated between neighbouring pixels.
+    virtual void YUYV422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine,
+            int width) const;
+    virtual void UYVY422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine,
+            int width) const;
+    virtual void YUV411toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine,
+            int width) const;
+    // Copies every second byte.
+    virtual void YUYV422toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width) const;
+    virtual void YUV411toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width) const;
+    // Grayscale to 32 bit with opaque alpha.
+    virtual void I8toBGR32Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width) const;
+    // Adds opaque alpha, channel order is unchanged.
+    virtual void BGR24toBGR32Line(const unsigned char* pSrcLine, 
+            unsigned char* pDestLine, int width) const;
+    virtual void BGR32toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width, bool bRedFirst) const;
+    virtual void ByteToFloatLine(const unsigned char* pSrcLine, float* pDestLine,
+            int numValues) const;
+    // Inner loop of Bitmap::BY8toRGBBilinear(): Demosaics numPairs horizontal pixel 
+    // pairs. pSrc points to the top left of the 3x3 neighbourhood of the first pixel.
+    virtual void BY8toBGR32BilinearPairs(const unsigned char* pSrc, int srcStride,
+            unsigned char* pDest, int numPairs, bool bBlueFirst) const;
+
+protected:
+    // Scalar 4:2:2 conversion, starting at pixel pair startPair. Used for the pixels
+    // left over by SIMD loops.
+    static void YUV422toBGR32Pixels(const unsigned char* pSrcLine, Pixel32* pDestLine,
+            int width, int startPair, int yPos, int uPos, int vPos);
+};
+
+}
+
+#endif
@@ -98,6 +98,14 @@ string getPixelFormatString(PixelFormat pf)
             return "R32G32B32A32F";
         case I32F:
             return "I32F";
+        case BC1:
+            return "BC1";
+        case BC3:
+            return "BC3";
+        case ETC2_RGB8:
+            return "ETC2_RGB8";
+        case ETC2_RGBA8:
+            return "ETC2_RGBA8";
         case NO_PIXELFORMAT:
             return "NO_PIXELFORMAT";
         default:
@@ -194,6 +202,18 @@ PixelFormat stringToPixelFormat(const string& s)
     if (s == "I32F") {
         return I32F;
     }
+    if (s == "BC1") {
+        return BC1;
+    }
+    if (s == "BC3") {
+        return BC3;
+    }
+    if (s == "ETC2_RGB8") {
+        return ETC2_RGB8;
+    }
+    if (s == "ETC2_RGBA8") {
+        return ETC2_RGBA8;
+    }
     return NO_PIXELFORMAT;
 }
 
@@ -223,7 +243,7 @@ bool pixelFormatIsBayer(PixelFormat pf)
 bool pixelFormatHasAlpha(PixelFormat pf)
 {
     return pf == B8G8R8A8 || pf == A8B8G8R8 || pf == R8G8B8A8 || pf == A8R8G8B8 ||
-            pf == YCbCrA420p;
+            pf == YCbCrA420p || pf == BC3 || pf == ETC2_RGBA8;
 }
 
 bool pixelFormatIsPlanar(PixelFormat pf)
@@ -236,6 +256,11 @@ bool AVG_API pixelFormatIsBlueFirst(PixelFormat pf)
     return pf == B5G6R5 || pf == B8G8R8 || pf == B8G8R8X8 || pf == B8G8R8A8;
 }
 
+bool pixelFormatIsBlockCompressed(PixelFormat pf)
+{
+    return pf == BC1 || pf == BC3 || pf == ETC2_RGB8 || pf == ETC2_RGBA8;
+}
+
 unsigned getNumPixelFormatPlanes(PixelFormat pf)
 {
     switch (pf) {
@@ -291,4 +316,21 @@ unsigned getBytesPerPixel(PixelFormat pf)
     }
 }
 
+unsigned getBytesPerBlock(PixelFormat pf)
+{
+    switch (pf) {
+        case BC1:
+        case ETC2_RGB8:
+            return 8;
+        case BC3:
+        case ETC2_RGBA8:
+            return 16;
+        default:
+            AVG_LOG_ERROR("getBytesPerBlock(): Unknown format " <<
+                    getPixelFormatString(pf) << ".");
+            AVG_ASSERT(false);
+            return 0;
+    }
+}
+
 }
@@ -47,6 +47,10 @@ typedef enum {
     BAYER8_BGGR,
     R32G32B32A32F, // 32bit per channel float rgba
     I32F,
+    BC1,        // 4x4 blocks, 8 bytes each (S3TC DXT1, opaque)
+    BC3,        // 4x4 blocks, 16 bytes each (S3TC DXT5)
+    ETC2_RGB8,  // 4x4 blocks, 8 bytes each
+    ETC2_RGBA8, // 4x4 blocks, 16 bytes each (ETC2 + EAC alpha)
     NO_PIXELFORMAT
 } PixelFormat;
 
@@ -60,8 +64,10 @@ bool AVG_API pixelFormatIsBayer(PixelFormat pf);
 bool AVG_API pixelFormatHasAlpha(PixelFormat pf);
 bool AVG_API pixelFormatIsPlanar(PixelFormat pf);
 bool AVG_API pixelFormatIsBlueFirst(PixelFormat pf);
+bool AVG_API pixelFormatIsBlockCompressed(PixelFormat pf);
 unsigned AVG_API getNumPixelFormatPlanes(PixelFormat pf);
 unsigned AVG_API getBytesPerPixel(PixelFormat pf);
+unsigned AVG_API getBytesPerBlock(PixelFormat pf);
 
 }
 #endif
@@ -0,0 +1,154 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ReadbackRing.h"
+
+#include "GLContext.h"
+#include "PBO.h"
+#include "Bitmap.h"
+
+#include "../base/Exception.h"
+#include "../base/ConfigMgr.h"
+#include "../base/ObjectCounter.h"
+
+using namespace std;
+
+namespace avg {
+
+ReadbackRing::ReadbackRing(const IntPoint& size, PixelFormat pf, int numBuffers)
+    : m_Size(size),
+      m_PF(pf),
+      m_OldestIndex(0),
+      m_NumPending(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    GLContext* pContext = GLContext::getCurrent();
+    AVG_ASSERT(pContext->getMemoryMode() == MM_PBO);
+    AVG_ASSERT(numBuffers > 0);
+    m_bUseFences = pContext->areFencesSupported();
+    for (int i=0; i<numBuffers; ++i) {
+        m_pPBOs.push_back(PBOPtr(new PBO(size, pf, GL_STREAM_READ)));
+#ifndef AVG_ENABLE_EGL
+        m_Fences.push_back(0);
+#endif
+    }
+}
+
+ReadbackRing::~ReadbackRing()
+{
+#ifndef AVG_ENABLE_EGL
+    if (GLContext::getCurrent()) {
+        for (unsigned i=0; i<m_Fences.size(); ++i) {
+            if (m_Fences[i]) {
+                glproc::DeleteSync(m_Fences[i]);
+            }
+        }
+    }
+#endif
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+void ReadbackRing::startReadback()
+{
+    AVG_ASSERT(!isFull());
+    int i = (m_OldestIndex+m_NumPending) % getNumBuffers();
+    m_pPBOs[i]->moveFramebufferToPBO();
+#ifndef AVG_ENABLE_EGL
+    if (m_bUseFences) {
+        m_Fences[i] = glproc::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GLContext::checkError("ReadbackRing::startReadback: FenceSync()");
+    }
+#endif
+    m_NumPending++;
+}
+
+BitmapPtr ReadbackRing::getImage(bool bWait)
+{
+    if (m_NumPending == 0 || !isOldestFinished(bWait)) {
+        return BitmapPtr();
+    }
+    BitmapPtr pBmp = m_pPBOs[m_OldestIndex]->movePBOToBmp();
+    m_OldestIndex = (m_OldestIndex+1) % getNumBuffers();
+    m_NumPending--;
+    return pBmp;
+}
+
+bool ReadbackRing::isFull() const
+{
+    return m_NumPending == getNumBuffers();
+}
+
+bool ReadbackRing::usesFences() const
+{
+    return m_bUseFences;
+}
+
+int ReadbackRing::getNumPending() const
+{
+    return m_NumPending;
+}
+
+int ReadbackRing::getNumBuffers() const
+{
+    return int(m_pPBOs.size());
+}
+
+const IntPoint& ReadbackRing::getSize() const
+{
+    return m_Size;
+}
+
+PixelFormat ReadbackRing::getPF() const
+{
+    return m_PF;
+}
+
+int ReadbackRing::getDefaultNumBuffers()
+{
+    int numBuffers = ConfigMgr::get()->getIntOption("scr", "readbackbuffers", 2);
+    if (numBuffers < 1) {
+        numBuffers = 1;
+    }
+    return numBuffers;
+}
+
+bool ReadbackRing::isOldestFinished(bool bWait)
+{
+#ifndef AVG_ENABLE_EGL
+    if (m_bUseFences) {
+        GLsync& fence = m_Fences[m_OldestIndex];
+        if (!bWait) {
+            GLenum rc = glproc::ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            GLContext::checkError("ReadbackRing: ClientWaitSync()");
+            if (rc == GL_TIMEOUT_EXPIRED) {
+                return false;
+            }
+        }
+        // When waiting, mapping the PBO blocks until the data is there.
+        glproc::DeleteSync(fence);
+        fence = 0;
+        return true;
+    }
+#endif
+    return bWait || isFull();
+}
+
+}
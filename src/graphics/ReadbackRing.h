@@ -0,0 +1,86 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ReadbackRing_H_
+#define _ReadbackRing_H_
+
+#include "../api.h"
+#include "OGLHelper.h"
+#include "PixelFormat.h"
+
+#include "../base/GLMHelper.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+class PBO;
+typedef boost::shared_ptr<PBO> PBOPtr;
+
+// Ring of read PBOs for asynchronous readback of framebuffer contents. 
+// startReadback() queues a read of the current framebuffer into the next free PBO;
+// getImage() returns the oldest readback once the GPU is done with it. If fences are
+// supported, completion is polled using them. Otherwise, a readback is considered
+// done once all buffers are in use.
+class AVG_API ReadbackRing
+{
+public:
+    ReadbackRing(const IntPoint& size, PixelFormat pf, int numBuffers);
+    virtual ~ReadbackRing();
+
+    // Reads the current read buffer of the bound framebuffer. The ring may not be full.
+    void startReadback();
+    // Returns the oldest pending readback. Returns an empty BitmapPtr if nothing is 
+    // pending or if bWait is false and the readback isn't finished yet.
+    BitmapPtr getImage(bool bWait);
+
+    bool isFull() const;
+    bool usesFences() const;
+    int getNumPending() const;
+    int getNumBuffers() const;
+    const IntPoint& getSize() const;
+    PixelFormat getPF() const;
+
+    static int getDefaultNumBuffers();
+
+private:
+    bool isOldestFinished(bool bWait);
+    
+    IntPoint m_Size;
+    PixelFormat m_PF;
+    bool m_bUseFences;
+    std::vector<PBOPtr> m_pPBOs;
+#ifndef AVG_ENABLE_EGL
+    std::vector<GLsync> m_Fences;
+#endif
+    int m_OldestIndex;
+    int m_NumPending;
+};
+
+typedef boost::shared_ptr<ReadbackRing> ReadbackRingPtr;
+
+}
+
+#endif
@@ -0,0 +1,667 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "SIMDPixelConverter.h"
+#include "Pixel32.h"
+
+#if defined(AVG_ENABLE_SSE2_CONVERSION)
+#include <emmintrin.h>
+#endif
+#if defined(AVG_ENABLE_AVX2_CONVERSION)
+#include <immintrin.h>
+#endif
+#if defined(AVG_ENABLE_NEON_CONVERSION)
+#include <arm_neon.h>
+#endif
+
+// AVX2 functions are compiled for the AVX2 target regardless of the compiler flags.
+#if defined(__GNUC__)
+#define AVG_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define AVG_TARGET_AVX2
+#endif
+
+namespace avg {
+
+#ifdef AVG_ENABLE_SSE2_CONVERSION
+
+// Pairs of 16 bit coefficients for _mm_madd_epi16.
+static inline __m128i coeffPair(short a, short b)
+{
+    return _mm_set_epi16(b, a, b, a, b, a, b, a);
+}
+
+// Converts eight pixels, given as 16 bit y, u and v values, exactly like
+// YUVtoBGR32Pixel().
+static inline void YUVtoBGR32PixelsSSE2(__m128i y, __m128i u, __m128i v, 
+        unsigned char* pDest)
+{
+    y = _mm_sub_epi16(y, _mm_set1_epi16(16));
+    u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+    v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+    __m128i zero = _mm_setzero_si128();
+    __m128i yuLo = _mm_unpacklo_epi16(y, u);
+    __m128i yuHi = _mm_unpackhi_epi16(y, u);
+    __m128i yvLo = _mm_unpacklo_epi16(y, v);
+    __m128i yvHi = _mm_unpackhi_epi16(y, v);
+    __m128i vLo = _mm_unpacklo_epi16(v, zero);
+    __m128i vHi = _mm_unpackhi_epi16(v, zero);
+
+    __m128i bCoeffs = coeffPair(298, 516);
+    __m128i gCoeffs = coeffPair(298, -100);
+    __m128i gvCoeffs = coeffPair(-208, 0);
+    __m128i rCoeffs = coeffPair(298, 409);
+    __m128i b = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_madd_epi16(yuLo, bCoeffs), 8),
+            _mm_srai_epi32(_mm_madd_epi16(yuHi, bCoeffs), 8));
+    __m128i g = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuLo, gCoeffs), 
+                    _mm_madd_epi16(vLo, gvCoeffs)), 8),
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuHi, gCoeffs), 
+                    _mm_madd_epi16(vHi, gvCoeffs)), 8));
+    __m128i r = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_madd_epi16(yvLo, rCoeffs), 8),
+            _mm_srai_epi32(_mm_madd_epi16(yvHi, rCoeffs), 8));
+    // Saturation does the clamping.
+    b = _mm_packus_epi16(b, b);
+    g = _mm_packus_epi16(g, g);
+    r = _mm_packus_epi16(r, r);
+    __m128i bg = _mm_unpacklo_epi8(b, g);
+    __m128i ra = _mm_unpacklo_epi8(r, _mm_set1_epi8(-1));
+    _mm_storeu_si128((__m128i*)pDest, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i*)(pDest+16), _mm_unpackhi_epi16(bg, ra));
+}
+
+// Y_POS is 0 for YUYV and 1 for UYVY.
+template<int Y_POS>
+static void YUV422toBGR32LineSSE2(const unsigned char* pSrcLine, Pixel32* pDestLine,
+        int width, int& numPairsDone)
+{
+    const int uPos = 1-Y_POS;
+    const int vPos = 3-Y_POS;
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i lowWords = _mm_set1_epi32(0x0000FFFF);
+    int numPairs = width/2;
+    int prevV = pSrcLine[vPos];
+    int k = 0;
+    // The last pair is special, so it's left to the scalar code.
+    for (; k+4 <= numPairs-1; k += 4) {
+        const unsigned char* pSrc = pSrcLine + k*4;
+        __m128i src = _mm_loadu_si128((const __m128i*)pSrc);
+        __m128i y;
+        __m128i chroma;
+        if (Y_POS == 0) {
+            y = _mm_and_si128(src, lowBytes);
+            chroma = _mm_srli_epi16(src, 8);
+        } else {
+            y = _mm_srli_epi16(src, 8);
+            chroma = _mm_and_si128(src, lowBytes);
+        }
+        // One chroma sample per pair in each 32 bit lane.
+        __m128i u32 = _mm_and_si128(chroma, lowWords);
+        __m128i v32 = _mm_srli_epi32(chroma, 16);
+        __m128i nextU32 = _mm_or_si128(_mm_srli_si128(u32, 4),
+                _mm_slli_si128(_mm_cvtsi32_si128(pSrc[16+uPos]), 12));
+        __m128i prevV32 = _mm_or_si128(_mm_slli_si128(v32, 4), 
+                _mm_cvtsi32_si128(prevV));
+        // First pixel of a pair: u = u[k], v = (v[k-1]+v[k])/2. 
+        // Second pixel: u = (u[k]+u[k+1])/2, v = v[k].
+        __m128i u = _mm_srli_epi16(_mm_add_epi16(
+                _mm_or_si128(u32, _mm_slli_epi32(u32, 16)),
+                _mm_or_si128(u32, _mm_slli_epi32(nextU32, 16))), 1);
+        __m128i v = _mm_srli_epi16(_mm_add_epi16(
+                _mm_or_si128(prevV32, _mm_slli_epi32(v32, 16)),
+                _mm_or_si128(v32, _mm_slli_epi32(v32, 16))), 1);
+        YUVtoBGR32PixelsSSE2(y, u, v, (unsigned char*)(pDestLine + k*2));
+        prevV = pSrc[12+vPos];
+    }
+    numPairsDone = k;
+}
+
+const char* SSE2PixelConverter::getName() const
+{
+    return "SSE2";
+}
+
+void SSE2PixelConverter::YUYV422toBGR32Line(const unsigned char* pSrcLine, 
+        Pixel32* pDestLine, int width) const
+{
+    int numPairsDone;
+    YUV422toBGR32LineSSE2<0>(pSrcLine, pDestLine, width, numPairsDone);
+    YUV422toBGR32Pixels(pSrcLine, pDestLine, width, numPairsDone, 0, 1, 3);
+}
+
+void SSE2PixelConverter::UYVY422toBGR32Line(const unsigned char* pSrcLine, 
+        Pixel32* pDestLine, int width) const
+{
+    int numPairsDone;
+    YUV422toBGR32LineSSE2<1>(pSrcLine, pDestLine, width, numPairsDone);
+    YUV422toBGR32Pixels(pSrcLine, pDestLine, width, numPairsDone, 1, 0, 2);
+}
+
+void SSE2PixelConverter::YUYV422toI8Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    int x = 0;
+    // Stops early so the loads never touch the byte after the last y value.
+    for (; x+16 < width; x += 16) {
+        __m128i src0 = _mm_loadu_si128((const __m128i*)(pSrcLine + x*2));
+        __m128i src1 = _mm_loadu_si128((const __m128i*)(pSrcLine + x*2 + 16));
+        _mm_storeu_si128((__m128i*)(pDestLine + x), _mm_packus_epi16(
+                _mm_and_si128(src0, lowBytes), _mm_and_si128(src1, lowBytes)));
+    }
+    PixelConverter::YUYV422toI8Line(pSrcLine + x*2, pDestLine + x, width - x);
+}
+
+void SSE2PixelConverter::I8toBGR32Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    const __m128i alpha = _mm_set1_epi8(-1);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m128i gray = _mm_loadu_si128((const __m128i*)(pSrcLine + x));
+        __m128i ggLo = _mm_unpacklo_epi8(gray, gray);
+        __m128i ggHi = _mm_unpackhi_epi8(gray, gray);
+        __m128i gaLo = _mm_unpacklo_epi8(gray, alpha);
+        __m128i gaHi = _mm_unpackhi_epi8(gray, alpha);
+        unsigned char* pDest = pDestLine + x*4;
+        _mm_storeu_si128((__m128i*)pDest, _mm_unpacklo_epi16(ggLo, gaLo));
+        _mm_storeu_si128((__m128i*)(pDest+16), _mm_unpackhi_epi16(ggLo, gaLo));
+        _mm_storeu_si128((__m128i*)(pDest+32), _mm_unpacklo_epi16(ggHi, gaHi));
+        _mm_storeu_si128((__m128i*)(pDest+48), _mm_unpackhi_epi16(ggHi, gaHi));
+    }
+    PixelConverter::I8toBGR32Line(pSrcLine + x, pDestLine + x*4, width - x);
+}
+
+// Weighted sum of the first three channels of four pixels, divided by 256. The
+// products fit into 16 bits, so _mm_mullo_epi16 works on the 32 bit lanes.
+static inline __m128i weighPixelsSSE2(const unsigned char* pSrc, __m128i w0, __m128i w1,
+        __m128i w2)
+{
+    const __m128i lowBytes = _mm_set1_epi32(0xFF);
+    __m128i src = _mm_loadu_si128((const __m128i*)pSrc);
+    __m128i sum = _mm_mullo_epi16(_mm_and_si128(src, lowBytes), w0);
+    sum = _mm_add_epi32(sum, 
+            _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(src, 8), lowBytes), w1));
+    sum = _mm_add_epi32(sum, 
+            _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(src, 16), lowBytes), w2));
+    return _mm_srli_epi32(sum, 8);
+}
+
+void SSE2PixelConverter::BGR32toI8Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width, bool bRedFirst) const
+{
+    __m128i w0 = _mm_set1_epi32(bRedFirst ? 54 : 19);
+    __m128i w1 = _mm_set1_epi32(183);
+    __m128i w2 = _mm_set1_epi32(bRedFirst ? 19 : 54);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        const unsigned char* pSrc = pSrcLine + x*4;
+        __m128i i0 = weighPixelsSSE2(pSrc, w0, w1, w2);
+        __m128i i1 = weighPixelsSSE2(pSrc+16, w0, w1, w2);
+        __m128i i2 = weighPixelsSSE2(pSrc+32, w0, w1, w2);
+        __m128i i3 = weighPixelsSSE2(pSrc+48, w0, w1, w2);
+        _mm_storeu_si128((__m128i*)(pDestLine + x), _mm_packus_epi16(
+                _mm_packs_epi32(i0, i1), _mm_packs_epi32(i2, i3)));
+    }
+    PixelConverter::BGR32toI8Line(pSrcLine + x*4, pDestLine + x, width - x, bRedFirst);
+}
+
+void SSE2PixelConverter::ByteToFloatLine(const unsigned char* pSrcLine, 
+        float* pDestLine, int numValues) const
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 divisor = _mm_set1_ps(255.f);
+    int x = 0;
+    for (; x+16 <= numValues; x += 16) {
+        __m128i src = _mm_loadu_si128((const __m128i*)(pSrcLine + x));
+        __m128i lo = _mm_unpacklo_epi8(src, zero);
+        __m128i hi = _mm_unpackhi_epi8(src, zero);
+        float* pDest = pDestLine + x;
+        _mm_storeu_ps(pDest, _mm_div_ps(
+                _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), divisor));
+        _mm_storeu_ps(pDest+4, _mm_div_ps(
+                _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), divisor));
+        _mm_storeu_ps(pDest+8, _mm_div_ps(
+                _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), divisor));
+        _mm_storeu_ps(pDest+12, _mm_div_ps(
+                _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), divisor));
+    }
+    PixelConverter::ByteToFloatLine(pSrcLine + x, pDestLine + x, numValues - x);
+}
+
+// Interleaves two sets of eight pixels given as 16 bit channel values and stores them
+// as a0, b0, a1, b1, ...
+static inline void storePixelPairsSSE2(__m128i a0, __m128i a1, __m128i a2, __m128i b0, 
+        __m128i b1, __m128i b2, unsigned char* pDest)
+{
+    const __m128i alpha = _mm_set1_epi16(short(0xFF00));
+    __m128i a01 = _mm_or_si128(a0, _mm_slli_epi16(a1, 8));
+    __m128i a2a = _mm_or_si128(a2, alpha);
+    __m128i b01 = _mm_or_si128(b0, _mm_slli_epi16(b1, 8));
+    __m128i b2a = _mm_or_si128(b2, alpha);
+    __m128i aLo = _mm_unpacklo_epi16(a01, a2a);
+    __m128i aHi = _mm_unpackhi_epi16(a01, a2a);
+    __m128i bLo = _mm_unpacklo_epi16(b01, b2a);
+    __m128i bHi = _mm_unpackhi_epi16(b01, b2a);
+    _mm_storeu_si128((__m128i*)pDest, _mm_unpacklo_epi32(aLo, bLo));
+    _mm_storeu_si128((__m128i*)(pDest+16), _mm_unpackhi_epi32(aLo, bLo));
+    _mm_storeu_si128((__m128i*)(pDest+32), _mm_unpacklo_epi32(aHi, bHi));
+    _mm_storeu_si128((__m128i*)(pDest+48), _mm_unpackhi_epi32(aHi, bHi));
+}
+
+void SSE2PixelConverter::BY8toBGR32BilinearPairs(const unsigned char* pSrc, 
+        int srcStride, unsigned char* pDest, int numPairs, bool bBlueFirst) const
+{
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi16(2);
+    int i = 0;
+    for (; i+8 <= numPairs; i += 8) {
+        // One 16 bit lane per pixel pair. e: even source columns, o: odd columns,
+        // s: shifted by two columns.
+        const unsigned char* pRow0 = pSrc + i*2;
+        const unsigned char* pRow1 = pRow0 + srcStride;
+        const unsigned char* pRow2 = pRow1 + srcStride;
+        __m128i row0 = _mm_loadu_si128((const __m128i*)pRow0);
+        __m128i row0s = _mm_loadu_si128((const __m128i*)(pRow0+2));
+        __m128i row1 = _mm_loadu_si128((const __m128i*)pRow1);
+        __m128i row1s = _mm_loadu_si128((const __m128i*)(pRow1+2));
+        __m128i row2 = _mm_loadu_si128((const __m128i*)pRow2);
+        __m128i row2s = _mm_loadu_si128((const __m128i*)(pRow2+2));
+        __m128i row0e = _mm_and_si128(row0, lowBytes);
+        __m128i row0o = _mm_srli_epi16(row0, 8);
+        __m128i row0se = _mm_and_si128(row0s, lowBytes);
+        __m128i row1e = _mm_and_si128(row1, lowBytes);
+        __m128i row1o = _mm_srli_epi16(row1, 8);
+        __m128i row1se = _mm_and_si128(row1s, lowBytes);
+        __m128i row1so = _mm_srli_epi16(row1s, 8);
+        __m128i row2e = _mm_and_si128(row2, lowBytes);
+        __m128i row2o = _mm_srli_epi16(row2, 8);
+        __m128i row2se = _mm_and_si128(row2s, lowBytes);
+
+        // First pixel of each pair.
+        __m128i t0a = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+                _mm_add_epi16(row0e, row0se), _mm_add_epi16(row2e, row2se)), two), 2);
+        __m128i t1a = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+                _mm_add_epi16(row0o, row1e), _mm_add_epi16(row1se, row2o)), two), 2);
+        __m128i ca = row1o;
+        // Second pixel.
+        __m128i t0b = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(row0se, row2se), one), 
+                1);
+        __m128i t1b = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(row1o, row1so), one), 
+                1);
+        __m128i cb = row1se;
+        unsigned char* pDestPixel = pDest + i*8;
+        if (bBlueFirst) {
+            storePixelPairsSSE2(t0a, t1a, ca, t0b, cb, t1b, pDestPixel);
+        } else {
+            storePixelPairsSSE2(ca, t1a, t0a, t1b, cb, t0b, pDestPixel);
+        }
+    }
+    PixelConverter::BY8toBGR32BilinearPairs(pSrc + i*2, srcStride, pDest + i*8, 
+            numPairs - i, bBlueFirst);
+}
+
+#endif
+
+#ifdef AVG_ENABLE_AVX2_CONVERSION
+
+static inline AVG_TARGET_AVX2 __m256i coeffPairAVX2(short a, short b)
+{
+    return _mm256_set_epi16(b, a, b, a, b, a, b, a, b, a, b, a, b, a, b, a);
+}
+
+// Same as YUVtoBGR32PixelsSSE2, for sixteen pixels.
+static inline AVG_TARGET_AVX2 void YUVtoBGR32PixelsAVX2(__m256i y, __m256i u, __m256i v,
+        unsigned char* pDest)
+{
+    y = _mm256_sub_epi16(y, _mm256_set1_epi16(16));
+    u = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+    v = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+    __m256i zero = _mm256_setzero_si256();
+    __m256i yuLo = _mm256_unpacklo_epi16(y, u);
+    __m256i yuHi = _mm256_unpackhi_epi16(y, u);
+    __m256i yvLo = _mm256_unpacklo_epi16(y, v);
+    __m256i yvHi = _mm256_unpackhi_epi16(y, v);
+    __m256i vLo = _mm256_unpacklo_epi16(v, zero);
+    __m256i vHi = _mm256_unpackhi_epi16(v, zero);
+
+    __m256i bCoeffs = coeffPairAVX2(298, 516);
+    __m256i gCoeffs = coeffPairAVX2(298, -100);
+    __m256i gvCoeffs = coeffPairAVX2(-208, 0);
+    __m256i rCoeffs = coeffPairAVX2(298, 409);
+    __m256i b = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_madd_epi16(yuLo, bCoeffs), 8),
+            _mm256_srai_epi32(_mm256_madd_epi16(yuHi, bCoeffs), 8));
+    __m256i g = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuLo, gCoeffs), 
+                    _mm256_madd_epi16(vLo, gvCoeffs)), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuHi, gCoeffs), 
+                    _mm256_madd_epi16(vHi, gvCoeffs)), 8));
+    __m256i r = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_madd_epi16(yvLo, rCoeffs), 8),
+            _mm256_srai_epi32(_mm256_madd_epi16(yvHi, rCoeffs), 8));
+    b = _mm256_packus_epi16(b, b);
+    g = _mm256_packus_epi16(g, g);
+    r = _mm256_packus_epi16(r, r);
+    __m256i bg = _mm256_unpacklo_epi8(b, g);
+    __m256i ra = _mm256_unpacklo_epi8(r, _mm256_set1_epi8(-1));
+    // Everything above works on the two 128 bit lanes separately.
+    __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+    __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+    _mm256_storeu_si256((__m256i*)pDest, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i*)(pDest+32), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+template<int Y_POS>
+static AVG_TARGET_AVX2 void YUV422toBGR32LineAVX2(const unsigned char* pSrcLine, 
+        Pixel32* pDestLine, int width, int& numPairsDone)
+{
+    const int uPos = 1-Y_POS;
+    const int vPos = 3-Y_POS;
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+    const __m256i lowWords = _mm256_set1_epi32(0x0000FFFF);
+    int numPairs = width/2;
+    int prevV = pSrcLine[vPos];
+    int k = 0;
+    for (; k+8 <= numPairs-1; k += 8) {
+        const unsigned char* pSrc = pSrcLine + k*4;
+        __m256i src = _mm256_loadu_si256((const __m256i*)pSrc);
+        __m256i y;
+        __m256i chroma;
+        if (Y_POS == 0) {
+            y = _mm256_and_si256(src, lowBytes);
+            chroma = _mm256_srli_epi16(src, 8);
+        } else {
+            y = _mm256_srli_epi16(src, 8);
+            chroma = _mm256_and_si256(src, lowBytes);
+        }
+        __m256i u32 = _mm256_and_si256(chroma, lowWords);
+        __m256i v32 = _mm256_srli_epi32(chroma, 16);
+        // Byte shifts don't cross 128 bit lanes, so the neighbouring values at the lane 
+        // borders are inserted separately.
+        __m256i nextU32 = _mm256_or_si256(_mm256_srli_si256(u32, 4),
+                _mm256_set_epi32(pSrc[32+uPos], 0, 0, 0, pSrc[16+uPos], 0, 0, 0));
+        __m256i prevV32 = _mm256_or_si256(_mm256_slli_si256(v32, 4), 
+                _mm256_set_epi32(0, 0, 0, pSrc[12+vPos], 0, 0, 0, prevV));
+        __m256i u = _mm256_srli_epi16(_mm256_add_epi16(
+                _mm256_or_si256(u32, _mm256_slli_epi32(u32, 16)),
+                _mm256_or_si256(u32, _mm256_slli_epi32(nextU32, 16))), 1);
+        __m256i v = _mm256_srli_epi16(_mm256_add_epi16(
+                _mm256_or_si256(prevV32, _mm256_slli_epi32(v32, 16)),
+                _mm256_or_si256(v32, _mm256_slli_epi32(v32, 16))), 1);
+        YUVtoBGR32PixelsAVX2(y, u, v, (unsigned char*)(pDestLine + k*2));
+        prevV = pSrc[28+vPos];
+    }
+    numPairsDone = k;
+}
+
+static AVG_TARGET_AVX2 int YUYV422toI8AVX2(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width)
+{
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+    int x = 0;
+    for (; x+32 < width; x += 32) {
+        __m256i src0 = _mm256_loadu_si256((const __m256i*)(pSrcLine + x*2));
+        __m256i src1 = _mm256_loadu_si256((const __m256i*)(pSrcLine + x*2 + 32));
+        __m256i packed = _mm256_packus_epi16(_mm256_and_si256(src0, lowBytes), 
+                _mm256_and_si256(src1, lowBytes));
+        _mm256_storeu_si256((__m256i*)(pDestLine + x), 
+                _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return x;
+}
+
+static AVG_TARGET_AVX2 int I8toBGR32AVX2(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width)
+{
+    const __m256i factor = _mm256_set1_epi32(0x00010101);
+    const __m256i alpha = _mm256_set1_epi32(0xFF000000);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m256i gray0 = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64((const __m128i*)(pSrcLine + x)));
+        __m256i gray1 = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64((const __m128i*)(pSrcLine + x + 8)));
+        unsigned char* pDest = pDestLine + x*4;
+        _mm256_storeu_si256((__m256i*)pDest, 
+                _mm256_or_si256(_mm256_mullo_epi32(gray0, factor), alpha));
+        _mm256_storeu_si256((__m256i*)(pDest+32), 
+                _mm256_or_si256(_mm256_mullo_epi32(gray1, factor), alpha));
+    }
+    return x;
+}
+
+static AVG_TARGET_AVX2 int BGR24toBGR32AVX2(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width)
+{
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 
+            9, 10, 11, -1);
+    // The last load starts four bytes early so it doesn't read past the 16 pixels.
+    const __m128i lastShuffle = _mm_setr_epi8(4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1,
+            13, 14, 15, -1);
+    const __m128i alpha = _mm_set1_epi32(0xFF000000);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        const unsigned char* pSrc = pSrcLine + x*3;
+        unsigned char* pDest = pDestLine + x*4;
+        __m128i src0 = _mm_loadu_si128((const __m128i*)pSrc);
+        __m128i src1 = _mm_loadu_si128((const __m128i*)(pSrc+12));
+        __m128i src2 = _mm_loadu_si128((const __m128i*)(pSrc+24));
+        __m128i src3 = _mm_loadu_si128((const __m128i*)(pSrc+32));
+        _mm_storeu_si128((__m128i*)pDest, 
+                _mm_or_si128(_mm_shuffle_epi8(src0, shuffle), alpha));
+        _mm_storeu_si128((__m128i*)(pDest+16), 
+                _mm_or_si128(_mm_shuffle_epi8(src1, shuffle), alpha));
+        _mm_storeu_si128((__m128i*)(pDest+32), 
+                _mm_or_si128(_mm_shuffle_epi8(src2, shuffle), alpha));
+        _mm_storeu_si128((__m128i*)(pDest+48), 
+                _mm_or_si128(_mm_shuffle_epi8(src3, lastShuffle), alpha));
+    }
+    return x;
+}
+
+static inline AVG_TARGET_AVX2 __m256i weighPixelsAVX2(const unsigned char* pSrc, 
+        __m256i w0, __m256i w1, __m256i w2)
+{
+    const __m256i lowBytes = _mm256_set1_epi32(0xFF);
+    __m256i src = _mm256_loadu_si256((const __m256i*)pSrc);
+    __m256i sum = _mm256_mullo_epi16(_mm256_and_si256(src, lowBytes), w0);
+    sum = _mm256_add_epi32(sum, _mm256_mullo_epi16(
+            _mm256_and_si256(_mm256_srli_epi32(src, 8), lowBytes), w1));
+    sum = _mm256_add_epi32(sum, _mm256_mullo_epi16(
+            _mm256_and_si256(_mm256_srli_epi32(src, 16), lowBytes), w2));
+    return _mm256_srli_epi32(sum, 8);
+}
+
+static AVG_TARGET_AVX2 int BGR32toI8AVX2(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width, bool bRedFirst)
+{
+    __m256i w0 = _mm256_set1_epi32(bRedFirst ? 54 : 19);
+    __m256i w1 = _mm256_set1_epi32(183);
+    __m256i w2 = _mm256_set1_epi32(bRedFirst ? 19 : 54);
+    // Undoes the lane interleaving of the pack instructions.
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = 0;
+    for (; x+32 <= width; x += 32) {
+        const unsigned char* pSrc = pSrcLine + x*4;
+        __m256i i0 = weighPixelsAVX2(pSrc, w0, w1, w2);
+        __m256i i1 = weighPixelsAVX2(pSrc+32, w0, w1, w2);
+        __m256i i2 = weighPixelsAVX2(pSrc+64, w0, w1, w2);
+        __m256i i3 = weighPixelsAVX2(pSrc+96, w0, w1, w2);
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(i0, i1), 
+                _mm256_packs_epi32(i2, i3));
+        _mm256_storeu_si256((__m256i*)(pDestLine + x), 
+                _mm256_permutevar8x32_epi32(packed, order));
+    }
+    return x;
+}
+
+static AVG_TARGET_AVX2 int ByteToFloatAVX2(const unsigned char* pSrcLine, 
+        float* pDestLine, int numValues)
+{
+    const __m256 divisor = _mm256_set1_ps(255.f);
+    int x = 0;
+    for (; x+16 <= numValues; x += 16) {
+        __m256i src0 = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64((const __m128i*)(pSrcLine + x)));
+        __m256i src1 = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64((const __m128i*)(pSrcLine + x + 8)));
+        _mm256_storeu_ps(pDestLine + x, 
+                _mm256_div_ps(_mm256_cvtepi32_ps(src0), divisor));
+        _mm256_storeu_ps(pDestLine + x + 8, 
+                _mm256_div_ps(_mm256_cvtepi32_ps(src1), divisor));
+    }
+    return x;
+}
+
+const char* AVX2PixelConverter::getName() const
+{
+    return "AVX2";
+}
+
+void AVX2PixelConverter::YUYV422toBGR32Line(const unsigned char* pSrcLine, 
+        Pixel32* pDestLine, int width) const
+{
+    int numPairsDone;
+    YUV422toBGR32LineAVX2<0>(pSrcLine, pDestLine, width, numPairsDone);
+    YUV422toBGR32Pixels(pSrcLine, pDestLine, width, numPairsDone, 0, 1, 3);
+}
+
+void AVX2PixelConverter::UYVY422toBGR32Line(const unsigned char* pSrcLine, 
+        Pixel32* pDestLine, int width) const
+{
+    int numPairsDone;
+    YUV422toBGR32LineAVX2<1>(pSrcLine, pDestLine, width, numPairsDone);
+    YUV422toBGR32Pixels(pSrcLine, pDestLine, width, numPairsDone, 1, 0, 2);
+}
+
+void AVX2PixelConverter::YUYV422toI8Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    int x = YUYV422toI8AVX2(pSrcLine, pDestLine, width);
+    SSE2PixelConverter::YUYV422toI8Line(pSrcLine + x*2, pDestLine + x, width - x);
+}
+
+void AVX2PixelConverter::I8toBGR32Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    int x = I8toBGR32AVX2(pSrcLine, pDestLine, width);
+    SSE2PixelConverter::I8toBGR32Line(pSrcLine + x, pDestLine + x*4, width - x);
+}
+
+void AVX2PixelConverter::BGR24toBGR32Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    int x = BGR24toBGR32AVX2(pSrcLine, pDestLine, width);
+    PixelConverter::BGR24toBGR32Line(pSrcLine + x*3, pDestLine + x*4, width - x);
+}
+
+void AVX2PixelConverter::BGR32toI8Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width, bool bRedFirst) const
+{
+    int x = BGR32toI8AVX2(pSrcLine, pDestLine, width, bRedFirst);
+    SSE2PixelConverter::BGR32toI8Line(pSrcLine + x*4, pDestLine + x, width - x, 
+            bRedFirst);
+}
+
+void AVX2PixelConverter::ByteToFloatLine(const unsigned char* pSrcLine, 
+        float* pDestLine, int numValues) const
+{
+    int x = ByteToFloatAVX2(pSrcLine, pDestLine, numValues);
+    SSE2PixelConverter::ByteToFloatLine(pSrcLine + x, pDestLine + x, numValues - x);
+}
+
+#endif
+
+#ifdef AVG_ENABLE_NEON_CONVERSION
+
+const char* NEONPixelConverter::getName() const
+{
+    return "NEON";
+}
+
+void NEONPixelConverter::YUYV422toI8Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    int x = 0;
+    // Stops early so the loads never touch the byte after the last y value.
+    for (; x+16 < width; x += 16) {
+        uint8x16x2_t src = vld2q_u8(pSrcLine + x*2);
+        vst1q_u8(pDestLine + x, src.val[0]);
+    }
+    PixelConverter::YUYV422toI8Line(pSrcLine + x*2, pDestLine + x, width - x);
+}
+
+void NEONPixelConverter::I8toBGR32Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    uint8x16x4_t dest;
+    dest.val[3] = vdupq_n_u8(255);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        uint8x16_t gray = vld1q_u8(pSrcLine + x);
+        dest.val[0] = gray;
+        dest.val[1] = gray;
+        dest.val[2] = gray;
+        vst4q_u8(pDestLine + x*4, dest);
+    }
+    PixelConverter::I8toBGR32Line(pSrcLine + x, pDestLine + x*4, width - x);
+}
+
+void NEONPixelConverter::BGR24toBGR32Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width) const
+{
+    uint8x16x4_t dest;
+    dest.val[3] = vdupq_n_u8(255);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        uint8x16x3_t src = vld3q_u8(pSrcLine + x*3);
+        dest.val[0] = src.val[0];
+        dest.val[1] = src.val[1];
+        dest.val[2] = src.val[2];
+        vst4q_u8(pDestLine + x*4, dest);
+    }
+    PixelConverter::BGR24toBGR32Line(pSrcLine + x*3, pDestLine + x*4, width - x);
+}
+
+void NEONPixelConverter::BGR32toI8Line(const unsigned char* pSrcLine, 
+        unsigned char* pDestLine, int width, bool bRedFirst) const
+{
+    uint8x8_t w0 = vdup_n_u8(bRedFirst ? 54 : 19);
+    uint8x8_t w1 = vdup_n_u8(183);
+    uint8x8_t w2 = vdup_n_u8(bRedFirst ? 19 : 54);
+    int x = 0;
+    for (; x+8 <= width; x += 8) {
+        uint8x8x4_t src = vld4_u8(pSrcLine + x*4);
+        uint16x8_t sum = vmull_u8(src.val[0], w0);
+        sum = vmlal_u8(sum, src.val[1], w1);
+        sum = vmlal_u8(sum, src.val[2], w2);
+        vst1_u8(pDestLine + x, vshrn_n_u16(sum, 8));
+    }
+    PixelConverter::BGR32toI8Line(pSrcLine + x*4, pDestLine + x, width - x, bRedFirst);
+}
+
+#endif
+
+}
@@ -0,0 +1,109 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _SIMDPixelConverter_H_
+#define _SIMDPixelConverter_H_
+
+#include "../api.h"
+#include "PixelConverter.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AVG_ENABLE_SSE2_CONVERSION
+// AVX2 code is compiled for a separate target and only used if the cpu supports it.
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define AVG_ENABLE_AVX2_CONVERSION
+#endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define AVG_ENABLE_NEON_CONVERSION
+#endif
+
+namespace avg {
+
+#ifdef AVG_ENABLE_SSE2_CONVERSION
+class AVG_API SSE2PixelConverter: public PixelConverter
+{
+public:
+    virtual const char* getName() const;
+
+    virtual void YUYV422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine,
+            int width) const;
+    virtual void UYVY422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine,
+            int width) const;
+    virtual void YUYV422toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width) const;
+    virtual void I8toBGR32Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width) const;
+    virtual void BGR32toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width, bool bRedFirst) const;
+    virtual void ByteToFloatLine(const unsigned char* pSrcLine, float* pDestLine,
+            int numValues) const;
+    virtual void BY8toBGR32BilinearPairs(const unsigned char* pSrc, int srcStride,
+            unsigned char* pDest, int numPairs, bool bBlueFirst) const;
+};
+#endif
+
+#ifdef AVG_ENABLE_AVX2_CONVERSION
+// Conversions that don't profit from wider registers are inherited from SSE2.
+class AVG_API AVX2PixelConverter: public SSE2PixelConverter
+{
+public:
+    virtual const char* getName() const;
+
+    virtual void YUYV422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine,
+            int width) const;
+    virtual void UYVY422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine,
+            int width) const;
+    virtual void YUYV422toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width) const;
+    virtual void I8toBGR32Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width) const;
+    virtual void BGR24toBGR32Line(const unsigned char* pSrcLine, 
+            unsigned char* pDestLine, int width) const;
+    virtual void BGR32toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width, bool bRedFirst) const;
+    virtual void ByteToFloatLine(const unsigned char* pSrcLine, float* pDestLine,
+            int numValues) const;
+};
+#endif
+
+#ifdef AVG_ENABLE_NEON_CONVERSION
+// NEON is a compile-time option (-mfpu=neon), so there is no runtime check.
+class AVG_API NEONPixelConverter: public PixelConverter
+{
+public:
+    virtual const char* getName() const;
+
+    virtual void YUYV422toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width) const;
+    virtual void I8toBGR32Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width) const;
+    virtual void BGR24toBGR32Line(const unsigned char* pSrcLine, 
+            unsigned char* pDestLine, int width) const;
+    virtual void BGR32toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine,
+            int width, bool bRedFirst) const;
+};
+#endif
+
+}
+
+#endif
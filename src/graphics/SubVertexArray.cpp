@@ -38,6 +38,12 @@ using namespace boost;
 namespace avg {
 
 SubVertexArray::SubVertexArray()
+    : m_pVA(0),
+      m_StartVertex(0),
+      m_StartIndex(0),
+      m_NumVerts(0),
+      m_NumIndexes(0),
+      m_Generation(-1)
 {
 }
 
@@ -72,6 +78,7 @@ void SubVertexArray::addLineData(Pixel32 color, const glm::vec2& p1, const glm::
         float width, float tc1, float tc2)
 {
     m_pVA->addLineData(color, p1, p2, width, tc1, tc2);
+    m_NumVerts += 4;
     m_NumIndexes += 6;
 }
 
@@ -87,11 +94,30 @@ int SubVertexArray::getNumVerts() const
     return m_NumVerts;
 }
 
+int SubVertexArray::getNumIndexes() const
+{
+    return m_NumIndexes;
+}
+
 void SubVertexArray::draw()
 {
     m_pVA->draw(m_StartIndex, m_NumIndexes, m_StartVertex, m_StartIndex);
 }
 
+bool SubVertexArray::directlyFollows(const SubVertexArray& prevSubVA) const
+{
+    return m_pVA == prevSubVA.m_pVA && m_Generation == prevSubVA.m_Generation &&
+            m_StartIndex == prevSubVA.m_StartIndex+prevSubVA.m_NumIndexes;
+}
+
+void SubVertexArray::draw(const SubVertexArray& lastSubVA)
+{
+    AVG_ASSERT(m_pVA == lastSubVA.m_pVA && lastSubVA.m_StartIndex >= m_StartIndex);
+    unsigned numIndexes = lastSubVA.m_StartIndex+lastSubVA.m_NumIndexes-m_StartIndex;
+    unsigned numVerts = lastSubVA.m_StartVertex+lastSubVA.m_NumVerts-m_StartVertex;
+    m_pVA->draw(m_StartIndex, numIndexes, m_StartVertex, numVerts);
+}
+
 void SubVertexArray::dump() const
 {
     cerr << "SubVertexArray: m_StartVertex=" << m_StartVertex << ", " 
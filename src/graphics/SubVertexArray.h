@@ -47,17 +47,26 @@ public:
             float width, float tc1=0, float tc2=1);
     void appendVertexData(VertexDataPtr pVertexes);
     int getNumVerts() const;
+    int getNumIndexes() const;
 
     void draw();
+    // True if this sub-VA's indexes start right where prevSubVA's end. Such runs of
+    // sub-VAs can be drawn with a single draw(lastSubVA) call on the first one.
+    bool directlyFollows(const SubVertexArray& prevSubVA) const;
+    void draw(const SubVertexArray& lastSubVA);
     void dump() const;
 
 private:
+    friend class VertexArray;
+
     VertexArray* m_pVA;
         
     unsigned m_StartVertex;
     unsigned m_StartIndex;
     int m_NumVerts;
     int m_NumIndexes;
+    // VertexArray generation the data was last written or reused in.
+    int m_Generation;
 };
 
 inline void SubVertexArray::appendPos(const glm::vec2& pos, 
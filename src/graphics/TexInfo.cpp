@@ -41,6 +41,10 @@ TexCompression string2TexCompression(const std::string& s)
         return TEXCOMPRESSION_NONE;
     } else if (s == "B5G6R5") {
         return TEXCOMPRESSION_B5G6R5;
+    } else if (s == "BC") {
+        return TEXCOMPRESSION_BC;
+    } else if (s == "ETC2") {
+        return TEXCOMPRESSION_ETC2;
     } else {
         throw(Exception(AVG_ERR_UNSUPPORTED, "Texture compression "+s+" not supported."));
     }
@@ -53,18 +57,28 @@ std::string texCompression2String(TexCompression compression)
             return "none";
         case TEXCOMPRESSION_B5G6R5:
             return "B5G6R5";
+        case TEXCOMPRESSION_BC:
+            return "BC";
+        case TEXCOMPRESSION_ETC2:
+            return "ETC2";
         default:
             AVG_ASSERT(false);
             return 0;
     }
 }
 
+bool isBlockCompression(TexCompression compression)
+{
+    return compression == TEXCOMPRESSION_BC || compression == TEXCOMPRESSION_ETC2;
+}
+
 
 TexInfo::TexInfo(const IntPoint& size, PixelFormat pf, bool bMipmap, bool bUsePOT,
         int potBorderColor)
     : m_Size(size),
       m_pf(pf),
-      m_bMipmap(bMipmap),
+      // glGenerateMipmap() doesn't support compressed textures.
+      m_bMipmap(bMipmap && !pixelFormatIsBlockCompressed(pf)),
       m_bUsePOT(bUsePOT),
       m_POTBorderColor(potBorderColor)
 {
@@ -86,6 +100,13 @@ TexInfo::TexInfo(const IntPoint& size, PixelFormat pf, bool bMipmap, bool bUsePO
         throw Exception(AVG_ERR_UNSUPPORTED, 
                 "Float textures not supported by OpenGL configuration.");
     }
+
+    if (pixelFormatIsBlockCompressed(m_pf) && 
+            !GLContext::getCurrent()->isTexCompressionSupported(m_pf))
+    {
+        throw Exception(AVG_ERR_UNSUPPORTED, "Texture compression for " +
+                getPixelFormatString(m_pf) + " not supported by OpenGL configuration.");
+    }
 }
 
 TexInfo::~TexInfo()
@@ -109,6 +130,9 @@ PixelFormat TexInfo::getPF() const
     
 int TexInfo::getMemNeeded() const
 {
+    if (pixelFormatIsBlockCompressed(m_pf)) {
+        return ((m_GLSize.x+3)/4)*((m_GLSize.y+3)/4)*getBytesPerBlock(m_pf);
+    }
     return m_GLSize.x*m_GLSize.y*getBytesPerPixel(m_pf);
 }
 
@@ -211,6 +235,14 @@ int TexInfo::getGLInternalFormat() const
         case R8G8B8:
         case B5G6R5:
             return GL_RGB;
+        case BC1:
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BC3:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case ETC2_RGB8:
+            return GL_COMPRESSED_RGB8_ETC2;
+        case ETC2_RGBA8:
+            return GL_COMPRESSED_RGBA8_ETC2_EAC;
         default:
             AVG_ASSERT(false);
             return 0;
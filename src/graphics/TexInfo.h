@@ -34,11 +34,14 @@ namespace avg {
 
 enum TexCompression {
     TEXCOMPRESSION_NONE,
-    TEXCOMPRESSION_B5G6R5
+    TEXCOMPRESSION_B5G6R5,
+    TEXCOMPRESSION_BC,   // BC1 for opaque images, BC3 for images with alpha
+    TEXCOMPRESSION_ETC2  // ETC2_RGB8 for opaque images, ETC2_RGBA8 for images with alpha
 };
 
 TexCompression string2TexCompression(const std::string& s);
 std::string texCompression2String(TexCompression compression);
+bool isBlockCompression(TexCompression compression);
 
 class AVG_API TexInfo {
 
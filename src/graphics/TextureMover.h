@@ -50,6 +50,10 @@ public:
     virtual ~TextureMover();
 
     virtual void moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex) = 0;
+    // Uploads pBmp to the texture lines starting at startLine. pBmp must be as wide as
+    // the texture. Doesn't regenerate mipmaps.
+    virtual void moveBmpToTextureLines(BitmapPtr pBmp, GLTexture& tex, 
+            int startLine) = 0;
     virtual BitmapPtr moveTextureToBmp(GLTexture& tex, int mipmapLevel=0) = 0;
 
     PixelFormat getPF() const;
@@ -42,8 +42,18 @@ const unsigned VertexArray::TEX_INDEX = 0;
 const unsigned VertexArray::POS_INDEX = 1;
 const unsigned VertexArray::COLOR_INDEX = 2;
 
+VertexArray::BufferState::BufferState()
+    : m_Generation(-2),
+      m_NumVertsWritten(0),
+      m_NumIndexesWritten(0),
+      m_ReserveVerts(0),
+      m_ReserveIndexes(0)
+{
+}
+
 VertexArray::VertexArray(int reserveVerts, int reserveIndexes)
-    : VertexData(reserveVerts, reserveIndexes)
+    : VertexData(reserveVerts, reserveIndexes),
+      m_NumBytesUploaded(0)
 {
     GLContext* pContext = GLContext::getCurrent();
     m_bUseMapBuffer = (!pContext->isGLES());
@@ -67,26 +77,51 @@ VertexArray::~VertexArray()
     GLContextManager::get()->deleteBuffers(m_IndexBufferIDMap);
 }
 
+void VertexArray::reset()
+{
+    VertexData::reset();
+    m_NumBytesUploaded = 0;
+}
+
 void VertexArray::update(GLContext* pContext)
 {
     AVG_ASSERT(!m_VertexBufferIDMap.empty());
-    if (hasDataChanged()) {
-        unsigned vertexBufferID = m_VertexBufferIDMap[pContext];
+    BufferState& state = m_BufferStateMap[pContext];
+    int generation = getGeneration();
+    int numVertsWritten = getNumVertsWritten();
+    int numIndexesWritten = getNumIndexesWritten();
+    if (state.m_Generation == generation && state.m_NumVertsWritten == numVertsWritten
+            && state.m_NumIndexesWritten == numIndexesWritten)
+    {
+        // Already up to date.
+        return;
+    }
+    unsigned vertexBufferID = m_VertexBufferIDMap[pContext];
+    unsigned indexBufferID = m_IndexBufferIDMap[pContext];
+    // The dirty ranges are relative to the previous generation, so they can only be
+    // used if that is what the buffers contain.
+    bool bFullUpload = (state.m_Generation < generation-1 || 
+            state.m_ReserveVerts != getReserveVerts() ||
+            state.m_ReserveIndexes != getReserveIndexes());
+    if (bFullUpload) {
         transferBuffer(GL_ARRAY_BUFFER, vertexBufferID, 
                 getReserveVerts()*sizeof(Vertex), 
                 getNumVerts()*sizeof(Vertex), getVertexPointer());
-        unsigned indexBufferID = m_IndexBufferIDMap[pContext];
-#ifdef AVG_ENABLE_EGL        
         transferBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID, 
-                getReserveIndexes()*sizeof(unsigned short),
-                getNumIndexes()*sizeof(unsigned short), getIndexPointer());
-#else
-        transferBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID, 
-                getReserveIndexes()*sizeof(unsigned int),
-                getNumIndexes()*sizeof(unsigned int), getIndexPointer());
-#endif
-        GLContext::checkError("VertexArray::update()");
+                getReserveIndexes()*sizeof(GL_INDEX_TYPE),
+                getNumIndexes()*sizeof(GL_INDEX_TYPE), getIndexPointer());
+    } else {
+        transferRanges(GL_ARRAY_BUFFER, vertexBufferID, getDirtyVertRanges(),
+                sizeof(Vertex), getVertexPointer());
+        transferRanges(GL_ELEMENT_ARRAY_BUFFER, indexBufferID, getDirtyIndexRanges(),
+                sizeof(GL_INDEX_TYPE), getIndexPointer());
     }
+    GLContext::checkError("VertexArray::update()");
+    state.m_Generation = generation;
+    state.m_NumVertsWritten = numVertsWritten;
+    state.m_NumIndexesWritten = numIndexesWritten;
+    state.m_ReserveVerts = getReserveVerts();
+    state.m_ReserveIndexes = getReserveIndexes();
 }
 
 void VertexArray::activate(GLContext* pContext)
@@ -117,6 +152,7 @@ void VertexArray::draw(GLContext* pContext)
 #else
     glDrawElements(GL_TRIANGLES, getNumIndexes(), GL_UNSIGNED_INT, 0);
 #endif
+    pContext->incNumDrawCalls();
     GLContext::checkError("VertexArray::draw()");
 }
 
@@ -133,25 +169,66 @@ void VertexArray::draw(unsigned startIndex, unsigned numIndexes, unsigned startV
 //    XXX: Theoretically faster, but broken on Linux/Intel N10 graphics, Ubuntu 12/04
 //    glproc::DrawRangeElements(GL_TRIANGLES, startVertex, startVertex+numVertexes, 
 //            numIndexes, GL_UNSIGNED_SHORT, (void *)(startIndex*sizeof(unsigned short)));
+    GLContext::getCurrent()->incNumDrawCalls();
     GLContext::checkError("VertexArray::draw()");
 }
 
 void VertexArray::startSubVA(SubVertexArray& subVA)
 {
     subVA.init(this, getNumVerts(), getNumIndexes());
+    subVA.m_Generation = getGeneration();
+}
+
+bool VertexArray::reuseSubVA(SubVertexArray& subVA)
+{
+    // Everything appended in the previous generation is still there, and nothing has
+    // been appended at or after the current position in this generation.
+    if (subVA.m_pVA == this && subVA.m_Generation == getGeneration()-1 &&
+            subVA.m_StartVertex == unsigned(getNumVerts()) && 
+            subVA.m_StartIndex == unsigned(getNumIndexes()))
+    {
+        skip(subVA.m_NumVerts, subVA.m_NumIndexes);
+        subVA.m_Generation = getGeneration();
+        return true;
+    } else {
+        return false;
+    }
+}
+
+int VertexArray::getNumBytesUploaded() const
+{
+    return m_NumBytesUploaded;
 }
 
 void VertexArray::transferBuffer(GLenum target, unsigned bufferID, unsigned reservedSize, 
         unsigned usedSize, const void* pData)
 {
     glproc::BindBuffer(target, bufferID);
+    // The buffer needs to have its reserved size so later partial updates fit.
     if (m_bUseMapBuffer) {
-        glproc::BufferData(target, reservedSize, 0, GL_STREAM_DRAW);
+        glproc::BufferData(target, reservedSize, 0, GL_DYNAMIC_DRAW);
         void * pBuffer = glproc::MapBuffer(target, GL_WRITE_ONLY);
         memcpy(pBuffer, pData, usedSize);
         glproc::UnmapBuffer(target);
     } else {
-        glproc::BufferData(target, usedSize, pData, GL_STREAM_DRAW);
+        glproc::BufferData(target, reservedSize, 0, GL_DYNAMIC_DRAW);
+        glproc::BufferSubData(target, 0, usedSize, pData);
+    }
+    m_NumBytesUploaded += usedSize;
+}
+
+void VertexArray::transferRanges(GLenum target, unsigned bufferID, 
+        const RangeList& ranges, unsigned elementSize, const void* pData)
+{
+    if (ranges.empty()) {
+        return;
+    }
+    glproc::BindBuffer(target, bufferID);
+    for (unsigned i=0; i<ranges.size(); ++i) {
+        unsigned offset = ranges[i].first*elementSize;
+        unsigned size = (ranges[i].second-ranges[i].first)*elementSize;
+        glproc::BufferSubData(target, offset, size, (const char*)pData+offset);
+        m_NumBytesUploaded += size;
     }
 }
 
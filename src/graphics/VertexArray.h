@@ -44,6 +44,7 @@ public:
     void initForGLContext(GLContext* pContext);
     virtual ~VertexArray();
 
+    virtual void reset();
     void update(GLContext* pContext);
     void activate(GLContext* pContext);
     void draw(GLContext* pContext);
@@ -51,16 +52,37 @@ public:
             unsigned numVertexes);
 
     void startSubVA(SubVertexArray& subVA);
+    // If subVA was filled in the previous generation at the current position, its
+    // data is kept and true is returned. Otherwise, the caller needs to call 
+    // startSubVA() and fill it again.
+    bool reuseSubVA(SubVertexArray& subVA);
+
+    // Bytes sent to the graphics card since the last reset().
+    int getNumBytesUploaded() const;
 
 private:
+    struct BufferState {
+        BufferState();
+
+        int m_Generation;
+        int m_NumVertsWritten;
+        int m_NumIndexesWritten;
+        int m_ReserveVerts;
+        int m_ReserveIndexes;
+    };
+
     void transferBuffer(GLenum target, unsigned bufferID, unsigned reservedSize, 
             unsigned usedSize, const void* pData);
+    void transferRanges(GLenum target, unsigned bufferID, const RangeList& ranges,
+            unsigned elementSize, const void* pData);
 
     typedef std::map<const GLContext*, unsigned> BufferIDMap;
     BufferIDMap m_VertexBufferIDMap;
     BufferIDMap m_IndexBufferIDMap;
+    std::map<const GLContext*, BufferState> m_BufferStateMap;
 
     bool m_bUseMapBuffer;
+    int m_NumBytesUploaded;
 };
 
 typedef boost::shared_ptr<VertexArray> VertexArrayPtr;
@@ -44,7 +44,8 @@ VertexData::VertexData(int reserveVerts, int reserveIndexes)
       m_NumIndexes(0),
       m_ReserveVerts(reserveVerts),
       m_ReserveIndexes(reserveIndexes),
-      m_bDataChanged(true)
+      m_bDataChanged(true),
+      m_Generation(0)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     if (m_ReserveVerts < MIN_VERTEXES) {
@@ -79,6 +80,7 @@ void VertexData::appendPos(const glm::vec2& pos, const glm::vec2& texPos,
     pVertex->m_Tex[1] = (GLfloat)(texPos.y);
     pVertex->m_Color = color;
     m_bDataChanged = true;
+    markDirty(m_DirtyVertRanges, m_NumVerts, m_NumVerts+1);
     m_NumVerts++;
 }
 
@@ -90,6 +92,7 @@ void VertexData::appendTriIndexes(int v0, int v1, int v2)
     m_pIndexData[m_NumIndexes] = v0;
     m_pIndexData[m_NumIndexes+1] = v1;
     m_pIndexData[m_NumIndexes+2] = v2;
+    markDirty(m_DirtyIndexRanges, m_NumIndexes, m_NumIndexes+3);
     m_NumIndexes += 3;
 }
 
@@ -104,6 +107,7 @@ void VertexData::appendQuadIndexes(int v0, int v1, int v2, int v3)
     m_pIndexData[m_NumIndexes+3] = v1;
     m_pIndexData[m_NumIndexes+4] = v2;
     m_pIndexData[m_NumIndexes+5] = v3;
+    markDirty(m_DirtyIndexRanges, m_NumIndexes, m_NumIndexes+6);
     m_NumIndexes += 6;
 }
 
@@ -135,6 +139,12 @@ void VertexData::appendVertexData(const VertexDataPtr& pVertexes)
     for (int i=0; i<numIndexes; ++i) {
         m_pIndexData[oldNumIndexes+i] = pVertexes->m_pIndexData[i] + oldNumVerts;
     }
+    if (m_NumVerts > oldNumVerts) {
+        markDirty(m_DirtyVertRanges, oldNumVerts, m_NumVerts);
+    }
+    if (m_NumIndexes > oldNumIndexes) {
+        markDirty(m_DirtyIndexRanges, oldNumIndexes, m_NumIndexes);
+    }
     m_bDataChanged = true;
 }
 
@@ -152,7 +162,12 @@ void VertexData::reset()
 {
     m_NumVerts = 0;
     m_NumIndexes = 0;
-    m_bDataChanged = false;
+    // The contents are different from what they were before, even if nothing gets
+    // appended.
+    m_bDataChanged = true;
+    m_DirtyVertRanges.clear();
+    m_DirtyIndexRanges.clear();
+    m_Generation++;
 }
 
 int VertexData::getNumVerts() const
@@ -165,6 +180,31 @@ int VertexData::getNumIndexes() const
     return m_NumIndexes;
 }
 
+const VertexData::RangeList& VertexData::getDirtyVertRanges() const
+{
+    return m_DirtyVertRanges;
+}
+
+const VertexData::RangeList& VertexData::getDirtyIndexRanges() const
+{
+    return m_DirtyIndexRanges;
+}
+
+int VertexData::getNumVertsWritten() const
+{
+    return getRangeListSize(m_DirtyVertRanges);
+}
+
+int VertexData::getNumIndexesWritten() const
+{
+    return getRangeListSize(m_DirtyIndexRanges);
+}
+
+int VertexData::getGeneration() const
+{
+    return m_Generation;
+}
+
 void VertexData::dump() const
 {
     dump(0, m_NumVerts, 0, m_NumIndexes);
@@ -243,6 +283,23 @@ const GL_INDEX_TYPE * VertexData::getIndexPointer() const
     return m_pIndexData;
 }
 
+void VertexData::skip(int numVerts, int numIndexes)
+{
+    AVG_ASSERT(m_NumVerts+numVerts <= m_ReserveVerts);
+    AVG_ASSERT(m_NumIndexes+numIndexes <= m_ReserveIndexes);
+    m_NumVerts += numVerts;
+    m_NumIndexes += numIndexes;
+}
+
+int VertexData::getRangeListSize(const RangeList& ranges)
+{
+    int size = 0;
+    for (unsigned i=0; i<ranges.size(); ++i) {
+        size += ranges[i].second-ranges[i].first;
+    }
+    return size;
+}
+
 std::ostream& operator<<(std::ostream& os, const Vertex& v)
 {
     os << "  ((" << v.m_Pos[0] << ", " << v.m_Pos[1] << "), (" 
@@ -31,6 +31,8 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <vector>
+
 namespace avg {
 
 struct Vertex {
@@ -62,10 +64,21 @@ public:
     void appendVertexData(const VertexDataPtr& pVertexes);
     bool hasDataChanged() const;
     void resetDataChanged();
-    void reset();
+    virtual void reset();
 
     int getNumVerts() const;
     int getNumIndexes() const;
+
+    // Ranges ([first, last+1)) of vertexes and indexes written since the last reset().
+    // Everything else still contains the data from before the reset.
+    typedef std::vector<std::pair<int, int> > RangeList;
+    const RangeList& getDirtyVertRanges() const;
+    const RangeList& getDirtyIndexRanges() const;
+    int getNumVertsWritten() const;
+    int getNumIndexesWritten() const;
+    // Incremented on every reset().
+    int getGeneration() const;
+
     void dump() const;
     void dump(unsigned startVertex, int numVerts, unsigned startIndex, int numIndexes) 
             const;
@@ -77,11 +90,16 @@ protected:
     const Vertex * getVertexPointer() const;
     const GL_INDEX_TYPE * getIndexPointer() const;
 
+    // Keeps the data that is already at the current position.
+    void skip(int numVerts, int numIndexes);
+
     static const int MIN_VERTEXES;
     static const int MIN_INDEXES;
 
 private:
     void grow();
+    void markDirty(RangeList& ranges, int start, int end);
+    static int getRangeListSize(const RangeList& ranges);
 
     int m_NumVerts;
     int m_NumIndexes;
@@ -91,8 +109,20 @@ private:
     GL_INDEX_TYPE * m_pIndexData;
 
     bool m_bDataChanged;
+    RangeList m_DirtyVertRanges;
+    RangeList m_DirtyIndexRanges;
+    int m_Generation;
 };
 
+inline void VertexData::markDirty(RangeList& ranges, int start, int end)
+{
+    if (!ranges.empty() && ranges.back().second == start) {
+        ranges.back().second = end;
+    } else {
+        ranges.push_back(std::pair<int, int>(start, end));
+    }
+}
+
 std::ostream& operator<<(std::ostream& os, const Vertex& v);
 
 }
@@ -0,0 +1,121 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "GLContext.h"
+#include "GLContextManager.h"
+#include "ShaderRegistry.h"
+#include "BitmapLoader.h"
+#include "MCFBO.h"
+#include "FBO.h"
+#include "ReadbackRing.h"
+
+#include "../base/Exception.h"
+#include "../base/FileHelper.h"
+#include "../base/TimeSource.h"
+
+#include <iostream>
+
+using namespace avg;
+using namespace std;
+
+// Main-thread time per frame for reading back a full HD framebuffer. The GPU work
+// between readbacks is simulated by clearing the framebuffer several times.
+
+static const IntPoint FRAME_SIZE(1920, 1080);
+static const int NUM_FRAMES = 200;
+
+void renderFrame(FBOPtr pFBO, int i)
+{
+    pFBO->activate();
+    for (int j = 0; j < 10; ++j) {
+        glClearColor((i%256)/255.f, j/10.f, 0, 1);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+}
+
+void runSyncBenchmark(FBOPtr pFBO)
+{
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    for (int i = 0; i < NUM_FRAMES; ++i) {
+        renderFrame(pFBO, i);
+        BitmapPtr pBmp = pFBO->getImage();
+    }
+    float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.;
+    cerr << "Synchronous readback: " << activeTime/NUM_FRAMES << " ms" << endl;
+}
+
+void runRingBenchmark(FBOPtr pFBO, int numBuffers)
+{
+    ReadbackRingPtr pRing = pFBO->createReadbackRing(numBuffers);
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    for (int i = 0; i < NUM_FRAMES; ++i) {
+        renderFrame(pFBO, i);
+        if (pRing->isFull()) {
+            pRing->getImage(true);
+        }
+        pFBO->startReadback(*pRing);
+        // Collect everything that's done without blocking, like VideoWriter does.
+        while (pRing->getImage(false)) {
+        }
+    }
+    while (pRing->getNumPending() > 0) {
+        pRing->getImage(true);
+    }
+    float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.;
+    cerr << "ReadbackRing, " << numBuffers << " buffer(s): " << activeTime/NUM_FRAMES 
+            << " ms" << endl;
+}
+
+int main(int nargs, char** args)
+{
+    try {
+        BitmapLoader::init(true);
+        GLContextManager cm;
+        if (fileExists("./shaders")) {
+            ShaderRegistry::setShaderPath("./shaders");
+        } else {
+            ShaderRegistry::setShaderPath("../shaders");
+        }
+        GLContext* pContext = cm.createContext(GLConfig(false, false, true, 1, 
+                GLConfig::AUTO, true));
+        if (pContext->getMemoryMode() != MM_PBO) {
+            cerr << "Skipping readback benchmark: PBOs not supported." << endl;
+            delete pContext;
+            return 0;
+        }
+        cerr << "Fences supported: " << pContext->areFencesSupported() << endl;
+        {
+            MCFBOPtr pMCFBO = cm.createFBO(FRAME_SIZE, B8G8R8A8);
+            cm.uploadData();
+            FBOPtr pFBO = pMCFBO->getCurFBO(pContext);
+            runSyncBenchmark(pFBO);
+            for (int numBuffers = 1; numBuffers <= 3; ++numBuffers) {
+                runRingBenchmark(pFBO, numBuffers);
+            }
+        }
+        delete pContext;
+    } catch (Exception& ex) {
+        cerr << "Skipping readback benchmark." << endl;
+        cerr << "Reason: " << ex.getStr() << endl;
+    }
+}
+
@@ -25,6 +25,8 @@
 #include "Pixel32.h"
 #include "Pixel24.h"
 #include "Pixel16.h"
+#include "PixelConverter.h"
+#include "BlockCompressor.h"
 #include "Filtergrayscale.h"
 #include "Filterfill.h"
 #include "Filterflip.h"
@@ -40,8 +42,10 @@
 #include "../base/TimeSource.h"
 
 #include <iostream>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
 
 using namespace avg;
 using namespace std;
@@ -233,6 +237,83 @@ private:
         
 };
 
+// Times the line conversions of all pixel converters the cpu supports.
+void runPixelConverterTests()
+{
+    const int width = 1024;
+    const int numLines = 1024*20;
+    vector<unsigned char> src(width*4);
+    for (unsigned i = 0; i < src.size(); ++i) {
+        src[i] = (unsigned char)(rand() & 255);
+    }
+    vector<unsigned char> dest(width*4);
+    vector<float> floatDest(width*4);
+    const vector<const PixelConverter*>& converters = PixelConverter::getAvailable();
+    for (unsigned i = 0; i < converters.size(); ++i) {
+        const PixelConverter* pConverter = converters[i];
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        for (int y = 0; y < numLines; ++y) {
+            pConverter->YUYV422toBGR32Line(&src[0], (Pixel32*)&dest[0], width);
+        }
+        long long yuvTime = TimeSource::get()->getCurrentMicrosecs();
+        for (int y = 0; y < numLines; ++y) {
+            pConverter->I8toBGR32Line(&src[0], &dest[0], width);
+        }
+        long long i8Time = TimeSource::get()->getCurrentMicrosecs();
+        for (int y = 0; y < numLines; ++y) {
+            pConverter->BGR32toI8Line(&src[0], &dest[0], width, false);
+        }
+        long long grayTime = TimeSource::get()->getCurrentMicrosecs();
+        for (int y = 0; y < numLines/4; ++y) {
+            pConverter->ByteToFloatLine(&src[0], &floatDest[0], width*4);
+        }
+        long long floatTime = TimeSource::get()->getCurrentMicrosecs();
+        cerr << "PixelConverter " << pConverter->getName() << " (ms per 1024x1024): " 
+                << "YUYV422->BGR32: " << (yuvTime-startTime)/20000. 
+                << ", I8->BGR32: " << (i8Time-yuvTime)/20000.
+                << ", BGR32->I8: " << (grayTime-i8Time)/20000.
+                << ", RGBA->float: " << (floatTime-grayTime)/5000. << endl;
+    }
+}
+
+// Reports encoding speed and quality (PSNR of the color channels) per format.
+void runBlockCompressionTests()
+{
+    IntPoint size(1024, 1024);
+    BitmapPtr pSrcBmp(new Bitmap(size, R8G8B8A8));
+    for (int y = 0; y < size.y; ++y) {
+        unsigned char* pLine = pSrcBmp->getPixels() + y*pSrcBmp->getStride();
+        for (int x = 0; x < size.x; ++x) {
+            pLine[x*4] = (unsigned char)(x/4);
+            pLine[x*4+1] = (unsigned char)(y/4);
+            pLine[x*4+2] = (unsigned char)(128+100*sin(x*0.05)*cos(y*0.07));
+            pLine[x*4+3] = (unsigned char)((x+y)/8);
+        }
+    }
+    const PixelFormat pfs[] = {BC1, BC3, ETC2_RGB8, ETC2_RGBA8};
+    for (int i = 0; i < 4; ++i) {
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        BitmapPtr pCompressedBmp = compressBlocks(*pSrcBmp, pfs[i]);
+        float time = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+        BitmapPtr pDestBmp = decompressBlocks(*pCompressedBmp, R8G8B8A8);
+        double sqrErr = 0;
+        for (int y = 0; y < size.y; ++y) {
+            const unsigned char* pSrc = pSrcBmp->getPixels() + y*pSrcBmp->getStride();
+            const unsigned char* pDest = pDestBmp->getPixels() + y*pDestBmp->getStride();
+            for (int x = 0; x < size.x*4; ++x) {
+                if (x%4 != 3) {
+                    double diff = double(pSrc[x])-pDest[x];
+                    sqrErr += diff*diff;
+                }
+            }
+        }
+        double mse = sqrErr/(size.x*size.y*3);
+        cerr << "BlockCompression " << getPixelFormatString(pfs[i]) 
+                << " (1024x1024): " << time << " ms, PSNR: " 
+                << 10*log10(255*255/mse) << " dB" << endl;
+    }
+}
+
 void runPerformanceTests()
 {
     runPerformanceTest<LoadPNGPerfTest>();
@@ -244,6 +325,8 @@ void runPerformanceTests()
     runPerformanceTest<CopyRGBPerfTest>();
     runPerformanceTest<CopyRGBAPerfTest>();
     runPerformanceTest<YUV2RGBPerfTest>(200);
+    runPixelConverterTests();
+    runBlockCompressionTests();
 }
 
 int main(int nargs, char** args)
@@ -35,6 +35,9 @@
 #include "ShaderRegistry.h"
 #include "BmpTextureMover.h"
 #include "PBO.h"
+#include "FBO.h"
+#include "MCFBO.h"
+#include "ReadbackRing.h"
 #include "ImageCache.h"
 #include "CachedImage.h"
 
@@ -434,6 +437,124 @@ private:
 };
 
 
+class TextureUploadTest: public GraphicsTest {
+public:
+    TextureUploadTest()
+        : GraphicsTest("TextureUploadTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        GLContextManager* pCM = GLContextManager::get();
+        BitmapPtr pOrigBmp = loadTestBmp("rgb24-65x65");
+        pCM->setTexUploadBudget(pOrigBmp->getLineLen()*10);
+        pCM->startFrame();
+        MCTexturePtr pPrefetchTex = pCM->createTextureFromBmp(pOrigBmp, true, false, 0,
+                GLContextManager::UPLOAD_PREFETCH);
+        MCTexturePtr pVisibleTex = pCM->createTextureFromBmp(pOrigBmp, false, false, 0,
+                GLContextManager::UPLOAD_PREFETCH);
+        pCM->promoteTexUpload(pVisibleTex);
+        TEST(!pPrefetchTex->isResident());
+        TEST(!pVisibleTex->isResident());
+        TEST(pCM->getNumDeferredTexUploads() == 2);
+
+        // 10 lines per frame, visible textures first.
+        int numFrames = runUntilResident(pVisibleTex);
+        TEST(numFrames == 7);
+        TEST(!pPrefetchTex->isResident());
+        numFrames = runUntilResident(pPrefetchTex);
+        TEST(numFrames == 6);
+        TEST(pCM->getNumDeferredTexUploads() == 0);
+        GLContext* pContext = GLContext::getCurrent();
+        BitmapPtr pDestBmp = pVisibleTex->getTex(pContext)->moveTextureToBmp();
+        testEqual(*pDestBmp, *pOrigBmp, "deferred-visible", 0.01, 0.1);
+        pDestBmp = pPrefetchTex->getTex(pContext)->moveTextureToBmp();
+        testEqual(*pDestBmp, *pOrigBmp, "deferred-prefetch", 0.01, 0.1);
+
+        // Immediate uploads aren't affected by the budget.
+        MCTexturePtr pTex = pCM->createTextureFromBmp(pOrigBmp);
+        TEST(pTex->isResident());
+        TEST(pCM->getNumDeferredTexUploads() == 0);
+        pCM->uploadData();
+        pCM->setTexUploadBudget(0);
+    }
+
+private:
+    int runUntilResident(MCTexturePtr pTex)
+    {
+        GLContextManager* pCM = GLContextManager::get();
+        int numFrames = 0;
+        while (!pTex->isResident()) {
+            pCM->uploadData();
+            pCM->startFrame();
+            numFrames++;
+        }
+        return numFrames;
+    }
+};
+
+
+class ReadbackRingTest: public GraphicsTest {
+public:
+    ReadbackRingTest()
+        : GraphicsTest("ReadbackRingTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        for (int numBuffers = 1; numBuffers <= 3; ++numBuffers) {
+            cerr << "    Testing " << numBuffers << " buffer(s)" << endl;
+            runBufferTest(numBuffers);
+        }
+    }
+
+private:
+    void runBufferTest(int numBuffers)
+    {
+        GLContextManager* pCM = GLContextManager::get();
+        MCFBOPtr pMCFBO = pCM->createFBO(IntPoint(64, 64), B8G8R8A8);
+        pCM->uploadData();
+        GLContext* pContext = GLContext::getCurrent();
+        FBOPtr pFBO = pMCFBO->getCurFBO(pContext);
+        ReadbackRingPtr pRing = pFBO->createReadbackRing(numBuffers);
+        TEST(pRing->getNumBuffers() == numBuffers);
+
+        // Each frame gets a different color. Images must come back in order.
+        int numFramesRead = 0;
+        for (int i = 0; i < 6; ++i) {
+            if (pRing->isFull()) {
+                checkFrame(pRing->getImage(true), numFramesRead);
+                numFramesRead++;
+            }
+            pFBO->activate();
+            glClearColor(i*40/255.f, 0, 0, 1);
+            glClear(GL_COLOR_BUFFER_BIT);
+            GLContext::checkError("ReadbackRingTest: glClear()");
+            pFBO->startReadback(*pRing);
+            TEST(pRing->getNumPending() == min(i-numFramesRead+1, numBuffers));
+        }
+        while (pRing->getNumPending() > 0) {
+            checkFrame(pRing->getImage(true), numFramesRead);
+            numFramesRead++;
+        }
+        TEST(numFramesRead == 6);
+        TEST(pRing->getImage(true) == BitmapPtr());
+        glproc::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void checkFrame(BitmapPtr pBmp, int i)
+    {
+        TEST(pBmp != BitmapPtr());
+        TEST(pBmp->getSize() == IntPoint(64, 64));
+        Pixel32 color = *(Pixel32*)(pBmp->getPixels());
+        TEST(abs(int(color.getR()) - i*40) <= 1);
+        TEST(color.getG() == 0);
+    }
+};
+
+
 class ImageCacheTest: public GraphicsTest {
 public:
     ImageCacheTest()
@@ -510,7 +631,11 @@ public:
         : TestSuite("GPUTestSuite ("+sVariant+")")
     {
         addTest(TestPtr(new TextureMoverTest));
+        addTest(TestPtr(new TextureUploadTest));
         addTest(TestPtr(new ImageCacheTest));
+        if (GLContext::getCurrent()->getMemoryMode() == MM_PBO) {
+            addTest(TestPtr(new ReadbackRingTest));
+        }
         addTest(TestPtr(new BrightnessFilterTest));
         addTest(TestPtr(new HueSatFilterTest));
         addTest(TestPtr(new InvertFilterTest));
@@ -22,10 +22,14 @@
 #include "GraphicsTest.h"
 #include "Bitmap.h"
 #include "BitmapLoader.h"
+#include "BitmapDiskCache.h"
+#include "BlockCompressor.h"
 #include "Pixel32.h"
 #include "Pixel24.h"
 #include "Pixel16.h"
+#include "PixelConverter.h"
 #include "Color.h"
+#include "VertexData.h"
 #include "Filtercolorize.h"
 #include "Filtergrayscale.h"
 #include "Filterfill.h"
@@ -442,6 +446,363 @@ private:
 
 };
 
+class BitmapDiskCacheTest: public GraphicsTest {
+public:
+    BitmapDiskCacheTest()
+        : GraphicsTest("BitmapDiskCacheTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        char * pSrcDir = getenv("srcdir");
+        string sFilename;
+        if (pSrcDir) {
+            sFilename = (string)pSrcDir+"/";
+        }
+        sFilename += "../test/media/rgb24-64x64.png";
+        BitmapPtr pBmp = loadBitmap(sFilename);
+        string sDir = "testimgdiskcache";
+        {
+            BitmapDiskCache cache(sDir, 1024*1024);
+            cache.clear();
+            TEST(!cache.load(sFilename, NO_PIXELFORMAT, true));
+            cache.save(sFilename, NO_PIXELFORMAT, true, *pBmp);
+            TEST(cache.getSize() > 0);
+            BitmapPtr pCachedBmp = cache.load(sFilename, NO_PIXELFORMAT, true);
+            TEST(pCachedBmp.get() != 0);
+            testEqual(*pCachedBmp, *pBmp, "DiskCacheLoad", 0, 0);
+            // Changing the loaded bitmap mustn't change the cache entry.
+            FilterFlipRGB().applyInPlace(pCachedBmp);
+            pCachedBmp = cache.load(sFilename, NO_PIXELFORMAT, true);
+            testEqual(*pCachedBmp, *pBmp, "DiskCacheModify", 0, 0);
+            TEST(!cache.load(sFilename, R8G8B8, true));
+            TEST(!cache.load(sFilename, NO_PIXELFORMAT, false));
+        }
+        {
+            cerr << "    Testing reopen." << endl;
+            BitmapDiskCache cache(sDir, 1024*1024);
+            long long entrySize = cache.getSize();
+            TEST(entrySize > 0);
+            BitmapPtr pCachedBmp = cache.load(sFilename, NO_PIXELFORMAT, true);
+            TEST(pCachedBmp.get() != 0);
+            testEqual(*pCachedBmp, *pBmp, "DiskCacheReopen", 0, 0);
+
+            cerr << "    Testing size limit." << endl;
+            BitmapDiskCache smallCache(sDir, entrySize);
+            BitmapPtr pRGBBmp = loadBitmap(sFilename, R8G8B8);
+            smallCache.save(sFilename, R8G8B8, true, *pRGBBmp);
+            TEST(smallCache.getSize() <= entrySize);
+            TEST(smallCache.load(sFilename, R8G8B8, true).get() != 0);
+            smallCache.clear();
+            TEST(smallCache.getSize() == 0);
+        }
+    }
+};
+
+class VertexDataTest: public GraphicsTest {
+public:
+    VertexDataTest()
+        : GraphicsTest("VertexDataTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        TestVertexData vd;
+        appendQuad(vd);
+        appendQuad(vd);
+        TEST(vd.getNumVertsWritten() == 8);
+        TEST(vd.getDirtyVertRanges().size() == 1);
+        TEST(vd.getDirtyIndexRanges().size() == 1);
+        int generation = vd.getGeneration();
+
+        // Keep the first quad, rewrite the second one.
+        vd.reset();
+        TEST(vd.getGeneration() == generation+1);
+        TEST(vd.getNumVertsWritten() == 0);
+        vd.skipQuad();
+        appendQuad(vd);
+        TEST(vd.getNumVerts() == 8);
+        TEST(vd.getNumIndexes() == 12);
+        TEST(vd.getNumVertsWritten() == 4);
+        TEST(vd.getNumIndexesWritten() == 6);
+        const VertexData::RangeList& ranges = vd.getDirtyVertRanges();
+        TEST(ranges.size() == 1 && ranges[0].first == 4 && ranges[0].second == 8);
+
+        // Ranges that aren't adjacent stay separate.
+        vd.reset();
+        appendQuad(vd);
+        vd.skipQuad();
+        appendQuad(vd);
+        TEST(vd.getDirtyVertRanges().size() == 2);
+        TEST(vd.getNumVertsWritten() == 8);
+    }
+
+private:
+    class TestVertexData: public VertexData {
+    public:
+        void skipQuad()
+        {
+            skip(4, 6);
+        }
+    };
+
+    void appendQuad(VertexData& vd)
+    {
+        int curVertex = vd.getNumVerts();
+        for (int i=0; i<4; ++i) {
+            vd.appendPos(glm::vec2(i, i), glm::vec2(0, 0));
+        }
+        vd.appendQuadIndexes(curVertex, curVertex+1, curVertex+2, curVertex+3);
+    }
+};
+
+class PixelConverterTest: public GraphicsTest {
+public:
+    PixelConverterTest()
+        : GraphicsTest("PixelConverterTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        // Odd widths and widths below the SIMD block sizes exercise the scalar tails.
+        const int widths[] = {2, 7, 16, 33, 66, 1023};
+        const vector<const PixelConverter*>& converters = PixelConverter::getAvailable();
+        TEST(string(converters[0]->getName()) == "scalar");
+        for (unsigned i = 1; i < converters.size(); ++i) {
+            cerr << "    Testing " << converters[i]->getName() << endl;
+            for (int j = 0; j < 6; ++j) {
+                testConverter(converters[0], converters[i], widths[j]);
+            }
+        }
+    }
+
+private:
+    void testConverter(const PixelConverter* pRef, const PixelConverter* pConverter,
+            int width)
+    {
+        // Three lines of source data for the bayer conversion.
+        int srcStride = width*4;
+        vector<unsigned char> src(srcStride*3);
+        for (unsigned i = 0; i < src.size(); ++i) {
+            src[i] = (unsigned char)(rand() & 255);
+        }
+        vector<unsigned char> refDest(width*4);
+        vector<unsigned char> dest(width*4);
+        int evenWidth = max(2, width & ~1);
+
+        pRef->YUYV422toBGR32Line(&src[0], (Pixel32*)&refDest[0], evenWidth);
+        pConverter->YUYV422toBGR32Line(&src[0], (Pixel32*)&dest[0], evenWidth);
+        TEST(refDest == dest);
+        pRef->UYVY422toBGR32Line(&src[0], (Pixel32*)&refDest[0], evenWidth);
+        pConverter->UYVY422toBGR32Line(&src[0], (Pixel32*)&dest[0], evenWidth);
+        TEST(refDest == dest);
+        pRef->YUYV422toI8Line(&src[1], &refDest[0], width);
+        pConverter->YUYV422toI8Line(&src[1], &dest[0], width);
+        TEST(refDest == dest);
+        pRef->I8toBGR32Line(&src[0], &refDest[0], width);
+        pConverter->I8toBGR32Line(&src[0], &dest[0], width);
+        TEST(refDest == dest);
+        pRef->BGR24toBGR32Line(&src[0], &refDest[0], width);
+        pConverter->BGR24toBGR32Line(&src[0], &dest[0], width);
+        TEST(refDest == dest);
+        for (int i = 0; i < 2; ++i) {
+            bool bFlag = (i == 1);
+            pRef->BGR32toI8Line(&src[0], &refDest[0], width, bFlag);
+            pConverter->BGR32toI8Line(&src[0], &dest[0], width, bFlag);
+            TEST(refDest == dest);
+            pRef->BY8toBGR32BilinearPairs(&src[0], srcStride, &refDest[0], width/2-1, 
+                    bFlag);
+            pConverter->BY8toBGR32BilinearPairs(&src[0], srcStride, &dest[0], 
+                    width/2-1, bFlag);
+            TEST(refDest == dest);
+        }
+        vector<float> refFloatDest(width*4);
+        vector<float> floatDest(width*4);
+        pRef->ByteToFloatLine(&src[0], &refFloatDest[0], width*4);
+        pConverter->ByteToFloatLine(&src[0], &floatDest[0], width*4);
+        TEST(refFloatDest == floatDest);
+    }
+};
+
+class BlockCompressorTest: public GraphicsTest {
+public:
+    BlockCompressorTest()
+        : GraphicsTest("BlockCompressorTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        TEST(getBlockCompressedPF(TEXCOMPRESSION_BC, false) == BC1);
+        TEST(getBlockCompressedPF(TEXCOMPRESSION_BC, true) == BC3);
+        TEST(getBlockCompressedPF(TEXCOMPRESSION_ETC2, false) == ETC2_RGB8);
+        TEST(getBlockCompressedPF(TEXCOMPRESSION_ETC2, true) == ETC2_RGBA8);
+
+        testKnownBlocks();
+
+        const PixelFormat pfs[] = {BC1, BC3, ETC2_RGB8, ETC2_RGBA8};
+        for (int i = 0; i < 4; ++i) {
+            cerr << "    Testing " << pfs[i] << endl;
+            // Sizes that aren't multiples of 4 exercise the partial edge blocks.
+            testRoundTrip(pfs[i], IntPoint(16, 16));
+            testRoundTrip(pfs[i], IntPoint(13, 7));
+            testConstantColor(pfs[i]);
+        }
+    }
+
+private:
+    // Blocks written by hand from the format specs, with their decoded texels.
+    void testKnownBlocks()
+    {
+        cerr << "    Testing known blocks" << endl;
+        // BC1, four color mode: color0 = red > color1 = blue, indices 0, 1, 2, 3 in 
+        // every row.
+        const unsigned char bc1Block[] = 
+                {0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4};
+        const unsigned char bc1Colors[4][4] = {
+                {255, 0, 0, 255}, {0, 0, 255, 255}, {170, 0, 85, 255}, {85, 0, 170, 255}
+        };
+        testDecodeBlock(BC1, bc1Block, bc1Colors, false);
+
+        // BC1, three color mode: color0 = blue < color1 = red. Index 3 is black.
+        const unsigned char bc1Block3[] = 
+                {0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4};
+        const unsigned char bc1Colors3[4][4] = {
+                {0, 0, 255, 255}, {255, 0, 0, 255}, {127, 0, 127, 255}, {0, 0, 0, 255}
+        };
+        testDecodeBlock(BC1, bc1Block3, bc1Colors3, false);
+
+        // ETC2 individual mode, no flip: base colors 0x888 (left half) and 0x444 
+        // (right half), tables 0 and 1. Rows use the modifier indices 0 to 3, i.e. 
+        // +small, +large, -small, -large.
+        const unsigned char etcBlock[] = 
+                {0x84, 0x84, 0x84, 0x04, 0xCC, 0xCC, 0xAA, 0xAA};
+        const unsigned char etcRows[4][2] = {{138, 73}, {144, 85}, {134, 63}, {128, 51}};
+        unsigned char etcColors[16][4];
+        for (int i = 0; i < 16; ++i) {
+            unsigned char gray = etcRows[i/4][(i%4)/2];
+            setTexel(etcColors[i], gray, gray, gray, 255);
+        }
+        testDecodeBlock(ETC2_RGB8, etcBlock, etcColors, true);
+
+        // ETC2 differential mode, flipped: base color 16 (132) in the top half, 16-2 
+        // (115) in the bottom half, tables 2 and 3. Columns use the modifier indices 0 
+        // to 3.
+        const unsigned char etcDiffBlock[] = 
+                {0x86, 0x86, 0x86, 0x4F, 0xFF, 0x00, 0xF0, 0xF0};
+        const unsigned char etcDiffRows[2][4] = 
+                {{141, 161, 123, 103}, {128, 157, 102, 73}};
+        for (int i = 0; i < 16; ++i) {
+            unsigned char gray = etcDiffRows[i/8][i%4];
+            setTexel(etcColors[i], gray, gray, gray, 255);
+        }
+        testDecodeBlock(ETC2_RGB8, etcDiffBlock, etcColors, true);
+
+        // ETC2 RGBA: EAC alpha with base 128, multiplier 2 and table 13. The top left
+        // texel uses index 3 (-10), all others index 7 (+9).
+        unsigned char etcAlphaBlock[16] = 
+                {0x80, 0x2D, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        memcpy(etcAlphaBlock+8, etcBlock, 8);
+        for (int i = 0; i < 16; ++i) {
+            unsigned char gray = etcRows[i/4][(i%4)/2];
+            setTexel(etcColors[i], gray, gray, gray, i == 0 ? 108 : 146);
+        }
+        testDecodeBlock(ETC2_RGBA8, etcAlphaBlock, etcColors, true);
+
+        // Colors the formats can represent exactly have a single best encoding. The 
+        // colors don't depend on the channel order of Pixel32.
+        const unsigned char bc1Magenta[] = {0x1F, 0xF8, 0x1F, 0xF8, 0, 0, 0, 0};
+        testEncodeBlock(BC1, Pixel32(255, 0, 255, 255), bc1Magenta);
+        const unsigned char etcGray[] = {0x88, 0x88, 0x88, 0, 0, 0, 0, 0};
+        testEncodeBlock(ETC2_RGB8, Pixel32(138, 138, 138, 255), etcGray);
+    }
+
+    void setTexel(unsigned char* pTexel, unsigned char r, unsigned char g, 
+            unsigned char b, unsigned char a)
+    {
+        pTexel[0] = r;
+        pTexel[1] = g;
+        pTexel[2] = b;
+        pTexel[3] = a;
+    }
+
+    // pTexels holds 16 r, g, b, a texels in row-major order, or, if bAllTexels is 
+    // false, four texels that every row repeats.
+    void testDecodeBlock(PixelFormat pf, const unsigned char* pBlock,
+            const unsigned char (*pTexels)[4], bool bAllTexels)
+    {
+        Bitmap srcBmp(IntPoint(4, 4), pf);
+        memcpy(srcBmp.getPixels(), pBlock, getBytesPerBlock(pf));
+        BitmapPtr pDestBmp = decompressBlocks(srcBmp, R8G8B8A8);
+        bool bOK = true;
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                const unsigned char* pPixel = pDestBmp->getPixels() + 
+                        y*pDestBmp->getStride() + x*4;
+                const unsigned char* pTexel = pTexels[bAllTexels ? y*4+x : x];
+                if (memcmp(pPixel, pTexel, 4) != 0) {
+                    bOK = false;
+                }
+            }
+        }
+        TEST(bOK);
+        if (!bOK) {
+            pDestBmp->dump(true);
+        }
+    }
+
+    void testEncodeBlock(PixelFormat pf, Pixel32 color, const unsigned char* pBlock)
+    {
+        BitmapPtr pSrcBmp(new Bitmap(IntPoint(4, 4), R8G8B8A8));
+        FilterFill<Pixel32>(color).applyInPlace(pSrcBmp);
+        BitmapPtr pDestBmp = compressBlocks(*pSrcBmp, pf);
+        TEST(memcmp(pDestBmp->getPixels(), pBlock, getBytesPerBlock(pf)) == 0);
+    }
+
+    void testRoundTrip(PixelFormat pf, const IntPoint& size)
+    {
+        bool bAlpha = pixelFormatHasAlpha(pf);
+        BitmapPtr pSrcBmp(new Bitmap(size, R8G8B8A8));
+        for (int y = 0; y < size.y; ++y) {
+            for (int x = 0; x < size.x; ++x) {
+                unsigned char a = bAlpha ? (unsigned char)(255-y*8) : 255;
+                pSrcBmp->setPixel(IntPoint(x, y), 
+                        Pixel32(x*12+20, x*8+y*2+10, (x+y)*4, a));
+            }
+        }
+        BitmapPtr pCompressedBmp = compressBlocks(*pSrcBmp, pf);
+        TEST(pCompressedBmp->getPixelFormat() == pf);
+        TEST(pCompressedBmp->getSize() == size);
+        int numBlocks = ((size.x+3)/4)*((size.y+3)/4);
+        TEST(pCompressedBmp->getMemNeeded() == int(numBlocks*getBytesPerBlock(pf)));
+
+        // Compare color and alpha separately, since getAvg() weights colors by alpha.
+        string sName = string("BlockCompressor")+getPixelFormatString(pf);
+        BitmapPtr pDestBmp = decompressBlocks(*pCompressedBmp, R8G8B8X8);
+        Bitmap srcColorBmp(size, R8G8B8X8);
+        srcColorBmp.copyPixels(*pSrcBmp);
+        testEqual(*pDestBmp, srcColorBmp, sName, 4.f, 3.f);
+        if (bAlpha) {
+            pDestBmp = decompressBlocks(*pCompressedBmp, R8G8B8A8);
+            BitmapPtr pDestAlphaBmp = FilterGetAlpha().apply(pDestBmp);
+            BitmapPtr pSrcAlphaBmp = FilterGetAlpha().apply(pSrcBmp);
+            testEqual(*pDestAlphaBmp, *pSrcAlphaBmp, sName+"Alpha", 1.f, 1.f);
+        }
+    }
+
+    void testConstantColor(PixelFormat pf)
+    {
+        BitmapPtr pSrcBmp(new Bitmap(IntPoint(8, 8), R8G8B8A8));
+        FilterFill<Pixel32>(Pixel32(200, 100, 50, 255)).applyInPlace(pSrcBmp);
+        BitmapPtr pDestBmp = decompressBlocks(*compressBlocks(*pSrcBmp, pf), R8G8B8A8);
+        testEqual(*pDestBmp, *pSrcBmp, 
+                string("BlockCompressorConst")+getPixelFormatString(pf), 2.f, 0.5f);
+    }
+};
+
 class FilterColorizeTest: public GraphicsTest {
 public:
     FilterColorizeTest()
@@ -1012,6 +1373,10 @@ public:
         addTest(TestPtr(new PixelTest));
         addTest(TestPtr(new ColorTest));
         addTest(TestPtr(new BitmapTest));
+        addTest(TestPtr(new BitmapDiskCacheTest));
+        addTest(TestPtr(new VertexDataTest));
+        addTest(TestPtr(new PixelConverterTest));
+        addTest(TestPtr(new BlockCompressorTest));
         addTest(TestPtr(new Filter3x3Test));
         addTest(TestPtr(new FilterConvolTest));
         addTest(TestPtr(new FilterColorizeTest));
@@ -81,7 +81,12 @@ static ProfilingZoneID CameraConvertProfilingZone("Camera format conversion", tr
 BitmapPtr Camera::convertCamFrameToDestPF(BitmapPtr pCamBmp)
 {
     ScopeTimer Timer(CameraConvertProfilingZone);
-    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(pCamBmp->getSize(), m_DestPF));
+    if (!m_pDestBmpPool || m_pDestBmpPool->getSize() != pCamBmp->getSize()) {
+        // One bitmap each for the converter, the newest frame and the one displayed.
+        m_pDestBmpPool = CameraBitmapPoolPtr(
+                new CameraBitmapPool(pCamBmp->getSize(), m_DestPF, 3));
+    }
+    BitmapPtr pDestBmp = m_pDestBmpPool->getBitmap();
     pDestBmp->copyPixels(*pCamBmp);
     if (m_CamPF == R8G8B8 && m_DestPF == B8G8R8X8) {
         pDestBmp->setPixelFormat(R8G8B8X8);
@@ -231,6 +236,8 @@ CameraPtr createCamera(const string& sDriver, const string& sDevice, int unit,
             AVG_LOG_WARNING("DirectShow camera specified, but "
                     "DirectShow is only available under windows.");
 #endif
+        } else if (sDriver == "fake") {
+            pCamera = CameraPtr(new FakeCamera(camPF, destPF, captureSize, frameRate));
         } else {
             throw Exception(AVG_ERR_INVALID_ARGS,
                     "Unable to set up camera. Camera source '"+sDriver+"' unknown.");
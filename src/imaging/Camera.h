@@ -27,6 +27,7 @@
 
 #include <boost/shared_ptr.hpp>
 #include "CameraInfo.h"
+#include "CameraBitmapPool.h"
 
 #include <string>
 #include <list>
@@ -71,6 +72,8 @@ public:
     PixelFormat getCamPF() const;
     void setCamPF(PixelFormat pf);
     PixelFormat getDestPF() const;
+    // The bitmaps returned are recycled once they aren't referenced anymore. Must 
+    // always be called from the same thread.
     BitmapPtr convertCamFrameToDestPF(BitmapPtr pCamBmp);
 
     IntPoint getImgSize();
@@ -99,6 +102,8 @@ private:
 
     IntPoint m_Size;
     float m_FrameRate;
+
+    CameraBitmapPoolPtr m_pDestBmpPool;
 };
 
 
@@ -0,0 +1,115 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "CameraBitmapPool.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+#include "../graphics/Bitmap.h"
+
+using namespace std;
+
+namespace avg {
+
+class PooledBitmapDeleter
+{
+public:
+    PooledBitmapDeleter(CameraBitmapPoolPtr pPool)
+        : m_pPool(pPool)
+    {
+    }
+
+    void operator()(Bitmap* pBmp) const
+    {
+        m_pPool->returnBitmap(pBmp);
+    }
+
+private:
+    CameraBitmapPoolPtr m_pPool;
+};
+
+CameraBitmapPool::CameraBitmapPool(const IntPoint& size, PixelFormat pf, 
+        unsigned maxFreeBmps)
+    : m_Size(size),
+      m_PF(pf),
+      m_MaxFreeBmps(maxFreeBmps),
+      m_NumAllocated(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+CameraBitmapPool::~CameraBitmapPool()
+{
+    for (unsigned i = 0; i < m_pFreeBmps.size(); ++i) {
+        delete m_pFreeBmps[i];
+    }
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+BitmapPtr CameraBitmapPool::getBitmap()
+{
+    Bitmap* pBmp = 0;
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        if (!m_pFreeBmps.empty()) {
+            pBmp = m_pFreeBmps.back();
+            m_pFreeBmps.pop_back();
+        } else {
+            m_NumAllocated++;
+        }
+    }
+    if (!pBmp) {
+        pBmp = new Bitmap(m_Size, m_PF);
+    }
+    // The deleter keeps the pool alive until all bitmaps have been returned.
+    return BitmapPtr(pBmp, PooledBitmapDeleter(shared_from_this()));
+}
+
+const IntPoint& CameraBitmapPool::getSize() const
+{
+    return m_Size;
+}
+
+PixelFormat CameraBitmapPool::getPixelFormat() const
+{
+    return m_PF;
+}
+
+int CameraBitmapPool::getNumAllocated() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_NumAllocated;
+}
+
+void CameraBitmapPool::returnBitmap(Bitmap* pBmp)
+{
+    // Format conversions may have changed the pixel format to an equivalent one.
+    pBmp->setPixelFormat(m_PF);
+    boost::mutex::scoped_lock lock(m_Mutex);
+    if (m_pFreeBmps.size() < m_MaxFreeBmps) {
+        m_pFreeBmps.push_back(pBmp);
+    } else {
+        m_NumAllocated--;
+        delete pBmp;
+    }
+}
+
+}
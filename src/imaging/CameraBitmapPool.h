@@ -0,0 +1,72 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _CameraBitmapPool_H_
+#define _CameraBitmapPool_H_
+
+#include "../api.h"
+#include "../graphics/PixelFormat.h"
+#include "../base/GLMHelper.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// Recycles the bitmaps camera frames are converted into. Bitmaps handed out by 
+// getBitmap() go back to the pool when their last reference is released, from 
+// whatever thread that happens in.
+class AVG_API CameraBitmapPool: public boost::enable_shared_from_this<CameraBitmapPool>
+{
+public:
+    CameraBitmapPool(const IntPoint& size, PixelFormat pf, unsigned maxFreeBmps);
+    virtual ~CameraBitmapPool();
+
+    BitmapPtr getBitmap();
+
+    const IntPoint& getSize() const;
+    PixelFormat getPixelFormat() const;
+    int getNumAllocated() const;
+
+private:
+    friend class PooledBitmapDeleter;
+    void returnBitmap(Bitmap* pBmp);
+
+    IntPoint m_Size;
+    PixelFormat m_PF;
+    unsigned m_MaxFreeBmps;
+
+    mutable boost::mutex m_Mutex;
+    std::vector<Bitmap*> m_pFreeBmps;
+    int m_NumAllocated;
+};
+
+typedef boost::shared_ptr<CameraBitmapPool> CameraBitmapPoolPtr;
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "CameraCaptureThread.h"
+
+#include "../base/TimeSource.h"
+
+using namespace std;
+
+namespace avg {
+
+CameraFrameSlot::CameraFrameSlot()
+    : m_CaptureTime(0),
+      m_NumDroppedFrames(0)
+{
+}
+
+void CameraFrameSlot::publish(BitmapPtr pBmp, long long captureTime)
+{
+    BitmapPtr pOldBmp;
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        if (m_pBmp) {
+            m_NumDroppedFrames++;
+        }
+        pOldBmp = m_pBmp;
+        m_pBmp = pBmp;
+        m_CaptureTime = captureTime;
+    }
+    // pOldBmp is returned to the bitmap pool here, outside of the lock.
+}
+
+BitmapPtr CameraFrameSlot::fetch(long long& captureTime)
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    BitmapPtr pBmp = m_pBmp;
+    m_pBmp = BitmapPtr();
+    captureTime = m_CaptureTime;
+    return pBmp;
+}
+
+int CameraFrameSlot::getNumDroppedFrames() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_NumDroppedFrames;
+}
+
+
+CameraCaptureThread::CameraCaptureThread(CQueue& cmdQ, CameraPtr pCamera, 
+        CameraFrameSlotPtr pFrameSlot, boost::mutex& featureMutex)
+    : WorkerThread<CameraCaptureThread>("Camera Capture", cmdQ),
+      m_pCamera(pCamera),
+      m_pFrameSlot(pFrameSlot),
+      m_FeatureMutex(featureMutex)
+{
+}
+
+CameraCaptureThread::~CameraCaptureThread()
+{
+}
+
+bool CameraCaptureThread::work()
+{
+    // Format conversion is profiled in Camera::convertCamFrameToDestPF().
+    BitmapPtr pBmp = m_pCamera->getImage(true);
+    if (pBmp) {
+        m_pFrameSlot->publish(pBmp, TimeSource::get()->getCurrentMicrosecs());
+    }
+    return true;
+}
+
+void CameraCaptureThread::setFeature(CameraFeature feature, int value)
+{
+    boost::mutex::scoped_lock lock(m_FeatureMutex);
+    m_pCamera->setFeature(feature, value);
+}
+
+void CameraCaptureThread::setWhitebalance(int u, int v)
+{
+    boost::mutex::scoped_lock lock(m_FeatureMutex);
+    m_pCamera->setWhitebalance(u, v);
+}
+
+void CameraCaptureThread::doOneShotWhitebalance()
+{
+    boost::mutex::scoped_lock lock(m_FeatureMutex);
+    // The first line turns off auto white balance.
+    m_pCamera->setWhitebalance(m_pCamera->getWhitebalanceU(), 
+            m_pCamera->getWhitebalanceV());
+    m_pCamera->setFeatureOneShot(CAM_FEATURE_WHITE_BALANCE);
+}
+
+}
@@ -0,0 +1,82 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _CameraCaptureThread_H_
+#define _CameraCaptureThread_H_
+
+#include "../api.h"
+#include "Camera.h"
+
+#include "../base/WorkerThread.h"
+
+#include <boost/thread/mutex.hpp>
+
+namespace avg {
+
+// Holds the newest captured frame until the main thread fetches it. Frames that are 
+// replaced before they are fetched count as dropped.
+class AVG_API CameraFrameSlot
+{
+public:
+    CameraFrameSlot();
+
+    void publish(BitmapPtr pBmp, long long captureTime);
+    // Returns an empty BitmapPtr if there is no new frame.
+    BitmapPtr fetch(long long& captureTime);
+    int getNumDroppedFrames() const;
+
+private:
+    mutable boost::mutex m_Mutex;
+    BitmapPtr m_pBmp;
+    long long m_CaptureTime;
+    int m_NumDroppedFrames;
+};
+
+typedef boost::shared_ptr<CameraFrameSlot> CameraFrameSlotPtr;
+
+// Dequeues and converts camera frames outside of the main thread. While it runs, it
+// owns the camera: Features are set through commands that run between frames.
+// featureMutex protects the camera's feature values so the main thread can still 
+// read them.
+class AVG_API CameraCaptureThread: public WorkerThread<CameraCaptureThread>
+{
+public:
+    CameraCaptureThread(CQueue& cmdQ, CameraPtr pCamera, CameraFrameSlotPtr pFrameSlot,
+            boost::mutex& featureMutex);
+    virtual ~CameraCaptureThread();
+
+    void setFeature(CameraFeature feature, int value);
+    void setWhitebalance(int u, int v);
+    void doOneShotWhitebalance();
+
+private:
+    virtual bool work();
+
+    CameraPtr m_pCamera;
+    CameraFrameSlotPtr m_pFrameSlot;
+    boost::mutex& m_FeatureMutex;
+};
+
+typedef boost::shared_ptr<CameraCaptureThread::CQueue> CameraCaptureCmdQueuePtr;
+
+}
+
+#endif
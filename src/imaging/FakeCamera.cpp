@@ -31,6 +31,8 @@
 #include "../base/Exception.h"
 #include "../base/Logger.h"
 
+#include <string.h>
+
 
 using namespace std;
 
@@ -39,14 +41,31 @@ namespace avg {
 FakeCamera::FakeCamera(PixelFormat camPF, PixelFormat destPF)
     : Camera(camPF, destPF, IntPoint(640, 480), 60),
       m_pBmpQ(new std::queue<BitmapPtr>()),
-      m_bIsOpen(false)
+      m_bIsOpen(false),
+      m_bGenerateFrames(false),
+      m_FrameNum(0),
+      m_LastFrameTime(0)
+{
+}
+
+FakeCamera::FakeCamera(PixelFormat camPF, PixelFormat destPF, const IntPoint& size,
+        float frameRate)
+    : Camera(camPF, destPF, size, frameRate),
+      m_pBmpQ(new std::queue<BitmapPtr>()),
+      m_bIsOpen(false),
+      m_bGenerateFrames(true),
+      m_FrameNum(0),
+      m_LastFrameTime(0)
 {
 }
 
 FakeCamera::FakeCamera(std::vector<std::string>& pictures)
     : Camera(I8, I8, IntPoint(640,480), 60),
       m_pBmpQ(new std::queue<BitmapPtr>()),
-      m_bIsOpen(false)
+      m_bIsOpen(false),
+      m_bGenerateFrames(false),
+      m_FrameNum(0),
+      m_LastFrameTime(0)
 {
     for (vector<string>::iterator it = pictures.begin(); it != pictures.end(); ++it) {
         try {
@@ -78,6 +97,9 @@ void FakeCamera::close()
 
 BitmapPtr FakeCamera::getImage(bool bWait)
 {
+    if (m_bGenerateFrames) {
+        return generateFrame(bWait);
+    }
     if (bWait) {
         msleep(100);
     }
@@ -90,6 +112,26 @@ BitmapPtr FakeCamera::getImage(bool bWait)
     }
 }
 
+BitmapPtr FakeCamera::generateFrame(bool bWait)
+{
+    long long frameDuration = (long long)(1000/getFrameRate());
+    long long timeToNextFrame = m_LastFrameTime+frameDuration - 
+            TimeSource::get()->getCurrentMillisecs();
+    if (timeToNextFrame > 0) {
+        if (!bWait) {
+            return BitmapPtr();
+        }
+        msleep(int(timeToNextFrame));
+    }
+    m_LastFrameTime = TimeSource::get()->getCurrentMillisecs();
+
+    BitmapPtr pCamBmp(new Bitmap(getImgSize(), getCamPF()));
+    memset(pCamBmp->getPixels(), (m_FrameNum*8)%256, 
+            pCamBmp->getStride()*getImgSize().y);
+    m_FrameNum++;
+    return convertCamFrameToDestPF(pCamBmp);
+}
+
 bool FakeCamera::isCameraAvailable()
 {
     return true;
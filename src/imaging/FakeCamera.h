@@ -38,6 +38,9 @@ class AVG_API FakeCamera: public Camera
 {
 public:
     FakeCamera(PixelFormat camPF, PixelFormat destPF);
+    // Generates uniformly colored frames at the given frame rate.
+    FakeCamera(PixelFormat camPF, PixelFormat destPF, const IntPoint& size, 
+            float frameRate);
     FakeCamera(std::vector<std::string>& pictures);
     virtual ~FakeCamera();
     virtual void open();
@@ -58,8 +61,14 @@ public:
     virtual void setWhitebalance(int u, int v, bool bIgnoreOldValue=false);
 
 private:
+    BitmapPtr generateFrame(bool bWait);
+
     BitmapQueuePtr m_pBmpQ;
     bool m_bIsOpen;
+
+    bool m_bGenerateFrames;
+    int m_FrameNum;
+    long long m_LastFrameTime;
 };
 
 }
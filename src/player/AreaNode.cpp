@@ -107,6 +107,7 @@ void AreaNode::connectDisplay()
         notifySubscribers("SIZE_CHANGED", m_RelViewport.size());
     }
     m_bTransformChanged = true;
+    invalidateHitTestBounds();
     Node::connectDisplay();
 }
 
@@ -182,6 +183,7 @@ void AreaNode::setAngle(float angle)
 {
     m_Angle = fmod(angle, 2*(float)M_PI);
     m_bTransformChanged = true;
+    invalidateHitTestBounds();
 }
 
 glm::vec2 AreaNode::getPivot() const
@@ -199,6 +201,7 @@ void AreaNode::setPivot(const glm::vec2& pt)
     m_Pivot.y = pt.y;
     m_bHasCustomPivot = true;
     m_bTransformChanged = true;
+    invalidateHitTestBounds();
 }
 
 const std::string& AreaNode::getElementOutlineColor() const
@@ -214,6 +217,7 @@ void AreaNode::setElementOutlineColor(const std::string& sColor)
     } else {
         m_ElementOutlineColor = Color(m_sElementOutlineColor);
     }
+    invalidateRender();
 }
 
 glm::vec2 AreaNode::toLocal(const glm::vec2& globalPos) const
@@ -237,11 +241,30 @@ void AreaNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements
     }
 }
 
+bool AreaNode::getHitTestBounds(FRect& bounds) const
+{
+    glm::vec2 size = getSize();
+    glm::vec2 corners[4] = {toGlobal(glm::vec2(0,0)), toGlobal(glm::vec2(size.x,0)),
+            toGlobal(glm::vec2(0,size.y)), toGlobal(size)};
+    bounds = FRect(corners[0], corners[0]);
+    for (int i = 1; i < 4; ++i) {
+        bounds.tl = glm::min(bounds.tl, corners[i]);
+        bounds.br = glm::max(bounds.br, corners[i]);
+    }
+    // Leave some room for rounding errors in toLocal().
+    bounds.tl -= glm::vec2(1,1);
+    bounds.br += glm::vec2(1,1);
+    return true;
+}
+
 void AreaNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
         float parentEffectiveOpacity)
 {
     Node::preRender(pVA, bIsParentActive, parentEffectiveOpacity);
     if (isVisible()) {
+        if (m_bTransformChanged) {
+            invalidateRender();
+        }
         calcTransform();
     }
 }
@@ -302,6 +325,7 @@ void AreaNode::setViewport(float x, float y, float width, float height)
         notifySubscribers("SIZE_CHANGED", m_RelViewport.size());
     }
     m_bTransformChanged = true;
+    invalidateHitTestBounds();
 }
 
 const FRect& AreaNode::getRelViewport() const
@@ -336,6 +360,11 @@ Pixel32 AreaNode::getEffectiveOutlineColor(Pixel32 parentColor) const
     }
 }
 
+const glm::mat4& AreaNode::getLocalTransform() const
+{
+    return m_LocalTransform;
+}
+
 void AreaNode::calcTransform()
 {
     if (m_bTransformChanged) {
@@ -86,6 +86,7 @@ class AVG_API AreaNode: public Node
         
         virtual void getElementsByPos(const glm::vec2& pos, 
                 std::vector<NodePtr>& pElements);
+        virtual bool getHitTestBounds(FRect& bounds) const;
 
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
                 float parentEffectiveOpacity);
@@ -105,6 +106,8 @@ class AVG_API AreaNode: public Node
         AreaNode();
         glm::vec2 getUserSize() const;
         Pixel32 getEffectiveOutlineColor(Pixel32 parentColor) const;
+        // Transform to parent coordinates. Up to date after preRender().
+        const glm::mat4& getLocalTransform() const;
 
     private:
         void calcTransform();
@@ -27,8 +27,15 @@
 #endif
 #include  <stdio.h>
 #include  <stdlib.h>
+#include  <limits.h>
+
+#include "Player.h"
 
 #include "../base/OSHelper.h"
+#include "../base/FileHelper.h"
+#include "../base/TimeSource.h"
+
+#include "../graphics/ImageCache.h"
 
 using namespace std;
 
@@ -37,12 +44,19 @@ namespace avg {
 BitmapManager * BitmapManager::s_pBitmapManager=0;
 
 BitmapManager::BitmapManager()
+    : m_NumLatencySamples(0),
+      m_TotalQueueTime(0),
+      m_TotalLoadTime(0),
+      m_TotalDeliveryTime(0),
+      m_MaxLatency(0),
+      m_LastLatencyLogTime(TimeSource::get()->getCurrentMicrosecs()/1000.0f)
 {
     if (s_pBitmapManager) {
         throw Exception(AVG_ERR_UNKNOWN, "BitmapMananger has already been instantiated.");
     }
     
     m_pCmdQueue = BitmapManagerThread::CQueuePtr(new BitmapManagerThread::CQueue);
+    m_pRequestQueue = BitmapRequestQueuePtr(new BitmapRequestQueue);
     m_pMsgQueue = BitmapManagerMsgQueuePtr(new BitmapManagerMsgQueue(8));
 
     startThreads(1);
@@ -55,6 +69,8 @@ BitmapManager::~BitmapManager()
     while (!m_pCmdQueue->empty()) {
         m_pCmdQueue->pop();
     }
+    m_pRequestQueue->clear();
+    m_pMainThreadMsgs.clear();
     while (!m_pMsgQueue->empty()) {
         m_pMsgQueue->pop();
     }
@@ -88,18 +104,80 @@ void BitmapManager::loadBitmap(const UTF8String& sUtf8FileName,
     internalLoadBitmap(pMsg);
 }
 
+void BitmapManager::loadCachedImage(const std::string& sFileName,
+        TexCompression compression, const IBitmapLoadedListenerPtr& pLoadedListener)
+{
+    BitmapManagerMsgPtr pMsg = BitmapManagerMsgPtr(
+            new BitmapManagerMsg(sFileName, pLoadedListener, INT_MAX, compression));
+    if (ImageCache::get()->hasImage(sFileName, compression)) {
+        pMsg->setBitmap(BitmapPtr());
+        m_pMainThreadMsgs.push_back(pMsg);
+    } else {
+        internalLoadBitmap(pMsg);
+    }
+}
+
 void BitmapManager::setNumThreads(int numThreads)
 {
     stopThreads();
     startThreads(numThreads);
 }
 
+void BitmapManager::prefetch(const std::vector<std::string>& sUtf8FileNames,
+        const std::vector<int>& priorities)
+{
+    if (!priorities.empty() && priorities.size() != sUtf8FileNames.size()) {
+        throw Exception(AVG_ERR_INVALID_ARGS, 
+                "BitmapManager.prefetch: Need one priority per file.");
+    }
+    for (unsigned i=0; i<sUtf8FileNames.size(); ++i) {
+        string sFileName = getPrefetchFilename(sUtf8FileNames[i]);
+        if (ImageCache::get()->hasImage(sFileName, TEXCOMPRESSION_NONE)) {
+            continue;
+        }
+        if (!fileExists(sFileName)) {
+            // Don't queue an error message: Nobody is waiting for it.
+            AVG_LOG_WARNING("BitmapManager.prefetch: File '" << sFileName 
+                    << "' not found.");
+            continue;
+        }
+        int priority = 0;
+        if (!priorities.empty()) {
+            priority = priorities[i];
+        }
+        BitmapManagerMsgPtr pMsg(new BitmapManagerMsg(sFileName, priority));
+        internalLoadBitmap(pMsg);
+    }
+}
+
+void BitmapManager::cancelPrefetch(const std::string& sUtf8FileName)
+{
+    m_pRequestQueue->cancelPrefetch(getPrefetchFilename(sUtf8FileName));
+}
+
+void BitmapManager::cancelAllPrefetches()
+{
+    m_pRequestQueue->cancelAllPrefetches();
+}
+
 void BitmapManager::onFrameEnd()
 {
+    float now = TimeSource::get()->getCurrentMicrosecs()/1000.0f;
+    // Callbacks can generate new messages.
+    vector<BitmapManagerMsgPtr> pMainThreadMsgs;
+    pMainThreadMsgs.swap(m_pMainThreadMsgs);
+    for (unsigned i = 0; i < pMainThreadMsgs.size(); ++i) {
+        addLatency(pMainThreadMsgs[i], now);
+        pMainThreadMsgs[i]->executeCallback();
+    }
     while (!m_pMsgQueue->empty()) {
         BitmapManagerMsgPtr pMsg = m_pMsgQueue->pop();
+        addLatency(pMsg, now);
         pMsg->executeCallback();
     }
+    if (now-m_LastLatencyLogTime > 5000) {
+        logLatencySummary(now);
+    }
 }
 
 void BitmapManager::internalLoadBitmap(BitmapManagerMsgPtr pMsg)
@@ -115,17 +193,71 @@ void BitmapManager::internalLoadBitmap(BitmapManagerMsgPtr pMsg)
                 std::string("BitmapManager can't open output file '") +
                 pMsg->getFilename() + "'. Reason: " +
                 strerror(errno)));
-        m_pMsgQueue->push(pMsg);
+        m_pMainThreadMsgs.push_back(pMsg);
     } else {
-        m_pCmdQueue->pushCmd(boost::bind(&BitmapManagerThread::loadBitmap, _1, pMsg));
+        bool bNewRequest = m_pRequestQueue->push(pMsg);
+        if (bNewRequest) {
+            m_pCmdQueue->pushCmd(boost::bind(&BitmapManagerThread::loadNextBitmap, _1));
+        }
+    }
+}
+
+void BitmapManager::addLatency(const BitmapManagerMsgPtr& pMsg, float deliveryTime)
+{
+    float deliveryLatency = deliveryTime-pMsg->getLoadEndTime();
+    bool bFailed = (pMsg->getType() == BitmapManagerMsg::ERROR);
+    AVG_TRACE(Logger::category::PROFILE, Logger::severity::DEBUG,
+            "Async bitmap load '" << pMsg->getFilename() << "', priority " 
+            << pMsg->getPriority() << (bFailed ? " (failed)" : "") << ": queued " << pMsg->getQueueTime() << " ms, load " 
+            << pMsg->getLoadTime() << " ms, delivery " << deliveryLatency << " ms");
+    m_NumLatencySamples++;
+    m_TotalQueueTime += pMsg->getQueueTime();
+    m_TotalLoadTime += pMsg->getLoadTime();
+    m_TotalDeliveryTime += deliveryLatency;
+    float latency = pMsg->getQueueTime()+pMsg->getLoadTime()+deliveryLatency;
+    if (latency > m_MaxLatency) {
+        m_MaxLatency = latency;
+        m_sMaxLatencyFilename = pMsg->getFilename();
+    }
+}
+
+void BitmapManager::logLatencySummary(float now)
+{
+    if (m_NumLatencySamples > 0) {
+        float numSamples = float(m_NumLatencySamples);
+        AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                "Async bitmap loads: " << m_NumLatencySamples << " in " 
+                << (now-m_LastLatencyLogTime)/1000 << " s, avg. queued "
+                << m_TotalQueueTime/numSamples << " ms, load " 
+                << m_TotalLoadTime/numSamples << " ms, delivery " 
+                << m_TotalDeliveryTime/numSamples << " ms, max. total "
+                << m_MaxLatency << " ms ('" << m_sMaxLatencyFilename << "')");
+    }
+    m_NumLatencySamples = 0;
+    m_TotalQueueTime = 0;
+    m_TotalLoadTime = 0;
+    m_TotalDeliveryTime = 0;
+    m_MaxLatency = 0;
+    m_sMaxLatencyFilename = "";
+    m_LastLatencyLogTime = now;
+}
+
+std::string BitmapManager::getPrefetchFilename(const std::string& sUtf8FileName)
+{
+    // Resolve relative paths the same way ImageNode hrefs are resolved so the
+    // ImageCache finds the prefetched images.
+    string sFileName = sUtf8FileName;
+    if (!isAbsPath(sFileName)) {
+        sFileName = Player::get()->getRootMediaDir()+sFileName;
     }
+    return convertUTF8ToFilename(sFileName);
 }
 
 void BitmapManager::startThreads(int numThreads)
 {
     for (int i=0; i<numThreads; ++i) {
-        boost::thread* pThread = new boost::thread(
-                BitmapManagerThread(*m_pCmdQueue, *m_pMsgQueue));
+        WorkerHandlePtr pThread = startWorkerThread(
+                BitmapManagerThread(*m_pCmdQueue, *m_pRequestQueue, *m_pMsgQueue));
         m_pBitmapManagerThreads.push_back(pThread);
     }
 }
@@ -137,9 +269,7 @@ void BitmapManager::stopThreads()
         m_pCmdQueue->pushCmd(boost::bind(&BitmapManagerThread::stop, _1));
     }
     for (int i=0; i<numThreads; ++i) {
-        boost::thread* pThread = m_pBitmapManagerThreads[i];
-        pThread->join();
-        delete pThread;
+        m_pBitmapManagerThreads[i]->join();
     }
     m_pBitmapManagerThreads.clear();
 }
@@ -26,9 +26,12 @@
 
 #include "BitmapManagerThread.h"
 #include "BitmapManagerMsg.h"
+#include "BitmapRequestQueue.h"
+#include "IBitmapLoadedListener.h"
 
 #include "../base/Queue.h"
 #include "../base/IFrameEndListener.h"
+#include "../base/WorkerHandle.h"
 
 #include <boost/thread.hpp>
 
@@ -46,20 +49,50 @@ class AVG_API BitmapManager : public IFrameEndListener
                 const boost::python::object& pyFunc, PixelFormat pf=NO_PIXELFORMAT);
         void loadBitmap(const UTF8String& sUtf8FileName,
                 IBitmapLoadedListener* pLoadedListener, PixelFormat pf=NO_PIXELFORMAT);
+        // Loads the file into the ImageCache in the background, before any prefetches,
+        // and notifies the listener at the end of the frame. If the file is already 
+        // cached, the listener is just notified and gets an empty bitmap. Block
+        // compression is done in the background as well.
+        void loadCachedImage(const std::string& sFileName, TexCompression compression,
+                const IBitmapLoadedListenerPtr& pLoadedListener);
         void setNumThreads(int numThreads);
 
+        // Loads the files into the ImageCache in the background. Higher priorities are
+        // loaded first. priorities is either empty or contains one entry per file.
+        void prefetch(const std::vector<std::string>& sUtf8FileNames,
+                const std::vector<int>& priorities=std::vector<int>());
+        void cancelPrefetch(const std::string& sUtf8FileName);
+        void cancelAllPrefetches();
+
         virtual void onFrameEnd();
         
     private:
         void internalLoadBitmap(BitmapManagerMsgPtr pMsg);
+        std::string getPrefetchFilename(const std::string& sUtf8FileName);
         void startThreads(int numThreads);
         void stopThreads();
+        void addLatency(const BitmapManagerMsgPtr& pMsg, float deliveryTime);
+        void logLatencySummary(float now);
 
         static BitmapManager * s_pBitmapManager;
 
-        std::vector<boost::thread*> m_pBitmapManagerThreads;
+        std::vector<WorkerHandlePtr> m_pBitmapManagerThreads;
         BitmapManagerThread::CQueuePtr m_pCmdQueue;
+        BitmapRequestQueuePtr m_pRequestQueue;
         BitmapManagerMsgQueuePtr m_pMsgQueue;
+        // Messages generated in the main thread. These can't go through m_pMsgQueue,
+        // since pushing to a full queue would block until onFrameEnd().
+        std::vector<BitmapManagerMsgPtr> m_pMainThreadMsgs;
+
+        // Latency statistics in milliseconds, logged periodically. Every request is 
+        // logged at debug severity as well.
+        int m_NumLatencySamples;
+        float m_TotalQueueTime;
+        float m_TotalLoadTime;
+        float m_TotalDeliveryTime;
+        float m_MaxLatency;
+        std::string m_sMaxLatencyFilename;
+        float m_LastLatencyLogTime;
 };
 
 }
@@ -25,6 +25,9 @@
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
 #include "../base/TimeSource.h"
+#include "../base/Logger.h"
+
+#include "../graphics/ImageCache.h"
 
 
 namespace avg {
@@ -33,7 +36,7 @@ BitmapManagerMsg::BitmapManagerMsg(const UTF8String& sFilename,
         const boost::python::object& onLoadedCb, PixelFormat pf) 
 {
     ObjectCounter::get()->incRef(&typeid(*this));
-    init(sFilename, pf);
+    init(sFilename, pf, 0);
     m_OnLoadedCb = onLoadedCb;
     m_pLoadedListener = 0;
 }
@@ -42,11 +45,32 @@ BitmapManagerMsg::BitmapManagerMsg(const UTF8String& sFilename,
         IBitmapLoadedListener* pLoadedListener, PixelFormat pf)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
-    init(sFilename, pf);
+    init(sFilename, pf, 0);
     m_OnLoadedCb = boost::python::object();
     m_pLoadedListener = pLoadedListener;
 }
 
+BitmapManagerMsg::BitmapManagerMsg(const UTF8String& sFilename, int priority)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    init(sFilename, NO_PIXELFORMAT, priority);
+    m_OnLoadedCb = boost::python::object();
+    m_pLoadedListener = 0;
+    m_bPrefetch = true;
+}
+
+BitmapManagerMsg::BitmapManagerMsg(const UTF8String& sFilename,
+        const IBitmapLoadedListenerPtr& pLoadedListener, int priority,
+        TexCompression compression)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    init(sFilename, NO_PIXELFORMAT, priority);
+    m_Compression = compression;
+    m_OnLoadedCb = boost::python::object();
+    m_pCacheListener = pLoadedListener;
+    m_pLoadedListener = pLoadedListener.get();
+}
+
 BitmapManagerMsg::~BitmapManagerMsg()
 {
     if (m_pEx) {
@@ -55,17 +79,34 @@ BitmapManagerMsg::~BitmapManagerMsg()
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
-void BitmapManagerMsg::init(const UTF8String& sFilename, PixelFormat pf)
+void BitmapManagerMsg::init(const UTF8String& sFilename, PixelFormat pf, int priority)
 {
     m_sFilename = sFilename;
     m_StartTime = TimeSource::get()->getCurrentMicrosecs()/1000.0f;
     m_PF = pf;
+    m_Compression = TEXCOMPRESSION_NONE;
+    m_Priority = priority;
+    m_bPrefetch = false;
+    m_LoadStartTime = m_StartTime;
+    m_LoadEndTime = m_StartTime;
     m_MsgType = REQUEST;
     m_pEx = 0;
 }
 
 void BitmapManagerMsg::executeCallback()
 {
+    if (m_bPrefetch) {
+        if (m_MsgType == BITMAP) {
+            ImageCache::get()->addImage(m_sFilename, TEXCOMPRESSION_NONE, m_pBmp);
+        } else {
+            AVG_LOG_WARNING("Prefetching " << m_sFilename << " failed: " 
+                    << m_pEx->getStr());
+        }
+        return;
+    }
+    if (m_pCacheListener && m_MsgType == BITMAP && m_pBmp) {
+        ImageCache::get()->addImage(m_sFilename, m_Compression, m_pBmp);
+    }
     switch (m_MsgType) {
         case BITMAP:
             if (m_pLoadedListener) {
@@ -104,6 +145,21 @@ PixelFormat BitmapManagerMsg::getPixelFormat()
     return m_PF;
 }
 
+TexCompression BitmapManagerMsg::getCompression() const
+{
+    return m_Compression;
+}
+
+int BitmapManagerMsg::getPriority() const
+{
+    return m_Priority;
+}
+
+bool BitmapManagerMsg::isPrefetch() const
+{
+    return m_bPrefetch;
+}
+
 void BitmapManagerMsg::setBitmap(BitmapPtr pBmp)
 {
     AVG_ASSERT(m_MsgType == REQUEST);
@@ -118,4 +174,25 @@ void BitmapManagerMsg::setError(const Exception& ex)
     m_pEx = new Exception(ex);
 }
 
+void BitmapManagerMsg::setLoadTimes(float loadStartTime, float loadEndTime)
+{
+    m_LoadStartTime = loadStartTime;
+    m_LoadEndTime = loadEndTime;
+}
+
+float BitmapManagerMsg::getQueueTime() const
+{
+    return m_LoadStartTime-m_StartTime;
+}
+
+float BitmapManagerMsg::getLoadTime() const
+{
+    return m_LoadEndTime-m_LoadStartTime;
+}
+
+float BitmapManagerMsg::getLoadEndTime() const
+{
+    return m_LoadEndTime;
+}
+
 }
@@ -30,6 +30,7 @@
 #include "../base/Exception.h"
 
 #include "../graphics/PixelFormat.h"
+#include "../graphics/TexInfo.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/python.hpp>
@@ -40,6 +41,7 @@ namespace avg {
 class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 class IBitmapLoadedListener;
+typedef boost::shared_ptr<IBitmapLoadedListener> IBitmapLoadedListenerPtr;
 
 class AVG_API BitmapManagerMsg
 {
@@ -50,16 +52,32 @@ public:
             const boost::python::object& onLoadedCb, PixelFormat pf);
     BitmapManagerMsg(const UTF8String& sFilename,
             IBitmapLoadedListener* pLoadedListener, PixelFormat pf);
+    // Prefetch request: The bitmap ends up in the ImageCache.
+    BitmapManagerMsg(const UTF8String& sFilename, int priority);
+    // The bitmap is added to the ImageCache before the listener is called. The message
+    // keeps the listener alive. Block compression is done in the loader thread.
+    BitmapManagerMsg(const UTF8String& sFilename, 
+            const IBitmapLoadedListenerPtr& pLoadedListener, int priority,
+            TexCompression compression);
     virtual ~BitmapManagerMsg();
-    void init(const UTF8String& sFilename, PixelFormat pf);
+    void init(const UTF8String& sFilename, PixelFormat pf, int priority);
 
     void executeCallback();
     const UTF8String getFilename();
     float getStartTime();
     PixelFormat getPixelFormat();
+    TexCompression getCompression() const;
+    int getPriority() const;
+    bool isPrefetch() const;
     void setBitmap(BitmapPtr pBmp);
     void setError(const Exception& ex);
 
+    // Timestamps in milliseconds for latency statistics.
+    void setLoadTimes(float loadStartTime, float loadEndTime);
+    float getQueueTime() const;
+    float getLoadTime() const;
+    float getLoadEndTime() const;
+
     MsgType getType() { return m_MsgType; };
 
 private:
@@ -68,7 +86,13 @@ private:
     BitmapPtr m_pBmp;
     boost::python::object m_OnLoadedCb;
     IBitmapLoadedListener* m_pLoadedListener;
+    IBitmapLoadedListenerPtr m_pCacheListener;
     PixelFormat m_PF;
+    TexCompression m_Compression;
+    int m_Priority;
+    bool m_bPrefetch;
+    float m_LoadStartTime;
+    float m_LoadEndTime;
     MsgType m_MsgType;
     Exception* m_pEx;
 };
@@ -26,53 +26,113 @@
 #include "../base/TimeSource.h"
 
 #include "../graphics/BitmapLoader.h"
+#include "../graphics/BlockCompressor.h"
+
+#include <boost/bind.hpp>
 
 #include <stdio.h>
 #include <stdlib.h>
 
 namespace avg {
 
-BitmapManagerThread::BitmapManagerThread(CQueue& cmdQ, BitmapManagerMsgQueue& MsgQueue)
+BitmapManagerThread::BitmapManagerThread(CQueue& cmdQ, 
+        BitmapRequestQueue& requestQueue, BitmapManagerMsgQueue& MsgQueue)
     : WorkerThread<BitmapManagerThread>("BitmapManager", cmdQ),
+      m_CmdQueue(cmdQ),
+      m_RequestQueue(requestQueue),
       m_MsgQueue(MsgQueue),
-      m_TotalLatency(0),
-      m_NumBmpsLoaded(0)
+      m_NumDeferredLoads(0)
+{
+}
+
+void BitmapManagerThread::addQueueListener(IQueueListener* pListener)
 {
+    WorkerThread<BitmapManagerThread>::addQueueListener(pListener);
+    m_MsgQueue.addPopListener(pListener);
+}
+
+void BitmapManagerThread::removeQueueListener(IQueueListener* pListener)
+{
+    WorkerThread<BitmapManagerThread>::removeQueueListener(pListener);
+    m_MsgQueue.removeListener(pListener);
 }
 
 bool BitmapManagerThread::work()
 {
+    if (isScheduled()) {
+        if (m_pPendingMsg && m_MsgQueue.tryPush(m_pPendingMsg)) {
+            m_pPendingMsg = BitmapManagerMsgPtr();
+        }
+        while (!m_pPendingMsg && m_NumDeferredLoads > 0) {
+            m_NumDeferredLoads--;
+            loadNextBitmap();
+        }
+        if (m_pPendingMsg) {
+            // Wait for the main thread to make space in the message queue.
+            setIdle();
+            return true;
+        }
+    }
     waitForCommand();
     return true;
 }
 
 void BitmapManagerThread::deinit()
 {
-    if (m_NumBmpsLoaded > 0) {
-        AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
-                "Average latency for async bitmap loads: " << m_TotalLatency/m_NumBmpsLoaded
-                << " ms");
+    if (m_pPendingMsg) {
+        m_MsgQueue.push(m_pPendingMsg);
+        m_pPendingMsg = BitmapManagerMsgPtr();
     }
+    // Leave deferred loads to the threads that are started next.
+    for (int i=0; i<m_NumDeferredLoads; ++i) {
+        m_CmdQueue.pushCmd(boost::bind(&BitmapManagerThread::loadNextBitmap, _1));
+    }
+    m_NumDeferredLoads = 0;
 }
 
 static ProfilingZoneID LoaderProfilingZone("loadBitmap", true);
 
-void BitmapManagerThread::loadBitmap(BitmapManagerMsgPtr pRequest)
+void BitmapManagerThread::loadNextBitmap()
 {
+    if (m_pPendingMsg) {
+        // The request stays in the request queue, so it keeps its priority and can
+        // still be cancelled.
+        m_NumDeferredLoads++;
+        return;
+    }
+    BitmapManagerMsgPtr pRequest = m_RequestQueue.pop();
+    if (!pRequest) {
+        // Request was cancelled.
+        return;
+    }
     BitmapPtr pBmp;
     ScopeTimer timer(LoaderProfilingZone);
-    float startTime = pRequest->getStartTime();
+    float loadStartTime = TimeSource::get()->getCurrentMicrosecs()/1000.0f;
     try {
         pBmp = avg::loadBitmap(pRequest->getFilename(), pRequest->getPixelFormat());
+        if (isBlockCompression(pRequest->getCompression())) {
+            pBmp = compressBlocks(*pBmp, pRequest->getCompression());
+        }
         pRequest->setBitmap(pBmp);
     } catch (const Exception& ex) {
         pRequest->setError(ex);
     }
-    m_MsgQueue.push(pRequest);
-    m_NumBmpsLoaded++;
-    float curLatency = TimeSource::get()->getCurrentMicrosecs()/1000 - startTime;
-    m_TotalLatency += curLatency;
+    pRequest->setLoadTimes(loadStartTime, 
+            TimeSource::get()->getCurrentMicrosecs()/1000.0f);
+    pushMsg(pRequest);
     ThreadProfiler::get()->reset();
 }
 
+void BitmapManagerThread::pushMsg(BitmapManagerMsgPtr pMsg)
+{
+    if (isScheduled()) {
+        // Blocking on a full queue would block the scheduler's worker as well.
+        if (!m_MsgQueue.tryPush(pMsg)) {
+            m_pPendingMsg = pMsg;
+        }
+    } else {
+        m_MsgQueue.push(pMsg);
+    }
+}
+
 }
@@ -25,6 +25,7 @@
 #include "../api.h"
 
 #include "BitmapManagerMsg.h"
+#include "BitmapRequestQueue.h"
 
 #include "../base/WorkerThread.h"
 
@@ -36,17 +37,28 @@ namespace avg {
 class AVG_API BitmapManagerThread : public WorkerThread<BitmapManagerThread>
 {
     public:
-        BitmapManagerThread(CQueue& cmdQ, BitmapManagerMsgQueue& MsgQueue);
+        BitmapManagerThread(CQueue& cmdQ, BitmapRequestQueue& requestQueue,
+                BitmapManagerMsgQueue& MsgQueue);
                 
-        void loadBitmap(BitmapManagerMsgPtr pRequest);
+        // Loads the request with the highest priority. The BitmapManager pushes one
+        // of these commands per request.
+        void loadNextBitmap();
+
+        virtual void addQueueListener(IQueueListener* pListener);
+        virtual void removeQueueListener(IQueueListener* pListener);
         
     private:
         virtual bool work();
         virtual void deinit();
-        BitmapManagerMsgQueue& m_MsgQueue;
+        void pushMsg(BitmapManagerMsgPtr pMsg);
 
-        float m_TotalLatency;
-        int m_NumBmpsLoaded;
+        CQueue& m_CmdQueue;
+        BitmapRequestQueue& m_RequestQueue;
+        BitmapManagerMsgQueue& m_MsgQueue;
+        // When running on the TaskScheduler, a finished bitmap that didn't fit into the
+        // message queue waits here. Further loads are deferred until it's delivered.
+        BitmapManagerMsgPtr m_pPendingMsg;
+        int m_NumDeferredLoads;
 };
 
 }
@@ -0,0 +1,116 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "BitmapRequestQueue.h"
+
+using namespace std;
+
+namespace avg {
+
+BitmapRequestQueue::BitmapRequestQueue()
+{
+}
+
+BitmapRequestQueue::~BitmapRequestQueue()
+{
+}
+
+bool BitmapRequestQueue::push(BitmapManagerMsgPtr pMsg)
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    bool bNewRequest = true;
+    if (pMsg->isPrefetch()) {
+        RequestMap::iterator it = findPrefetch(pMsg->getFilename());
+        if (it != m_Requests.end()) {
+            m_Requests.erase(it);
+            bNewRequest = false;
+        }
+    }
+    m_Requests.insert(make_pair(pMsg->getPriority(), pMsg));
+    return bNewRequest;
+}
+
+BitmapManagerMsgPtr BitmapRequestQueue::pop()
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    if (m_Requests.empty()) {
+        return BitmapManagerMsgPtr();
+    }
+    BitmapManagerMsgPtr pMsg = m_Requests.begin()->second;
+    m_Requests.erase(m_Requests.begin());
+    return pMsg;
+}
+
+int BitmapRequestQueue::cancelPrefetch(const UTF8String& sFilename)
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    RequestMap::iterator it = findPrefetch(sFilename);
+    if (it != m_Requests.end()) {
+        m_Requests.erase(it);
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+int BitmapRequestQueue::cancelAllPrefetches()
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    int numCancelled = 0;
+    RequestMap::iterator it = m_Requests.begin();
+    while (it != m_Requests.end()) {
+        if (it->second->isPrefetch()) {
+            m_Requests.erase(it++);
+            numCancelled++;
+        } else {
+            ++it;
+        }
+    }
+    return numCancelled;
+}
+
+void BitmapRequestQueue::clear()
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    m_Requests.clear();
+}
+
+int BitmapRequestQueue::size() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_Requests.size();
+}
+
+BitmapRequestQueue::RequestMap::iterator BitmapRequestQueue::findPrefetch(
+        const UTF8String& sFilename)
+{
+    // Linear search, but the number of pending requests is small.
+    RequestMap::iterator it;
+    for (it = m_Requests.begin(); it != m_Requests.end(); ++it) {
+        if (it->second->isPrefetch() && it->second->getFilename() == sFilename) {
+            break;
+        }
+    }
+    return it;
+}
+
+}
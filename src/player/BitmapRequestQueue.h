@@ -0,0 +1,71 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _BitmapRequestQueue_H_
+#define _BitmapRequestQueue_H_
+
+#include "../api.h"
+
+#include "BitmapManagerMsg.h"
+
+#include <boost/thread/mutex.hpp>
+
+#include <map>
+#include <functional>
+
+namespace avg {
+
+// Pending BitmapManager requests, ordered by priority. Requests with the same priority
+// are served in the order they were pushed. Shared by all BitmapManagerThreads.
+class AVG_API BitmapRequestQueue
+{
+public:
+    BitmapRequestQueue();
+    virtual ~BitmapRequestQueue();
+
+    // A prefetch for a file that is already queued just updates the priority of the
+    // queued request. Returns false in this case.
+    bool push(BitmapManagerMsgPtr pMsg);
+    // Returns an empty pointer if there are no requests.
+    BitmapManagerMsgPtr pop();
+
+    // Only prefetch requests can be cancelled. Returns the number of requests removed.
+    int cancelPrefetch(const UTF8String& sFilename);
+    int cancelAllPrefetches();
+
+    void clear();
+    int size() const;
+
+private:
+    typedef std::multimap<int, BitmapManagerMsgPtr, std::greater<int> > RequestMap;
+
+    RequestMap::iterator findPrefetch(const UTF8String& sFilename);
+
+    RequestMap m_Requests;
+    mutable boost::mutex m_Mutex;
+};
+
+typedef boost::shared_ptr<BitmapRequestQueue> BitmapRequestQueuePtr;
+
+}
+
+#endif
@@ -29,6 +29,7 @@
 #include "../base/Exception.h"
 #include "../base/ScopeTimer.h"
 #include "../base/XMLHelper.h"
+#include "../base/TimeSource.h"
 
 #include "../graphics/Filterfill.h"
 #include "../graphics/TextureMover.h"
@@ -70,13 +71,17 @@ void CameraNode::registerType()
         .addArg(Arg<int>("camgamma", -1))
         .addArg(Arg<int>("shutter", -1))
         .addArg(Arg<int>("gain", -1))
-        .addArg(Arg<int>("strobeduration", -1));
+        .addArg(Arg<int>("strobeduration", -1))
+        .addArg(Arg<bool>("threadedcapture", false));
     TypeRegistry::get()->registerType(def);
 }
 
 CameraNode::CameraNode(const ArgList& args)
     : m_bIsPlaying(false),
       m_FrameNum(0),
+      m_NumDroppedFrames(0),
+      m_CurBmpCaptureTime(0),
+      m_CaptureLatency(0),
       m_bAutoUpdateCameraImage(true),
       m_bNewBmp(false),
       m_bNewSurface(false)
@@ -90,6 +95,7 @@ CameraNode::CameraNode(const ArgList& args)
     int width = args.getArgVal<int>("capturewidth");
     int height = args.getArgVal<int>("captureheight");
     string sPF = args.getArgVal<string>("pixelformat");
+    m_bThreadedCapture = args.getArgVal<bool>("threadedcapture");
 
     PixelFormat camPF = stringToPixelFormat(sPF);
     if (camPF == NO_PIXELFORMAT) {
@@ -125,6 +131,7 @@ CameraNode::CameraNode(const ArgList& args)
 
 CameraNode::~CameraNode()
 {
+    stopCaptureThread();
     m_pCamera = CameraPtr();
 }
 
@@ -147,6 +154,7 @@ void CameraNode::connect(CanvasPtr pCanvas)
 
 void CameraNode::disconnect(bool bKill)
 {
+    stopCaptureThread();
     if (bKill) {
         m_pCamera = CameraPtr();
     }
@@ -163,6 +171,7 @@ void CameraNode::play()
 
 void CameraNode::stop()
 {
+    stopCaptureThread();
     m_bIsPlaying = false;
 }
 
@@ -237,25 +246,37 @@ void CameraNode::setGain(int value)
 
 int CameraNode::getWhitebalanceU() const
 {
+    boost::mutex::scoped_lock lock(m_FeatureMutex);
     return m_pCamera->getWhitebalanceU();
 }
 
 int CameraNode::getWhitebalanceV() const
 {
+    boost::mutex::scoped_lock lock(m_FeatureMutex);
     return m_pCamera->getWhitebalanceV();
 }
 
 void CameraNode::setWhitebalance(int u, int v)
 {
-    m_pCamera->setWhitebalance(u, v);
+    if (m_pCaptureThread) {
+        m_pCaptureCmdQ->pushCmd(boost::bind(&CameraCaptureThread::setWhitebalance, _1,
+                u, v));
+    } else {
+        m_pCamera->setWhitebalance(u, v);
+    }
 }
 
 void CameraNode::doOneShotWhitebalance()
 {
-    // The first line turns off auto white balance.
-    m_pCamera->setWhitebalance(m_pCamera->getWhitebalanceU(), 
-            m_pCamera->getWhitebalanceV());
-    m_pCamera->setFeatureOneShot(CAM_FEATURE_WHITE_BALANCE);
+    if (m_pCaptureThread) {
+        m_pCaptureCmdQ->pushCmd(boost::bind(
+                &CameraCaptureThread::doOneShotWhitebalance, _1));
+    } else {
+        // The first line turns off auto white balance.
+        m_pCamera->setWhitebalance(m_pCamera->getWhitebalanceU(), 
+                m_pCamera->getWhitebalanceV());
+        m_pCamera->setFeatureOneShot(CAM_FEATURE_WHITE_BALANCE);
+    }
 }
 
 int CameraNode::getStrobeDuration() const
@@ -303,6 +324,9 @@ float CameraNode::getFPS() const
 void CameraNode::open()
 {
     m_pCamera->startCapture();
+    if (m_bThreadedCapture) {
+        startCaptureThread();
+    }
     setViewport(-32767, -32767, -32767, -32767);
     PixelFormat pf = getPixelFormat();
     IntPoint size = getMediaSize();
@@ -317,12 +341,18 @@ void CameraNode::open()
 
 int CameraNode::getFeature(CameraFeature feature) const
 {
+    boost::mutex::scoped_lock lock(m_FeatureMutex);
     return m_pCamera->getFeature(feature);
 }
 
 void CameraNode::setFeature(CameraFeature feature, int value)
 {
-    m_pCamera->setFeature(feature, value);
+    if (m_pCaptureThread) {
+        m_pCaptureCmdQ->pushCmd(boost::bind(&CameraCaptureThread::setFeature, _1,
+                feature, value));
+    } else {
+        m_pCamera->setFeature(feature, value);
+    }
 }
 
 int CameraNode::getFrameNum() const
@@ -330,6 +360,20 @@ int CameraNode::getFrameNum() const
     return m_FrameNum;
 }
 
+int CameraNode::getNumDroppedFrames() const
+{
+    int numDropped = m_NumDroppedFrames;
+    if (m_pFrameSlot) {
+        numDropped += m_pFrameSlot->getNumDroppedFrames();
+    }
+    return numDropped;
+}
+
+float CameraNode::getCaptureLatency() const
+{
+    return m_CaptureLatency;
+}
+
 static ProfilingZoneID CameraFetchImage("Camera fetch image");
 static ProfilingZoneID CameraDownloadProfilingZone("Camera tex download");
 
@@ -346,6 +390,9 @@ void CameraNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
             if (m_bNewBmp) {
                 ScopeTimer Timer(CameraDownloadProfilingZone);
                 m_FrameNum++;
+                invalidateRender();
+                m_CaptureLatency = float(TimeSource::get()->getCurrentMicrosecs()-
+                        m_CurBmpCaptureTime)/1000;
                 GLContextManager::get()->scheduleTexUpload(m_pTex, m_pCurBmp);
                 scheduleFXRender();
                 m_bNewBmp = false;
@@ -360,6 +407,7 @@ void CameraNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
                 }
                 GLContextManager::get()->scheduleTexUpload(m_pTex, pBmp);
                 scheduleFXRender();
+                invalidateRender();
             }
             m_bNewSurface = false;
         }
@@ -385,18 +433,56 @@ PixelFormat CameraNode::getPixelFormat()
 
 void CameraNode::updateToLatestCameraImage()
 {
-    BitmapPtr pTmpBmp = m_pCamera->getImage(false);
+    long long captureTime;
+    BitmapPtr pTmpBmp = fetchCameraImage(captureTime);
     while (pTmpBmp) {
+        if (m_bNewBmp) {
+            m_NumDroppedFrames++;
+        }
         m_bNewBmp = true;
         m_pCurBmp = pTmpBmp;
-        pTmpBmp = m_pCamera->getImage(false);
+        m_CurBmpCaptureTime = captureTime;
+        pTmpBmp = fetchCameraImage(captureTime);
     }
 }
 
 void CameraNode::updateCameraImage()
 {
     if (!m_bAutoUpdateCameraImage) {
-        m_pCurBmp = m_pCamera->getImage(false);
+        m_pCurBmp = fetchCameraImage(m_CurBmpCaptureTime);
+    }
+}
+
+BitmapPtr CameraNode::fetchCameraImage(long long& captureTime)
+{
+    if (m_pFrameSlot) {
+        return m_pFrameSlot->fetch(captureTime);
+    } else {
+        captureTime = TimeSource::get()->getCurrentMicrosecs();
+        return m_pCamera->getImage(false);
+    }
+}
+
+void CameraNode::startCaptureThread()
+{
+    if (!m_pCaptureThread) {
+        m_pCaptureCmdQ = CameraCaptureCmdQueuePtr(new CameraCaptureThread::CQueue);
+        m_pFrameSlot = CameraFrameSlotPtr(new CameraFrameSlot);
+        m_pCaptureThread = WorkerHandlePtr(new OSThreadHandle(new boost::thread(
+                CameraCaptureThread(*m_pCaptureCmdQ, m_pCamera, m_pFrameSlot,
+                        m_FeatureMutex))));
+    }
+}
+
+void CameraNode::stopCaptureThread()
+{
+    if (m_pCaptureThread) {
+        m_pCaptureCmdQ->pushCmd(boost::bind(&CameraCaptureThread::stop, _1));
+        m_pCaptureThread->join();
+        m_NumDroppedFrames += m_pFrameSlot->getNumDroppedFrames();
+        m_pCaptureThread = WorkerHandlePtr();
+        m_pFrameSlot = CameraFrameSlotPtr();
+        m_pCaptureCmdQ = CameraCaptureCmdQueuePtr();
     }
 }
 
@@ -29,6 +29,9 @@
 
 #include "../imaging/Camera.h"
 #include "../imaging/CameraInfo.h"
+#include "../imaging/CameraCaptureThread.h"
+
+#include "../base/WorkerHandle.h"
 
 #include <boost/thread/thread.hpp>
 
@@ -102,6 +105,8 @@ class AVG_API CameraNode : public RasterNode
         virtual void render(GLContext* pContext, const glm::mat4& transform);
 
         int getFrameNum() const;
+        int getNumDroppedFrames() const;
+        float getCaptureLatency() const;
         IntPoint getMediaSize();
         virtual BitmapPtr getBitmap();
 
@@ -118,17 +123,31 @@ class AVG_API CameraNode : public RasterNode
         void setFeature(int FeatureID);
 
         void updateToLatestCameraImage();
+        BitmapPtr fetchCameraImage(long long& captureTime);
+        void startCaptureThread();
+        void stopCaptureThread();
 
         bool m_bIsPlaying;
     
         CameraPtr m_pCamera;
         int m_FrameNum;
+        int m_NumDroppedFrames;
         BitmapPtr m_pCurBmp;
+        long long m_CurBmpCaptureTime;
+        float m_CaptureLatency;
         bool m_bAutoUpdateCameraImage;
         bool m_bNewBmp;
         bool m_bNewSurface;
 
         MCTexturePtr m_pTex;
+
+        bool m_bThreadedCapture;
+        CameraCaptureCmdQueuePtr m_pCaptureCmdQ;
+        CameraFrameSlotPtr m_pFrameSlot;
+        WorkerHandlePtr m_pCaptureThread;
+        // Features are changed by the capture thread while it runs. Setting a feature
+        // only takes effect after the next captured frame in that case.
+        mutable boost::mutex m_FeatureMutex;
 };
 
 }
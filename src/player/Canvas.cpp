@@ -34,6 +34,7 @@
 #include "../graphics/StandardShader.h"
 #include "../graphics/GLContextManager.h"
 #include "../graphics/MCFBO.h"
+#include "../graphics/ReadbackRing.h"
 
 #include <iostream>
 
@@ -49,7 +50,9 @@ Canvas::Canvas(Player * pPlayer)
       m_PlaybackEndSignal(&IPlaybackEndListener::onPlaybackEnd),
       m_FrameEndSignal(&IFrameEndListener::onFrameEnd),
       m_PreRenderSignal(&IPreRenderListener::onPreRender),
-      m_ClipLevel(0)
+      m_ClipLevel(0),
+      m_bDirty(true),
+      m_NumDrawCalls(0)
 {
 }
 
@@ -72,6 +75,7 @@ void Canvas::initPlayback(int multiSampleSamples)
     m_pRootNode->connectDisplay();
     m_MultiSampleSamples = multiSampleSamples;
     m_pVertexArray = GLContextManager::get()->createVertexArray(2000, 3000);
+    m_bDirty = true;
 }
 
 void Canvas::stopPlayback(bool bIsAbort)
@@ -85,9 +89,43 @@ void Canvas::stopPlayback(bool bIsAbort)
         m_IDMap.clear();
         m_bIsPlaying = false;
         m_pVertexArray = VertexArrayPtr();
+        m_pReadbackRing = ReadbackRingPtr();
+        m_pFinishedScreenshots.clear();
     }
 }
 
+void Canvas::requestScreenshot()
+{
+    if (!m_pReadbackRing) {
+        m_pReadbackRing = createReadbackRing();
+        if (!m_pReadbackRing) {
+            m_pFinishedScreenshots.push_back(screenshot());
+            return;
+        }
+    }
+    if (m_pReadbackRing->isFull()) {
+        m_pFinishedScreenshots.push_back(finishReadback(m_pReadbackRing->getImage(true)));
+    }
+    startReadback(*m_pReadbackRing);
+}
+
+BitmapPtr Canvas::getRequestedScreenshot()
+{
+    if (!m_pFinishedScreenshots.empty()) {
+        BitmapPtr pBmp = m_pFinishedScreenshots.front();
+        m_pFinishedScreenshots.pop_front();
+        return pBmp;
+    }
+    if (m_pReadbackRing) {
+        // Without fences, there's no way to poll, so we wait for the oldest readback.
+        BitmapPtr pBmp = m_pReadbackRing->getImage(!m_pReadbackRing->usesFences());
+        if (pBmp) {
+            return finishReadback(pBmp);
+        }
+    }
+    return BitmapPtr();
+}
+
 NodePtr Canvas::getElementByID(const std::string& id)
 {
     if (m_IDMap.find(id) != m_IDMap.end()) {
@@ -245,9 +283,16 @@ static ProfilingZoneID VATransferProfilingZone("VA Transfer");
 void Canvas::preRender()
 {
     ScopeTimer Timer(PreRenderProfilingZone);
+    m_NumDrawCalls = 0;
     m_pVertexArray->reset();
     createStdSubVA();
     m_pRootNode->preRender(m_pVertexArray, true, 1.0f);
+    if (m_pVertexArray->getNumVertsWritten() != 0 || 
+            m_pVertexArray->getNumIndexesWritten() != 0)
+    {
+        // Geometry changed in a way the nodes didn't report.
+        m_bDirty = true;
+    }
 }
 
 static ProfilingZoneID RootRenderProfilingZone("RootNode: render");
@@ -256,6 +301,7 @@ void Canvas::renderWindow(WindowPtr pWindow, MCFBOPtr pFBO, const IntRect& viewp
 {
     GLContext* pContext = pWindow->getGLContext();
     pContext->activate();
+    int numDrawCallsBefore = pContext->getNumDrawCalls();
 
     GLContextManager::get()->uploadDataForContext();
     renderFX(pContext);
@@ -285,6 +331,22 @@ void Canvas::renderWindow(WindowPtr pWindow, MCFBOPtr pFBO, const IntRect& viewp
         m_pRootNode->maybeRender(pContext, projMat);
     }
     renderOutlines(pContext, projMat);
+    m_NumDrawCalls += pContext->getNumDrawCalls()-numDrawCallsBefore;
+}
+
+void Canvas::setDirty()
+{
+    m_bDirty = true;
+}
+
+bool Canvas::isDirty() const
+{
+    return m_bDirty;
+}
+
+void Canvas::resetDirty()
+{
+    m_bDirty = false;
 }
 
 void Canvas::scheduleFXRender(const RasterNodePtr& pNode)
@@ -297,6 +359,29 @@ SubVertexArray& Canvas::getStdSubVA()
     return m_StdSubVA;
 }
 
+int Canvas::getNumVertsWritten() const
+{
+    if (m_pVertexArray) {
+        return m_pVertexArray->getNumVertsWritten();
+    } else {
+        return 0;
+    }
+}
+
+int Canvas::getNumVertexBytesUploaded() const
+{
+    if (m_pVertexArray) {
+        return m_pVertexArray->getNumBytesUploaded();
+    } else {
+        return 0;
+    }
+}
+
+int Canvas::getNumDrawCalls() const
+{
+    return m_NumDrawCalls;
+}
+
 void Canvas::renderOutlines(GLContext* pContext, const glm::mat4& transform)
 {
     VertexArrayPtr pVA = GLContextManager::get()->createVertexArray();
@@ -315,6 +400,9 @@ void Canvas::renderOutlines(GLContext* pContext, const glm::mat4& transform)
 
 void Canvas::createStdSubVA()
 {
+    if (m_pVertexArray->reuseSubVA(m_StdSubVA)) {
+        return;
+    }
     m_pVertexArray->startSubVA(m_StdSubVA);
     Pixel32 color(0, 0, 0, 0);
     m_StdSubVA.appendPos(vec2(0,0), vec2(0,0), color); 
@@ -39,6 +39,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <deque>
 #include <boost/enable_shared_from_this.hpp>
 
 namespace avg {
@@ -57,6 +58,7 @@ class VertexArray;
 class SubVertexArray;
 class Window;
 class Bitmap;
+class ReadbackRing;
 
 typedef boost::shared_ptr<Node> NodePtr;
 typedef boost::shared_ptr<RasterNode> RasterNodePtr;
@@ -66,6 +68,7 @@ typedef boost::shared_ptr<MCFBO> MCFBOPtr;
 typedef boost::shared_ptr<VertexArray> VertexArrayPtr;
 typedef boost::shared_ptr<Window> WindowPtr;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
+typedef boost::shared_ptr<ReadbackRing> ReadbackRingPtr;
 
 class Canvas;
 typedef boost::shared_ptr<Canvas> CanvasPtr;
@@ -88,6 +91,10 @@ class AVG_API Canvas: public ExportedObject
         virtual void doFrame(bool bPythonAvailable);
         IntPoint getSize() const;
         virtual BitmapPtr screenshot() const = 0;
+        // Asynchronous screenshot: requestScreenshot() starts reading the canvas,
+        // getRequestedScreenshot() returns the screenshots in order once they're there.
+        void requestScreenshot();
+        BitmapPtr getRequestedScreenshot();
         virtual void pushClipRect(GLContext* pContext, const glm::mat4& transform,
                 SubVertexArray& va);
         virtual void popClipRect(GLContext* pContext, const glm::mat4& transform,
@@ -108,12 +115,28 @@ class AVG_API Canvas: public ExportedObject
         void scheduleFXRender(const RasterNodePtr& pNode);
         SubVertexArray& getStdSubVA();
 
+        // Vertex array statistics for the last frame.
+        int getNumVertsWritten() const;
+        int getNumVertexBytesUploaded() const;
+        int getNumDrawCalls() const;
+
+        // Damage tracking: Nodes set the canvas dirty when something they render 
+        // changes.
+        void setDirty();
+        bool isDirty() const;
+
     protected:
         Player * getPlayer() const;
         void preRender();
         void emitPreRenderSignal(); 
+        void resetDirty();
         void emitFrameEndSignal();
 
+        // Return an empty ReadbackRingPtr if asynchronous readback isn't possible.
+        virtual ReadbackRingPtr createReadbackRing() const = 0;
+        virtual void startReadback(ReadbackRing& ring) const = 0;
+        virtual BitmapPtr finishReadback(BitmapPtr pBmp) const = 0;
+
     private:
         virtual void renderTree()=0;
         void renderFX(GLContext* pContext);
@@ -138,8 +161,13 @@ class AVG_API Canvas: public ExportedObject
 
         int m_MultiSampleSamples;
         int m_ClipLevel;
+        bool m_bDirty;
+        int m_NumDrawCalls;
 
         std::vector<RasterNodePtr> m_pScheduledFXNodes;
+
+        ReadbackRingPtr m_pReadbackRing;
+        std::deque<BitmapPtr> m_pFinishedScreenshots;
 };
 
 }
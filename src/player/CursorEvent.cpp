@@ -135,6 +135,19 @@ ContactPtr CursorEvent::getContact() const
     return m_pContact.lock();
 }
 
+void CursorEvent::addToHistory(CursorEventPtr pEvent)
+{
+    m_History.insert(m_History.end(), pEvent->m_History.begin(), 
+            pEvent->m_History.end());
+    pEvent->m_History.clear();
+    m_History.push_back(pEvent);
+}
+
+const vector<CursorEventPtr>& CursorEvent::getHistory() const
+{
+    return m_History;
+}
+
 bool operator ==(const CursorEvent& event1, const CursorEvent& event2)
 {
     return (event1.m_Position == event2.m_Position && 
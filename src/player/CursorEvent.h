@@ -32,6 +32,8 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
 
+#include <vector>
+
 namespace avg {
 
 const int MOUSECURSORID=-1;
@@ -70,6 +72,10 @@ class AVG_API CursorEvent: public Event
 
         void setContact(ContactPtr pContact);
         ContactPtr getContact() const;
+
+        // Earlier motion events that were coalesced into this one, oldest first.
+        void addToHistory(CursorEventPtr pEvent);
+        const std::vector<CursorEventPtr>& getHistory() const;
         virtual void removeBlob() {};
 
         friend bool operator ==(const CursorEvent& event1, const CursorEvent& event2);
@@ -83,6 +89,7 @@ class AVG_API CursorEvent: public Event
         int m_JointID;
         NodePtr m_pNode;
         glm::vec2 m_Speed;
+        std::vector<CursorEventPtr> m_History;
 };
 
 bool operator ==(const CursorEvent& event1, const CursorEvent& event2);
@@ -24,6 +24,7 @@
 #include "TypeDefinition.h"
 #include "TypeRegistry.h"
 #include "Canvas.h"
+#include "ShapeBatch.h"
 
 #include "../graphics/GLContext.h"
 
@@ -55,7 +56,9 @@ void DivNode::registerType()
             ExportedObject::buildObject<DivNode>)
         .addChildren(sChildren)
         .addArg(Arg<bool>("crop", false, false, offsetof(DivNode, m_bCrop)))
-        .addArg(Arg<UTF8String>("mediadir", "", false, offsetof(DivNode, m_sMediaDir)));
+        .addArg(Arg<UTF8String>("mediadir", "", false, offsetof(DivNode, m_sMediaDir)))
+        .addArg(Arg<bool>("spatialindex", false, false, 
+                offsetof(DivNode, m_bSpatialIndex)));
     TypeRegistry::get()->registerType(def);
 }
 
@@ -169,6 +172,8 @@ void DivNode::insertChild(NodePtr pChild, unsigned i)
     }
     std::vector<NodePtr>::iterator pos = m_Children.begin()+i;
     m_Children.insert(pos, pChild);
+    m_HitTestGrid.invalidate();
+    invalidateRender();
     try {
         pChild->setParent(this, getState(), getCanvas());
     } catch (Exception&) {
@@ -190,6 +195,8 @@ void DivNode::reorderChild(NodePtr pChild, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    m_HitTestGrid.invalidate();
+    invalidateRender();
 }
 
 void DivNode::reorderChild(unsigned i, unsigned j)
@@ -202,6 +209,8 @@ void DivNode::reorderChild(unsigned i, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    m_HitTestGrid.invalidate();
+    invalidateRender();
 }
 
 unsigned DivNode::indexOf(NodePtr pChild)
@@ -242,6 +251,8 @@ void DivNode::removeChild(NodePtr pChild, bool bKill)
                 getID()+"::removeChild: index "+toString(i)+" out of bounds."));
     }
     m_Children.erase(m_Children.begin()+i);
+    m_HitTestGrid.invalidate();
+    invalidateRender();
 }
 
 void DivNode::removeChild(unsigned i, bool bKill)
@@ -258,6 +269,7 @@ bool DivNode::getCrop() const
 void DivNode::setCrop(bool bCrop)
 {
     m_bCrop = bCrop;
+    invalidateRender();
 }
 
 const UTF8String& DivNode::getMediaDir() const
@@ -272,19 +284,39 @@ void DivNode::setMediaDir(const UTF8String& sMediaDir)
     checkReload();
 }
 
+bool DivNode::getSpatialIndex() const
+{
+    return m_bSpatialIndex;
+}
+
+void DivNode::setSpatialIndex(bool bSpatialIndex)
+{
+    m_bSpatialIndex = bSpatialIndex;
+    m_HitTestGrid.invalidate();
+}
+
 void DivNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements)
 {
     if (reactsToMouseEvents() &&
             ((getSize() == glm::vec2(0,0) ||
              (pos.x >= 0 && pos.y >= 0 && pos.x < getSize().x && pos.y < getSize().y))))
     {
-        for (int i = getNumChildren()-1; i >= 0; i--) {
-            NodePtr pCurChild = getChild(i);
-            glm::vec2 relPos = pCurChild->toLocal(pos);
-            pCurChild->getElementsByPos(relPos, pElements);
-            if (!pElements.empty()) {
-                pElements.push_back(getSharedThis());
-                return;
+        if (m_bSpatialIndex) {
+            if (!m_HitTestGrid.isValid()) {
+                m_HitTestGrid.rebuild(m_Children);
+            }
+            vector<int> candidates;
+            m_HitTestGrid.getCandidates(pos, candidates);
+            for (unsigned i = 0; i < candidates.size(); ++i) {
+                if (getChildElementsByPos(m_Children[candidates[i]], pos, pElements)) {
+                    return;
+                }
+            }
+        } else {
+            for (int i = getNumChildren()-1; i >= 0; i--) {
+                if (getChildElementsByPos(m_Children[i], pos, pElements)) {
+                    return;
+                }
             }
         }
         // pos isn't in any of the children.
@@ -295,13 +327,33 @@ void DivNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements)
     }
 }
 
+bool DivNode::getHitTestBounds(FRect& bounds) const
+{
+    if (getSize() == glm::vec2(0,0)) {
+        // Children can be anywhere.
+        return false;
+    } else {
+        return AreaNode::getHitTestBounds(bounds);
+    }
+}
+
+void DivNode::onChildHitTestBoundsChange(const Node* pChild)
+{
+    if (m_bSpatialIndex && m_HitTestGrid.isValid()) {
+        m_HitTestGrid.updateChild(pChild);
+    }
+}
+
 void DivNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
         float parentEffectiveOpacity)
 {
     AreaNode::preRender(pVA, bIsParentActive, parentEffectiveOpacity);
-    if (getCrop() && getSize() != glm::vec2(0,0)) {
+    if (getCrop() && getSize() != glm::vec2(0,0) && 
+            (getSize() != m_ClipVASize || !pVA->reuseSubVA(m_ClipVA)))
+    {
         pVA->startSubVA(m_ClipVA);
         glm::vec2 viewport = getSize();
+        m_ClipVASize = viewport;
         m_ClipVA.appendPos(glm::vec2(0,0), glm::vec2(0,0), Pixel32(0,0,0,0));
         m_ClipVA.appendPos(glm::vec2(0,viewport.y), glm::vec2(0,0), Pixel32(0,0,0,0));
         m_ClipVA.appendPos(glm::vec2(viewport.x,0), glm::vec2(0,0), Pixel32(0,0,0,0));
@@ -318,9 +370,11 @@ void DivNode::render(GLContext* pContext, const glm::mat4& transform)
     if (getCrop() && getSize() != glm::vec2(0,0)) {
         getCanvas()->pushClipRect(pContext, transform, m_ClipVA);
     }
+    ShapeBatch batch(pContext);
     for (unsigned i = 0; i < getNumChildren(); i++) {
-        getChild(i)->maybeRender(pContext, transform);
+        getChild(i)->maybeRenderBatched(batch, transform);
     }
+    batch.flush();
     if (getCrop() && getSize() != glm::vec2(0,0)) {
         getCanvas()->popClipRect(pContext, transform, m_ClipVA);
     }
@@ -391,4 +445,17 @@ bool DivNode::isChildTypeAllowed(const string& sType)
     return getDefinition()->isChildAllowed(sType);
 }
 
+bool DivNode::getChildElementsByPos(const NodePtr& pChild, const glm::vec2& pos, 
+        vector<NodePtr>& pElements)
+{
+    glm::vec2 relPos = pChild->toLocal(pos);
+    pChild->getElementsByPos(relPos, pElements);
+    if (!pElements.empty()) {
+        pElements.push_back(getSharedThis());
+        return true;
+    } else {
+        return false;
+    }
+}
+
 }
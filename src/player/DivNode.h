@@ -24,6 +24,7 @@
 
 #include "../api.h"
 #include "AreaNode.h"
+#include "HitTestGrid.h"
 
 #include "../graphics/SubVertexArray.h"
 
@@ -68,7 +69,12 @@ class AVG_API DivNode : public AreaNode
         const UTF8String& getMediaDir() const;
         void setMediaDir(const UTF8String& mediaDir);
 
+        bool getSpatialIndex() const;
+        void setSpatialIndex(bool bSpatialIndex);
+
         void getElementsByPos(const glm::vec2& pos, std::vector<NodePtr>& pElements);
+        virtual bool getHitTestBounds(FRect& bounds) const;
+        void onChildHitTestBoundsChange(const Node* pChild);
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
         virtual void render(GLContext* pContext, const glm::mat4& transform);
@@ -82,11 +88,16 @@ class AVG_API DivNode : public AreaNode
    
     private:
         bool isChildTypeAllowed(const std::string& sType);
+        bool getChildElementsByPos(const NodePtr& pChild, const glm::vec2& pos, 
+                std::vector<NodePtr>& pElements);
 
         UTF8String m_sMediaDir;
         bool m_bCrop;
+        bool m_bSpatialIndex;
+        HitTestGrid m_HitTestGrid;
 
         SubVertexArray m_ClipVA;
+        glm::vec2 m_ClipVASize;
 
         std::vector<NodePtr> m_Children;
 };
@@ -25,11 +25,14 @@
 #include "Contact.h"
 #include "CursorEvent.h"
 #include "InputDevice.h"
+#include "EventRecorder.h"
 
 #include "../base/Exception.h"
+#include "../base/Logger.h"
 #include "../base/OSHelper.h"
 
 #include <string>
+#include <algorithm>
 
 using namespace std;
 using namespace boost;
@@ -39,7 +42,8 @@ namespace avg {
 EventDispatcher::EventDispatcher(Player* pPlayer, bool bMouseEnabled)
     : m_pPlayer(pPlayer),
       m_NumMouseButtonsDown(0),
-      m_bMouseEnabled(bMouseEnabled)
+      m_bMouseEnabled(bMouseEnabled),
+      m_bCoalesceMotion(false)
 {
 }
 
@@ -63,6 +67,13 @@ void EventDispatcher::dispatch()
         }
     }
 
+    if (m_pRecorder) {
+        m_pRecorder->addFrame(events, m_pPlayer->getFrameTime());
+    }
+    if (m_bCoalesceMotion) {
+        coalesceMotionEvents(events);
+    }
+
     vector<EventPtr>::iterator it;
     for (it = events.begin(); it != events.end(); ++it) {
         EventPtr pEvent = *it;
@@ -91,6 +102,21 @@ void EventDispatcher::enableMouse(bool bEnabled)
     m_bMouseEnabled = bEnabled;
 }
 
+void EventDispatcher::enableMotionCoalescing(bool bEnabled)
+{
+    m_bCoalesceMotion = bEnabled;
+}
+
+void EventDispatcher::startRecording(const string& sFilename)
+{
+    m_pRecorder = EventRecorderPtr(new EventRecorder(sFilename));
+}
+
+void EventDispatcher::stopRecording()
+{
+    m_pRecorder = EventRecorderPtr();
+}
+
 ContactPtr EventDispatcher::getContact(int id)
 {
     std::map<int, ContactPtr>::iterator it = m_ContactMap.find(id);
@@ -118,6 +144,44 @@ bool EventDispatcher::processEventHook(EventPtr pEvent)
     return false;
 }
 
+void EventDispatcher::coalesceMotionEvents(vector<EventPtr>& events)
+{
+    // Cursor ids are only unique per input device.
+    typedef pair<InputDevice*, int> CursorKey;
+    map<CursorKey, unsigned> lastMotionIndexes;
+    int numMotionEvents = 0;
+    int numCoalesced = 0;
+    for (unsigned i = 0; i < events.size(); ++i) {
+        CursorEventPtr pCursorEvent = dynamic_pointer_cast<CursorEvent>(events[i]);
+        if (!pCursorEvent) {
+            continue;
+        }
+        CursorKey key(pCursorEvent->getInputDevice().get(), 
+                pCursorEvent->getCursorID());
+        if (pCursorEvent->getType() == Event::CURSOR_MOTION) {
+            numMotionEvents++;
+            map<CursorKey, unsigned>::iterator it = lastMotionIndexes.find(key);
+            if (it != lastMotionIndexes.end()) {
+                EventPtr& pPrevEvent = events[it->second];
+                pCursorEvent->addToHistory(dynamic_pointer_cast<CursorEvent>(pPrevEvent));
+                pPrevEvent = EventPtr();
+                numCoalesced++;
+            }
+            lastMotionIndexes[key] = i;
+        } else {
+            // Down and up events end a run of motion events.
+            lastMotionIndexes.erase(key);
+        }
+    }
+    if (numCoalesced > 0) {
+        events.erase(remove(events.begin(), events.end(), EventPtr()), events.end());
+        AVG_TRACE(Logger::category::EVENTS, Logger::severity::DEBUG,
+                "Coalesced " << numMotionEvents << " motion events into " <<
+                numMotionEvents-numCoalesced << " (ratio " << 
+                float(numMotionEvents)/(numMotionEvents-numCoalesced) << ").");
+    }
+}
+
 void EventDispatcher::testAddContact(EventPtr pEvent)
 {
     ContactPtr pContact;
@@ -144,6 +208,12 @@ void EventDispatcher::testAddContact(EventPtr pEvent)
                             pCursorEvent->getSource() == Event::MOUSE && 
                             m_NumMouseButtonsDown == 0));
                     if (pContact) {
+                        // Coalesced motion still counts towards the contact's path.
+                        const vector<CursorEventPtr>& history = 
+                                pCursorEvent->getHistory();
+                        for (unsigned i = 0; i < history.size(); ++i) {
+                            pContact->addEvent(history[i]);
+                        }
                         pContact->addEvent(pCursorEvent);
                     }
                 }
@@ -26,6 +26,7 @@
 
 #include <vector>
 #include <map>
+#include <string>
 #include <boost/shared_ptr.hpp>
 
 namespace avg {
@@ -37,6 +38,8 @@ typedef boost::shared_ptr<class InputDevice> InputDevicePtr;
 class Contact;
 typedef boost::shared_ptr<class Contact> ContactPtr;
 class Player;
+class EventRecorder;
+typedef boost::shared_ptr<class EventRecorder> EventRecorderPtr;
 
 class AVG_API EventDispatcher {
     public:
@@ -48,11 +51,18 @@ class AVG_API EventDispatcher {
 
         void sendEvent(EventPtr pEvent);
         void enableMouse(bool bEnabled);
+        // Merges all motion events of a cursor in a frame into one event. The merged
+        // events are available as the event's history.
+        void enableMotionCoalescing(bool bEnabled);
+        // Records all polled events, see EventRecorder.
+        void startRecording(const std::string& sFilename);
+        void stopRecording();
         ContactPtr getContact(int id);
 
     private:
         void handleEvent(EventPtr pEvent);
         bool processEventHook(EventPtr pEvent);
+        void coalesceMotionEvents(std::vector<EventPtr>& events);
         void testAddContact(EventPtr pEvent);
         void testRemoveContact(EventPtr pEvent);
 
@@ -61,6 +71,8 @@ class AVG_API EventDispatcher {
         std::map<int, ContactPtr> m_ContactMap;
         int m_NumMouseButtonsDown;
         bool m_bMouseEnabled;
+        bool m_bCoalesceMotion;
+        EventRecorderPtr m_pRecorder;
 };
 typedef boost::shared_ptr<EventDispatcher> EventDispatcherPtr;
 
@@ -0,0 +1,272 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "EventRecorder.h"
+
+#include "Event.h"
+#include "CursorEvent.h"
+#include "MouseEvent.h"
+#include "TouchEvent.h"
+#include "TangibleEvent.h"
+#include "KeyEvent.h"
+
+#include "../base/Exception.h"
+
+#include <string.h>
+
+using namespace std;
+using namespace boost;
+
+#define EVENT_FILE_MAGIC "AVGEVENTS"
+#define EVENT_FILE_VERSION 1
+
+namespace avg {
+
+enum EventKind {EK_EVENT, EK_CURSOR, EK_MOUSE, EK_TOUCH, EK_TANGIBLE, EK_KEY};
+
+template<class T>
+static void write(ostream& stream, const T& val)
+{
+    stream.write((const char*)&val, sizeof(T));
+}
+
+template<class T>
+static T read(istream& stream)
+{
+    T val;
+    stream.read((char*)&val, sizeof(T));
+    if (!stream) {
+        throw Exception(AVG_ERR_FILEIO, "Event recording is truncated.");
+    }
+    return val;
+}
+
+static void writeString(ostream& stream, const string& s)
+{
+    write<int>(stream, int(s.length()));
+    stream.write(s.c_str(), s.length());
+}
+
+static string readString(istream& stream)
+{
+    int len = read<int>(stream);
+    string s(len, ' ');
+    if (len > 0) {
+        stream.read(&s[0], len);
+    }
+    return s;
+}
+
+EventRecorder::EventRecorder(const string& sFilename)
+    : m_sFilename(sFilename),
+      m_CurFrame(0)
+{
+    m_Stream.open(sFilename.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!m_Stream) {
+        throw Exception(AVG_ERR_FILEIO, 
+                "Could not open event recording file '" + sFilename + "'.");
+    }
+    writeHeader(m_Stream);
+}
+
+EventRecorder::~EventRecorder()
+{
+}
+
+void EventRecorder::addFrame(const vector<EventPtr>& events, long long frameTime)
+{
+    if (!events.empty()) {
+        write<int>(m_Stream, m_CurFrame);
+        write<long long>(m_Stream, frameTime);
+        write<int>(m_Stream, int(events.size()));
+        for (unsigned i = 0; i < events.size(); ++i) {
+            writeEvent(m_Stream, events[i]);
+        }
+        if (!m_Stream) {
+            throw Exception(AVG_ERR_FILEIO, 
+                    "Could not write to event recording file '" + m_sFilename + "'.");
+        }
+    }
+    m_CurFrame++;
+}
+
+void EventRecorder::writeHeader(ostream& stream)
+{
+    stream.write(EVENT_FILE_MAGIC, strlen(EVENT_FILE_MAGIC));
+    write<int>(stream, EVENT_FILE_VERSION);
+}
+
+void EventRecorder::readHeader(istream& stream, const string& sFilename)
+{
+    char magic[sizeof(EVENT_FILE_MAGIC)];
+    stream.read(magic, strlen(EVENT_FILE_MAGIC));
+    magic[strlen(EVENT_FILE_MAGIC)] = 0;
+    if (!stream || string(magic) != EVENT_FILE_MAGIC) {
+        throw Exception(AVG_ERR_FILEIO, 
+                "'" + sFilename + "' is not an event recording.");
+    }
+    int version = read<int>(stream);
+    if (version != EVENT_FILE_VERSION) {
+        throw Exception(AVG_ERR_FILEIO, 
+                "Unsupported event recording version in '" + sFilename + "'.");
+    }
+}
+
+void EventRecorder::writeEvent(ostream& stream, const EventPtr& pEvent)
+{
+    EventKind kind;
+    if (dynamic_pointer_cast<MouseEvent>(pEvent)) {
+        kind = EK_MOUSE;
+    } else if (dynamic_pointer_cast<TouchEvent>(pEvent)) {
+        kind = EK_TOUCH;
+    } else if (dynamic_pointer_cast<TangibleEvent>(pEvent)) {
+        kind = EK_TANGIBLE;
+    } else if (dynamic_pointer_cast<CursorEvent>(pEvent)) {
+        kind = EK_CURSOR;
+    } else if (dynamic_pointer_cast<KeyEvent>(pEvent)) {
+        kind = EK_KEY;
+    } else {
+        kind = EK_EVENT;
+    }
+    write<int>(stream, kind);
+    write<int>(stream, pEvent->getType());
+    write<int>(stream, pEvent->getSource());
+
+    CursorEventPtr pCursorEvent = dynamic_pointer_cast<CursorEvent>(pEvent);
+    if (pCursorEvent) {
+        write<int>(stream, pCursorEvent->getCursorID());
+        write<int>(stream, pCursorEvent->getXPosition());
+        write<int>(stream, pCursorEvent->getYPosition());
+        write<glm::vec2>(stream, pCursorEvent->getSpeed());
+        write<int>(stream, pCursorEvent->getUserID());
+        write<int>(stream, pCursorEvent->getJointID());
+    }
+    switch (kind) {
+        case EK_MOUSE: {
+                MouseEventPtr pMouseEvent = dynamic_pointer_cast<MouseEvent>(pEvent);
+                write<char>(stream, pMouseEvent->getLeftButtonState());
+                write<char>(stream, pMouseEvent->getMiddleButtonState());
+                write<char>(stream, pMouseEvent->getRightButtonState());
+                write<int>(stream, pMouseEvent->getButton());
+            }
+            break;
+        case EK_TOUCH: {
+                TouchEventPtr pTouchEvent = dynamic_pointer_cast<TouchEvent>(pEvent);
+                write<float>(stream, pTouchEvent->getOrientation());
+                write<float>(stream, pTouchEvent->getArea());
+                write<float>(stream, pTouchEvent->getEccentricity());
+                write<glm::vec2>(stream, pTouchEvent->getMajorAxis());
+                write<glm::vec2>(stream, pTouchEvent->getMinorAxis());
+            }
+            break;
+        case EK_TANGIBLE: {
+                TangibleEventPtr pTangibleEvent = 
+                        dynamic_pointer_cast<TangibleEvent>(pEvent);
+                write<int>(stream, pTangibleEvent->getMarkerID());
+                write<float>(stream, pTangibleEvent->getOrientation());
+            }
+            break;
+        case EK_KEY: {
+                KeyEventPtr pKeyEvent = dynamic_pointer_cast<KeyEvent>(pEvent);
+                write<int>(stream, pKeyEvent->getScanCode());
+                write<int>(stream, pKeyEvent->getModifiers());
+                writeString(stream, pKeyEvent->getName());
+                writeString(stream, pKeyEvent->getText());
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+EventPtr EventRecorder::readEvent(istream& stream)
+{
+    EventKind kind = EventKind(read<int>(stream));
+    Event::Type type = Event::Type(read<int>(stream));
+    Event::Source source = Event::Source(read<int>(stream));
+
+    int cursorID = 0;
+    IntPoint pos;
+    glm::vec2 speed;
+    int userID = -1;
+    int jointID = -1;
+    if (kind == EK_CURSOR || kind == EK_MOUSE || kind == EK_TOUCH || 
+            kind == EK_TANGIBLE)
+    {
+        cursorID = read<int>(stream);
+        pos.x = read<int>(stream);
+        pos.y = read<int>(stream);
+        speed = read<glm::vec2>(stream);
+        userID = read<int>(stream);
+        jointID = read<int>(stream);
+    }
+    CursorEventPtr pCursorEvent;
+    switch (kind) {
+        case EK_EVENT:
+            return EventPtr(new Event(type, source));
+        case EK_CURSOR:
+            pCursorEvent = CursorEventPtr(new CursorEvent(cursorID, type, pos, source));
+            pCursorEvent->setSpeed(speed);
+            break;
+        case EK_MOUSE: {
+                bool bLeft = read<char>(stream) != 0;
+                bool bMiddle = read<char>(stream) != 0;
+                bool bRight = read<char>(stream) != 0;
+                int button = read<int>(stream);
+                pCursorEvent = CursorEventPtr(new MouseEvent(type, bLeft, bMiddle, bRight,
+                        pos, button, speed));
+            }
+            break;
+        case EK_TOUCH: {
+                float orientation = read<float>(stream);
+                float area = read<float>(stream);
+                float eccentricity = read<float>(stream);
+                glm::vec2 majorAxis = read<glm::vec2>(stream);
+                glm::vec2 minorAxis = read<glm::vec2>(stream);
+                pCursorEvent = CursorEventPtr(new TouchEvent(cursorID, type, pos, source,
+                        speed, orientation, area, eccentricity, majorAxis, minorAxis));
+            }
+            break;
+        case EK_TANGIBLE: {
+                int markerID = read<int>(stream);
+                float orientation = read<float>(stream);
+                pCursorEvent = CursorEventPtr(new TangibleEvent(cursorID, markerID, type,
+                        pos, speed, orientation));
+            }
+            break;
+        case EK_KEY: {
+                int scanCode = read<int>(stream);
+                int modifiers = read<int>(stream);
+                UTF8String sName = readString(stream);
+                UTF8String sText = readString(stream);
+                KeyEventPtr pKeyEvent(new KeyEvent(type, scanCode, sName, modifiers));
+                pKeyEvent->setText(sText);
+                return pKeyEvent;
+            }
+        default:
+            throw Exception(AVG_ERR_FILEIO, "Event recording is corrupt.");
+    }
+    pCursorEvent->setUserID(userID, jointID);
+    return pCursorEvent;
+}
+
+}
@@ -0,0 +1,67 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _EventRecorder_H_
+#define _EventRecorder_H_
+
+#include "../api.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+
+namespace avg {
+
+class Event;
+typedef boost::shared_ptr<class Event> EventPtr;
+
+// Writes the input events of each frame to a compact binary file that 
+// EventReplayDevice can play back. The file is written in native byte order.
+class AVG_API EventRecorder
+{
+public:
+    EventRecorder(const std::string& sFilename);
+    virtual ~EventRecorder();
+
+    // Must be called once per frame, even if there are no events.
+    void addFrame(const std::vector<EventPtr>& events, long long frameTime);
+
+    // File format helpers, shared with EventReplayDevice.
+    static void writeHeader(std::ostream& stream);
+    static void readHeader(std::istream& stream, const std::string& sFilename);
+    static void writeEvent(std::ostream& stream, const EventPtr& pEvent);
+    static EventPtr readEvent(std::istream& stream);
+
+private:
+    std::string m_sFilename;
+    std::ofstream m_Stream;
+    int m_CurFrame;
+};
+
+typedef boost::shared_ptr<EventRecorder> EventRecorderPtr;
+
+}
+
+#endif
@@ -0,0 +1,90 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "EventReplayDevice.h"
+#include "EventRecorder.h"
+#include "Event.h"
+
+#include "../base/Exception.h"
+
+using namespace std;
+
+namespace avg {
+
+EventReplayDevice::EventReplayDevice(const string& sFilename)
+    : InputDevice("EventReplayDevice"),
+      m_sFilename(sFilename),
+      m_CurFrame(0),
+      m_NextRecordedFrame(-1),
+      m_NumNextEvents(0)
+{
+    m_Stream.open(sFilename.c_str(), ios::in | ios::binary);
+    if (!m_Stream) {
+        throw Exception(AVG_ERR_FILEIO, 
+                "Could not open event recording file '" + sFilename + "'.");
+    }
+    EventRecorder::readHeader(m_Stream, sFilename);
+    readFrameHeader();
+}
+
+EventReplayDevice::~EventReplayDevice()
+{
+}
+
+vector<EventPtr> EventReplayDevice::pollEvents()
+{
+    vector<EventPtr> events;
+    if (m_NextRecordedFrame == m_CurFrame) {
+        for (int i = 0; i < m_NumNextEvents; ++i) {
+            events.push_back(EventRecorder::readEvent(m_Stream));
+        }
+        readFrameHeader();
+    }
+    m_CurFrame++;
+    return events;
+}
+
+bool EventReplayDevice::isFinished() const
+{
+    return m_NextRecordedFrame == -1;
+}
+
+void EventReplayDevice::readFrameHeader()
+{
+    int frame;
+    m_Stream.read((char*)&frame, sizeof(frame));
+    if (m_Stream.eof()) {
+        m_NextRecordedFrame = -1;
+        m_NumNextEvents = 0;
+        return;
+    }
+    long long frameTime;
+    m_Stream.read((char*)&frameTime, sizeof(frameTime));
+    m_Stream.read((char*)&m_NumNextEvents, sizeof(m_NumNextEvents));
+    if (!m_Stream) {
+        throw Exception(AVG_ERR_FILEIO, 
+                "Event recording '" + m_sFilename + "' is truncated.");
+    }
+    m_NextRecordedFrame = frame;
+}
+
+}
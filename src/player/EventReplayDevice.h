@@ -0,0 +1,63 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _EventReplayDevice_H_
+#define _EventReplayDevice_H_
+
+#include "../api.h"
+#include "InputDevice.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace avg {
+
+// Plays back a file written by EventRecorder. Events are returned in the same frame
+// (counted from the first call to pollEvents()) they were recorded in, so replays 
+// are deterministic if the player runs with a fake framerate.
+class AVG_API EventReplayDevice: public InputDevice
+{
+public:
+    EventReplayDevice(const std::string& sFilename);
+    virtual ~EventReplayDevice();
+
+    virtual std::vector<EventPtr> pollEvents();
+    bool isFinished() const;
+
+private:
+    void readFrameHeader();
+
+    std::string m_sFilename;
+    std::ifstream m_Stream;
+    int m_CurFrame;
+    int m_NextRecordedFrame;
+    int m_NumNextEvents;
+};
+
+typedef boost::shared_ptr<EventReplayDevice> EventReplayDevicePtr;
+
+}
+
+#endif
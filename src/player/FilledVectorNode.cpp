@@ -25,6 +25,7 @@
 #include "TypeRegistry.h"
 #include "DivNode.h"
 #include "Shape.h"
+#include "ShapeBatch.h"
 
 #include "../base/ScopeTimer.h"
 #include "../base/Logger.h"
@@ -85,7 +86,8 @@ void FilledVectorNode::disconnect(bool bKill)
 
 void FilledVectorNode::checkReload()
 {
-    Node::checkReload(m_FillTexHRef, m_pFillShape->getGPUImage());
+    Node::checkReload(m_FillTexHRef, m_pFillShape->getGPUImage(), TEXCOMPRESSION_NONE,
+            getAsyncListener());
     if (getState() == Node::NS_CANRENDER) {
         m_pFillShape->moveToGPU();
         setDrawNeeded();
@@ -174,6 +176,14 @@ void FilledVectorNode::render(GLContext* pContext, const glm::mat4& transform)
     VectorNode::render(pContext, transform);
 }
 
+void FilledVectorNode::renderBatched(ShapeBatch& batch, const glm::mat4& transform)
+{
+    if (m_EffectiveOpacity > 0.01) {
+        batch.draw(m_pFillShape.get(), transform, m_EffectiveOpacity, getBlendMode());
+    }
+    VectorNode::renderBatched(batch, transform);
+}
+
 void FilledVectorNode::setFillColor(const Color& color)
 {
     if (m_FillColor != color) {
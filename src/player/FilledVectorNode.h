@@ -58,6 +58,7 @@ class AVG_API FilledVectorNode : public VectorNode
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
         virtual void render(GLContext* pContext, const glm::mat4& transform);
+        virtual void renderBatched(ShapeBatch& batch, const glm::mat4& transform);
 
         virtual void calcFillVertexes(
                 const VertexDataPtr& pVertexData, Pixel32 color) = 0;
@@ -30,9 +30,13 @@
 #include "../graphics/CachedImage.h"
 #include "../graphics/GLContextManager.h"
 #include "../graphics/Filterfliprgb.h"
+#include "../graphics/BlockCompressor.h"
 
 #include "OGLSurface.h"
 #include "OffscreenCanvas.h"
+#include "ImageAtlas.h"
+#include "BitmapManager.h"
+#include "IBitmapLoadedListener.h"
 
 #include <iostream>
 #include <sstream>
@@ -41,12 +45,49 @@ using namespace std;
 
 namespace avg {
 
+// Passes the result of a BitmapManager request on to the GPUImage. The BitmapManager
+// keeps the request alive until it is done, so it can outlive the GPUImage.
+class GPUImage::LoadRequest: public IBitmapLoadedListener
+{
+public:
+    LoadRequest(GPUImage* pImage)
+        : m_pImage(pImage)
+    {
+    }
+
+    void cancel()
+    {
+        m_pImage = 0;
+    }
+
+    virtual void onBitmapLoaded(BitmapPtr pBmp)
+    {
+        if (m_pImage) {
+            m_pImage->onAsyncLoaded();
+        }
+    }
+
+    virtual void onBitmapLoadError(const Exception* pEx)
+    {
+        if (m_pImage) {
+            m_pImage->onAsyncLoadError(pEx);
+        }
+    }
+
+private:
+    GPUImage* m_pImage;
+};
+
 GPUImage::GPUImage(OGLSurface * pSurface, bool bUseMipmaps)
     : m_sFilename(""),
       m_pSurface(pSurface),
       m_State(CPU),
       m_Source(NONE),
-      m_bUseMipmaps(bUseMipmaps)
+      m_bUseMipmaps(bUseMipmaps),
+      m_bUseAtlas(false),
+      m_bInAtlas(false),
+      m_RequestedCompression(TEXCOMPRESSION_NONE),
+      m_pLoadedListener(0)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     assertValid();
@@ -54,6 +95,7 @@ GPUImage::GPUImage(OGLSurface * pSurface, bool bUseMipmaps)
 
 GPUImage::~GPUImage()
 {
+    cancelAsyncLoad();
     unload();
     ObjectCounter::get()->decRef(&typeid(*this));
 }
@@ -90,7 +132,7 @@ void GPUImage::moveToCPU()
         m_State = CPU;
         m_pSurface->destroy();
         if (m_pImage) {
-            m_pImage->decTexRef();
+            releaseImageTex();
         }
     }
     assertValid();
@@ -99,6 +141,7 @@ void GPUImage::moveToCPU()
 void GPUImage::setEmpty()
 {
     assertValid();
+    cancelAsyncLoad();
     unload();
     changeSource(NONE);
     assertValid();
@@ -107,6 +150,7 @@ void GPUImage::setEmpty()
 void GPUImage::setFilename(const std::string& sFilename, TexCompression comp)
 {
     assertValid();
+    cancelAsyncLoad();
     CachedImagePtr pImage = ImageCache::get()->getImage(sFilename, comp);
     BitmapPtr pBmp = pImage->getBmp();
     if (comp == TEXCOMPRESSION_B5G6R5 && pBmp->hasAlpha()) {
@@ -128,6 +172,21 @@ void GPUImage::setFilename(const std::string& sFilename, TexCompression comp)
     assertValid();
 }
 
+void GPUImage::setFilenameAsync(const std::string& sFilename, TexCompression comp,
+        IBitmapLoadedListener* pLoadedListener)
+{
+    if (ImageCache::get()->hasImage(sFilename, comp)) {
+        setFilename(sFilename, comp);
+    } else {
+        setEmpty();
+    }
+    m_sRequestedFilename = sFilename;
+    m_RequestedCompression = comp;
+    m_pLoadedListener = pLoadedListener;
+    m_pLoadRequest = LoadRequestPtr(new LoadRequest(this));
+    BitmapManager::get()->loadCachedImage(sFilename, comp, m_pLoadRequest);
+}
+
 void GPUImage::setBitmap(BitmapPtr pBmp, TexCompression comp)
 {
     assertValid();
@@ -138,17 +197,22 @@ void GPUImage::setBitmap(BitmapPtr pBmp, TexCompression comp)
         throw Exception(AVG_ERR_UNSUPPORTED, 
                 "B5G6R5-compressed textures with an alpha channel are not supported.");
     }
+    cancelAsyncLoad();
     unload();
     changeSource(BITMAP);
-    m_pBmp = BitmapPtr(new Bitmap(pBmp->getSize(), pBmp->getPixelFormat(), ""));
-    m_pBmp->copyPixels(*pBmp);
-    if (comp == TEXCOMPRESSION_B5G6R5) {
-        BitmapPtr pDestBmp = BitmapPtr(new Bitmap(pBmp->getSize(), B5G6R5, ""));
-        if (!BitmapLoader::get()->isBlueFirst()) {
-            FilterFlipRGB().applyInPlace(m_pBmp);
+    if (isBlockCompression(comp)) {
+        m_pBmp = compressBlocks(*pBmp, comp);
+    } else {
+        m_pBmp = BitmapPtr(new Bitmap(pBmp->getSize(), pBmp->getPixelFormat(), ""));
+        m_pBmp->copyPixels(*pBmp);
+        if (comp == TEXCOMPRESSION_B5G6R5) {
+            BitmapPtr pDestBmp = BitmapPtr(new Bitmap(pBmp->getSize(), B5G6R5, ""));
+            if (!BitmapLoader::get()->isBlueFirst()) {
+                FilterFlipRGB().applyInPlace(m_pBmp);
+            }
+            pDestBmp->copyPixels(*m_pBmp);
+            m_pBmp = pDestBmp;
         }
-        pDestBmp->copyPixels(*m_pBmp);
-        m_pBmp = pDestBmp;
     }
     if (m_State == GPU) {
         setupBitmapSurface();
@@ -162,6 +226,7 @@ void GPUImage::setCanvas(OffscreenCanvasPtr pCanvas)
     if (m_Source == SCENE && pCanvas == m_pCanvas) {
         return;
     }
+    cancelAsyncLoad();
     unload();
     changeSource(SCENE);
     m_pCanvas = pCanvas;
@@ -172,6 +237,21 @@ void GPUImage::setCanvas(OffscreenCanvasPtr pCanvas)
     assertValid();
 }
 
+bool GPUImage::setUseAtlas(bool bUseAtlas)
+{
+    if (bUseAtlas == m_bUseAtlas) {
+        return false;
+    }
+    m_bUseAtlas = bUseAtlas;
+    if (m_State == GPU && m_Source == FILE && m_bInAtlas != bUseAtlas) {
+        releaseImageTex();
+        m_pSurface->destroy();
+        setupImageSurface();
+        return true;
+    }
+    return false;
+}
+
 OffscreenCanvasPtr GPUImage::getCanvas() const
 {
     return m_pCanvas;
@@ -182,10 +262,26 @@ const string& GPUImage::getFilename() const
     return m_sFilename;
 }
 
+const string& GPUImage::getRequestedFilename() const
+{
+    if (m_pLoadRequest) {
+        return m_sRequestedFilename;
+    } else {
+        return m_sFilename;
+    }
+}
+
 BitmapPtr GPUImage::getBitmap()
 {
     if (m_Source == NONE || m_Source == SCENE) {
         return BitmapPtr();
+    } else if (pixelFormatIsBlockCompressed(m_pBmp->getPixelFormat())) {
+        // Callers expect pixels they can access.
+        if (BitmapLoader::get()->isBlueFirst()) {
+            return decompressBlocks(*m_pBmp, B8G8R8A8);
+        } else {
+            return decompressBlocks(*m_pBmp, R8G8B8A8);
+        }
     } else {
         return m_pBmp;
     }
@@ -231,23 +327,80 @@ GPUImage::State GPUImage::getState()
     return m_State;
 }
 
-GPUImage::Source GPUImage::getSource()
+GPUImage::Source GPUImage::getSource() const
 {
     return m_Source;
 }
 
+void GPUImage::onAsyncLoaded()
+{
+    IBitmapLoadedListener* pLoadedListener = m_pLoadedListener;
+    if (m_sFilename == m_sRequestedFilename) {
+        // The image was already cached.
+        cancelAsyncLoad();
+    } else {
+        // The image is in the ImageCache now (unless the cache is full of images in 
+        // use, in which case it is loaded again).
+        try {
+            setFilename(m_sRequestedFilename, m_RequestedCompression);
+        } catch (const Exception& ex) {
+            cancelAsyncLoad();
+            pLoadedListener->onBitmapLoadError(&ex);
+            return;
+        }
+    }
+    pLoadedListener->onBitmapLoaded(m_pBmp);
+}
+
+void GPUImage::onAsyncLoadError(const Exception* pEx)
+{
+    IBitmapLoadedListener* pLoadedListener = m_pLoadedListener;
+    cancelAsyncLoad();
+    pLoadedListener->onBitmapLoadError(pEx);
+}
+
+void GPUImage::cancelAsyncLoad()
+{
+    if (m_pLoadRequest) {
+        m_pLoadRequest->cancel();
+        m_pLoadRequest = LoadRequestPtr();
+        m_sRequestedFilename = "";
+        m_pLoadedListener = 0;
+    }
+}
+
 void GPUImage::setupImageSurface()
 {
+    if (m_bUseAtlas && !m_bUseMipmaps) {
+        MCTexturePtr pTex;
+        IntRect rect;
+        if (ImageAtlas::get()->incRef(m_pImage, pTex, rect)) {
+            m_bInAtlas = true;
+            m_pSurface->createSubTexture(ImageAtlas::get()->getPixelFormat(), pTex, rect);
+            return;
+        }
+    }
     PixelFormat pf = m_pImage->getBmp()->getPixelFormat();
     m_pImage->incTexRef(m_bUseMipmaps);
     MCTexturePtr pTex = m_pImage->getTex();
     m_pSurface->create(pf, pTex);
 }
 
+void GPUImage::releaseImageTex()
+{
+    if (m_bInAtlas) {
+        m_bInAtlas = false;
+        ImageAtlas::get()->decRef(m_pImage->getFilename());
+    } else {
+        m_pImage->decTexRef();
+    }
+}
+
 void GPUImage::setupBitmapSurface()
 {
     GLContextManager* pCM = GLContextManager::get();
-    MCTexturePtr pTex = pCM->createTextureFromBmp(m_pBmp, m_bUseMipmaps);
+    MCTexturePtr pTex = pCM->createTextureFromBmp(m_pBmp, m_bUseMipmaps, false, 0,
+            GLContextManager::UPLOAD_PREFETCH);
     m_pSurface->create(m_pBmp->getPixelFormat(), pTex);
 }
 
@@ -278,7 +431,7 @@ void GPUImage::unload()
 {
     if (m_pImage) {
         if (m_State == GPU) {
-            m_pImage->decTexRef();
+            releaseImageTex();
             m_pSurface->destroy();
         }
         m_pImage->decBmpRef();
@@ -35,12 +35,14 @@
 namespace avg {
 
 class OGLSurface;
+class Exception;
 class OffscreenCanvas;
 typedef boost::shared_ptr<OffscreenCanvas> OffscreenCanvasPtr;
 class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 class CachedImage;
 typedef boost::shared_ptr<CachedImage> CachedImagePtr;
+class IBitmapLoadedListener;
 
 class AVG_API GPUImage
 {
@@ -57,21 +59,39 @@ class AVG_API GPUImage
         void setEmpty();
         void setFilename(const std::string& sFilename,
                 TexCompression comp = TEXCOMPRESSION_NONE);
+        // Files that aren't in the ImageCache are loaded by the BitmapManager. The
+        // image is empty until loading is done. The listener is notified at the end of
+        // the frame the image is set in, even if it was cached.
+        void setFilenameAsync(const std::string& sFilename, TexCompression comp,
+                IBitmapLoadedListener* pLoadedListener);
         void setBitmap(BitmapPtr pBmp, 
                 TexCompression comp = TEXCOMPRESSION_NONE);
         void setCanvas(OffscreenCanvasPtr pCanvas);
+        // Lets small image files share a texture with other images (see ImageAtlas).
+        // Returns true if the surface was recreated.
+        bool setUseAtlas(bool bUseAtlas);
         OffscreenCanvasPtr getCanvas() const;
         const std::string& getFilename() const;
+        // Includes files that are still being loaded.
+        const std::string& getRequestedFilename() const;
 
         BitmapPtr getBitmap();
         IntPoint getSize();
         PixelFormat getPixelFormat();
         OGLSurface* getSurface();
         State getState();
-        Source getSource();
+        Source getSource() const;
 
     private:
+        class LoadRequest;
+        typedef boost::shared_ptr<LoadRequest> LoadRequestPtr;
+
+        void onAsyncLoaded();
+        void onAsyncLoadError(const Exception* pEx);
+        void cancelAsyncLoad();
+
         void setupImageSurface();
+        void releaseImageTex();
         void setupBitmapSurface();
         bool changeSource(Source newSource);
         void unload();
@@ -87,6 +107,13 @@ class AVG_API GPUImage
         State m_State;
         Source m_Source;
         bool m_bUseMipmaps;
+        bool m_bUseAtlas;
+        bool m_bInAtlas;
+
+        LoadRequestPtr m_pLoadRequest;
+        std::string m_sRequestedFilename;
+        TexCompression m_RequestedCompression;
+        IBitmapLoadedListener* m_pLoadedListener;
 };
 
 typedef boost::shared_ptr<GPUImage> GPUImagePtr;
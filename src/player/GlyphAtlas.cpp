@@ -0,0 +1,226 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "GlyphAtlas.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ObjectCounter.h"
+
+#include "../graphics/Bitmap.h"
+#include "../graphics/Filterfill.h"
+#include "../graphics/GLContextManager.h"
+#include "../graphics/MCTexture.h"
+
+#include <pango/pangoft2.h>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+
+// Width and height of the atlas texture.
+#define ATLAS_SIZE 1024
+
+namespace avg {
+
+GlyphAtlas* GlyphAtlas::s_pGlyphAtlas = 0;
+
+GlyphAtlas* GlyphAtlas::get()
+{
+    if (!s_pGlyphAtlas) {
+        s_pGlyphAtlas = new GlyphAtlas();
+    }
+    return s_pGlyphAtlas;
+}
+
+bool GlyphAtlas::exists()
+{
+    return s_pGlyphAtlas != 0;
+}
+
+GlyphAtlas::GlyphAtlas()
+    : m_DirtyStartLine(0),
+      m_DirtyEndLine(ATLAS_SIZE),
+      m_bClearPending(false),
+      m_Generation(0),
+      m_ShelfPos(0, 0),
+      m_ShelfHeight(0)
+{
+    m_pBmp = BitmapPtr(new Bitmap(IntPoint(ATLAS_SIZE, ATLAS_SIZE), A8, "GlyphAtlas"));
+    FilterFill<unsigned char>(0).applyInPlace(m_pBmp);
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    for (unsigned i = 0; i < m_pFonts.size(); ++i) {
+        g_object_unref(m_pFonts[i]);
+    }
+    s_pGlyphAtlas = 0;
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::getGlyph(PangoFont* pFont, PangoGlyph glyph)
+{
+    pair<PangoFont*, PangoGlyph> key(pFont, glyph);
+    GlyphMap::iterator it = m_Glyphs.find(key);
+    if (it != m_Glyphs.end()) {
+        return &(it->second);
+    }
+    Glyph glyphInfo;
+    if (!addGlyph(pFont, glyph, glyphInfo)) {
+        if (!m_Glyphs.empty() && !m_bClearPending) {
+            // The node falls back to bitmap rendering until the atlas is cleared.
+            AVG_TRACE(Logger::category::MEMORY, Logger::severity::INFO,
+                    "Glyph atlas full, clearing at start of next frame.");
+            m_bClearPending = true;
+        }
+        return 0;
+    }
+    if (find(m_pFonts.begin(), m_pFonts.end(), pFont) == m_pFonts.end()) {
+        g_object_ref(pFont);
+        m_pFonts.push_back(pFont);
+    }
+    return &(m_Glyphs[key] = glyphInfo);
+}
+
+int GlyphAtlas::getGeneration() const
+{
+    return m_Generation;
+}
+
+void GlyphAtlas::startFrame()
+{
+    if (m_bClearPending) {
+        clear();
+    }
+}
+
+MCTexturePtr GlyphAtlas::getTexture()
+{
+    GLContextManager* pCM = GLContextManager::get();
+    if (!m_pTex) {
+        m_pTex = pCM->createTexture(m_pBmp->getSize(), A8);
+        addDirtyLines(0, ATLAS_SIZE);
+    }
+    if (m_DirtyStartLine == 0 && m_DirtyEndLine == ATLAS_SIZE) {
+        pCM->scheduleTexUpload(m_pTex, m_pBmp);
+    } else if (m_DirtyStartLine < m_DirtyEndLine) {
+        pCM->scheduleTexLinesUpload(m_pTex, m_pBmp, m_DirtyStartLine, 
+                m_DirtyEndLine-m_DirtyStartLine);
+    }
+    m_DirtyStartLine = ATLAS_SIZE;
+    m_DirtyEndLine = 0;
+    return m_pTex;
+}
+
+int GlyphAtlas::getNumGlyphs() const
+{
+    return m_Glyphs.size();
+}
+
+void GlyphAtlas::clear()
+{
+    m_Glyphs.clear();
+    for (unsigned i = 0; i < m_pFonts.size(); ++i) {
+        g_object_unref(m_pFonts[i]);
+    }
+    m_pFonts.clear();
+    // Only the lines that contain glyphs need to be erased and uploaded.
+    int numUsedLines = min(m_ShelfPos.y+m_ShelfHeight, ATLAS_SIZE);
+    memset(m_pBmp->getPixels(), 0, numUsedLines*m_pBmp->getStride());
+    addDirtyLines(0, numUsedLines);
+    m_ShelfPos = IntPoint(0, 0);
+    m_ShelfHeight = 0;
+    m_bClearPending = false;
+    m_Generation++;
+}
+
+bool GlyphAtlas::addGlyph(PangoFont* pFont, PangoGlyph glyph, Glyph& glyphInfo)
+{
+    PangoRectangle inkRect;
+    pango_font_get_glyph_extents(pFont, glyph, &inkRect, 0);
+    if (inkRect.width == 0 || inkRect.height == 0) {
+        // Whitespace.
+        glyphInfo.m_Rect = IntRect(0, 0, 0, 0);
+        glyphInfo.m_TexRect = FRect(0, 0, 0, 0);
+        return true;
+    }
+    // Leave a pixel of room on all sides for antialiasing and hinting.
+    IntRect rect(PANGO_PIXELS_FLOOR(inkRect.x)-1, PANGO_PIXELS_FLOOR(inkRect.y)-1,
+            PANGO_PIXELS_CEIL(inkRect.x+inkRect.width)+1, 
+            PANGO_PIXELS_CEIL(inkRect.y+inkRect.height)+1);
+    IntPoint pos;
+    if (!allocRect(rect.size(), pos)) {
+        return false;
+    }
+
+    FT_Bitmap bitmap;
+    bitmap.rows = rect.height();
+    bitmap.width = rect.width();
+    bitmap.pitch = m_pBmp->getStride();
+    bitmap.buffer = m_pBmp->getPixels()+pos.y*m_pBmp->getStride()+pos.x;
+    bitmap.num_grays = 256;
+    bitmap.pixel_mode = ft_pixel_mode_grays;
+
+    PangoGlyphString* pGlyphString = pango_glyph_string_new();
+    pango_glyph_string_set_size(pGlyphString, 1);
+    PangoGlyphInfo& info = pGlyphString->glyphs[0];
+    info.glyph = glyph;
+    info.geometry.width = 0;
+    info.geometry.x_offset = 0;
+    info.geometry.y_offset = 0;
+    info.attr.is_cluster_start = 1;
+    pango_ft2_render(&bitmap, pFont, pGlyphString, -rect.tl.x, -rect.tl.y);
+    pango_glyph_string_free(pGlyphString);
+
+    glyphInfo.m_Rect = rect;
+    glm::vec2 texPos = glm::vec2(pos)/float(ATLAS_SIZE);
+    glyphInfo.m_TexRect = FRect(texPos, texPos+glm::vec2(rect.size())/float(ATLAS_SIZE));
+    addDirtyLines(pos.y, pos.y+rect.height());
+    return true;
+}
+
+bool GlyphAtlas::allocRect(const IntPoint& size, IntPoint& pos)
+{
+    // Glyphs are placed in rows (shelves) with a pixel of space between them.
+    if (m_ShelfPos.x+size.x > ATLAS_SIZE) {
+        m_ShelfPos = IntPoint(0, m_ShelfPos.y+m_ShelfHeight+1);
+        m_ShelfHeight = 0;
+    }
+    if (size.x > ATLAS_SIZE || m_ShelfPos.y+size.y > ATLAS_SIZE) {
+        return false;
+    }
+    pos = m_ShelfPos;
+    m_ShelfPos.x += size.x+1;
+    m_ShelfHeight = max(m_ShelfHeight, size.y);
+    return true;
+}
+
+void GlyphAtlas::addDirtyLines(int startLine, int endLine)
+{
+    m_DirtyStartLine = min(m_DirtyStartLine, startLine);
+    m_DirtyEndLine = max(m_DirtyEndLine, endLine);
+}
+
+}
@@ -0,0 +1,104 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _GlyphAtlas_H_
+#define _GlyphAtlas_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include <pango/pango.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+class MCTexture;
+typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+
+// A8 texture that holds rasterized glyphs for WordsNodes in glyph atlas mode. Glyphs
+// are identified by PangoFont and glyph index, so different sizes and hint settings
+// get different entries. When the atlas is full, it is cleared at the start of the
+// next frame and the generation is incremented; nodes that use the atlas need to look
+// up their glyphs again. Clearing mid-frame would invalidate the texture coordinates
+// of nodes that have already been prerendered.
+class AVG_API GlyphAtlas
+{
+public:
+    struct Glyph {
+        // Position of the bitmap relative to the glyph origin, in pixels.
+        IntRect m_Rect;
+        FRect m_TexRect;
+    };
+
+    static GlyphAtlas* get();
+    static bool exists();
+    virtual ~GlyphAtlas();
+
+    // Rasterizes the glyph if it isn't in the atlas yet. Returns 0 if the glyph is
+    // too large for the atlas or the atlas is full.
+    const Glyph* getGlyph(PangoFont* pFont, PangoGlyph glyph);
+    int getGeneration() const;
+    void startFrame();
+
+    // Schedules an upload of the lines that changed since the last call.
+    MCTexturePtr getTexture();
+
+    int getNumGlyphs() const;
+
+private:
+    GlyphAtlas();
+    void clear();
+    bool addGlyph(PangoFont* pFont, PangoGlyph glyph, Glyph& glyphInfo);
+    bool allocRect(const IntPoint& size, IntPoint& pos);
+    void addDirtyLines(int startLine, int endLine);
+
+    static GlyphAtlas* s_pGlyphAtlas;
+
+    typedef std::map<std::pair<PangoFont*, PangoGlyph>, Glyph> GlyphMap;
+    GlyphMap m_Glyphs;
+    // References to all fonts in m_Glyphs so the pointers stay unique.
+    std::vector<PangoFont*> m_pFonts;
+
+    BitmapPtr m_pBmp;
+    MCTexturePtr m_pTex;
+    // Lines that need to be uploaded. Empty if m_DirtyStartLine >= m_DirtyEndLine.
+    int m_DirtyStartLine;
+    int m_DirtyEndLine;
+    bool m_bClearPending;
+    int m_Generation;
+
+    // Shelf packing state.
+    IntPoint m_ShelfPos;
+    int m_ShelfHeight;
+};
+
+}
+
+#endif
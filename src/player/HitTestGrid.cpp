@@ -0,0 +1,184 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "HitTestGrid.h"
+
+#include "Node.h"
+
+#include "../base/Exception.h"
+
+#include <algorithm>
+#include <functional>
+#include <math.h>
+
+using namespace std;
+
+// Upper bound for the number of cells along one axis.
+#define MAX_CELLS 128
+
+namespace avg {
+
+HitTestGrid::HitTestGrid()
+    : m_bValid(false),
+      m_NumUpdatesOutside(0)
+{
+}
+
+HitTestGrid::~HitTestGrid()
+{
+}
+
+void HitTestGrid::rebuild(const vector<NodePtr>& children)
+{
+    int numChildren = children.size();
+    vector<FRect> bounds(numChildren);
+    vector<bool> bBounded(numChildren);
+    int numBounded = 0;
+    for (int i = 0; i < numChildren; ++i) {
+        bBounded[i] = children[i]->getHitTestBounds(bounds[i]);
+        if (bBounded[i]) {
+            if (numBounded == 0) {
+                m_Bounds = bounds[i];
+            } else {
+                m_Bounds.expand(bounds[i]);
+            }
+            numBounded++;
+        }
+    }
+    if (numBounded == 0) {
+        m_Bounds = FRect(0, 0, 0, 0);
+    }
+
+    // About one bounded child per cell.
+    int numCellsPerAxis = int(ceil(sqrt(float(numBounded))));
+    numCellsPerAxis = max(1, min(numCellsPerAxis, MAX_CELLS));
+    m_NumCells = IntPoint(numCellsPerAxis, numCellsPerAxis);
+    m_CellSize = glm::vec2(max(m_Bounds.width()/m_NumCells.x, 1.f),
+            max(m_Bounds.height()/m_NumCells.y, 1.f));
+    m_Cells.clear();
+    m_Cells.resize(m_NumCells.x*m_NumCells.y);
+    m_UnboundedChildren.clear();
+    m_ChildInfos.resize(numChildren);
+    m_ChildIndexes.clear();
+    for (int i = 0; i < numChildren; ++i) {
+        m_ChildIndexes[children[i].get()] = i;
+        addChild(i, children[i].get());
+    }
+    m_NumUpdatesOutside = 0;
+    m_bValid = true;
+}
+
+void HitTestGrid::invalidate()
+{
+    m_bValid = false;
+    m_Cells.clear();
+    m_UnboundedChildren.clear();
+    m_ChildInfos.clear();
+    m_ChildIndexes.clear();
+}
+
+bool HitTestGrid::isValid() const
+{
+    return m_bValid;
+}
+
+void HitTestGrid::updateChild(const Node* pChild)
+{
+    AVG_ASSERT(m_bValid);
+    map<const Node*, int>::iterator it = m_ChildIndexes.find(pChild);
+    if (it == m_ChildIndexes.end()) {
+        // Child is being inserted.
+        invalidate();
+        return;
+    }
+    int i = it->second;
+    removeChild(i);
+    addChild(i, pChild);
+    FRect bounds;
+    if (pChild->getHitTestBounds(bounds) && 
+            (bounds.tl.x < m_Bounds.tl.x || bounds.tl.y < m_Bounds.tl.y ||
+             bounds.br.x > m_Bounds.br.x || bounds.br.y > m_Bounds.br.y))
+    {
+        // Children outside of the grid all end up in the border cells. Rebuild if
+        // that happens too often.
+        m_NumUpdatesOutside++;
+        if (m_NumUpdatesOutside > int(m_ChildInfos.size()/4)+4) {
+            invalidate();
+        }
+    }
+}
+
+void HitTestGrid::getCandidates(const glm::vec2& pos, vector<int>& candidates) const
+{
+    AVG_ASSERT(m_bValid);
+    IntPoint cell = getCell(pos);
+    const vector<int>& cellChildren = m_Cells[cell.y*m_NumCells.x+cell.x];
+    candidates.assign(cellChildren.begin(), cellChildren.end());
+    candidates.insert(candidates.end(), m_UnboundedChildren.begin(), 
+            m_UnboundedChildren.end());
+    sort(candidates.begin(), candidates.end(), greater<int>());
+}
+
+IntPoint HitTestGrid::getCell(const glm::vec2& pos) const
+{
+    // Clamping keeps children and points outside of the grid in the border cells.
+    glm::vec2 cellPos = (pos-m_Bounds.tl)/m_CellSize;
+    IntPoint cell(int(floor(cellPos.x)), int(floor(cellPos.y)));
+    cell.x = max(0, min(cell.x, m_NumCells.x-1));
+    cell.y = max(0, min(cell.y, m_NumCells.y-1));
+    return cell;
+}
+
+void HitTestGrid::addChild(int i, const Node* pChild)
+{
+    ChildInfo& info = m_ChildInfos[i];
+    FRect bounds;
+    info.m_bBounded = pChild->getHitTestBounds(bounds);
+    if (info.m_bBounded) {
+        info.m_Cells = IntRect(getCell(bounds.tl), getCell(bounds.br)+IntPoint(1,1));
+        for (int y = info.m_Cells.tl.y; y < info.m_Cells.br.y; ++y) {
+            for (int x = info.m_Cells.tl.x; x < info.m_Cells.br.x; ++x) {
+                m_Cells[y*m_NumCells.x+x].push_back(i);
+            }
+        }
+    } else {
+        m_UnboundedChildren.push_back(i);
+    }
+}
+
+void HitTestGrid::removeChild(int i)
+{
+    ChildInfo& info = m_ChildInfos[i];
+    if (info.m_bBounded) {
+        for (int y = info.m_Cells.tl.y; y < info.m_Cells.br.y; ++y) {
+            for (int x = info.m_Cells.tl.x; x < info.m_Cells.br.x; ++x) {
+                vector<int>& cell = m_Cells[y*m_NumCells.x+x];
+                cell.erase(find(cell.begin(), cell.end(), i));
+            }
+        }
+    } else {
+        m_UnboundedChildren.erase(find(m_UnboundedChildren.begin(), 
+                m_UnboundedChildren.end(), i));
+    }
+}
+
+}
@@ -0,0 +1,83 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _HitTestGrid_H_
+#define _HitTestGrid_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+#include <map>
+
+namespace avg {
+
+class Node;
+typedef boost::shared_ptr<Node> NodePtr;
+
+// Uniform grid over the hit test bounds of a DivNode's children. Finds the children
+// that can contain a point without asking every child. Children that can't report
+// bounds (vector nodes, divs without a size) are candidates for every point.
+class AVG_API HitTestGrid
+{
+public:
+    HitTestGrid();
+    virtual ~HitTestGrid();
+
+    void rebuild(const std::vector<NodePtr>& children);
+    void invalidate();
+    bool isValid() const;
+
+    // Moves the child to the cells that correspond to its current bounds.
+    void updateChild(const Node* pChild);
+
+    // Returns the indexes of the children that might contain pos, topmost first.
+    void getCandidates(const glm::vec2& pos, std::vector<int>& candidates) const;
+
+private:
+    struct ChildInfo {
+        bool m_bBounded;
+        IntRect m_Cells;
+    };
+
+    IntPoint getCell(const glm::vec2& pos) const;
+    void addChild(int i, const Node* pChild);
+    void removeChild(int i);
+
+    bool m_bValid;
+    FRect m_Bounds;
+    IntPoint m_NumCells;
+    glm::vec2 m_CellSize;
+    std::vector<std::vector<int> > m_Cells;
+    std::vector<int> m_UnboundedChildren;
+    std::vector<ChildInfo> m_ChildInfos;
+    std::map<const Node*, int> m_ChildIndexes;
+    int m_NumUpdatesOutside;
+};
+
+}
+
+#endif
@@ -39,6 +39,8 @@ public:
     virtual void onBitmapLoadError(const Exception* e) = 0;
 };
 
+typedef boost::shared_ptr<IBitmapLoadedListener> IBitmapLoadedListenerPtr;
+
 }
 
 #endif
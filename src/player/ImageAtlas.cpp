@@ -0,0 +1,258 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "ImageAtlas.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ObjectCounter.h"
+
+#include "../graphics/Bitmap.h"
+#include "../graphics/BitmapLoader.h"
+#include "../graphics/CachedImage.h"
+#include "../graphics/GLContextManager.h"
+#include "../graphics/MCTexture.h"
+#include "../graphics/Pixel32.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+
+// Width and height of the atlas textures.
+#define ATLAS_SIZE 1024
+// Larger images get textures of their own.
+#define MAX_IMAGE_SIZE 128
+#define MAX_PAGES 8
+
+namespace avg {
+
+ImageAtlas* ImageAtlas::s_pImageAtlas = 0;
+
+ImageAtlas* ImageAtlas::get()
+{
+    if (!s_pImageAtlas) {
+        s_pImageAtlas = new ImageAtlas();
+    }
+    return s_pImageAtlas;
+}
+
+bool ImageAtlas::exists()
+{
+    return s_pImageAtlas != 0;
+}
+
+ImageAtlas::ImageAtlas()
+{
+    if (BitmapLoader::get()->isBlueFirst()) {
+        m_PF = B8G8R8A8;
+    } else {
+        m_PF = R8G8B8A8;
+    }
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+ImageAtlas::~ImageAtlas()
+{
+    s_pImageAtlas = 0;
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+bool ImageAtlas::incRef(CachedImagePtr pImage, MCTexturePtr& pTex, IntRect& rect)
+{
+    if (pImage->getCompression() != TEXCOMPRESSION_NONE) {
+        return false;
+    }
+    BitmapPtr pBmp = pImage->getBmp();
+    if (!canAdd(pBmp)) {
+        return false;
+    }
+    string sFilename = pImage->getFilename();
+    ImageMap::iterator it = m_Images.find(sFilename);
+    if (it == m_Images.end()) {
+        Image image;
+        if (!addImage(pBmp, image)) {
+            return false;
+        }
+        it = m_Images.insert(make_pair(sFilename, image)).first;
+    }
+    Image& image = it->second;
+    image.m_RefCount++;
+    pTex = m_Pages[image.m_PageIndex].m_pTex;
+    rect = image.m_Rect;
+    return true;
+}
+
+void ImageAtlas::decRef(const string& sFilename)
+{
+    ImageMap::iterator it = m_Images.find(sFilename);
+    AVG_ASSERT(it != m_Images.end());
+    AVG_ASSERT(it->second.m_RefCount >= 1);
+    it->second.m_RefCount--;
+}
+
+PixelFormat ImageAtlas::getPixelFormat() const
+{
+    return m_PF;
+}
+
+int ImageAtlas::getNumImages() const
+{
+    return m_Images.size();
+}
+
+int ImageAtlas::getNumPages() const
+{
+    return m_Pages.size();
+}
+
+bool ImageAtlas::canAdd(const BitmapPtr& pBmp) const
+{
+    IntPoint size = pBmp->getSize();
+    if (size.x <= 0 || size.y <= 0 || size.x > MAX_IMAGE_SIZE || 
+            size.y > MAX_IMAGE_SIZE)
+    {
+        return false;
+    }
+    PixelFormat pf = pBmp->getPixelFormat();
+    if (m_PF == B8G8R8A8) {
+        return pf == B8G8R8A8 || pf == B8G8R8X8;
+    } else {
+        return pf == R8G8B8A8 || pf == R8G8B8X8;
+    }
+}
+
+bool ImageAtlas::addImage(const BitmapPtr& pBmp, Image& image)
+{
+    // One pixel of border on each side.
+    IntPoint size = pBmp->getSize()+IntPoint(2,2);
+    IntPoint pos;
+    unsigned pageIndex = 0;
+    while (pageIndex < m_Pages.size() && !allocRect(m_Pages[pageIndex], size, pos)) {
+        pageIndex++;
+    }
+    if (pageIndex == m_Pages.size()) {
+        // All pages are full: Reuse one that isn't displayed or add a new one.
+        pageIndex = 0;
+        while (pageIndex < m_Pages.size() && isPageInUse(pageIndex)) {
+            pageIndex++;
+        }
+        if (pageIndex < m_Pages.size()) {
+            clearPage(pageIndex);
+        } else if (m_Pages.size() < MAX_PAGES) {
+            addPage();
+        } else {
+            AVG_TRACE(Logger::category::MEMORY, Logger::severity::INFO,
+                    "Image atlas full, images get textures of their own.");
+            return false;
+        }
+        bool bOk = allocRect(m_Pages[pageIndex], size, pos);
+        AVG_ASSERT(bOk);
+    }
+    Page& page = m_Pages[pageIndex];
+    copyImage(pBmp, page, pos);
+    GLContextManager::get()->scheduleTexLinesUpload(page.m_pTex, page.m_pBmp, pos.y, 
+            size.y);
+    image.m_PageIndex = pageIndex;
+    image.m_Rect = IntRect(pos+IntPoint(1,1), pos+size-IntPoint(1,1));
+    image.m_RefCount = 0;
+    return true;
+}
+
+bool ImageAtlas::allocRect(Page& page, const IntPoint& size, IntPoint& pos)
+{
+    if (page.m_ShelfPos.x+size.x > ATLAS_SIZE) {
+        page.m_ShelfPos = IntPoint(0, page.m_ShelfPos.y+page.m_ShelfHeight);
+        page.m_ShelfHeight = 0;
+    }
+    if (page.m_ShelfPos.y+size.y > ATLAS_SIZE) {
+        return false;
+    }
+    pos = page.m_ShelfPos;
+    page.m_ShelfPos.x += size.x;
+    page.m_ShelfHeight = max(page.m_ShelfHeight, size.y);
+    return true;
+}
+
+bool ImageAtlas::isPageInUse(unsigned pageIndex) const
+{
+    for (ImageMap::const_iterator it = m_Images.begin(); it != m_Images.end(); ++it) {
+        if (it->second.m_PageIndex == pageIndex && it->second.m_RefCount > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ImageAtlas::clearPage(unsigned pageIndex)
+{
+    ImageMap::iterator it = m_Images.begin();
+    while (it != m_Images.end()) {
+        if (it->second.m_PageIndex == pageIndex) {
+            m_Images.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    // Stale pixels are never sampled, so they don't need to be erased.
+    m_Pages[pageIndex].m_ShelfPos = IntPoint(0, 0);
+    m_Pages[pageIndex].m_ShelfHeight = 0;
+}
+
+void ImageAtlas::addPage()
+{
+    AVG_TRACE(Logger::category::MEMORY, Logger::severity::INFO,
+            "Adding image atlas page " << m_Pages.size());
+    Page page;
+    IntPoint size(ATLAS_SIZE, ATLAS_SIZE);
+    page.m_pBmp = BitmapPtr(new Bitmap(size, m_PF, "ImageAtlas"));
+    memset(page.m_pBmp->getPixels(), 0, size.y*page.m_pBmp->getStride());
+    GLContextManager* pCM = GLContextManager::get();
+    page.m_pTex = pCM->createTexture(size, m_PF);
+    pCM->scheduleTexUpload(page.m_pTex, page.m_pBmp);
+    page.m_ShelfPos = IntPoint(0, 0);
+    page.m_ShelfHeight = 0;
+    m_Pages.push_back(page);
+}
+
+void ImageAtlas::copyImage(const BitmapPtr& pBmp, Page& page, const IntPoint& pos)
+{
+    // pos is the top left corner of the border.
+    IntPoint size = pBmp->getSize();
+    bool bSetAlpha = !pixelFormatHasAlpha(pBmp->getPixelFormat());
+    for (int y = -1; y <= size.y; ++y) {
+        int srcY = min(max(y, 0), size.y-1);
+        const Pixel32* pSrc = (const Pixel32*)(pBmp->getPixels()+
+                srcY*pBmp->getStride());
+        Pixel32* pDest = (Pixel32*)(page.m_pBmp->getPixels()+
+                (pos.y+1+y)*page.m_pBmp->getStride())+pos.x+1;
+        for (int x = -1; x <= size.x; ++x) {
+            Pixel32 pixel = pSrc[min(max(x, 0), size.x-1)];
+            if (bSetAlpha) {
+                pixel.setA(255);
+            }
+            pDest[x] = pixel;
+        }
+    }
+}
+
+}
@@ -0,0 +1,105 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _ImageAtlas_H_
+#define _ImageAtlas_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include "../graphics/PixelFormat.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+class MCTexture;
+typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+class CachedImage;
+typedef boost::shared_ptr<CachedImage> CachedImagePtr;
+
+// RGBA textures (pages) that hold small image files for ImageNodes, so nodes that show
+// different images can share a texture and a draw call. Each image has a border of 
+// repeated edge pixels, so filtering looks the same as with a texture of its own.
+// Images stay in the atlas when they become unused. A page is only cleared when it is
+// needed for new images and none of its images are in use, so the position of an image
+// never changes while a node displays it.
+class AVG_API ImageAtlas
+{
+public:
+    static ImageAtlas* get();
+    static bool exists();
+    virtual ~ImageAtlas();
+
+    // Adds the image to the atlas if it isn't there yet. Returns false if the image 
+    // is too large, has an unsupported format or if all pages are full of images in
+    // use.
+    bool incRef(CachedImagePtr pImage, MCTexturePtr& pTex, IntRect& rect);
+    void decRef(const std::string& sFilename);
+    // Pixel format of the atlas textures.
+    PixelFormat getPixelFormat() const;
+
+    int getNumImages() const;
+    int getNumPages() const;
+
+private:
+    struct Page {
+        BitmapPtr m_pBmp;
+        MCTexturePtr m_pTex;
+        // Shelf packing state.
+        IntPoint m_ShelfPos;
+        int m_ShelfHeight;
+    };
+    struct Image {
+        unsigned m_PageIndex;
+        IntRect m_Rect;
+        int m_RefCount;
+    };
+
+    ImageAtlas();
+    bool canAdd(const BitmapPtr& pBmp) const;
+    bool addImage(const BitmapPtr& pBmp, Image& image);
+    bool allocRect(Page& page, const IntPoint& size, IntPoint& pos);
+    bool isPageInUse(unsigned pageIndex) const;
+    void clearPage(unsigned pageIndex);
+    void addPage();
+    void copyImage(const BitmapPtr& pBmp, Page& page, const IntPoint& pos);
+
+    static ImageAtlas* s_pImageAtlas;
+
+    typedef std::map<std::string, Image> ImageMap;
+    ImageMap m_Images;
+    std::vector<Page> m_Pages;
+    PixelFormat m_PF;
+};
+
+}
+
+#endif
@@ -52,12 +52,15 @@ void ImageNode::registerType()
     TypeDefinition def = TypeDefinition("image", "rasternode", 
             ExportedObject::buildObject<ImageNode>)
         .addArg(Arg<UTF8String>("href", "", false, offsetof(ImageNode, m_href)))
-        .addArg(Arg<string>("compression", "none"));
+        .addArg(Arg<string>("compression", "none"))
+        .addArg(Arg<bool>("asyncload", false, false, offsetof(ImageNode, m_bAsyncLoad)));
     TypeRegistry::get()->registerType(def);
 }
 
 ImageNode::ImageNode(const ArgList& args)
-    : m_Compression(TEXCOMPRESSION_NONE)
+    : m_Compression(TEXCOMPRESSION_NONE),
+      m_bAsyncLoad(false),
+      m_CanvasNumRenders(-1)
 {
     args.setMembers(this);
     m_pGPUImage = GPUImagePtr(new GPUImage(getSurface(), getMipmap()));
@@ -80,6 +83,7 @@ void ImageNode::connectDisplay()
     if (m_pGPUImage->getSource() == GPUImage::SCENE) {
         checkCanvasValid(m_pGPUImage->getCanvas());
     }
+    m_pGPUImage->setUseAtlas(!hasEffect());
     m_pGPUImage->moveToGPU();
     RasterNode::connectDisplay();
     if (m_pGPUImage->getSource() == GPUImage::SCENE) {
@@ -130,8 +134,10 @@ void ImageNode::setHRef(const UTF8String& href)
     } catch (const Exception&) {
         m_href = "";
         m_pGPUImage->setEmpty();
+        invalidateRender();
         throw;
     }
+    invalidateRender();
 }
 
 const string ImageNode::getCompression() const
@@ -139,6 +145,16 @@ const string ImageNode::getCompression() const
     return texCompression2String(m_Compression);
 }
 
+bool ImageNode::getAsyncLoad() const
+{
+    return m_bAsyncLoad;
+}
+
+void ImageNode::setAsyncLoad(bool bAsyncLoad)
+{
+    m_bAsyncLoad = bAsyncLoad;
+}
+
 void ImageNode::setBitmap(BitmapPtr pBmp)
 {
     if (m_pGPUImage->getSource() == GPUImage::SCENE && getState() == Node::NS_CANRENDER) {
@@ -159,12 +175,25 @@ void ImageNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
 {
     ScopeTimer timer(PrerenderProfilingZone);
     AreaNode::preRender(pVA, bIsParentActive, parentEffectiveOpacity);
+    // Effects render the whole texture, so images with effects can't be in the atlas.
+    if (m_pGPUImage->setUseAtlas(!hasEffect())) {
+        newSurface();
+    }
     if (isVisible() && m_pGPUImage->getSource() != GPUImage::NONE) {
-        if (m_pGPUImage->getCanvas()) {
-            // Force FX render every frame for canvas nodes.
-            getSurface()->setDirty();
+        if (!getSurface()->isResident()) {
+            // Deferred upload in progress: Upload before textures that aren't visible.
+            getSurface()->promoteTexUploads();
+        } else {
+            OffscreenCanvasPtr pCanvas = m_pGPUImage->getCanvas();
+            if (pCanvas && pCanvas->getNumRenders() != m_CanvasNumRenders) {
+                // The canvas displayed has been redrawn: Redo FX and redraw this 
+                // node's canvas.
+                m_CanvasNumRenders = pCanvas->getNumRenders();
+                getSurface()->setDirty();
+                invalidateRender();
+            }
+            scheduleFXRender();
         }
-        scheduleFXRender();
     }
     calcVertexArray(pVA);
 }
@@ -174,7 +203,7 @@ static ProfilingZoneID RenderProfilingZone("ImageNode::render");
 void ImageNode::render(GLContext* pContext, const glm::mat4& transform)
 {
     ScopeTimer Timer(RenderProfilingZone);
-    if (m_pGPUImage->getSource() != GPUImage::NONE) {
+    if (m_pGPUImage->getSource() != GPUImage::NONE && getSurface()->isResident()) {
         blt32(pContext, transform);
     }
 }
@@ -204,7 +233,12 @@ void ImageNode::checkReload()
         }
         newSurface();
     } else {
-        bool bNewImage = Node::checkReload(m_href, m_pGPUImage, m_Compression);
+        IBitmapLoadedListener* pAsyncListener = 0;
+        if (m_bAsyncLoad) {
+            pAsyncListener = this;
+        }
+        bool bNewImage = Node::checkReload(m_href, m_pGPUImage, m_Compression,
+                pAsyncListener);
         if (bNewImage) {
             newSurface();
         }
@@ -213,6 +247,19 @@ void ImageNode::checkReload()
     RasterNode::checkReload();
 }
 
+void ImageNode::onBitmapLoaded(BitmapPtr pBmp)
+{
+    newSurface();
+    setViewport(-32767, -32767, -32767, -32767);
+    notifySubscribers("IMAGE_LOADED");
+}
+
+void ImageNode::onBitmapLoadError(const Exception* pEx)
+{
+    logFileNotFoundWarning(pEx->getStr());
+    notifySubscribers("IMAGE_LOAD_ERROR", pEx->getStr());
+}
+
 void ImageNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements)
 {
     if (reactsToMouseEvents()) {
@@ -244,6 +291,12 @@ BitmapPtr ImageNode::getBitmap()
     return m_pGPUImage->getBitmap();
 }
 
+bool ImageNode::isBatchable() const
+{
+    // Nodes that show the same file share the texture.
+    return m_pGPUImage->getSource() == GPUImage::FILE && !hasEffect();
+}
+
 bool ImageNode::isCanvasURL(const std::string& sURL)
 {
     return sURL.find("canvas:") == 0;
@@ -25,6 +25,7 @@
 #include "../api.h"
 #include "RasterNode.h"
 #include "GPUImage.h"
+#include "IBitmapLoadedListener.h"
 #include "../graphics/TexInfo.h"
 
 #include "../base/UTF8String.h"
@@ -36,7 +37,7 @@ namespace avg {
 class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 
-class AVG_API ImageNode : public RasterNode
+class AVG_API ImageNode : public RasterNode, IBitmapLoadedListener
 {
     public:
         static void registerType();
@@ -51,7 +52,12 @@ class AVG_API ImageNode : public RasterNode
         const UTF8String& getHRef() const;
         void setHRef(const UTF8String& href);
         const std::string getCompression() const;
+        bool getAsyncLoad() const;
+        void setAsyncLoad(bool bAsyncLoad);
         void setBitmap(BitmapPtr pBmp);
+
+        virtual void onBitmapLoaded(BitmapPtr pBmp);
+        virtual void onBitmapLoadError(const Exception* pEx);
         
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
@@ -64,13 +70,18 @@ class AVG_API ImageNode : public RasterNode
         virtual IntPoint getMediaSize();
         GPUImage::Source getSource() const;
 
+    protected:
+        virtual bool isBatchable() const;
+
     private:
         bool isCanvasURL(const std::string& sURL);
         void checkCanvasValid(const CanvasPtr& pCanvas);
 
         UTF8String m_href;
         TexCompression m_Compression;
+        bool m_bAsyncLoad;
         GPUImagePtr m_pGPUImage;
+        int m_CanvasNumRenders;
 };
 
 typedef boost::shared_ptr<ImageNode> ImageNodePtr;
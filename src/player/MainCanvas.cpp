@@ -33,6 +33,8 @@
 #include "../graphics/GLContext.h"
 #include "../graphics/GLTexture.h"
 #include "../graphics/GLContextManager.h"
+#include "../graphics/ReadbackRing.h"
+#include "../graphics/Filterflip.h"
 #ifdef __linux__
   #ifndef AVG_ENABLE_EGL
   #include <X11/Xlib.h>
@@ -79,6 +81,29 @@ BitmapPtr MainCanvas::screenshot() const
     return m_pDisplayEngine->screenshot();
 }
 
+ReadbackRingPtr MainCanvas::createReadbackRing() const
+{
+    // Multiple windows need to be stitched together, so they use the synchronous path.
+    if (!m_pDisplayEngine || m_pDisplayEngine->getNumWindows() != 1 ||
+            m_pDisplayEngine->getWindow(0)->getGLContext()->getMemoryMode() != MM_PBO)
+    {
+        return ReadbackRingPtr();
+    }
+    return ReadbackRingPtr(new ReadbackRing(m_pDisplayEngine->getWindow(0)->getSize(),
+            B8G8R8X8, ReadbackRing::getDefaultNumBuffers()));
+}
+
+void MainCanvas::startReadback(ReadbackRing& ring) const
+{
+    m_pDisplayEngine->getWindow(0)->startReadback(ring);
+}
+
+BitmapPtr MainCanvas::finishReadback(BitmapPtr pBmp) const
+{
+    FilterFlip().applyInPlace(pBmp);
+    return pBmp;
+}
+
 static ProfilingZoneID RootRenderProfilingZone("Render MainCanvas");
 static ProfilingZoneID SecondWindowRenderProfilingZone(
         "Render second window");
@@ -44,6 +44,11 @@ class AVG_API MainCanvas: public Canvas
        
         virtual BitmapPtr screenshot() const;
 
+    protected:
+        virtual ReadbackRingPtr createReadbackRing() const;
+        virtual void startReadback(ReadbackRing& ring) const;
+        virtual BitmapPtr finishReadback(BitmapPtr pBmp) const;
+
     private:
         void renderTree();
         void pollEvents();
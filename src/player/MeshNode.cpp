@@ -138,6 +138,7 @@ bool MeshNode::getBackfaceCull() const
 void MeshNode::setBackfaceCull(const bool bBackfaceCull)
 {
     m_bBackfaceCull = bBackfaceCull;
+    invalidateRender();
 }
 
 void MeshNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements)
@@ -189,4 +190,14 @@ void MeshNode::render(GLContext* pContext, const glm::mat4& transform)
     }
 }
 
+void MeshNode::maybeRenderBatched(ShapeBatch& batch, const glm::mat4& parentTransform)
+{
+    if (m_bBackfaceCull) {
+        // Culling is GL state that the batch doesn't track.
+        Node::maybeRenderBatched(batch, parentTransform);
+    } else {
+        VectorNode::maybeRenderBatched(batch, parentTransform);
+    }
+}
+
 }
@@ -60,6 +60,8 @@ class AVG_API MeshNode : public VectorNode
         virtual void calcVertexes(const VertexDataPtr& pVertexData, Pixel32 color);
         
         virtual void render(GLContext* pContext, const glm::mat4& transform);
+        virtual void maybeRenderBatched(ShapeBatch& batch, 
+                const glm::mat4& parentTransform);
 
     private:
         std::vector<glm::vec2> m_TexCoords;
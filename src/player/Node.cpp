@@ -30,6 +30,7 @@
 #include "CursorEvent.h"
 #include "PublisherDefinition.h"
 #include "GPUImage.h"
+#include "ShapeBatch.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
@@ -69,6 +70,8 @@ void Node::registerType()
     pPubDef->addMessage("PEN_OUT");
     pPubDef->addMessage("END_OF_FILE");
     pPubDef->addMessage("SIZE_CHANGED");
+    pPubDef->addMessage("IMAGE_LOADED");
+    pPubDef->addMessage("IMAGE_LOAD_ERROR");
     pPubDef->addMessage("KILLED");
 
     TypeDefinition def = TypeDefinition("node")
@@ -366,15 +369,48 @@ NodePtr Node::getElementByPos(const glm::vec2& pos)
     }
 }
 
+bool Node::getHitTestBounds(FRect& bounds) const
+{
+    return false;
+}
+
+void Node::invalidateHitTestBounds()
+{
+    if (m_pParent) {
+        m_pParent->onChildHitTestBoundsChange(this);
+    }
+}
+
+void Node::invalidateRender()
+{
+    CanvasPtr pCanvas = m_pCanvas.lock();
+    if (pCanvas) {
+        pCanvas->setDirty();
+    }
+}
+
 void Node::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements)
 {
 }
 
+void Node::maybeRenderBatched(ShapeBatch& batch, const glm::mat4& parentTransform)
+{
+    batch.flush();
+    maybeRender(batch.getContext(), parentTransform);
+}
+
 void Node::preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
         float parentEffectiveOpacity)
 {
-    m_EffectiveOpacity = m_Opacity*parentEffectiveOpacity;
-    m_bEffectiveActive = bIsParentActive && m_bActive;
+    float effectiveOpacity = m_Opacity*parentEffectiveOpacity;
+    bool bEffectiveActive = bIsParentActive && m_bActive;
+    if (effectiveOpacity != m_EffectiveOpacity || 
+            bEffectiveActive != m_bEffectiveActive)
+    {
+        invalidateRender();
+    }
+    m_EffectiveOpacity = effectiveOpacity;
+    m_bEffectiveActive = bEffectiveActive;
 }
 
 Node::NodeState Node::getState() const
@@ -470,9 +506,9 @@ void Node::initFilename(string& sFilename)
 }
 
 bool Node::checkReload(const std::string& sHRef, const GPUImagePtr& pGPUImage,
-        TexCompression comp)
+        TexCompression comp, IBitmapLoadedListener* pAsyncListener)
 {
-    string sLastFilename = pGPUImage->getFilename();
+    string sLastFilename = pGPUImage->getRequestedFilename();
     string sFilename = sHRef;
     initFilename(sFilename);
     if (sLastFilename != sFilename) {
@@ -480,6 +516,8 @@ bool Node::checkReload(const std::string& sHRef, const GPUImagePtr& pGPUImage,
             sFilename = convertUTF8ToFilename(sFilename);
             if (sHRef == "") {
                 pGPUImage->setEmpty();
+            } else if (pAsyncListener) {
+                pGPUImage->setFilenameAsync(sFilename, comp, pAsyncListener);
             } else {
                 pGPUImage->setFilename(sFilename, comp);
             }
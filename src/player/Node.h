@@ -31,6 +31,7 @@
 #include "../graphics/TexInfo.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
@@ -64,6 +65,8 @@ class GPUImage;
 typedef boost::shared_ptr<GPUImage> GPUImagePtr;
 typedef boost::weak_ptr<Canvas> CanvasWeakPtr;
 class GLContext;
+class ShapeBatch;
+class IBitmapLoadedListener;
 
 class AVG_API Node: public Publisher
 {
@@ -115,11 +118,18 @@ class AVG_API Node: public Publisher
         NodePtr getElementByPos(const glm::vec2& pos);
         virtual void getElementsByPos(const glm::vec2& pos, 
                 std::vector<NodePtr>& pElements);
+        // Bounding box of the area that reacts to the mouse, in parent coordinates.
+        // Returns false if the node doesn't have simple bounds.
+        virtual bool getHitTestBounds(FRect& bounds) const;
 
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
         virtual void maybeRender(GLContext* pContext, const glm::mat4& parentTransform)
                 {};
+        // Called by DivNode. Nodes that can share draw calls with their siblings add 
+        // their shapes to the batch, all others flush it and render normally.
+        virtual void maybeRenderBatched(ShapeBatch& batch, 
+                const glm::mat4& parentTransform);
         virtual void render(GLContext* pContext, const glm::mat4& transform) {};
         virtual void renderOutlines(const VertexArrayPtr& pVA, Pixel32 color) {};
 
@@ -140,11 +150,18 @@ class AVG_API Node: public Publisher
             
         void setState(NodeState state);
         void initFilename(std::string& sFilename);
+        // If pAsyncListener is set, files are loaded in the background.
         bool checkReload(const std::string& sHRef, const GPUImagePtr& pGPUImage,
-                TexCompression comp=TEXCOMPRESSION_NONE);
+                TexCompression comp=TEXCOMPRESSION_NONE,
+                IBitmapLoadedListener* pAsyncListener=0);
         virtual bool isVisible() const;
         bool getEffectiveActive() const;
         NodePtr getSharedThis();
+        // Needs to be called whenever the result of getHitTestBounds() changes.
+        void invalidateHitTestBounds();
+        // Needs to be called whenever something the node renders changes, so the 
+        // canvas gets redrawn.
+        void invalidateRender();
 
         void logFileNotFoundWarning(const std::string& sWarn) const;
 
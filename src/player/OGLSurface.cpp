@@ -28,6 +28,7 @@
 #include "../base/ObjectCounter.h"
 
 #include "../graphics/GLContext.h"
+#include "../graphics/GLContextManager.h"
 #include "../graphics/MCTexture.h"
 #include "../graphics/GLTexture.h"
 #include "../graphics/StandardShader.h"
@@ -49,6 +50,7 @@ namespace avg {
 
 OGLSurface::OGLSurface(const WrapMode& wrapMode)
     : m_Size(-1,-1),
+      m_TexPos(0,0),
       m_WrapMode(wrapMode),
       m_Gamma(1,1,1,1),
       m_Brightness(1,1,1),
@@ -68,6 +70,7 @@ void OGLSurface::create(PixelFormat pf, MCTexturePtr pTex0, MCTexturePtr pTex1,
 {
     m_pf = pf;
     m_Size = pTex0->getSize();
+    m_TexPos = IntPoint(0,0);
     m_pMCTextures[0] = pTex0;
     m_pMCTextures[1] = pTex1;
     m_pMCTextures[2] = pTex2;
@@ -88,6 +91,14 @@ void OGLSurface::create(PixelFormat pf, MCTexturePtr pTex0, MCTexturePtr pTex1,
     }
 }
 
+void OGLSurface::createSubTexture(PixelFormat pf, MCTexturePtr pTex, const IntRect& rect)
+{
+    AVG_ASSERT(!pixelFormatIsPlanar(pf));
+    create(pf, pTex);
+    m_Size = rect.size();
+    m_TexPos = rect.tl;
+}
+
 void OGLSurface::setMask(MCTexturePtr pTex)
 {
     m_pMaskMCTexture = pTex;
@@ -152,7 +163,7 @@ void OGLSurface::activate(GLContext* pContext, const IntPoint& logicalSize) cons
         //   need to a) undo this and b) adjust for pot mask textures. In the npot case,
         //   everything evaluates to (1,1);
         glm::vec2 texSize = m_pMCTextures[0]->getGLSize();
-        glm::vec2 imgSize = m_pMCTextures[0]->getSize();
+        glm::vec2 imgSize = m_Size;
         glm::vec2 imgScale = glm::vec2(texSize.x/imgSize.x, texSize.y/imgSize.y);
         maskPos = maskPos/imgScale;
         maskSize = maskSize/imgScale;
@@ -163,6 +174,8 @@ void OGLSurface::activate(GLContext* pContext, const IntPoint& logicalSize) cons
                 maskTexSize.y/maskImgSize.y);
         maskPos = maskPos*maskScale;
         maskSize = maskSize*maskScale;
+        // Sub-textures start at m_TexPos.
+        maskPos += glm::vec2(m_TexPos)/texSize;
 
         pShader->setMask(true, maskPos, maskSize);
     } else {
@@ -194,6 +207,11 @@ IntPoint OGLSurface::getTextureSize()
     return m_pMCTextures[0]->getGLSize();
 }
 
+IntPoint OGLSurface::getTexturePos()
+{
+    return m_TexPos;
+}
+
 bool OGLSurface::isCreated() const
 {
     return (m_pMCTextures[0] != MCTexturePtr());
@@ -204,6 +222,52 @@ bool OGLSurface::isPremultipliedAlpha() const
     return m_bPremultipliedAlpha;
 }
 
+bool OGLSurface::hasSameState(const OGLSurface& other) const
+{
+    for (int i = 0; i < 4; ++i) {
+        if (m_pMCTextures[i] != other.m_pMCTextures[i]) {
+            return false;
+        }
+    }
+    if (m_pMaskMCTexture != other.m_pMaskMCTexture) {
+        return false;
+    }
+    if (m_pMaskMCTexture && (m_MaskPos != other.m_MaskPos || 
+            m_MaskSize != other.m_MaskSize || m_TexPos != other.m_TexPos))
+    {
+        return false;
+    }
+    return m_pf == other.m_pf && m_bPremultipliedAlpha == other.m_bPremultipliedAlpha &&
+            m_WrapMode.getS() == other.m_WrapMode.getS() &&
+            m_WrapMode.getT() == other.m_WrapMode.getT() &&
+            m_Gamma == other.m_Gamma && m_bColorIsModified == other.m_bColorIsModified &&
+            m_Brightness == other.m_Brightness && m_Contrast == other.m_Contrast;
+}
+
+bool OGLSurface::isResident() const
+{
+    if (!isCreated()) {
+        return true;
+    }
+    for (unsigned i=0; i<getNumPixelFormatPlanes(m_pf); ++i) {
+        if (!m_pMCTextures[i]->isResident()) {
+            return false;
+        }
+    }
+    return !m_pMaskMCTexture || m_pMaskMCTexture->isResident();
+}
+
+void OGLSurface::promoteTexUploads()
+{
+    if (!isCreated()) {
+        return;
+    }
+    GLContextManager* pCM = GLContextManager::get();
+    for (unsigned i=0; i<getNumPixelFormatPlanes(m_pf); ++i) {
+        pCM->promoteTexUpload(m_pMCTextures[i]);
+    }
+}
+
 void OGLSurface::setColorParams(const glm::vec3& gamma, const glm::vec3& brightness,
             const glm::vec3& contrast)
 {
@@ -25,6 +25,7 @@
 #include "../api.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 #include "../graphics/PixelFormat.h"
 #include "../graphics/WrapMode.h"
 
@@ -44,6 +45,8 @@ public:
     virtual void create(PixelFormat pf, MCTexturePtr pTex0, 
             MCTexturePtr pTex1 = MCTexturePtr(), MCTexturePtr pTex2 = MCTexturePtr(), 
             MCTexturePtr pTex3 = MCTexturePtr(), bool bPremultipliedAlpha = false);
+    // Uses the part of pTex given by rect, e.g. an image in the ImageAtlas.
+    void createSubTexture(PixelFormat pf, MCTexturePtr pTex, const IntRect& rect);
     void setMask(MCTexturePtr pTex);
     virtual void destroy();
     void activate(GLContext* pContext, const IntPoint& logicalSize = IntPoint(1,1)) const;
@@ -53,8 +56,17 @@ public:
     PixelFormat getPixelFormat();
     IntPoint getSize();
     IntPoint getTextureSize();
+    // Position of the image in the texture. (0,0) unless this is a sub-texture.
+    IntPoint getTexturePos();
     bool isCreated() const;
     bool isPremultipliedAlpha() const;
+    // True if activate() would set up the same textures and shader state for both
+    // surfaces.
+    bool hasSameState(const OGLSurface& other) const;
+    // False while texture uploads are still pending. Surfaces that aren't resident 
+    // shouldn't be rendered.
+    bool isResident() const;
+    void promoteTexUploads();
 
     void setColorParams(const glm::vec3& gamma, const glm::vec3& brightness,
             const glm::vec3& contrast);
@@ -69,6 +81,7 @@ private:
 
     MCTexturePtr m_pMCTextures[4];
     IntPoint m_Size;
+    IntPoint m_TexPos;
     PixelFormat m_pf;
     MCTexturePtr m_pMaskMCTexture;
     glm::vec2 m_MaskPos;
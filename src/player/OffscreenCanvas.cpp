@@ -38,6 +38,7 @@
 #include "../graphics/MCTexture.h"
 #include "../graphics/MCFBO.h"
 #include "../graphics/FBO.h"
+#include "../graphics/ReadbackRing.h"
 
 #include <iostream>
 
@@ -49,6 +50,7 @@ namespace avg {
 OffscreenCanvas::OffscreenCanvas(Player * pPlayer)
     : Canvas(pPlayer),
       m_bIsRendered(false),
+      m_NumRenders(0),
       m_pCameraNodeRef(0)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -120,6 +122,30 @@ BitmapPtr OffscreenCanvas::screenshotIgnoreAlpha() const
     return pBmp;
 }
 
+ReadbackRingPtr OffscreenCanvas::createReadbackRing() const
+{
+    if (!isRunning()) {
+        return ReadbackRingPtr();
+    }
+    return m_pFBO->getCurFBO(GLContext::getCurrent())->createReadbackRing(
+            ReadbackRing::getDefaultNumBuffers());
+}
+
+void OffscreenCanvas::startReadback(ReadbackRing& ring) const
+{
+    if (!isRunning() || !m_bIsRendered) {
+        throw(Exception(AVG_ERR_UNSUPPORTED,
+                "OffscreenCanvas::requestScreenshot(): Canvas has not been rendered. No screenshot available"));
+    }
+    m_pFBO->startReadback(GLContext::getCurrent(), ring);
+}
+
+BitmapPtr OffscreenCanvas::finishReadback(BitmapPtr pBmp) const
+{
+    FilterUnmultiplyAlpha().applyInPlace(pBmp);
+    return pBmp;
+}
+
 bool OffscreenCanvas::getHandleEvents() const
 {
     return dynamic_pointer_cast<OffscreenCanvasNode>(getRootNode())->getHandleEvents();
@@ -142,6 +168,7 @@ void OffscreenCanvas::setAutoRender(bool bAutoRender)
 
 void OffscreenCanvas::manualRender()
 {
+    setDirty();
     emitPreRenderSignal(); 
     renderTree(); 
     emitFrameEndSignal(); 
@@ -231,6 +258,11 @@ unsigned OffscreenCanvas::getNumDependentCanvases() const
     return m_pDependentCanvases.size();
 }
 
+int OffscreenCanvas::getNumRenders() const
+{
+    return m_NumRenders;
+}
+
 bool OffscreenCanvas::isSupported()
 {
     if (!Player::get()->isPlaying()) {
@@ -271,6 +303,10 @@ void OffscreenCanvas::renderTree()
                 "OffscreenCanvas::renderTree(): Player.play() needs to be called before rendering offscreen canvases."));
     }
     preRender();
+    if (!isDirty() && m_bIsRendered) {
+        // Nothing changed, so the FBO still contains the current image.
+        return;
+    }
     DisplayEngine* pDisplayEngine = getPlayer()->getDisplayEngine();
     unsigned numWindows = pDisplayEngine->getNumWindows();
     for (unsigned i=0; i<numWindows; ++i) {
@@ -284,6 +320,8 @@ void OffscreenCanvas::renderTree()
     }
     GLContextManager::get()->reset();
     m_bIsRendered = true;
+    m_NumRenders++;
+    resetDirty();
 }
 
 }
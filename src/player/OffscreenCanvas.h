@@ -70,6 +70,9 @@ class AVG_API OffscreenCanvas: public Canvas
         void removeDependentCanvas(CanvasPtr pCanvas);
         const std::vector<CanvasPtr>& getDependentCanvases() const;
         unsigned getNumDependentCanvases() const;
+        // Number of times the canvas has actually been redrawn. Renders are skipped
+        // if nothing in the canvas has changed.
+        int getNumRenders() const;
 
         static bool isSupported();
         static bool isMultisampleSupported();
@@ -77,6 +80,9 @@ class AVG_API OffscreenCanvas: public Canvas
  
     protected:
         virtual void renderTree();
+        virtual ReadbackRingPtr createReadbackRing() const;
+        virtual void startReadback(ReadbackRing& ring) const;
+        virtual BitmapPtr finishReadback(BitmapPtr pBmp) const;
 
     private:
         MCFBOPtr m_pFBO;
@@ -84,6 +90,7 @@ class AVG_API OffscreenCanvas: public Canvas
         std::vector<CanvasPtr> m_pDependentCanvases;
 
         bool m_bIsRendered;
+        int m_NumRenders;
         CameraNode* m_pCameraNodeRef;
 };
 
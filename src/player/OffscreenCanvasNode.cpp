@@ -79,6 +79,8 @@ bool OffscreenCanvasNode::getAutoRender() const
 void OffscreenCanvasNode::setAutoRender(bool bAutoRender)
 {
     m_bAutoRender = bAutoRender;
+    // Changes made while autorendering was off haven't been tracked.
+    invalidateRender();
 }
 
 }
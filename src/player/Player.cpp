@@ -41,6 +41,8 @@
 #include "PluginManager.h"
 #include "TextEngine.h"
 #include "TestHelper.h"
+#include "GlyphAtlas.h"
+#include "ImageAtlas.h"
 #include "MainCanvas.h"
 #include "OffscreenCanvas.h"
 #include "OffscreenCanvasNode.h"
@@ -55,6 +57,7 @@
 #include "KeyEvent.h"
 #include "MouseEvent.h"
 #include "EventDispatcher.h"
+#include "EventReplayDevice.h"
 #include "PublisherDefinition.h"
 #include "BitmapManager.h"
 #include "Timeout.h"
@@ -70,6 +73,7 @@
 #include "../base/ConfigMgr.h"
 #include "../base/XMLHelper.h"
 #include "../base/ScopeTimer.h"
+#include "../base/TimeSource.h"
 #include "../base/WorkerThread.h"
 #include "../base/DAG.h"
 
@@ -126,7 +130,10 @@ Player::Player()
       m_pLastMouseEvent(new MouseEvent(Event::CURSOR_MOTION, false, false, false, 
             IntPoint(-1, -1), MouseEvent::NO_BUTTON, glm::vec2(-1, -1), 0)),
       m_EventHookPyFunc(Py_None),
-      m_bMouseEnabled(true)
+      m_bMouseEnabled(true),
+      m_bMotionCoalescingEnabled(false),
+      m_TraceFrameThreshold(0),
+      m_LastTraceWriteTime(0)
 {
     string sDummy;
 #ifdef _WIN32
@@ -645,6 +652,36 @@ long long Player::getFrameTime()
     return m_FrameTime;
 }
 
+void Player::enableFrameTimeHistory(bool bEnable)
+{
+    ThreadProfiler::get()->enableFrameTimeHistory(bEnable);
+}
+
+ThreadProfiler::FrameTimeMap Player::getZoneFrameTimes() const
+{
+    return ThreadProfiler::get()->getFrameTimes();
+}
+
+void Player::enableTracing(bool bEnable, int ringSize)
+{
+    if (ringSize <= 0) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "enableTracing: ringSize must be positive.");
+    }
+    ThreadProfiler::enableTracing(bEnable, ringSize);
+}
+
+void Player::writeTrace(const string& sFilename)
+{
+    ThreadProfiler::writeTrace(sFilename);
+}
+
+void Player::setTraceFrameThreshold(float threshold, const string& sFilename)
+{
+    m_TraceFrameThreshold = threshold;
+    m_sTraceFilename = sFilename;
+}
+
 float Player::getFrameDuration()
 {
     if (!m_bIsPlaying) {
@@ -682,6 +719,42 @@ void Player::enableMouse(bool enabled)
     }
 }
 
+void Player::enableMotionCoalescing(bool enabled)
+{
+    m_bMotionCoalescingEnabled = enabled;
+    
+    if (m_pEventDispatcher) {
+        m_pEventDispatcher->enableMotionCoalescing(enabled);
+    }
+}
+
+void Player::startEventRecording(const string& sFilename)
+{
+    if (!m_pEventDispatcher) {
+        throw Exception(AVG_ERR_UNSUPPORTED,
+                "You must use loadFile() before startEventRecording().");
+    }
+    m_pEventDispatcher->startRecording(sFilename);
+}
+
+void Player::stopEventRecording()
+{
+    if (m_pEventDispatcher) {
+        m_pEventDispatcher->stopRecording();
+    }
+}
+
+void Player::startEventReplay(const string& sFilename)
+{
+    m_pEventReplayDevice = EventReplayDevicePtr(new EventReplayDevice(sFilename));
+    addInputDevice(m_pEventReplayDevice);
+}
+
+bool Player::isReplayingEvents() const
+{
+    return m_pEventReplayDevice && !m_pEventReplayDevice->isFinished();
+}
+
 void Player::setEventCapture(NodePtr pNode, int cursorID=MOUSECURSORID)
 {
     std::map<int, EventCaptureInfoPtr>::iterator it =
@@ -995,10 +1068,12 @@ static ProfilingZoneID OffscreenProfilingZone("Offscreen rendering");
 
 void Player::doFrame(bool bFirstFrame)
 {
+    long long frameStartTime = TimeSource::get()->getCurrentMicrosecs();
     {
         ScopeTimer Timer(MainProfilingZone);
         if (!bFirstFrame) {
             m_NumFrames++;
+            ThreadProfiler::get()->addFrameMarker(m_NumFrames);
             if (m_bFakeFPS) {
                 m_FrameTime = (long long)((m_NumFrames*1000.0)/m_FakeFPS);
             } else {
@@ -1015,6 +1090,10 @@ void Player::doFrame(bool bFirstFrame)
                 removeDeadEventCaptures();
             }
         }
+        GLContextManager::get()->startFrame();
+        if (GlyphAtlas::exists()) {
+            GlyphAtlas::get()->startFrame();
+        }
         for (unsigned i = 0; i < m_pCanvases.size(); ++i) {
             ScopeTimer Timer(OffscreenProfilingZone);
             dispatchOffscreenRendering(m_pCanvases[i].get());
@@ -1038,6 +1117,21 @@ void Player::doFrame(bool bFirstFrame)
         }
     }
     ThreadProfiler::get()->reset();
+    if (m_TraceFrameThreshold > 0 && ThreadProfiler::isTracingEnabled()) {
+        float frameDuration = 
+                (TimeSource::get()->getCurrentMicrosecs()-frameStartTime)/1000.f;
+        // Writing happens in a separate thread, at most once per second.
+        long long curTime = TimeSource::get()->getCurrentMillisecs();
+        if (frameDuration > m_TraceFrameThreshold && 
+                curTime-m_LastTraceWriteTime >= 1000 &&
+                ThreadProfiler::writeTraceAsync(m_sTraceFilename))
+        {
+            m_LastTraceWriteTime = curTime;
+            AVG_TRACE(Logger::category::PROFILE, Logger::severity::WARNING,
+                    "Frame " << m_NumFrames << " took " << frameDuration 
+                    << " ms. Writing trace to '" << m_sTraceFilename << "'.");
+        }
+    }
     if (m_NumFrames == 5) {
         ThreadProfiler::get()->restart();
     }
@@ -1202,6 +1296,7 @@ void Player::initAudio()
 void Player::initMainCanvas(NodePtr pRootNode)
 {
     m_pEventDispatcher = EventDispatcherPtr(new EventDispatcher(this, m_bMouseEnabled));
+    m_pEventDispatcher->enableMotionCoalescing(m_bMotionCoalescingEnabled);
     m_pMainCanvas = MainCanvasPtr(new MainCanvas(this));
     m_pMainCanvas->setRoot(pRootNode);
     if (m_DP.getNumWindows() == 1) {
@@ -1666,6 +1761,9 @@ void Player::cleanup(bool bIsAbort)
     m_pLastCursorStates.clear();
     m_pTestHelper->reset();
     ThreadProfiler::get()->dumpStatistics();
+    ThreadProfiler::waitForTraceWriter();
+    TextEngine::dumpLayoutCacheStatistics();
+    GLContextManager::get()->dumpTexUploadStatistics();
     for (unsigned i = 0; i < m_pCanvases.size(); ++i) {
         m_pCanvases[i]->stopPlayback(bIsAbort);
     }
@@ -1680,6 +1778,7 @@ void Player::cleanup(bool bIsAbort)
     if (m_pMultitouchInputDevice) {
         m_pMultitouchInputDevice = InputDevicePtr();
     }
+    m_pEventReplayDevice = EventReplayDevicePtr();
 
     if (m_pDisplayEngine) {
         m_DP.getWindowParams(0).m_Size = IntPoint(0, 0);
@@ -1693,6 +1792,12 @@ void Player::cleanup(bool bIsAbort)
     if (ImageCache::exists()) {
         ImageCache::get()->unloadAllTextures();
     }
+    if (GlyphAtlas::exists()) {
+        delete GlyphAtlas::get();
+    }
+    if (ImageAtlas::exists()) {
+        delete ImageAtlas::get();
+    }
     if (AudioEngine::get()) {
         AudioEngine::get()->teardown();
     }
@@ -29,6 +29,7 @@
 #include "Event.h"
 
 #include "../audio/AudioParams.h"
+#include "../base/ThreadProfiler.h"
 #include "../graphics/GLConfig.h"
 
 #include <libxml/parser.h>
@@ -63,6 +64,7 @@ class InputDevice;
 class Bitmap;
 class AVGNode;
 class ImageCache;
+class EventReplayDevice;
 
 typedef boost::shared_ptr<Node> NodePtr;
 typedef boost::weak_ptr<Node> NodeWeakPtr;
@@ -78,6 +80,7 @@ typedef boost::shared_ptr<Display> DisplayPtr;
 typedef boost::shared_ptr<GLContextManager> GLContextManagerPtr;
 typedef boost::shared_ptr<CursorState> CursorStatePtr;
 typedef boost::shared_ptr<TestHelper> TestHelperPtr;
+typedef boost::shared_ptr<EventReplayDevice> EventReplayDevicePtr;
 typedef boost::shared_ptr<InputDevice> InputDevicePtr;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 typedef boost::shared_ptr<AVGNode> AVGNodePtr;
@@ -136,6 +139,11 @@ class AVG_API Player: public Publisher
         void setFakeFPS(float fps);
         long long getFrameTime();
         float getFrameDuration();
+        void enableFrameTimeHistory(bool bEnable);
+        ThreadProfiler::FrameTimeMap getZoneFrameTimes() const;
+        void enableTracing(bool bEnable, int ringSize);
+        void writeTrace(const std::string& sFilename);
+        void setTraceFrameThreshold(float threshold, const std::string& sFilename);
 
         NodePtr createNode(const std::string& sType, const py::dict& PyDict,
                 const py::object& self=py::object());
@@ -152,6 +160,11 @@ class AVG_API Player: public Publisher
         EventPtr getCurrentEvent() const;
         BitmapPtr getTouchUserBmp() const;
         void enableMouse(bool enabled);
+        void enableMotionCoalescing(bool enabled);
+        void startEventRecording(const std::string& sFilename);
+        void stopEventRecording();
+        void startEventReplay(const std::string& sFilename);
+        bool isReplayingEvents() const;
         void setEventCapture(NodePtr pNode, int cursorID);
         void releaseEventCapture(int cursorID);
         bool isCaptured(int cursorID);
@@ -246,6 +259,7 @@ class AVG_API Player: public Publisher
         bool m_bStopping;
 
         InputDevicePtr m_pMultitouchInputDevice;
+        EventReplayDevicePtr m_pEventReplayDevice;
 
         // Timeout handling
         int internalSetTimeout(int time, PyObject * pyfunc, bool bIsInterval);
@@ -303,6 +317,11 @@ class AVG_API Player: public Publisher
 
         PyObject * m_EventHookPyFunc;
         bool m_bMouseEnabled;
+        bool m_bMotionCoalescingEnabled;
+
+        float m_TraceFrameThreshold;
+        std::string m_sTraceFilename;
+        long long m_LastTraceWriteTime;
 };
 
 }
@@ -26,6 +26,7 @@
 #include "OGLSurface.h"
 #include "FXNode.h"
 #include "Canvas.h"
+#include "ShapeBatch.h"
 
 #include "../graphics/ImagingProjection.h"
 #include "../graphics/ShaderRegistry.h"
@@ -78,8 +79,12 @@ RasterNode::RasterNode()
       m_bMipmap(false),
       m_Color(0,0,0,0),
       m_TileSize(-1,-1),
+      m_bHasStdVertices(true),
+      m_bBatched(false),
       m_pSubVA(0),
-      m_bFXDirty(true)
+      m_bVertexArrayDirty(true),
+      m_bFXDirty(true),
+      m_bSurfaceResident(false)
 {
 }
 
@@ -202,9 +207,11 @@ void RasterNode::setWarpedVertexCoords(const VertexGrid& grid)
     }
     if (m_bHasStdVertices) {
         m_bHasStdVertices = false;
-        m_pSubVA = new SubVertexArray();
+        m_pSubVA = &m_SubVA;
     }
     m_TileVertices = grid;
+    m_bVertexArrayDirty = true;
+    invalidateRender();
 }
 
 void RasterNode::setMirror(MirrorType mirrorType)
@@ -255,6 +262,7 @@ void RasterNode::setBlendModeStr(const string& sBlendMode)
     }
     m_sBlendMode = sBlendMode;
     m_BlendMode = blendMode;
+    invalidateRender();
 }
 
 const UTF8String& RasterNode::getMaskHRef() const
@@ -266,6 +274,7 @@ void RasterNode::setMaskHRef(const UTF8String& sHref)
 {
     m_sMaskHref = sHref;
     checkReload();
+    invalidateRender();
 }
 
 void RasterNode::setMaskBitmap(BitmapPtr pBmp)
@@ -283,6 +292,7 @@ void RasterNode::setMaskBitmap(BitmapPtr pBmp)
     if (getState() == Node::NS_CANRENDER && m_pMaskBmp) {
         downloadMask();
     }
+    invalidateRender();
 }
 
 const glm::vec2& RasterNode::getMaskPos() const
@@ -294,6 +304,7 @@ void RasterNode::setMaskPos(const glm::vec2& pos)
 {
     m_MaskPos = pos;
     setMaskCoords();
+    invalidateRender();
 }
 
 const glm::vec2& RasterNode::getMaskSize() const
@@ -305,6 +316,7 @@ void RasterNode::setMaskSize(const glm::vec2& size)
 {
     m_MaskSize = size;
     setMaskCoords();
+    invalidateRender();
 }
 
 void RasterNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements)
@@ -326,6 +338,7 @@ void RasterNode::setGamma(const glm::vec3& gamma)
     if (getState() == Node::NS_CANRENDER) {
         m_pSurface->setColorParams(m_Gamma, m_Intensity, m_Contrast);
     }
+    invalidateRender();
 }
 
 glm::vec3 RasterNode::getIntensity() const
@@ -339,6 +352,7 @@ void RasterNode::setIntensity(const glm::vec3& intensity)
     if (getState() == Node::NS_CANRENDER) {
         m_pSurface->setColorParams(m_Gamma, m_Intensity, m_Contrast);
     }
+    invalidateRender();
 }
 
 glm::vec3 RasterNode::getContrast() const
@@ -352,6 +366,7 @@ void RasterNode::setContrast(const glm::vec3& contrast)
     if (getState() == Node::NS_CANRENDER) {
         m_pSurface->setColorParams(m_Gamma, m_Intensity, m_Contrast);
     }
+    invalidateRender();
 }
 
 void RasterNode::setEffect(FXNodePtr pFXNode)
@@ -366,6 +381,7 @@ void RasterNode::setEffect(FXNodePtr pFXNode)
     if (getState() == NS_CANRENDER) {
         setupFX();
     }
+    invalidateRender();
 }
 
 static ProfilingZoneID FXProfilingZone("RasterNode::renderFX");
@@ -426,17 +442,50 @@ void RasterNode::scheduleFXRender()
 
 void RasterNode::calcVertexArray(const VertexArrayPtr& pVA)
 {
-    if (m_pSurface->isCreated() && !m_bHasStdVertices && isVisible()) {
+    if (isVisible()) {
+        // Texture uploads finishing and effect parameter changes need a redraw.
+        bool bResident = m_pSurface->isResident();
+        if (bResident != m_bSurfaceResident || (m_pFXNode && m_pFXNode->isDirty())) {
+            m_bSurfaceResident = bResident;
+            invalidateRender();
+        }
+    }
+    if (!m_pSurface->isCreated() || !isVisible()) {
+        return;
+    }
+    bool bBatched = isBatchable();
+    if (bBatched != m_bBatched) {
+        m_bBatched = bBatched;
+        m_bHasStdVertices = false;
+        m_pSubVA = &m_SubVA;
+        m_bVertexArrayDirty = true;
+    }
+    if (m_bBatched) {
+        // The vertices are in parent coordinates, so siblings with the same texture 
+        // can be drawn together.
+        glm::vec2 size = getSize();
+        glm::mat4 vertexTransform = glm::scale(getLocalTransform(), 
+                glm::vec3(size.x, size.y, 1));
+        if (vertexTransform != m_VertexTransform) {
+            m_VertexTransform = vertexTransform;
+            m_bVertexArrayDirty = true;
+        }
+    }
+    if (!m_bHasStdVertices) {
+        if (!m_bVertexArrayDirty && pVA->reuseSubVA(*m_pSubVA)) {
+            return;
+        }
+        m_bVertexArrayDirty = false;
         pVA->startSubVA(*m_pSubVA);
         for (unsigned y = 0; y < m_TileVertices.size()-1; y++) {
             for (unsigned x = 0; x < m_TileVertices[0].size()-1; x++) {
                 int curVertex = m_pSubVA->getNumVerts();
-                m_pSubVA->appendPos(m_TileVertices[y][x], m_TexCoords[y][x], m_Color);
-                m_pSubVA->appendPos(m_TileVertices[y][x+1], m_TexCoords[y][x+1],
+                m_pSubVA->appendPos(calcVertexPos(x, y), m_TexCoords[y][x], m_Color);
+                m_pSubVA->appendPos(calcVertexPos(x+1, y), m_TexCoords[y][x+1],
                         m_Color);
-                m_pSubVA->appendPos(m_TileVertices[y+1][x+1], m_TexCoords[y+1][x+1],
+                m_pSubVA->appendPos(calcVertexPos(x+1, y+1), m_TexCoords[y+1][x+1],
                         m_Color);
-                m_pSubVA->appendPos(m_TileVertices[y+1][x], m_TexCoords[y+1][x],
+                m_pSubVA->appendPos(calcVertexPos(x, y+1), m_TexCoords[y+1][x],
                         m_Color);
                 m_pSubVA->appendQuadIndexes(
                         curVertex+1, curVertex, curVertex+2, curVertex+3);
@@ -490,6 +539,39 @@ void RasterNode::blt(GLContext* pContext, const glm::mat4& transform,
     m_pSubVA->draw();
 }
 
+void RasterNode::maybeRenderBatched(ShapeBatch& batch, const glm::mat4& parentTransform)
+{
+    if (m_bBatched) {
+        AVG_ASSERT(getState() == NS_CANRENDER);
+        if (isVisible() && m_pSurface->isCreated() && m_pSurface->isResident()) {
+            batch.draw(this, parentTransform, getEffectiveOpacity(), m_BlendMode);
+        }
+    } else {
+        AreaNode::maybeRenderBatched(batch, parentTransform);
+    }
+}
+
+bool RasterNode::canBatchWith(const RasterNode& prevNode) const
+{
+    return m_pSubVA->directlyFollows(*prevNode.m_pSubVA) &&
+            m_pSurface->hasSameState(*prevNode.m_pSurface);
+}
+
+void RasterNode::bltBatched(GLContext* pContext, const glm::mat4& transform,
+        const RasterNode& lastNode)
+{
+    AVG_ASSERT(m_bBatched);
+    StandardShader* pShader = pContext->getStandardShader();
+    float opacity = getEffectiveOpacity();
+    pContext->setBlendColor(glm::vec4(1.0f, 1.0f, 1.0f, opacity));
+    pShader->setAlpha(opacity);
+    m_pSurface->activate(pContext, getMediaSize());
+    pContext->setBlendMode(m_BlendMode, m_pSurface->isPremultipliedAlpha());
+    pShader->setTransform(transform);
+    pShader->activate();
+    m_pSubVA->draw(*lastNode.m_pSubVA);
+}
+
 GLContext::BlendMode RasterNode::getBlendMode() const
 {
     return m_BlendMode;
@@ -505,6 +587,11 @@ bool RasterNode::hasMask() const
     return m_pMaskBmp != BitmapPtr();
 }
 
+bool RasterNode::hasEffect() const
+{
+    return m_pFXNode != FXNodePtr();
+}
+
 const BitmapPtr RasterNode::getMaskBmp() const
 {
     return m_pMaskBmp;
@@ -539,7 +626,11 @@ void RasterNode::downloadMask()
         
 void RasterNode::setRenderColor(const Pixel32& color)
 {
-    m_Color = color;
+    if (color != m_Color) {
+        m_Color = color;
+        m_bVertexArrayDirty = true;
+        invalidateRender();
+    }
 }
 
 void RasterNode::checkDisplayAvailable(std::string sMsg)
@@ -557,18 +648,23 @@ void RasterNode::checkDisplayAvailable(std::string sMsg)
 void RasterNode::newSurface()
 {
     if (m_pSurface->isCreated()) {
+        m_bBatched = isBatchable();
+        // The standard vertices cover the whole texture.
         m_bHasStdVertices = !(m_pSurface->getPixelFormat() == A8) &&
-                !GLContext::getCurrent()->usePOTTextures();
+                !GLContext::getCurrent()->usePOTTextures() && !m_bBatched &&
+                m_pSurface->getTexturePos() == IntPoint(0,0);
         if (m_bHasStdVertices) {
             m_pSubVA = &(getCanvas()->getStdSubVA());
         } else {
-            m_pSubVA = new SubVertexArray();
+            m_pSubVA = &m_SubVA;
         }
 
         calcVertexGrid(m_TileVertices);
         calcTexCoords();
+        m_bVertexArrayDirty = true;
         setupFX();
     }
+    invalidateRender();
 }
 
 void RasterNode::setupFX()
@@ -626,12 +722,27 @@ void RasterNode::calcTileVertex(int x, int y, glm::vec2& Vertex)
     }
 }
 
+glm::vec2 RasterNode::calcVertexPos(int x, int y) const
+{
+    const glm::vec2& pt = m_TileVertices[y][x];
+    if (m_bBatched) {
+        glm::vec4 pos = m_VertexTransform*glm::vec4(pt.x, pt.y, 0, 1);
+        return glm::vec2(pos.x, pos.y);
+    } else {
+        return pt;
+    }
+}
+
 void RasterNode::calcTexCoords()
 {
     glm::vec2 textureSize = glm::vec2(m_pSurface->getTextureSize());
     glm::vec2 imageSize = glm::vec2(m_pSurface->getSize());
     glm::vec2 texCoordExtents = glm::vec2(imageSize.x/textureSize.x,
             imageSize.y/textureSize.y);
+    // Images in an atlas start somewhere inside the texture.
+    glm::vec2 texCoordOffset = glm::vec2(m_pSurface->getTexturePos());
+    texCoordOffset = glm::vec2(texCoordOffset.x/textureSize.x, 
+            texCoordOffset.y/textureSize.y);
 
     glm::vec2 texSizePerTile;
     if (m_TileSize.x == -1) {
@@ -657,6 +768,7 @@ void RasterNode::calcTexCoords()
             } else {
                 m_TexCoords[y][x].x = texSizePerTile.x*x;
             }
+            m_TexCoords[y][x] += texCoordOffset;
         }
     }
 }
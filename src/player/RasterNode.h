@@ -30,12 +30,12 @@
 #include "../base/UTF8String.h"
 
 #include "../graphics/GLContext.h"
+#include "../graphics/SubVertexArray.h"
 
 #include <string>
 
 namespace avg {
 
-class SubVertexArray;
 class OGLSurface;
 class ImagingProjection;
 typedef boost::shared_ptr<ImagingProjection> ImagingProjectionPtr;
@@ -101,6 +101,14 @@ class AVG_API RasterNode: public AreaNode
         virtual void renderFX(GLContext* pContext);
         void resetFXDirty();
 
+        virtual void maybeRenderBatched(ShapeBatch& batch, 
+                const glm::mat4& parentTransform);
+        // Batched rendering, see ShapeBatch. Nodes that can be batched have their 
+        // vertices in parent coordinates.
+        bool canBatchWith(const RasterNode& prevNode) const;
+        void bltBatched(GLContext* pContext, const glm::mat4& transform,
+                const RasterNode& lastNode);
+
     protected:
         RasterNode();
         
@@ -111,7 +119,10 @@ class AVG_API RasterNode: public AreaNode
                 const glm::vec2& destSize);
 
         virtual OGLSurface * getSurface();
+        // True if the node can share draw calls with its siblings.
+        virtual bool isBatchable() const { return false; };
         bool hasMask() const;
+        bool hasEffect() const;
         const BitmapPtr getMaskBmp() const;
         void setMaskCoords();
         void setRenderColor(const Pixel32& color);
@@ -127,6 +138,7 @@ class AVG_API RasterNode: public AreaNode
         IntPoint getNumTiles();
         void calcVertexGrid(VertexGrid& grid);
         void calcTileVertex(int x, int y, glm::vec2& Vertex);
+        glm::vec2 calcVertexPos(int x, int y) const;
         void calcTexCoords();
 
         OGLSurface * m_pSurface;
@@ -146,8 +158,12 @@ class AVG_API RasterNode: public AreaNode
         IntPoint m_TileSize;
         VertexGrid m_TileVertices;
         bool m_bHasStdVertices;
+        bool m_bBatched;
+        glm::mat4 m_VertexTransform;
+        SubVertexArray m_SubVA;
         SubVertexArray* m_pSubVA;
         std::vector<std::vector<glm::vec2> > m_TexCoords;
+        bool m_bVertexArrayDirty;
 
         glm::vec3 m_Gamma;
         glm::vec3 m_Intensity;
@@ -156,6 +172,7 @@ class AVG_API RasterNode: public AreaNode
         MCFBOPtr m_pFBO;
         FXNodePtr m_pFXNode;
         bool m_bFXDirty;
+        bool m_bSurfaceResident;
         ImagingProjectionPtr m_pImagingProjection;
 };
 
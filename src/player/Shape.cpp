@@ -83,8 +83,12 @@ VertexDataPtr Shape::getVertexData()
 
 void Shape::setVertexArray(const VertexArrayPtr& pVA)
 {
+    if (!m_pVertexData->hasDataChanged() && pVA->reuseSubVA(m_SubVA)) {
+        return;
+    }
     pVA->startSubVA(m_SubVA);
     m_SubVA.appendVertexData(m_pVertexData);
+    m_pVertexData->resetDataChanged();
 /*
     cerr << endl;
     cerr << "Global VA: " << endl;
@@ -96,18 +100,48 @@ void Shape::setVertexArray(const VertexArrayPtr& pVA)
 
 void Shape::draw(GLContext* pContext, const glm::mat4& transform, float opacity)
 {
-    bool bIsTextured = (m_pGPUImage->getSource() != GPUImage::NONE);
+    if (!isDrawable()) {
+        // Don't render until the texture upload is complete.
+        m_pSurface->promoteTexUploads();
+        return;
+    }
+    activate(pContext, transform, opacity);
+    m_SubVA.draw();
+}
+
+bool Shape::isDrawable() const
+{
+    return !isTextured() || m_pSurface->isResident();
+}
+
+bool Shape::canBatchWith(const Shape& prevShape) const
+{
+    if (!m_SubVA.directlyFollows(prevShape.m_SubVA)) {
+        return false;
+    }
+    bool bIsTextured = isTextured();
+    if (bIsTextured != prevShape.isTextured()) {
+        return false;
+    }
+    return !bIsTextured || m_pSurface->hasSameState(*prevShape.m_pSurface);
+}
+
+void Shape::activate(GLContext* pContext, const glm::mat4& transform, float opacity)
+{
     StandardShader* pShader = pContext->getStandardShader();
     pShader->setTransform(transform);
     pShader->setAlpha(opacity);
-    if (bIsTextured) {
+    if (isTextured()) {
         m_pSurface->activate(pContext);
-        pShader->activate();
     } else {
         pShader->setUntextured();
-        pShader->activate();
     }
-    m_SubVA.draw();
+    pShader->activate();
+}
+
+SubVertexArray& Shape::getSubVA()
+{
+    return m_SubVA;
 }
 
 void Shape::discard()
@@ -116,4 +150,9 @@ void Shape::discard()
     m_pGPUImage->setEmpty();
 }
 
+bool Shape::isTextured() const
+{
+    return m_pGPUImage->getSource() != GPUImage::NONE;
+}
+
 }
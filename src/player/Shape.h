@@ -54,9 +54,17 @@ class AVG_API Shape
         void setVertexArray(const VertexArrayPtr& pVA);
         void draw(GLContext* pContext, const glm::mat4& transform, float opacity);
 
+        // Batched drawing, see ShapeBatch.
+        bool isDrawable() const;
+        bool canBatchWith(const Shape& prevShape) const;
+        void activate(GLContext* pContext, const glm::mat4& transform, float opacity);
+        SubVertexArray& getSubVA();
+
         void discard();
 
     private:
+        bool isTextured() const;
+
         VertexDataPtr m_pVertexData;
         SubVertexArray m_SubVA;
         OGLSurface * m_pSurface;
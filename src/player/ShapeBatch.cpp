@@ -0,0 +1,107 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "ShapeBatch.h"
+
+#include "Shape.h"
+#include "RasterNode.h"
+
+using namespace std;
+
+namespace avg {
+
+ShapeBatch::ShapeBatch(GLContext* pContext)
+    : m_pContext(pContext),
+      m_pFirstShape(0),
+      m_pLastShape(0),
+      m_pFirstNode(0),
+      m_pLastNode(0),
+      m_Opacity(0),
+      m_BlendMode(GLContext::BLEND_BLEND)
+{
+}
+
+ShapeBatch::~ShapeBatch()
+{
+}
+
+void ShapeBatch::draw(Shape* pShape, const glm::mat4& transform, float opacity,
+        GLContext::BlendMode blendMode)
+{
+    if (m_pFirstShape && blendMode == m_BlendMode && opacity == m_Opacity &&
+            transform == m_Transform && pShape->isDrawable() && 
+            pShape->canBatchWith(*m_pLastShape))
+    {
+        m_pLastShape = pShape;
+        return;
+    }
+    flush();
+    if (pShape->isDrawable()) {
+        m_pFirstShape = pShape;
+        m_pLastShape = pShape;
+        m_Transform = transform;
+        m_Opacity = opacity;
+        m_BlendMode = blendMode;
+    } else {
+        // Shape::draw() takes care of pending texture uploads.
+        pShape->draw(m_pContext, transform, opacity);
+    }
+}
+
+void ShapeBatch::draw(RasterNode* pNode, const glm::mat4& transform, float opacity,
+        GLContext::BlendMode blendMode)
+{
+    if (m_pFirstNode && blendMode == m_BlendMode && opacity == m_Opacity &&
+            transform == m_Transform && pNode->canBatchWith(*m_pLastNode))
+    {
+        m_pLastNode = pNode;
+        return;
+    }
+    flush();
+    m_pFirstNode = pNode;
+    m_pLastNode = pNode;
+    m_Transform = transform;
+    m_Opacity = opacity;
+    m_BlendMode = blendMode;
+}
+
+void ShapeBatch::flush()
+{
+    if (m_pFirstShape) {
+        m_pContext->setBlendMode(m_BlendMode);
+        m_pFirstShape->activate(m_pContext, m_Transform, m_Opacity);
+        m_pFirstShape->getSubVA().draw(m_pLastShape->getSubVA());
+        m_pFirstShape = 0;
+        m_pLastShape = 0;
+    } else if (m_pFirstNode) {
+        m_pFirstNode->bltBatched(m_pContext, m_Transform, *m_pLastNode);
+        m_pFirstNode = 0;
+        m_pLastNode = 0;
+    }
+}
+
+GLContext* ShapeBatch::getContext() const
+{
+    return m_pContext;
+}
+
+}
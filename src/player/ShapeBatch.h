@@ -0,0 +1,70 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _ShapeBatch_H_
+#define _ShapeBatch_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../graphics/GLContext.h"
+
+namespace avg {
+
+class Shape;
+class RasterNode;
+
+// Collects consecutive Shape and RasterNode draws and merges them into a single draw 
+// call if they share transform, opacity, blend mode and texture state and their 
+// geometry is contiguous in the canvas vertex array. Everything is drawn in the order 
+// it's added. Batched raster nodes have their vertices in parent coordinates, and 
+// small images share textures through the ImageAtlas.
+class AVG_API ShapeBatch
+{
+    public:
+        ShapeBatch(GLContext* pContext);
+        virtual ~ShapeBatch();
+
+        void draw(Shape* pShape, const glm::mat4& transform, float opacity,
+                GLContext::BlendMode blendMode);
+        void draw(RasterNode* pNode, const glm::mat4& transform, float opacity,
+                GLContext::BlendMode blendMode);
+        // Must be called before anything else is rendered.
+        void flush();
+
+        GLContext* getContext() const;
+
+    private:
+        GLContext* m_pContext;
+
+        Shape* m_pFirstShape;
+        Shape* m_pLastShape;
+        RasterNode* m_pFirstNode;
+        RasterNode* m_pLastNode;
+        glm::mat4 m_Transform;
+        float m_Opacity;
+        GLContext::BlendMode m_BlendMode;
+};
+
+}
+
+#endif
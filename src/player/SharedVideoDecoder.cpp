@@ -0,0 +1,257 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "SharedVideoDecoder.h"
+
+#include "Player.h"
+
+#include "../base/ConfigMgr.h"
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+
+#include "../graphics/GLContext.h"
+
+#include "../video/AsyncVideoDecoder.h"
+
+using namespace std;
+
+namespace avg {
+
+vector<boost::weak_ptr<SharedVideoDecoder> > SharedVideoDecoder::s_pDecoders;
+
+SharedVideoDecoderPtr SharedVideoDecoder::get(const string& sFilename,
+        bool bUseHardwareAcceleration, int queueLength, int numDecoderThreads,
+        float fps, bool bMipmap, bool bLoop, long long movieTime)
+{
+    vector<boost::weak_ptr<SharedVideoDecoder> >::iterator it = s_pDecoders.begin();
+    while (it != s_pDecoders.end()) {
+        SharedVideoDecoderPtr pDecoder = it->lock();
+        if (!pDecoder) {
+            it = s_pDecoders.erase(it);
+        } else {
+            if (pDecoder->m_bShared && pDecoder->hasSettings(sFilename,
+                    bUseHardwareAcceleration, queueLength, numDecoderThreads, fps,
+                    bMipmap, bLoop) &&
+                    pDecoder->isInSync(movieTime))
+            {
+                return pDecoder;
+            }
+            ++it;
+        }
+    }
+    SharedVideoDecoderPtr pDecoder(new SharedVideoDecoder(sFilename, 
+            bUseHardwareAcceleration, queueLength, numDecoderThreads, fps, bMipmap, 
+            bLoop, movieTime));
+    s_pDecoders.push_back(pDecoder);
+    return pDecoder;
+}
+
+SharedVideoDecoderPtr SharedVideoDecoder::createPrivate(const string& sFilename,
+        bool bUseHardwareAcceleration, int queueLength, int numDecoderThreads,
+        float fps, bool bMipmap, bool bLoop, long long movieTime)
+{
+    SharedVideoDecoderPtr pDecoder(new SharedVideoDecoder(sFilename, 
+            bUseHardwareAcceleration, queueLength, numDecoderThreads, fps, bMipmap, 
+            bLoop, movieTime));
+    pDecoder->setShared(false);
+    s_pDecoders.push_back(pDecoder);
+    return pDecoder;
+}
+
+SharedVideoDecoder::SharedVideoDecoder(const string& sFilename, 
+        bool bUseHardwareAcceleration, int queueLength, int numDecoderThreads, 
+        float fps, bool bMipmap, bool bLoop, long long movieTime)
+    : m_sFilename(sFilename),
+      m_bUseHardwareAcceleration(bUseHardwareAcceleration),
+      m_QueueLength(queueLength),
+      m_NumDecoderThreads(numDecoderThreads),
+      m_FPS(fps),
+      m_bMipmap(bMipmap),
+      m_bLoop(bLoop),
+      m_bDecoding(false),
+      m_bShared(true),
+      m_ShareTolerance(ConfigMgr::get()->getIntOption("video", "sharetolerance", 100)),
+      m_MovieTime(movieTime),
+      m_LastRenderFrameTime(-1),
+      m_LastRenderLoopCount(0),
+      m_LastFrameAvailable(FA_STILL_DECODING),
+      m_ThrowAwayFrameTime(-1),
+      m_ThrowAwayMovieTime(0),
+      m_LoopCount(0)
+{
+    m_pDecoder = new AsyncVideoDecoder(queueLength);
+    m_pDecoder->setNumDecoderThreads(numDecoderThreads);
+    try {
+        m_pDecoder->open(sFilename, bUseHardwareAcceleration, false);
+    } catch (const Exception&) {
+        delete m_pDecoder;
+        throw;
+    }
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+SharedVideoDecoder::~SharedVideoDecoder()
+{
+    m_pDecoder->close();
+    delete m_pDecoder;
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+VideoDecoder* SharedVideoDecoder::getDecoder() const
+{
+    return m_pDecoder;
+}
+
+void SharedVideoDecoder::startDecoding()
+{
+    if (!m_bDecoding) {
+        m_pDecoder->startDecoding(GLContext::getCurrent()->useGPUYUVConversion(), 0);
+        if (m_FPS != 0.0) {
+            m_pDecoder->setFPS(m_FPS);
+        }
+        m_bDecoding = true;
+        if (m_MovieTime > 0) {
+            m_pDecoder->seek(float(m_MovieTime)/1000.0f);
+        }
+    }
+}
+
+void SharedVideoDecoder::setShared(bool bShared)
+{
+    m_bShared = bShared;
+}
+
+bool SharedVideoDecoder::isShared() const
+{
+    return m_bShared;
+}
+
+bool SharedVideoDecoder::hasTextures() const
+{
+    return m_pTextures[0] != MCTexturePtr();
+}
+
+void SharedVideoDecoder::getTextures(MCTexturePtr* pTextures) const
+{
+    for (int i = 0; i < 4; ++i) {
+        pTextures[i] = m_pTextures[i];
+    }
+}
+
+void SharedVideoDecoder::setTextures(const MCTexturePtr* pTextures)
+{
+    for (int i = 0; i < 4; ++i) {
+        m_pTextures[i] = pTextures[i];
+    }
+}
+
+bool SharedVideoDecoder::isInSync(long long movieTime) const
+{
+    long long diff = movieTime-m_MovieTime;
+    return diff <= m_ShareTolerance && diff >= -m_ShareTolerance;
+}
+
+void SharedVideoDecoder::seek(long long destTime)
+{
+    if (m_bDecoding) {
+        m_pDecoder->seek(float(destTime)/1000.0f);
+    }
+    m_MovieTime = destTime;
+    m_LastRenderFrameTime = -1;
+}
+
+bool SharedVideoDecoder::getFrameResult(FrameAvailableCode& frameAvailable) const
+{
+    if (m_LastRenderFrameTime == Player::get()->getFrameTime() && 
+            m_LastRenderLoopCount == m_LoopCount)
+    {
+        frameAvailable = m_LastFrameAvailable;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+void SharedVideoDecoder::setFrameResult(FrameAvailableCode frameAvailable, 
+        long long movieTime, const vector<BitmapPtr>& pBmps)
+{
+    m_LastRenderFrameTime = Player::get()->getFrameTime();
+    m_LastRenderLoopCount = m_LoopCount;
+    m_LastFrameAvailable = frameAvailable;
+    m_MovieTime = movieTime;
+    if (frameAvailable == FA_NEW_FRAME) {
+        m_pLastBmps = pBmps;
+    }
+}
+
+void SharedVideoDecoder::getLastFrame(vector<BitmapPtr>& pBmps) const
+{
+    pBmps = m_pLastBmps;
+}
+
+void SharedVideoDecoder::throwAwayFrame(long long movieTime)
+{
+    m_ThrowAwayFrameTime = Player::get()->getFrameTime();
+    m_ThrowAwayMovieTime = movieTime;
+}
+
+void SharedVideoDecoder::onFrameEnd()
+{
+    long long frameTime = Player::get()->getFrameTime();
+    if (m_ThrowAwayFrameTime == frameTime && m_LastRenderFrameTime != frameTime) {
+        m_pDecoder->throwAwayFrame(m_ThrowAwayMovieTime/1000.0f);
+        m_MovieTime = m_ThrowAwayMovieTime;
+    }
+    m_ThrowAwayFrameTime = -1;
+}
+
+bool SharedVideoDecoder::isEOF(int loopCount) const
+{
+    return loopCount != m_LoopCount || m_pDecoder->isEOF();
+}
+
+int SharedVideoDecoder::loop(int loopCount)
+{
+    if (loopCount == m_LoopCount) {
+        m_pDecoder->loop();
+        m_LoopCount++;
+        m_MovieTime = 0;
+    }
+    return m_LoopCount;
+}
+
+int SharedVideoDecoder::getLoopCount() const
+{
+    return m_LoopCount;
+}
+
+bool SharedVideoDecoder::hasSettings(const string& sFilename, 
+        bool bUseHardwareAcceleration, int queueLength, int numDecoderThreads, 
+        float fps, bool bMipmap, bool bLoop) const
+{
+    return sFilename == m_sFilename && 
+            bUseHardwareAcceleration == m_bUseHardwareAcceleration &&
+            queueLength == m_QueueLength && numDecoderThreads == m_NumDecoderThreads &&
+            fps == m_FPS && bMipmap == m_bMipmap && bLoop == m_bLoop;
+}
+
+}
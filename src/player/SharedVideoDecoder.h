@@ -0,0 +1,137 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _SharedVideoDecoder_H_
+#define _SharedVideoDecoder_H_
+
+#include "../api.h"
+
+#include "../graphics/Bitmap.h"
+
+#include "../video/VideoDecoder.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace avg {
+
+class MCTexture;
+typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+class SharedVideoDecoder;
+typedef boost::shared_ptr<SharedVideoDecoder> SharedVideoDecoderPtr;
+
+// An AsyncVideoDecoder and the textures it renders to, shared by VideoNodes that play
+// the same file at (almost) the same position. The first node that renders in a frame
+// advances the decoder and uploads the frame; the others reuse the result. Nodes whose
+// playback position differs from the decoder's by more than the video:sharetolerance
+// avgrc setting need to switch decoders. Shared decoders don't decode audio.
+class AVG_API SharedVideoDecoder
+{
+public:
+    // Returns a shared decoder with matching settings that is in sync with movieTime or
+    // opens a new one, seeking to movieTime. Times are in milliseconds.
+    static SharedVideoDecoderPtr get(const std::string& sFilename,
+            bool bUseHardwareAcceleration, int queueLength, int numDecoderThreads,
+            float fps, bool bMipmap, bool bLoop, long long movieTime);
+    // Opens a decoder that get() doesn't return until setShared(true) is called.
+    static SharedVideoDecoderPtr createPrivate(const std::string& sFilename,
+            bool bUseHardwareAcceleration, int queueLength, int numDecoderThreads,
+            float fps, bool bMipmap, bool bLoop, long long movieTime);
+    virtual ~SharedVideoDecoder();
+
+    VideoDecoder* getDecoder() const;
+    // Decoders are opened on creation, but only start decoding when the first node
+    // that uses them can render. Later calls do nothing.
+    void startDecoding();
+
+    // Paused nodes use private decoders, since playing nodes would advance them.
+    void setShared(bool bShared);
+    bool isShared() const;
+
+    // The first node that creates textures for the decoder sets them.
+    bool hasTextures() const;
+    void getTextures(MCTexturePtr* pTextures) const;
+    void setTextures(const MCTexturePtr* pTextures);
+
+    bool isInSync(long long movieTime) const;
+    void seek(long long destTime);
+
+    // Returns true if the decoder has already been asked for a frame in this frame.
+    bool getFrameResult(FrameAvailableCode& frameAvailable) const;
+    void setFrameResult(FrameAvailableCode frameAvailable, long long movieTime,
+            const std::vector<BitmapPtr>& pBmps);
+    // The bitmaps of the last frame uploaded, so a node that switches decoders can
+    // show it until the new decoder delivers.
+    void getLastFrame(std::vector<BitmapPtr>& pBmps) const;
+    // Frames are only thrown away at the end of the frame if nobody rendered them.
+    void throwAwayFrame(long long movieTime);
+    void onFrameEnd();
+
+    // Every node loops the decoder once when it reaches the end of the file, but only
+    // the first one actually does it. loopCount is the number of loops the node has
+    // seen.
+    bool isEOF(int loopCount) const;
+    int loop(int loopCount);
+    int getLoopCount() const;
+
+private:
+    SharedVideoDecoder(const std::string& sFilename, bool bUseHardwareAcceleration,
+            int queueLength, int numDecoderThreads, float fps, bool bMipmap, bool bLoop,
+            long long movieTime);
+    bool hasSettings(const std::string& sFilename, bool bUseHardwareAcceleration,
+            int queueLength, int numDecoderThreads, float fps, bool bMipmap, bool bLoop)
+            const;
+
+    static std::vector<boost::weak_ptr<SharedVideoDecoder> > s_pDecoders;
+
+    std::string m_sFilename;
+    bool m_bUseHardwareAcceleration;
+    int m_QueueLength;
+    int m_NumDecoderThreads;
+    float m_FPS;
+    bool m_bMipmap;
+    bool m_bLoop;
+
+    VideoDecoder* m_pDecoder;
+    bool m_bDecoding;
+    bool m_bShared;
+    long long m_ShareTolerance;
+    MCTexturePtr m_pTextures[4];
+    std::vector<BitmapPtr> m_pLastBmps;
+
+    // Movie time the decoder was last asked for. Before decoding starts, this is the
+    // position to seek to.
+    long long m_MovieTime;
+    long long m_LastRenderFrameTime;
+    int m_LastRenderLoopCount;
+    FrameAvailableCode m_LastFrameAvailable;
+    long long m_ThrowAwayFrameTime;
+    long long m_ThrowAwayMovieTime;
+    int m_LoopCount;
+};
+
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include "TangibleEvent.h"
 #include "KeyEvent.h"
 #include "TouchStatus.h"
+#include "TextEngine.h"
 
 #include "../base/Exception.h"
 #include "../base/ObjectCounter.h"
@@ -106,6 +107,16 @@ TypeMap TestHelper::getObjectCount()
     return ObjectCounter::get()->getObjectCount();
 }
 
+int TestHelper::getNumTextLayoutHits()
+{
+    return TextEngine::getNumLayoutHits();
+}
+
+int TestHelper::getNumTextBitmapHits()
+{
+    return TextEngine::getNumBitmapHits();
+}
+
 // From InputDevice
 std::vector<EventPtr> TestHelper::pollEvents()
 {
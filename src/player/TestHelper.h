@@ -59,6 +59,8 @@ class AVG_API TestHelper : public InputDevice
                 const std::string& sKeyString, int modifiers, const std::string& sText);
         void dumpObjects();
         TypeMap getObjectCount();
+        int getNumTextLayoutHits();
+        int getNumTextBitmapHits();
 
         // From InputDevice
         virtual std::vector<EventPtr> pollEvents();
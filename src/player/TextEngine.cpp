@@ -27,12 +27,23 @@
 #include "../base/FileHelper.h"
 #include "../base/StringHelper.h"
 
+#include "../graphics/Bitmap.h"
+
 #include <algorithm>
 
+// Bounds for the layout cache.
+#define MAX_CACHED_LAYOUTS 256
+#define MAX_CACHED_LAYOUT_BMP_MEM (16*1024*1024)
+
 namespace avg {
 
 using namespace std;
 
+int TextEngine::s_NumLayoutHits = 0;
+int TextEngine::s_NumLayoutMisses = 0;
+int TextEngine::s_NumBitmapHits = 0;
+int TextEngine::s_NumBitmapMisses = 0;
+
 static void
 text_subst_func_hint(FcPattern *pattern, gpointer data)
 {
@@ -65,7 +76,8 @@ TextEngine& TextEngine::get(bool bHint)
 
 
 TextEngine::TextEngine(bool bHint)
-    : m_bHint(bHint)
+    : m_bHint(bHint),
+      m_LayoutCacheBmpMem(0)
 {
     m_sFontDirs.push_back("fonts/");
     init();
@@ -113,6 +125,8 @@ void TextEngine::init()
 
 void TextEngine::deinit()
 {
+    // Cached layouts reference the old font map.
+    clearLayoutCache();
     g_object_unref(m_pFontMap);
     g_free(m_ppFontFamilies);
     g_object_unref(m_pPangoContext);
@@ -205,6 +219,127 @@ PangoFontDescription * TextEngine::getFontDescription(const string& sFamily,
     return pango_font_description_copy(pDescription);
 }
 
+PangoLayout * TextEngine::getCachedLayout(const string& sKey)
+{
+    LayoutMap::iterator it = m_LayoutMap.find(sKey);
+    if (it == m_LayoutMap.end()) {
+        s_NumLayoutMisses++;
+        return 0;
+    }
+    s_NumLayoutHits++;
+    m_LayoutLRUList.splice(m_LayoutLRUList.begin(), m_LayoutLRUList, it->second);
+    PangoLayout * pLayout = it->second->m_pLayout;
+    g_object_ref(pLayout);
+    return pLayout;
+}
+
+bool TextEngine::hasCachedLayout(const string& sKey) const
+{
+    return m_LayoutMap.find(sKey) != m_LayoutMap.end();
+}
+
+void TextEngine::addCachedLayout(const string& sKey, PangoLayout * pLayout)
+{
+    AVG_ASSERT(!hasCachedLayout(sKey));
+    CachedLayout cachedLayout;
+    cachedLayout.m_sKey = sKey;
+    cachedLayout.m_pLayout = pLayout;
+    g_object_ref(pLayout);
+    m_LayoutLRUList.push_front(cachedLayout);
+    m_LayoutMap[sKey] = m_LayoutLRUList.begin();
+    checkLayoutCacheSize();
+}
+
+BitmapPtr TextEngine::getCachedBitmap(const string& sKey)
+{
+    LayoutMap::iterator it = m_LayoutMap.find(sKey);
+    if (it == m_LayoutMap.end() || !it->second->m_pBmp) {
+        s_NumBitmapMisses++;
+        return BitmapPtr();
+    }
+    s_NumBitmapHits++;
+    return it->second->m_pBmp;
+}
+
+void TextEngine::setCachedBitmap(const string& sKey, BitmapPtr pBmp)
+{
+    if (pBmp->getMemNeeded() > MAX_CACHED_LAYOUT_BMP_MEM/4) {
+        // Would push most other bitmaps out of the cache.
+        return;
+    }
+    LayoutMap::iterator it = m_LayoutMap.find(sKey);
+    if (it != m_LayoutMap.end()) {
+        BitmapPtr& pCachedBmp = it->second->m_pBmp;
+        if (pCachedBmp) {
+            m_LayoutCacheBmpMem -= pCachedBmp->getMemNeeded();
+        }
+        pCachedBmp = pBmp;
+        m_LayoutCacheBmpMem += pBmp->getMemNeeded();
+        checkLayoutCacheSize();
+    }
+}
+
+void TextEngine::clearLayoutCache()
+{
+    LayoutLRUList::iterator it;
+    for (it = m_LayoutLRUList.begin(); it != m_LayoutLRUList.end(); ++it) {
+        g_object_unref(it->m_pLayout);
+    }
+    m_LayoutLRUList.clear();
+    m_LayoutMap.clear();
+    m_LayoutCacheBmpMem = 0;
+}
+
+int TextEngine::getNumCachedLayouts() const
+{
+    return int(m_LayoutMap.size());
+}
+
+void TextEngine::dumpLayoutCacheStatistics()
+{
+    if (s_NumLayoutHits + s_NumLayoutMisses > 0) {
+        AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                "Text layout cache statistics: ");
+        AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                "  Layouts: " << s_NumLayoutHits << " hits, " << s_NumLayoutMisses 
+                << " misses");
+        AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                "  Bitmaps: " << s_NumBitmapHits << " hits, " << s_NumBitmapMisses 
+                << " misses");
+    }
+    s_NumLayoutHits = 0;
+    s_NumLayoutMisses = 0;
+    s_NumBitmapHits = 0;
+    s_NumBitmapMisses = 0;
+}
+
+int TextEngine::getNumLayoutHits()
+{
+    return s_NumLayoutHits;
+}
+
+int TextEngine::getNumBitmapHits()
+{
+    return s_NumBitmapHits;
+}
+
+void TextEngine::checkLayoutCacheSize()
+{
+    // Never evicts the most recently used layout.
+    while (m_LayoutLRUList.size() > 1 && 
+            (m_LayoutLRUList.size() > MAX_CACHED_LAYOUTS || 
+             m_LayoutCacheBmpMem > MAX_CACHED_LAYOUT_BMP_MEM))
+    {
+        CachedLayout& lruLayout = m_LayoutLRUList.back();
+        if (lruLayout.m_pBmp) {
+            m_LayoutCacheBmpMem -= lruLayout.m_pBmp->getMemNeeded();
+        }
+        g_object_unref(lruLayout.m_pLayout);
+        m_LayoutMap.erase(lruLayout.m_sKey);
+        m_LayoutLRUList.pop_back();
+    }
+}
+
 void GLibLogFunc(const gchar *log_domain, GLogLevelFlags log_level, 
         const gchar *message, gpointer unused_data)
 {
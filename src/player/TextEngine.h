@@ -26,13 +26,19 @@
 #include <pango/pangoft2.h>
 #include <fontconfig/fontconfig.h>
 
+#include <boost/shared_ptr.hpp>
+
 #include <vector>
 #include <string>
 #include <set>
 #include <map>
+#include <list>
 
 namespace avg {
 
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
 class TextEngine {
 public:
     static TextEngine& get(bool bHint);
@@ -48,6 +54,21 @@ public:
             const std::string& sVariant);
     void FT2SubstituteFunc(FcPattern *pattern, gpointer data);
 
+    // LRU cache of finished layouts and their rendered bitmaps. The key must contain
+    // everything that influences the layout. Cached layouts are shared between nodes
+    // and must not be changed.
+    // Returns a new reference to the layout or 0 if it isn't cached.
+    PangoLayout * getCachedLayout(const std::string& sKey);
+    bool hasCachedLayout(const std::string& sKey) const;
+    void addCachedLayout(const std::string& sKey, PangoLayout * pLayout);
+    BitmapPtr getCachedBitmap(const std::string& sKey);
+    void setCachedBitmap(const std::string& sKey, BitmapPtr pBmp);
+    void clearLayoutCache();
+    int getNumCachedLayouts() const;
+    static void dumpLayoutCacheStatistics();
+    static int getNumLayoutHits();
+    static int getNumBitmapHits();
+
 private:
     TextEngine(bool bHint);
     void init();
@@ -56,6 +77,7 @@ private:
     PangoFontFamily * getFontFamily(const std::string& sFamily);
 
     void checkFontError(int Ok, const std::string& sMsg);
+    void checkLayoutCacheSize();
 
     bool m_bHint;
     PangoContext * m_pPangoContext;
@@ -70,6 +92,23 @@ private:
     PangoFontFamily** m_ppFontFamilies;
     std::vector<std::string> m_sFontDirs;
 
+    struct CachedLayout {
+        std::string m_sKey;
+        PangoLayout * m_pLayout;
+        BitmapPtr m_pBmp;
+    };
+    // Most recently used layout first.
+    typedef std::list<CachedLayout> LayoutLRUList;
+    LayoutLRUList m_LayoutLRUList;
+    typedef std::map<std::string, LayoutLRUList::iterator> LayoutMap;
+    LayoutMap m_LayoutMap;
+    long long m_LayoutCacheBmpMem;
+
+    static int s_NumLayoutHits;
+    static int s_NumLayoutMisses;
+    static int s_NumBitmapHits;
+    static int s_NumBitmapMisses;
+
 };
 
 }
@@ -25,6 +25,7 @@
 #include "TypeRegistry.h"
 #include "OGLSurface.h"
 #include "Shape.h"
+#include "ShapeBatch.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
@@ -56,6 +57,7 @@ void VectorNode::registerType()
                 offsetof(VectorNode, m_Color)))
         .addArg(Arg<float>("strokewidth", 1, false, offsetof(VectorNode, m_StrokeWidth)))
         .addArg(Arg<UTF8String>("texhref", "", false, offsetof(VectorNode, m_TexHRef)))
+        .addArg(Arg<bool>("asyncload", false, false, offsetof(VectorNode, m_bAsyncLoad)))
         .addArg(Arg<string>("blendmode", "blend", false, 
                 offsetof(VectorNode, m_sBlendMode)))
         ;
@@ -69,6 +71,7 @@ VectorNode::VectorNode(const ArgList& args)
 
     ObjectCounter::get()->incRef(&typeid(*this));
     m_TexHRef = args.getArgVal<UTF8String>("texhref"); 
+    m_bAsyncLoad = args.getArgVal<bool>("asyncload");
     setTexHRef(m_TexHRef);
 }
 
@@ -103,7 +106,8 @@ void VectorNode::disconnect(bool bKill)
 
 void VectorNode::checkReload()
 {
-    Node::checkReload(m_TexHRef, m_pShape->getGPUImage());
+    Node::checkReload(m_TexHRef, m_pShape->getGPUImage(), TEXCOMPRESSION_NONE,
+            getAsyncListener());
     if (getState() == Node::NS_CANRENDER) {
         m_pShape->moveToGPU();
         setDrawNeeded();
@@ -129,6 +133,28 @@ void VectorNode::setBitmap(BitmapPtr pBmp)
     setDrawNeeded();
 }
 
+bool VectorNode::getAsyncLoad() const
+{
+    return m_bAsyncLoad;
+}
+
+void VectorNode::setAsyncLoad(bool bAsyncLoad)
+{
+    m_bAsyncLoad = bAsyncLoad;
+}
+
+void VectorNode::onBitmapLoaded(BitmapPtr pBmp)
+{
+    setDrawNeeded();
+    notifySubscribers("IMAGE_LOADED");
+}
+
+void VectorNode::onBitmapLoadError(const Exception* pEx)
+{
+    logFileNotFoundWarning(pEx->getStr());
+    notifySubscribers("IMAGE_LOAD_ERROR", pEx->getStr());
+}
+
 const string& VectorNode::getBlendModeStr() const
 {
     return m_sBlendMode;
@@ -138,6 +164,7 @@ void VectorNode::setBlendModeStr(const string& sBlendMode)
 {
     m_sBlendMode = sBlendMode;
     m_BlendMode = GLContext::stringToBlendMode(sBlendMode);
+    invalidateRender();
 }
 
 static ProfilingZoneID PrerenderProfilingZone("VectorNode::prerender");
@@ -150,6 +177,7 @@ void VectorNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
         ScopeTimer timer(PrerenderProfilingZone);
         VertexDataPtr pShapeVD = m_pShape->getVertexData();
         if (m_bDrawNeeded) {
+            invalidateRender();
             pShapeVD->reset();
             calcVertexes(pShapeVD, m_Color);
             m_bDrawNeeded = false;
@@ -182,6 +210,25 @@ void VectorNode::render(GLContext* pContext, const glm::mat4& transform)
     }
 }
 
+void VectorNode::maybeRenderBatched(ShapeBatch& batch, const glm::mat4& parentTransform)
+{
+    AVG_ASSERT(getState() == NS_CANRENDER);
+    if (isVisible()) {
+        glm::vec3 trans(m_Translate.x, m_Translate.y, 0);
+        glm::mat4 transform = glm::translate(parentTransform, trans);
+        renderBatched(batch, transform);
+    }
+}
+
+void VectorNode::renderBatched(ShapeBatch& batch, const glm::mat4& transform)
+{
+    ScopeTimer timer(RenderProfilingZone);
+    float curOpacity = getEffectiveOpacity();
+    if (curOpacity > 0.01) {
+        batch.draw(m_pShape.get(), transform, curOpacity, m_BlendMode);
+    }
+}
+
 void VectorNode::setColor(const Color& color)
 {
     if (m_Color != color) {
@@ -248,6 +295,15 @@ bool VectorNode::isDrawNeeded()
     return m_bDrawNeeded;
 }
 
+IBitmapLoadedListener* VectorNode::getAsyncListener()
+{
+    if (m_bAsyncLoad) {
+        return this;
+    } else {
+        return 0;
+    }
+}
+
 void VectorNode::calcPolyLineCumulDist(vector<float>& cumulDists, 
         const vector<glm::vec2>& pts, bool bIsClosed)
 {
@@ -507,6 +563,7 @@ int VectorNode::getNumDifferentPts(const vector<glm::vec2>& pts)
 void VectorNode::setTranslate(const glm::vec2& trans)
 {
     m_Translate = trans;
+    invalidateRender();
 }
 
 Shape* VectorNode::createDefaultShape() const
@@ -24,6 +24,7 @@
 
 #include "../api.h"
 #include "Node.h"
+#include "IBitmapLoadedListener.h"
 
 #include "../base/UTF8String.h"
 #include "../graphics/Pixel32.h"
@@ -44,7 +45,7 @@ typedef boost::shared_ptr<Shape> ShapePtr;
 class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 
-class AVG_API VectorNode : public Node
+class AVG_API VectorNode : public Node, IBitmapLoadedListener
 {
     public:
         enum LineJoin {LJ_MITER, LJ_BEVEL};
@@ -61,6 +62,11 @@ class AVG_API VectorNode : public Node
         const UTF8String& getTexHRef() const;
         void setTexHRef(const UTF8String& href);
         void setBitmap(BitmapPtr pBmp);
+        bool getAsyncLoad() const;
+        void setAsyncLoad(bool bAsyncLoad);
+
+        virtual void onBitmapLoaded(BitmapPtr pBmp);
+        virtual void onBitmapLoadError(const Exception* pEx);
 
         const std::string& getBlendModeStr() const;
         void setBlendModeStr(const std::string& sBlendMode);
@@ -69,6 +75,9 @@ class AVG_API VectorNode : public Node
                 float parentEffectiveOpacity);
         virtual void maybeRender(GLContext* pContext, const glm::mat4& parentTransform);
         virtual void render(GLContext* pContext, const glm::mat4& transform);
+        virtual void maybeRenderBatched(ShapeBatch& batch, 
+                const glm::mat4& parentTransform);
+        virtual void renderBatched(ShapeBatch& batch, const glm::mat4& transform);
 
         virtual void calcVertexes(const VertexDataPtr& pVertexData, Pixel32 color) = 0;
 
@@ -86,6 +95,8 @@ class AVG_API VectorNode : public Node
 
         void setDrawNeeded();
         bool isDrawNeeded();
+        // Returns 0 if textures should be loaded synchronously.
+        IBitmapLoadedListener* getAsyncListener();
         bool hasVASizeChanged();
         void calcPolyLineCumulDist(std::vector<float>& cumulDist, 
                 const std::vector<glm::vec2>& pts, bool bIsClosed);
@@ -108,6 +119,7 @@ class AVG_API VectorNode : public Node
         Color m_Color;
         float m_StrokeWidth;
         UTF8String m_TexHRef;
+        bool m_bAsyncLoad;
         std::string m_sBlendMode;
 
         bool m_bDrawNeeded;
@@ -24,6 +24,7 @@
 #include "TypeDefinition.h"
 #include "TypeRegistry.h"
 #include "Canvas.h"
+#include "SharedVideoDecoder.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
@@ -70,6 +71,10 @@ void VideoNode::registerType()
                 offsetof(VideoNode, m_bUsesHardwareAcceleration)))
         .addArg(Arg<bool>("enablesound", true, false,
                 offsetof(VideoNode, m_bEnableSound)))
+        .addArg(Arg<int>("decoderthreads", -1, false,
+                offsetof(VideoNode, m_NumDecoderThreads)))
+        .addArg(Arg<bool>("shareddecoder", false, false,
+                offsetof(VideoNode, m_bSharedDecoder)))
         ;
     TypeRegistry::get()->registerType(def);
 }
@@ -85,9 +90,12 @@ VideoNode::VideoNode(const ArgList& args)
       m_FramesPlayed(0),
       m_SeekBeforeCanRenderTime(0),
       m_pDecoder(0),
+      m_pOwnDecoder(0),
+      m_SharedLoopCount(0),
       m_Volume(1.0),
       m_bUsesHardwareAcceleration(false),
       m_bEnableSound(true),
+      m_bSharedDecoder(false),
       m_AudioID(-1)
 {
     args.setMembers(this);
@@ -97,10 +105,18 @@ VideoNode::VideoNode(const ArgList& args)
         throw Exception(AVG_ERR_INVALID_ARGS, 
                 "Can't set queue length for unthreaded videos because there is no decoder queue in this case.");
     }
-    if (m_bThreaded) {
-        m_pDecoder = new AsyncVideoDecoder(m_QueueLength);
-    } else {
-        m_pDecoder = new SyncVideoDecoder();
+    if (m_bSharedDecoder && !m_bThreaded) {
+        throw Exception(AVG_ERR_INVALID_ARGS, 
+                "Only threaded videos can share decoders.");
+    }
+    if (!m_bSharedDecoder) {
+        if (m_bThreaded) {
+            m_pOwnDecoder = new AsyncVideoDecoder(m_QueueLength);
+        } else {
+            m_pOwnDecoder = new SyncVideoDecoder();
+        }
+        m_pOwnDecoder->setNumDecoderThreads(m_NumDecoderThreads);
+        m_pDecoder = m_pOwnDecoder;
     }
 
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -108,8 +124,10 @@ VideoNode::VideoNode(const ArgList& args)
 
 VideoNode::~VideoNode()
 {
-    if (m_pDecoder) {
-        delete m_pDecoder;
+    m_pSharedDecoder = SharedVideoDecoderPtr();
+    if (m_pOwnDecoder) {
+        delete m_pOwnDecoder;
+        m_pOwnDecoder = 0;
         m_pDecoder = 0;
     }
     if (m_pEOFCallback) {
@@ -300,6 +318,11 @@ bool VideoNode::isThreaded() const
     return m_bThreaded;
 }
 
+bool VideoNode::usesSharedDecoder() const
+{
+    return m_bSharedDecoder;
+}
+
 bool VideoNode::hasAudio() const
 {
     exceptionIfUnloaded("hasAudio");
@@ -383,7 +406,9 @@ void VideoNode::checkReload()
 void VideoNode::onFrameEnd()
 {
     AsyncVideoDecoder* pAsyncDecoder = dynamic_cast<AsyncVideoDecoder*>(m_pDecoder);
-    if (pAsyncDecoder && (m_VideoState == Playing || m_VideoState == Paused)) {
+    if (m_pSharedDecoder) {
+        m_pSharedDecoder->onFrameEnd();
+    } else if (pAsyncDecoder && (m_VideoState == Playing || m_VideoState == Paused)) {
         pAsyncDecoder->updateAudioStatus();
     }
     if (m_bEOFPending) {
@@ -401,6 +426,7 @@ void VideoNode::changeVideoState(VideoState newVideoState)
     if (m_VideoState == newVideoState) {
         return;
     }
+    invalidateRender();
     if (m_VideoState == Unloaded) {
         m_PauseStartTime = curTime;
         open();
@@ -408,6 +434,13 @@ void VideoNode::changeVideoState(VideoState newVideoState)
     if (newVideoState == Unloaded) {
         close();
     }
+    if (m_pSharedDecoder) {
+        if (newVideoState == Paused) {
+            detachSharedDecoder();
+        } else {
+            m_pSharedDecoder->setShared(true);
+        }
+    }
     if (getState() == NS_CANRENDER) {
         if (m_VideoState == Unloaded) {
             startDecoding();
@@ -440,7 +473,16 @@ void VideoNode::seek(long long destTime)
         if (m_AudioID != -1) {
             AudioEngine::get()->notifySeek(m_AudioID);
         }
-        m_pDecoder->seek(float(destTime)/1000.0f);
+        if (m_pSharedDecoder && !m_pSharedDecoder.unique()) {
+            // Seeking the decoder would move the other nodes' videos as well.
+            attachSharedDecoder(destTime);
+            m_pSharedDecoder->startDecoding();
+            createTextures(m_pDecoder->getSize());
+        } else if (m_pSharedDecoder) {
+            m_pSharedDecoder->seek(destTime);
+        } else {
+            m_pDecoder->seek(float(destTime)/1000.0f);
+        }
         m_StartTime = Player::get()->getFrameTime() - destTime;
         m_JitterCompensation = 0.5;
         m_PauseTime = 0;
@@ -459,10 +501,15 @@ void VideoNode::open()
     m_FramesTooLate = 0;
     m_FramesInRowTooLate = 0;
     m_FramesPlayed = 0;
-    m_pDecoder->open(m_Filename, m_bUsesHardwareAcceleration, m_bEnableSound);
+    if (m_bSharedDecoder) {
+        // Shared decoders don't decode audio.
+        attachSharedDecoder(0);
+    } else {
+        m_pDecoder->open(m_Filename, m_bUsesHardwareAcceleration, m_bEnableSound);
+    }
     VideoInfo videoInfo = m_pDecoder->getVideoInfo();
     if (!videoInfo.m_bHasVideo) {
-        m_pDecoder->close();
+        close();
         throw Exception(AVG_ERR_VIDEO_GENERAL, 
                 string("Video: Opening "+m_Filename+" failed. No video stream found."));
     }
@@ -484,13 +531,17 @@ void VideoNode::startDecoding()
     if (pAudioEngine) {
         pAP = pAudioEngine->getParams();
     }
-    m_pDecoder->startDecoding(GLContext::getCurrent()->useGPUYUVConversion(), pAP);
+    if (m_pSharedDecoder) {
+        m_pSharedDecoder->startDecoding();
+    } else {
+        m_pDecoder->startDecoding(GLContext::getCurrent()->useGPUYUVConversion(), pAP);
+    }
     VideoInfo videoInfo = m_pDecoder->getVideoInfo();
     if (m_FPS != 0.0) {
         if (videoInfo.m_bHasAudio) {
             AVG_LOG_WARNING(getID() +
                     ": Can't set FPS if video contains audio. Ignored.");
-        } else {
+        } else if (!m_pSharedDecoder) {
             m_pDecoder->setFPS(m_FPS);
         }
     }
@@ -514,23 +565,30 @@ void VideoNode::startDecoding()
 void VideoNode::createTextures(IntPoint size)
 {
     PixelFormat pf = getPixelFormat();
-    bool bMipmap = getMipmap();
-    GLContextManager* pCM = GLContextManager::get();
-    if (pixelFormatIsPlanar(pf)) {
-        m_pTextures[0] = pCM->createTexture(size, I8, bMipmap);
-        IntPoint halfSize(size.x/2, size.y/2);
-        m_pTextures[1] = pCM->createTexture(halfSize, I8, bMipmap, false, 128);
-        m_pTextures[2] = pCM->createTexture(halfSize, I8, bMipmap, false, 128);
-        if (pixelFormatHasAlpha(pf)) {
-            m_pTextures[3] = pCM->createTexture(size, I8, bMipmap);
-        }
+    if (m_pSharedDecoder && m_pSharedDecoder->hasTextures()) {
+        m_pSharedDecoder->getTextures(m_pTextures);
     } else {
-        m_pTextures[0] = pCM->createTexture(size, pf, bMipmap);
-    }
-    if (pf == B8G8R8X8 || pf == B8G8R8A8) {
-        BitmapPtr pBmp = BitmapPtr(new Bitmap(size, pf));
-        FilterFill<Pixel32>(Pixel32(0,0,0,255)).applyInPlace(pBmp);
-        pCM->scheduleTexUpload(m_pTextures[0], pBmp);
+        bool bMipmap = getMipmap();
+        GLContextManager* pCM = GLContextManager::get();
+        if (pixelFormatIsPlanar(pf)) {
+            m_pTextures[0] = pCM->createTexture(size, I8, bMipmap);
+            IntPoint halfSize(size.x/2, size.y/2);
+            m_pTextures[1] = pCM->createTexture(halfSize, I8, bMipmap, false, 128);
+            m_pTextures[2] = pCM->createTexture(halfSize, I8, bMipmap, false, 128);
+            if (pixelFormatHasAlpha(pf)) {
+                m_pTextures[3] = pCM->createTexture(size, I8, bMipmap);
+            }
+        } else {
+            m_pTextures[0] = pCM->createTexture(size, pf, bMipmap);
+        }
+        if (pf == B8G8R8X8 || pf == B8G8R8A8) {
+            BitmapPtr pBmp = BitmapPtr(new Bitmap(size, pf));
+            FilterFill<Pixel32>(Pixel32(0,0,0,255)).applyInPlace(pBmp);
+            pCM->scheduleTexUpload(m_pTextures[0], pBmp);
+        }
+        if (m_pSharedDecoder) {
+            m_pSharedDecoder->setTextures(m_pTextures);
+        }
     }
     if (pixelFormatIsPlanar(pf)) {
         if (pixelFormatHasAlpha(pf)) {
@@ -545,6 +603,51 @@ void VideoNode::createTextures(IntPoint size)
     newSurface();
 }
 
+void VideoNode::attachSharedDecoder(long long movieTime)
+{
+    m_pSharedDecoder = SharedVideoDecoder::get(m_Filename, m_bUsesHardwareAcceleration,
+            m_QueueLength, m_NumDecoderThreads, m_FPS, getMipmap(), m_bLoop, 
+            movieTime);
+    m_pDecoder = m_pSharedDecoder->getDecoder();
+    m_SharedLoopCount = m_pSharedDecoder->getLoopCount();
+}
+
+void VideoNode::detachSharedDecoder()
+{
+    if (!m_pSharedDecoder.unique()) {
+        // The other nodes would keep advancing the decoder, so we switch to a private
+        // one at our current position.
+        bool bDecoding = (getState() == NS_CANRENDER && m_VideoState != Unloaded);
+        vector<BitmapPtr> pBmps;
+        m_pSharedDecoder->getLastFrame(pBmps);
+        m_pSharedDecoder = SharedVideoDecoder::createPrivate(m_Filename,
+                m_bUsesHardwareAcceleration, m_QueueLength, m_NumDecoderThreads, m_FPS,
+                getMipmap(), m_bLoop, getNextFrameTime());
+        m_pDecoder = m_pSharedDecoder->getDecoder();
+        m_SharedLoopCount = 0;
+        if (bDecoding) {
+            m_pSharedDecoder->startDecoding();
+            createTextures(m_pDecoder->getSize());
+            // Keep showing the current frame until the new decoder has caught up.
+            for (unsigned i = 0; i < pBmps.size(); ++i) {
+                GLContextManager::get()->scheduleTexUpload(m_pTextures[i], pBmps[i]);
+            }
+            m_bFrameAvailable = false;
+            m_bSeekPending = true;
+        }
+    }
+    m_pSharedDecoder->setShared(false);
+}
+
+bool VideoNode::isDecoderEOF() const
+{
+    if (m_pSharedDecoder) {
+        return m_pSharedDecoder->isEOF(m_SharedLoopCount);
+    } else {
+        return m_pDecoder->isEOF();
+    }
+}
+
 void VideoNode::close()
 {
     AudioEngine* pAudioEngine = AudioEngine::get();
@@ -552,7 +655,12 @@ void VideoNode::close()
         pAudioEngine->removeSource(m_AudioID);
         m_AudioID = -1;
     }
-    m_pDecoder->close();
+    if (m_bSharedDecoder) {
+        m_pSharedDecoder = SharedVideoDecoderPtr();
+        m_pDecoder = 0;
+    } else {
+        m_pDecoder->close();
+    }
     if (m_FramesTooLate > 0) {
         string sID;
         if (getID() == "") {
@@ -591,6 +699,11 @@ int VideoNode::getQueueLength() const
     return m_QueueLength;
 }
 
+int VideoNode::getNumDecoderThreads() const
+{
+    return m_NumDecoderThreads;
+}
+
 long long VideoNode::getNextFrameTime() const
 {
     switch (m_VideoState) {
@@ -646,16 +759,26 @@ void VideoNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
 {
     ScopeTimer timer(PrerenderProfilingZone);
     AreaNode::preRender(pVA, bIsParentActive, parentEffectiveOpacity);
+    if (m_pSharedDecoder && !m_pSharedDecoder->isInSync(getNextFrameTime())) {
+        // Our playback position diverged from that of the other nodes using the
+        // decoder.
+        seek(getNextFrameTime());
+    }
     if (isVisible()) {
         if (m_VideoState != Unloaded) {
+            bool bNewFrame = false;
             if (m_VideoState == Playing) {
-                bool bNewFrame = renderFrame();
+                bNewFrame = renderFrame();
                 m_bFrameAvailable |= bNewFrame;
             } else { // Paused
                 if (!m_bFrameAvailable) {
-                    m_bFrameAvailable = renderFrame();
+                    bNewFrame = renderFrame();
+                    m_bFrameAvailable = bNewFrame;
                 }
             }
+            if (bNewFrame) {
+                invalidateRender();
+            }
             m_bFirstFrameDecoded |= m_bFrameAvailable;
             if (m_bFirstFrameDecoded) {
                 scheduleFXRender();
@@ -668,9 +791,13 @@ void VideoNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
         if (m_VideoState == Playing) {
             // Throw away frames that are not visible to make sure the video 
             // stays in sync.
-            m_pDecoder->throwAwayFrame(getNextFrameTime()/1000.0f);
+            if (m_pSharedDecoder) {
+                m_pSharedDecoder->throwAwayFrame(getNextFrameTime());
+            } else {
+                m_pDecoder->throwAwayFrame(getNextFrameTime()/1000.0f);
+            }
 
-            if (m_pDecoder->isEOF()) {
+            if (isDecoderEOF()) {
                 updateStatusDueToDecoderEOF();
             }
         }
@@ -701,7 +828,7 @@ VideoNode::VideoAccelType VideoNode::getVideoAccelConfig()
 bool VideoNode::renderFrame()
 {
     FrameAvailableCode frameAvailable = renderToSurface();
-    if (m_pDecoder->isEOF()) {
+    if (isDecoderEOF()) {
 //        AVG_TRACE(Logger::category::PROFILE, "------------------ EOF -----------------");
         updateStatusDueToDecoderEOF();
         if (m_bLoop) {
@@ -765,19 +892,26 @@ bool VideoNode::renderFrame()
 FrameAvailableCode VideoNode::renderToSurface()
 {
     FrameAvailableCode frameAvailable;
-    PixelFormat pf = m_pDecoder->getPixelFormat();
-    std::vector<BitmapPtr> pBmps;
-    for (unsigned i=0; i<getNumPixelFormatPlanes(pf); ++i) {
-        pBmps.push_back(BitmapPtr());
-    }
-    if (pixelFormatIsPlanar(pf)) {
-        frameAvailable = m_pDecoder->getRenderedBmps(pBmps, getNextFrameTime()/1000.0f);
-    } else {
-        frameAvailable = m_pDecoder->getRenderedBmp(pBmps[0], getNextFrameTime()/1000.0f);
-    }
-    if (frameAvailable == FA_NEW_FRAME) {
+    if (!m_pSharedDecoder || !m_pSharedDecoder->getFrameResult(frameAvailable)) {
+        // Nobody has fetched a frame for the textures in this frame yet.
+        PixelFormat pf = m_pDecoder->getPixelFormat();
+        std::vector<BitmapPtr> pBmps;
         for (unsigned i=0; i<getNumPixelFormatPlanes(pf); ++i) {
-            GLContextManager::get()->scheduleTexUpload(m_pTextures[i], pBmps[i]);
+            pBmps.push_back(BitmapPtr());
+        }
+        long long nextFrameTime = getNextFrameTime();
+        if (pixelFormatIsPlanar(pf)) {
+            frameAvailable = m_pDecoder->getRenderedBmps(pBmps, nextFrameTime/1000.0f);
+        } else {
+            frameAvailable = m_pDecoder->getRenderedBmp(pBmps[0], nextFrameTime/1000.0f);
+        }
+        if (frameAvailable == FA_NEW_FRAME) {
+            for (unsigned i=0; i<getNumPixelFormatPlanes(pf); ++i) {
+                GLContextManager::get()->scheduleTexUpload(m_pTextures[i], pBmps[i]);
+            }
+        }
+        if (m_pSharedDecoder) {
+            m_pSharedDecoder->setFrameResult(frameAvailable, nextFrameTime, pBmps);
         }
     }
 
@@ -823,7 +957,11 @@ void VideoNode::updateStatusDueToDecoderEOF()
         if (m_AudioID != -1) {
             AudioEngine::get()->notifySeek(m_AudioID);
         }
-        m_pDecoder->loop();
+        if (m_pSharedDecoder) {
+            m_SharedLoopCount = m_pSharedDecoder->loop(m_SharedLoopCount);
+        } else {
+            m_pDecoder->loop();
+        }
     } else {
         changeVideoState(Paused);
     }
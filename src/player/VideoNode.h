@@ -42,6 +42,8 @@ class TextureMover;
 typedef boost::shared_ptr<TextureMover> TextureMoverPtr;
 class MCTexture;
 typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+class SharedVideoDecoder;
+typedef boost::shared_ptr<SharedVideoDecoder> SharedVideoDecoderPtr;
 
 class AVG_API VideoNode: public RasterNode, IFrameEndListener
 {
@@ -67,6 +69,7 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         void setVolume(float volume);
         float getFPS() const;
         int getQueueLength() const;
+        int getNumDecoderThreads() const;
         void checkReload();
 
         int getNumFrames() const;
@@ -88,6 +91,7 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         void seekToTime(long long time);
         bool getLoop() const;
         bool isThreaded() const;
+        bool usesSharedDecoder() const;
         bool hasAudio() const;
         bool hasAlpha() const;
         void setEOFCallback(PyObject * pEOFCallback);
@@ -113,6 +117,9 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         void open();
         void startDecoding();
         void createTextures(IntPoint size);
+        void attachSharedDecoder(long long movieTime);
+        void detachSharedDecoder();
+        bool isDecoderEOF() const;
         void close();
         enum VideoState {Unloaded, Paused, Playing};
         void changeVideoState(VideoState NewVideoState);
@@ -132,6 +139,7 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         bool m_bThreaded;
         float m_FPS;
         int m_QueueLength;
+        int m_NumDecoderThreads;
         bool m_bEOFPending;
         PyObject * m_pEOFCallback;
         int m_FramesTooLate;
@@ -145,10 +153,16 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         long long m_PauseStartTime;
         float m_JitterCompensation;
 
+        // The decoder in use: Either m_pOwnDecoder or the shared decoder's. Nodes that
+        // use shared decoders have no decoder of their own.
         VideoDecoder * m_pDecoder;
+        VideoDecoder * m_pOwnDecoder;
+        SharedVideoDecoderPtr m_pSharedDecoder;
+        int m_SharedLoopCount;
         float m_Volume;
         bool m_bUsesHardwareAcceleration;
         bool m_bEnableSound;
+        bool m_bSharedDecoder;
         int m_AudioID;
 
         MCTexturePtr m_pTextures[4];
@@ -28,8 +28,11 @@
 #include "../graphics/FBO.h"
 #include "../graphics/GPURGB2YUVFilter.h"
 #include "../graphics/Filterfill.h"
+#include "../graphics/Filterflip.h"
+#include "../graphics/ReadbackRing.h"
 #include "../graphics/GLContext.h"
 #include "../base/StringHelper.h"
+#include "../base/TimeSource.h"
 
 #include <boost/bind.hpp>
 
@@ -42,20 +45,29 @@ using namespace boost;
 namespace avg {
 
 VideoWriter::VideoWriter(CanvasPtr pCanvas, const string& sOutFileName, int frameRate,
-        int qMin, int qMax, bool bSyncToPlayback)
+        int qMin, int qMax, bool bSyncToPlayback, const string& sCodec,
+        const string& sPixelFormat, const string& sEncoderOptions, int numThreads,
+        int queueLength, bool bDropFrames)
     : m_pCanvas(pCanvas),
       m_sOutFileName(sOutFileName),
       m_FrameRate(frameRate),
       m_QMin(qMin),
       m_QMax(qMax),
+      m_sCodec(sCodec),
+      m_sEncoderOptions(sEncoderOptions),
+      m_NumThreads(numThreads),
+      m_QueueLength(queueLength),
+      m_bDropFrames(bDropFrames),
       m_bHasValidData(false),
+      m_CmdQueue(queueLength),
       m_bSyncToPlayback(bSyncToPlayback),
+      m_pStats(new VideoEncodeStats()),
+      m_NumDroppedFrames(0),
       m_bPaused(false),
       m_PauseTime(0),
       m_bStopped(false),
       m_CurFrame(0),
-      m_StartTime(-1),
-      m_bFramePending(false)
+      m_StartTime(-1)
 {
     if (!pCanvas) {
         throw Exception(AVG_ERR_INVALID_ARGS, "VideoWriter needs a canvas to write to.");
@@ -63,6 +75,12 @@ VideoWriter::VideoWriter(CanvasPtr pCanvas, const string& sOutFileName, int fram
     if (GLContext::getCurrent()->isGLES()) {
         throw Exception(AVG_ERR_UNSUPPORTED, "VideoWriter not supported under GLES.");
     }
+    if (queueLength < 1) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, "VideoWriter: queuelength must be >= 1.");
+    }
+    if (numThreads < 0) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, "VideoWriter: numthreads must be >= 0.");
+    }
 #ifdef WIN32
     int fd = _open(m_sOutFileName.c_str(), O_RDWR | O_CREAT, _S_IREAD | _S_IWRITE);
 #elif defined __linux__
@@ -81,25 +99,40 @@ VideoWriter::VideoWriter(CanvasPtr pCanvas, const string& sOutFileName, int fram
     close(fd);
 #endif
     remove(m_sOutFileName.c_str());
+    m_sPixelFormat = VideoWriterThread::checkEncoderParams(m_sOutFileName, m_sCodec,
+            sPixelFormat, m_sEncoderOptions);
     CanvasPtr pMainCanvas = Player::get()->getMainCanvas();
     DisplayEngine* pDisplayEngine = Player::get()->getDisplayEngine();
+    GLContext* pOldContext = GLContext::getCurrent();
+    m_pMainGLContext = pDisplayEngine->getWindow(0)->getGLContext();
+    m_pMainGLContext->activate();
+    bool bUsePBOs = (m_pMainGLContext->getMemoryMode() == MM_PBO);
     if (pMainCanvas == m_pCanvas) {
         m_FrameSize = pDisplayEngine->getWindowSize();
+        // Multiple windows are composited by DisplayEngine::screenshot().
+        if (bUsePBOs && pDisplayEngine->getNumWindows() == 1) {
+            m_pReadbackRing = ReadbackRingPtr(new ReadbackRing(m_FrameSize, B8G8R8X8,
+                    ReadbackRing::getDefaultNumBuffers()));
+        }
     } else {
         m_FrameSize = m_pCanvas->getSize();
-        GLContext* pOldContext = GLContext::getCurrent();
-        m_pMainGLContext = pDisplayEngine->getWindow(0)->getGLContext();
-        m_pMainGLContext->activate();
         m_pFBO = dynamic_pointer_cast<OffscreenCanvas>(m_pCanvas)->
                 getFBO(m_pMainGLContext);
-        if (GLContext::getCurrent()->useGPUYUVConversion()) {
+        // The GPU conversion delivers full-range yuv 4:2:0 only.
+        if (GLContext::getCurrent()->useGPUYUVConversion() &&
+                m_sPixelFormat == "yuvj420p")
+        {
             m_pFilter = GPURGB2YUVFilterPtr(new GPURGB2YUVFilter(m_FrameSize));
+        } else if (bUsePBOs) {
+            m_pReadbackRing = m_pFBO->createReadbackRing(
+                    ReadbackRing::getDefaultNumBuffers());
         }
-        pOldContext->activate();
     }
+    pOldContext->activate();
     VideoWriterThread writer(m_CmdQueue, m_sOutFileName, m_FrameSize, m_FrameRate, 
-            qMin, qMax);
-    m_pThread = new boost::thread(writer);
+            qMin, qMax, m_sCodec, m_sPixelFormat, m_sEncoderOptions, m_NumThreads,
+            m_pStats);
+    m_pThread = startWorkerThread(writer);
     m_pCanvas->registerPlaybackEndListener(this);
     m_pCanvas->registerFrameEndListener(this);
 }
@@ -109,14 +142,13 @@ VideoWriter::~VideoWriter()
     stop();
     if (m_pThread) {
         m_pThread->join();
-        delete m_pThread;
     }
 }
 
 void VideoWriter::stop()
 {
     if (!m_bStopped) {
-        getFrameFromPBO();
+        getFramesFromReadback(true);
         if (!m_bHasValidData) {
             writeDummyFrame();
         }
@@ -127,8 +159,12 @@ void VideoWriter::stop()
         m_pCanvas->unregisterFrameEndListener(this);
         m_pCanvas->unregisterPlaybackEndListener(this);
 
+        GLContext* pOldContext = GLContext::getCurrent();
+        m_pMainGLContext->activate();
         m_pFBO = FBOPtr();
         m_pFilter = GPURGB2YUVFilterPtr();
+        m_pReadbackRing = ReadbackRingPtr();
+        pOldContext->activate();
     }
 }
 
@@ -174,91 +210,173 @@ int VideoWriter::getQMax() const
     return m_QMax;
 }
 
+std::string VideoWriter::getCodec() const
+{
+    return m_sCodec;
+}
+
+std::string VideoWriter::getPixelFormat() const
+{
+    return m_sPixelFormat;
+}
+
+std::string VideoWriter::getEncoderOptions() const
+{
+    return m_sEncoderOptions;
+}
+
+int VideoWriter::getNumThreads() const
+{
+    return m_NumThreads;
+}
+
+int VideoWriter::getQueueLength() const
+{
+    return m_QueueLength;
+}
+
+bool VideoWriter::getDropFrames() const
+{
+    return m_bDropFrames;
+}
+
+int VideoWriter::getNumDroppedFrames() const
+{
+    return m_NumDroppedFrames;
+}
+
+int VideoWriter::getNumEncodedFrames() const
+{
+    return m_pStats->getNumEncodedFrames();
+}
+
+float VideoWriter::getEncodeLatency() const
+{
+    return m_pStats->getAvgLatency();
+}
+
+float VideoWriter::getMaxEncodeLatency() const
+{
+    return m_pStats->getMaxLatency();
+}
+
 void VideoWriter::onFrameEnd()
 {
-    // The VideoWriter handles OffscreenCanvas and MainCanvas differently:
-    // For MainCanvas, it simply does a screenshot onFrameEnd and sends that to the 
-    // VideoWriterThread immediately.
-    // For OffscreenCanvas, an asynchronous PBO readback is started in onFrameEnd.
-    // In the next frame's onFrameEnd, the data is read into a bitmap and sent to 
-    // the VideoWriterThread.
-    if (m_pFBO) {
-        // Read last frame's bitmap.
-        GLContext* pOldContext = GLContext::getCurrent();
-        m_pMainGLContext->activate();
-        getFrameFromPBO();
-        pOldContext->activate();
-    }
+    // Frames are read back from the GPU asynchronously: onFrameEnd starts a readback
+    // into a ring of PBOs and sends all earlier readbacks that have arrived to the
+    // VideoWriterThread. The number of PBOs is set by scr:readbackbuffers in avgrc.
+    // If PBOs aren't available or several windows are open, the main canvas is read 
+    // synchronously.
+    getFramesFromReadback(false);
     if (m_StartTime == -1) {
         m_StartTime = Player::get()->getFrameTime();
     }
     if (!m_bPaused) {
         if (m_bSyncToPlayback) {
-            getFrameFromFBO();
+            startFrameReadback();
         } else {
             long long movieTime = Player::get()->getFrameTime() - m_StartTime
                     - m_PauseTime;
             float timePerFrame = 1000.f/m_FrameRate;
             int wantedFrame = int(movieTime/timePerFrame+0.1);
             if (wantedFrame > m_CurFrame) {
-                getFrameFromFBO();
-                if (wantedFrame > m_CurFrame + 1) {
-                    m_CurFrame = wantedFrame - 1;
+                startFrameReadback();
+                if (wantedFrame > m_CurFrame) {
+                    m_CurFrame = wantedFrame;
                 }
             }
         }
     }
-    
-    if (!m_pFBO) {
-        getFrameFromPBO();
-    }
 }
 
-void VideoWriter::getFrameFromFBO()
+void VideoWriter::startFrameReadback()
 {
-    if (m_pFBO) {
-        GLContext* pOldContext = GLContext::getCurrent();
-        m_pMainGLContext->activate();
-        if (m_pFilter) {
-            m_pFilter->apply(m_pMainGLContext, m_pFBO->getTex());
-            FBOPtr pYUVFBO = m_pFilter->getFBO(m_pMainGLContext);
-            pYUVFBO->moveToPBO();
+    m_CurFrame++;
+    if (!m_pReadbackRing && !m_pFilter) {
+        if (m_pFBO) {
+            // No PBO support.
+            GLContext* pOldContext = GLContext::getCurrent();
+            m_pMainGLContext->activate();
+            BitmapPtr pBmp = m_pFBO->getImage();
+            pOldContext->activate();
+            sendFrameToEncoder(pBmp);
         } else {
-            m_pFBO->moveToPBO();
+            BitmapPtr pBmp = Player::get()->getDisplayEngine()->screenshot(GL_BACK);
+            sendFrameToEncoder(pBmp);
         }
-        pOldContext->activate();
-        m_bFramePending = true;
+        return;
+    }
+    GLContext* pOldContext = GLContext::getCurrent();
+    m_pMainGLContext->activate();
+    if (isReadbackFull()) {
+        // The GPU is more than readbackbuffers frames behind.
+        sendFrameToEncoder(getReadbackImage(true));
+    }
+    if (m_pFilter) {
+        m_pFilter->apply(m_pMainGLContext, m_pFBO->getTex());
+        m_pFilter->startImageReadback(m_pMainGLContext);
+    } else if (m_pFBO) {
+        m_pFBO->startReadback(*m_pReadbackRing);
     } else {
-        BitmapPtr pBmp = Player::get()->getDisplayEngine()->screenshot(GL_BACK);
+        Player::get()->getDisplayEngine()->getWindow(0)->startReadback(
+                *m_pReadbackRing, GL_BACK);
+    }
+    pOldContext->activate();
+}
+
+void VideoWriter::getFramesFromReadback(bool bWait)
+{
+    if (!m_pReadbackRing && !m_pFilter) {
+        return;
+    }
+    GLContext* pOldContext = GLContext::getCurrent();
+    m_pMainGLContext->activate();
+    BitmapPtr pBmp = getReadbackImage(bWait);
+    while (pBmp) {
         sendFrameToEncoder(pBmp);
+        pBmp = getReadbackImage(bWait);
     }
+    pOldContext->activate();
 }
 
-void VideoWriter::getFrameFromPBO()
+BitmapPtr VideoWriter::getReadbackImage(bool bWait)
 {
-    if (m_bFramePending) {
-        BitmapPtr pBmp;
-        GLContext* pOldContext = GLContext::getCurrent();
-        m_pMainGLContext->activate();
-        if (m_pFilter) {
-            pBmp = m_pFilter->getFBO(m_pMainGLContext)->getImageFromPBO();
-        } else {
-            pBmp = m_pFBO->getImageFromPBO();
+    if (m_pFilter) {
+        return m_pFilter->getReadbackImage(bWait);
+    } else {
+        BitmapPtr pBmp = m_pReadbackRing->getImage(bWait);
+        if (pBmp && !m_pFBO) {
+            FilterFlip().applyInPlace(pBmp);
         }
-            pOldContext->activate();
-        sendFrameToEncoder(pBmp);
-        m_bFramePending = false;
+        return pBmp;
+    }
+}
+
+bool VideoWriter::isReadbackFull() const
+{
+    if (m_pFilter) {
+        return m_pFilter->isReadbackFull();
+    } else {
+        return m_pReadbackRing->isFull();
     }
 }
 
 void VideoWriter::sendFrameToEncoder(BitmapPtr pBitmap)
 {
-    m_CurFrame++;
+    // Only this thread pushes, so the queue can't fill up between check and push.
+    // If frames aren't dropped, pushCmd() blocks until the encoder catches up.
+    if (m_bDropFrames && m_CmdQueue.size() >= m_QueueLength) {
+        m_NumDroppedFrames++;
+        return;
+    }
     m_bHasValidData = true;
+    long long submitTime = TimeSource::get()->getCurrentMicrosecs();
     if (m_pFilter) {
-        m_CmdQueue.pushCmd(boost::bind(&VideoWriterThread::encodeYUVFrame, _1, pBitmap));
+        m_CmdQueue.pushCmd(boost::bind(&VideoWriterThread::encodeYUVFrame, _1, pBitmap,
+                submitTime));
     } else {
-        m_CmdQueue.pushCmd(boost::bind(&VideoWriterThread::encodeFrame, _1, pBitmap));
+        m_CmdQueue.pushCmd(boost::bind(&VideoWriterThread::encodeFrame, _1, pBitmap,
+                submitTime));
     }
 }
 
@@ -266,8 +384,7 @@ void VideoWriter::onPlaybackEnd()
 {
     stop();
     m_pThread->join();
-    delete m_pThread;
-    m_pThread = 0;
+    m_pThread = WorkerHandlePtr();
 }
 
 void VideoWriter::writeDummyFrame()
@@ -29,6 +29,7 @@
 #include "../base/IFrameEndListener.h"
 #include "../base/IPlaybackEndListener.h"
 #include "../base/GLMHelper.h"
+#include "../base/WorkerHandle.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
@@ -44,12 +45,17 @@ typedef boost::shared_ptr<FBO> FBOPtr;
 class GPURGB2YUVFilter;
 typedef boost::shared_ptr<GPURGB2YUVFilter> GPURGB2YUVFilterPtr;
 class GLContext;
+class ReadbackRing;
+typedef boost::shared_ptr<ReadbackRing> ReadbackRingPtr;
 
 class AVG_API VideoWriter : public IFrameEndListener, IPlaybackEndListener  
 {
     public:
         VideoWriter(CanvasPtr pCanvas, const std::string& sOutFileName,
-                int frameRate=30, int qMin=3, int qMax=5, bool bSyncToPlayback=true);
+                int frameRate=30, int qMin=3, int qMax=5, bool bSyncToPlayback=true,
+                const std::string& sCodec="mjpeg", const std::string& sPixelFormat="",
+                const std::string& sEncoderOptions="", int numThreads=0,
+                int queueLength=8, bool bDropFrames=false);
         virtual ~VideoWriter();
         void stop();
         void pause();
@@ -59,13 +65,26 @@ class AVG_API VideoWriter : public IFrameEndListener, IPlaybackEndListener
         int getFramerate() const;
         int getQMin() const;
         int getQMax() const;
+        std::string getCodec() const;
+        std::string getPixelFormat() const;
+        std::string getEncoderOptions() const;
+        int getNumThreads() const;
+        int getQueueLength() const;
+        bool getDropFrames() const;
+
+        int getNumDroppedFrames() const;
+        int getNumEncodedFrames() const;
+        float getEncodeLatency() const;
+        float getMaxEncodeLatency() const;
 
         virtual void onFrameEnd();
         virtual void onPlaybackEnd();
 
     private:
-        void getFrameFromFBO();
-        void getFrameFromPBO();
+        void startFrameReadback();
+        void getFramesFromReadback(bool bWait);
+        BitmapPtr getReadbackImage(bool bWait);
+        bool isReadbackFull() const;
 
         void sendFrameToEncoder(BitmapPtr pBitmap);
         void writeDummyFrame();
@@ -74,17 +93,26 @@ class AVG_API VideoWriter : public IFrameEndListener, IPlaybackEndListener
         GLContext* m_pMainGLContext;
         FBOPtr m_pFBO;
         GPURGB2YUVFilterPtr m_pFilter;
+        ReadbackRingPtr m_pReadbackRing;
         std::string m_sOutFileName;
         int m_FrameRate;
         int m_QMin;
         int m_QMax;
+        std::string m_sCodec;
+        std::string m_sPixelFormat;
+        std::string m_sEncoderOptions;
+        int m_NumThreads;
+        int m_QueueLength;
+        bool m_bDropFrames;
         IntPoint m_FrameSize;
 
         bool m_bHasValidData;
 
         VideoWriterThread::CQueue m_CmdQueue;
-        boost::thread* m_pThread;
+        WorkerHandlePtr m_pThread;
         bool m_bSyncToPlayback;
+        VideoEncodeStatsPtr m_pStats;
+        int m_NumDroppedFrames;
 
         bool m_bPaused;
         long long m_PauseStartTime;
@@ -94,7 +122,6 @@ class AVG_API VideoWriter : public IFrameEndListener, IPlaybackEndListener
 
         int m_CurFrame;
         long long m_StartTime;
-        bool m_bFramePending;
 };
 
 }
@@ -25,6 +25,7 @@
 #include "../base/ProfilingZoneID.h"
 #include "../base/ScopeTimer.h"
 #include "../base/StringHelper.h"
+#include "../base/TimeSource.h"
 #include "../video/VideoDecoder.h"
 
 #if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(55, 18, 102)
@@ -39,16 +40,122 @@ namespace avg {
 const unsigned int VIDEO_BUFFER_SIZE = 400000;
 #endif
 
-const AVPixelFormat STREAM_PIXEL_FORMAT = ::PIX_FMT_YUVJ420P;
+VideoEncodeStats::VideoEncodeStats()
+    : m_NumEncodedFrames(0),
+      m_TotalLatency(0),
+      m_MaxLatency(0)
+{
+}
+
+void VideoEncodeStats::addFrame(long long latency)
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    m_NumEncodedFrames++;
+    m_TotalLatency += latency;
+    if (latency > m_MaxLatency) {
+        m_MaxLatency = latency;
+    }
+}
+
+int VideoEncodeStats::getNumEncodedFrames() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_NumEncodedFrames;
+}
+
+float VideoEncodeStats::getAvgLatency() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    if (m_NumEncodedFrames == 0) {
+        return 0;
+    }
+    return float(m_TotalLatency)/m_NumEncodedFrames/1000;
+}
+
+float VideoEncodeStats::getMaxLatency() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return float(m_MaxLatency)/1000;
+}
+
+static AVCodec* findEncoder(const string& sCodec)
+{
+    AVCodec* pCodec = avcodec_find_encoder_by_name(sCodec.c_str());
+    if (!pCodec && sCodec == "h264") {
+        pCodec = avcodec_find_encoder_by_name("libx264");
+    }
+    if (pCodec && pCodec->type != AVMEDIA_TYPE_VIDEO) {
+        pCodec = 0;
+    }
+    return pCodec;
+}
+
+static bool isPixelFormatSupported(AVCodec* pCodec, AVPixelFormat pf)
+{
+    if (!pCodec->pix_fmts) {
+        return true;
+    }
+    for (const AVPixelFormat* pCurPF = pCodec->pix_fmts; *pCurPF != PIX_FMT_NONE;
+            ++pCurPF)
+    {
+        if (*pCurPF == pf) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static AVPixelFormat getStreamPixelFormat(AVCodec* pCodec, const string& sPixelFormat)
+{
+    if (sPixelFormat == "") {
+        // Full-range 4:2:0 is what the GPU color conversion delivers.
+        if (isPixelFormatSupported(pCodec, ::PIX_FMT_YUVJ420P)) {
+            return ::PIX_FMT_YUVJ420P;
+        }
+        return pCodec->pix_fmts[0];
+    }
+    AVPixelFormat pf = av_get_pix_fmt(sPixelFormat.c_str());
+    if (pf == PIX_FMT_NONE) {
+        throw Exception(AVG_ERR_INVALID_ARGS,
+                "VideoWriter: Unknown pixel format '" + sPixelFormat + "'.");
+    }
+    if (!isPixelFormatSupported(pCodec, pf) || !sws_isSupportedOutput(pf)) {
+        throw Exception(AVG_ERR_INVALID_ARGS, string("VideoWriter: Codec '") +
+                pCodec->name + "' can't encode pixel format '" + sPixelFormat + "'.");
+    }
+    return pf;
+}
+
+static AVDictionary* parseEncoderOptions(const string& sEncoderOptions)
+{
+    AVDictionary* pOptions = 0;
+    if (sEncoderOptions != "") {
+        int rc = av_dict_parse_string(&pOptions, sEncoderOptions.c_str(), "=", ":", 0);
+        if (rc < 0) {
+            av_dict_free(&pOptions);
+            throw Exception(AVG_ERR_INVALID_ARGS,
+                    "VideoWriter: Could not parse encoder options '" + sEncoderOptions
+                    + "'.");
+        }
+    }
+    return pOptions;
+}
 
 VideoWriterThread::VideoWriterThread(CQueue& cmdQueue, const string& sFilename,
-        IntPoint size, int frameRate, int qMin, int qMax)
+        IntPoint size, int frameRate, int qMin, int qMax, const string& sCodec,
+        const string& sPixelFormat, const string& sEncoderOptions, int numThreads,
+        VideoEncodeStatsPtr pStats)
     : WorkerThread<VideoWriterThread>(sFilename, cmdQueue, Logger::category::PROFILE),
       m_sFilename(sFilename),
       m_Size(size),
       m_FrameRate(frameRate),
       m_QMin(qMin),
       m_QMax(qMax),
+      m_sCodec(sCodec),
+      m_StreamPixelFormat(av_get_pix_fmt(sPixelFormat.c_str())),
+      m_sEncoderOptions(sEncoderOptions),
+      m_NumThreads(numThreads),
+      m_pStats(pStats),
       m_pOutputFormatContext()
 {
 }
@@ -57,27 +164,59 @@ VideoWriterThread::~VideoWriterThread()
 {
 }
 
+string VideoWriterThread::checkEncoderParams(const string& sFilename,
+        const string& sCodec, const string& sPixelFormat, const string& sEncoderOptions)
+{
+    lock_guard lock(VideoDecoder::s_OpenMutex);
+    av_register_all();
+    AVOutputFormat* pOutputFormat = av_guess_format(0, sFilename.c_str(), 0);
+    if (!pOutputFormat) {
+        throw Exception(AVG_ERR_VIDEO_INIT_FAILED,
+                "VideoWriter: Could not deduce a file format from '" + sFilename + "'.");
+    }
+    AVCodec* pCodec = findEncoder(sCodec);
+    if (!pCodec) {
+        throw Exception(AVG_ERR_VIDEO_INIT_FAILED,
+                "VideoWriter: No encoder for codec '" + sCodec + "' available.");
+    }
+    if (avformat_query_codec(pOutputFormat, pCodec->id, FF_COMPLIANCE_NORMAL) == 0) {
+        throw Exception(AVG_ERR_VIDEO_INIT_FAILED, string("VideoWriter: Codec '") +
+                pCodec->name + "' can't be stored in '" + sFilename + "'.");
+    }
+    AVPixelFormat pf = getStreamPixelFormat(pCodec, sPixelFormat);
+    AVDictionary* pOptions = parseEncoderOptions(sEncoderOptions);
+    av_dict_free(&pOptions);
+    return av_get_pix_fmt_name(pf);
+}
+
 static ProfilingZoneID ProfilingZoneEncodeFrame("Encode frame", true);
 
-void VideoWriterThread::encodeYUVFrame(BitmapPtr pBmp)
+void VideoWriterThread::encodeYUVFrame(BitmapPtr pBmp, long long submitTime)
 {
-    ScopeTimer timer(ProfilingZoneEncodeFrame);
-    convertYUVImage(pBmp);
-    writeFrame(m_pConvertedFrame);
+    {
+        ScopeTimer timer(ProfilingZoneEncodeFrame);
+        convertYUVImage(pBmp);
+        writeFrame(m_pConvertedFrame);
+    }
+    addFrameStats(submitTime);
     ThreadProfiler::get()->reset();
 }
 
-void VideoWriterThread::encodeFrame(BitmapPtr pBmp)
+void VideoWriterThread::encodeFrame(BitmapPtr pBmp, long long submitTime)
 {
-    ScopeTimer timer(ProfilingZoneEncodeFrame);
-    convertRGBImage(pBmp);
-    writeFrame(m_pConvertedFrame);
+    {
+        ScopeTimer timer(ProfilingZoneEncodeFrame);
+        convertRGBImage(pBmp);
+        writeFrame(m_pConvertedFrame);
+    }
+    addFrameStats(submitTime);
     ThreadProfiler::get()->reset();
 }
 
 void VideoWriterThread::close()
 {
     if (m_pOutputFormatContext) {
+        flushEncoder();
         av_write_trailer(m_pOutputFormatContext);
         lock_guard lock(VideoDecoder::s_OpenMutex);
         avcodec_close(m_pVideoStream->codec);
@@ -102,6 +241,12 @@ void VideoWriterThread::close()
         av_free(m_pPictureBuffer);
         sws_freeContext(m_pFrameConversionContext);
         m_pOutputFormatContext = 0;
+
+        AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                "VideoWriter '" << m_sFilename << "': " << 
+                m_pStats->getNumEncodedFrames() << " frames encoded, latency avg " <<
+                m_pStats->getAvgLatency() << " ms, max " << m_pStats->getMaxLatency() <<
+                " ms.");
     }
 }
 
@@ -128,7 +273,8 @@ void VideoWriterThread::open()
     av_register_all(); // TODO: make sure this is only done once. 
 //    av_log_set_level(AV_LOG_DEBUG);
     m_pOutputFormat = av_guess_format(0, m_sFilename.c_str(), 0);
-    m_pOutputFormat->video_codec = AV_CODEC_ID_MJPEG;
+    m_pCodec = findEncoder(m_sCodec);
+    AVG_ASSERT(m_pOutputFormat && m_pCodec);
 
     m_pOutputFormatContext = avformat_alloc_context();
     m_pOutputFormatContext->oformat = m_pOutputFormat;
@@ -136,9 +282,7 @@ void VideoWriterThread::open()
     strncpy(m_pOutputFormatContext->filename, m_sFilename.c_str(),
             sizeof(m_pOutputFormatContext->filename));
 
-    if (m_pOutputFormat->video_codec != AV_CODEC_ID_NONE) {
-        setupVideoStream();
-    }
+    setupVideoStream();
 
     float muxMaxDelay = 0.7;
     m_pOutputFormatContext->max_delay = int(muxMaxDelay * AV_TIME_BASE);
@@ -164,10 +308,10 @@ void VideoWriterThread::open()
     }
 
     m_pFrameConversionContext = sws_getContext(m_Size.x, m_Size.y, 
-            ::PIX_FMT_RGB32, m_Size.x, m_Size.y, STREAM_PIXEL_FORMAT, 
+            ::PIX_FMT_RGB32, m_Size.x, m_Size.y, m_StreamPixelFormat, 
             SWS_BILINEAR, NULL, NULL, NULL);
 
-    m_pConvertedFrame = createFrame(STREAM_PIXEL_FORMAT, m_Size);
+    m_pConvertedFrame = createFrame(m_StreamPixelFormat, m_Size);
 
     avformat_write_header(m_pOutputFormatContext, 0);
 }
@@ -177,7 +321,7 @@ void VideoWriterThread::setupVideoStream()
     m_pVideoStream = avformat_new_stream(m_pOutputFormatContext, 0);
 
     AVCodecContext* pCodecContext = m_pVideoStream->codec;
-    pCodecContext->codec_id = static_cast<AVCodecID>(m_pOutputFormat->video_codec);
+    pCodecContext->codec_id = static_cast<AVCodecID>(m_pCodec->id);
     pCodecContext->codec_type = AVMEDIA_TYPE_VIDEO;
 
     /* put sample parameters */
@@ -192,10 +336,14 @@ void VideoWriterThread::setupVideoStream()
     pCodecContext->time_base.den = m_FrameRate;
     pCodecContext->time_base.num = 1;
 //    pCodecContext->gop_size = 12; /* emit one intra frame every twelve frames at most */
-    pCodecContext->pix_fmt = STREAM_PIXEL_FORMAT;
+    pCodecContext->pix_fmt = m_StreamPixelFormat;
     // Quality of quantization
     pCodecContext->qmin = m_QMin;
     pCodecContext->qmax = m_QMax;
+    // Encode several frames in parallel if the codec supports it, slices otherwise.
+    // 0 threads means one per cpu core.
+    pCodecContext->thread_count = m_NumThreads;
+    pCodecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
     // some formats want stream headers to be separate
     if (m_pOutputFormatContext->oformat->flags & AVFMT_GLOBALHEADER) {
         pCodecContext->flags |= CODEC_FLAG_GLOBAL_HEADER;
@@ -205,10 +353,18 @@ void VideoWriterThread::setupVideoStream()
 
 void VideoWriterThread::openVideoCodec()
 {
-    AVCodec* videoCodec = avcodec_find_encoder(m_pVideoStream->codec->codec_id);
-    AVG_ASSERT(videoCodec);
-
-    int rc = avcodec_open2(m_pVideoStream->codec, videoCodec, 0);
+    AVDictionary* pOptions = parseEncoderOptions(m_sEncoderOptions);
+    int rc = avcodec_open2(m_pVideoStream->codec, m_pCodec, &pOptions);
+    AVDictionaryEntry* pEntry = 0;
+    while ((pEntry = av_dict_get(pOptions, "", pEntry, AV_DICT_IGNORE_SUFFIX))) {
+        AVG_TRACE(Logger::category::VIDEO, Logger::severity::WARNING,
+                "VideoWriter: Unknown encoder option '" << pEntry->key << "' ignored.");
+    }
+    av_dict_free(&pOptions);
+    if (rc < 0) {
+        AVG_TRACE(Logger::category::VIDEO, Logger::severity::ERROR,
+                getAVErrorString(rc));
+    }
     AVG_ASSERT(rc == 0);
 }
 
@@ -222,6 +378,10 @@ AVFrame* VideoWriterThread::createFrame(AVPixelFormat pixelFormat, IntPoint size
     m_pPictureBuffer = static_cast<unsigned char*>(av_malloc(memNeeded));
     avpicture_fill(reinterpret_cast<AVPicture*>(pPicture),
             m_pPictureBuffer, pixelFormat, size.x, size.y);
+    // Needed by frame-threaded encoders, which copy the frame.
+    pPicture->width = size.x;
+    pPicture->height = size.y;
+    pPicture->format = pixelFormat;
 
     return pPicture;
 }
@@ -282,54 +442,80 @@ static ProfilingZoneID ProfilingZoneWriteFrame(" Write frame", true);
 void VideoWriterThread::writeFrame(AVFrame* pFrame)
 {
     ScopeTimer timer(ProfilingZoneWriteFrame);
+    pFrame->pts = m_FramesWritten;
     m_FramesWritten++;
     AVCodecContext* pCodecContext = m_pVideoStream->codec;
     AVPacket packet = { 0 };
-    int ret;
-    bool bGotOutput;
 
 #if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(54, 0, 0)
     av_init_packet(&packet);
     int got_output = 0;
-    ret = avcodec_encode_video2(pCodecContext, &packet, pFrame, &got_output);
+    int ret = avcodec_encode_video2(pCodecContext, &packet, pFrame, &got_output);
     AVG_ASSERT(ret >= 0);
-    if ((pCodecContext->coded_frame->pts) != (long long)AV_NOPTS_VALUE) {
-        packet.pts = av_rescale_q(pCodecContext->coded_frame->pts,
-                pCodecContext->time_base, m_pVideoStream->time_base);
+    if (got_output) {
+        writePacket(&packet);
     }
-    bGotOutput = (got_output != 0);
 #else
     int out_size = avcodec_encode_video(pCodecContext, m_pVideoBuffer,
             VIDEO_BUFFER_SIZE, pFrame);
     if (out_size > 0) {
         av_init_packet(&packet);
-
-        if ((pCodecContext->coded_frame->pts) != (long long)AV_NOPTS_VALUE) {
-            packet.pts = av_rescale_q(pCodecContext->coded_frame->pts,
-                    pCodecContext->time_base, m_pVideoStream->time_base);
-        }
-
+        packet.pts = pCodecContext->coded_frame->pts;
         if (pCodecContext->coded_frame->key_frame) {
             packet.flags |= AV_PKT_FLAG_KEY;
         }
-        packet.stream_index = m_pVideoStream->index;
         packet.data = m_pVideoBuffer;
         packet.size = out_size;
+        writePacket(&packet);
     }
-    bGotOutput = (out_size > 0);
 #endif
-    if (bGotOutput) {
-        /* write the compressed frame in the media file */
-        ret = av_interleaved_write_frame(m_pOutputFormatContext, &packet);
-        av_free_packet(&packet);
-        if (ret != 0) {
-            AVG_TRACE(Logger::category::VIDEO, Logger::severity::ERROR,
-                    getAVErrorString(ret));
+}
+
+void VideoWriterThread::flushEncoder()
+{
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(54, 0, 0)
+    // Frame-threaded and B-frame encoders hold back frames until they get a null frame.
+    AVCodecContext* pCodecContext = m_pVideoStream->codec;
+    int got_output;
+    do {
+        AVPacket packet = { 0 };
+        av_init_packet(&packet);
+        got_output = 0;
+        int ret = avcodec_encode_video2(pCodecContext, &packet, 0, &got_output);
+        AVG_ASSERT(ret >= 0);
+        if (got_output) {
+            writePacket(&packet);
         }
-        AVG_ASSERT(ret == 0);
-    }
+    } while (got_output);
+#endif
+}
 
+void VideoWriterThread::writePacket(AVPacket* pPacket)
+{
+    AVCodecContext* pCodecContext = m_pVideoStream->codec;
+    if (pPacket->pts != (long long)AV_NOPTS_VALUE) {
+        pPacket->pts = av_rescale_q(pPacket->pts, pCodecContext->time_base,
+                m_pVideoStream->time_base);
+    }
+    if (pPacket->dts != (long long)AV_NOPTS_VALUE) {
+        pPacket->dts = av_rescale_q(pPacket->dts, pCodecContext->time_base,
+                m_pVideoStream->time_base);
+    }
+    pPacket->stream_index = m_pVideoStream->index;
+
+    /* write the compressed frame in the media file */
+    int ret = av_interleaved_write_frame(m_pOutputFormatContext, pPacket);
+    av_free_packet(pPacket);
+    if (ret != 0) {
+        AVG_TRACE(Logger::category::VIDEO, Logger::severity::ERROR,
+                getAVErrorString(ret));
+    }
+    AVG_ASSERT(ret == 0);
 }
 
+void VideoWriterThread::addFrameStats(long long submitTime)
+{
+    m_pStats->addFrame(TimeSource::get()->getCurrentMicrosecs() - submitTime);
 }
 
+}
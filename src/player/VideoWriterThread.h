@@ -36,14 +36,42 @@
 
 namespace avg {
 
+// Encoder statistics. Written by the VideoWriterThread, read by the VideoWriter.
+class AVG_API VideoEncodeStats {
+    public:
+        VideoEncodeStats();
+
+        void addFrame(long long latency);
+        int getNumEncodedFrames() const;
+        // Time between submission of a frame and the encoder accepting it, in ms.
+        float getAvgLatency() const;
+        float getMaxLatency() const;
+
+    private:
+        mutable boost::mutex m_Mutex;
+        int m_NumEncodedFrames;
+        long long m_TotalLatency;
+        long long m_MaxLatency;
+};
+
+typedef boost::shared_ptr<VideoEncodeStats> VideoEncodeStatsPtr;
+
 class AVG_API VideoWriterThread : public WorkerThread<VideoWriterThread>  {
     public:
         VideoWriterThread(CQueue& cmdQueue, const std::string& sFilename, IntPoint size,
-                int frameRate, int qMin, int qMax);
+                int frameRate, int qMin, int qMax, const std::string& sCodec,
+                const std::string& sPixelFormat, const std::string& sEncoderOptions,
+                int numThreads, VideoEncodeStatsPtr pStats);
         virtual ~VideoWriterThread();
 
-        void encodeYUVFrame(BitmapPtr pBmp);
-        void encodeFrame(BitmapPtr pBmp);
+        // Checks the encoder parameters and returns the pixel format that will be
+        // written. Throws if the parameters can't be used to write sFilename.
+        static std::string checkEncoderParams(const std::string& sFilename,
+                const std::string& sCodec, const std::string& sPixelFormat,
+                const std::string& sEncoderOptions);
+
+        void encodeYUVFrame(BitmapPtr pBmp, long long submitTime);
+        void encodeFrame(BitmapPtr pBmp, long long submitTime);
         void close();
 
     private:
@@ -62,13 +90,22 @@ class AVG_API VideoWriterThread : public WorkerThread<VideoWriterThread>  {
         void convertRGBImage(BitmapPtr pSrcBmp);
         void convertYUVImage(BitmapPtr pSrcBmp);
         void writeFrame(AVFrame* pFrame);
+        void flushEncoder();
+        void writePacket(AVPacket* pPacket);
+        void addFrameStats(long long submitTime);
 
         std::string m_sFilename;
         IntPoint m_Size;
         int m_FrameRate;
         int m_QMin;
         int m_QMax;
+        std::string m_sCodec;
+        AVPixelFormat m_StreamPixelFormat;
+        std::string m_sEncoderOptions;
+        int m_NumThreads;
+        VideoEncodeStatsPtr m_pStats;
         
+        AVCodec* m_pCodec;
         AVOutputFormat* m_pOutputFormat;
         AVFormatContext* m_pOutputFormatContext;
         AVStream* m_pVideoStream;
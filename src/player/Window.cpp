@@ -43,6 +43,7 @@
 #include "../graphics/Filterflip.h"
 #include "../graphics/Filterfliprgb.h"
 #include "../graphics/ImageCache.h"
+#include "../graphics/ReadbackRing.h"
 
 #ifdef WIN32
 #undef WIN32_LEAN_AND_MEAN
@@ -87,18 +88,7 @@ BitmapPtr Window::screenshot(int buffer)
     } else {
 #ifndef AVG_ENABLE_EGL
         pBmp = BitmapPtr(new Bitmap(m_Size, B8G8R8X8, "screenshot"));
-        string sTmp;
-        bool bBroken = getEnv("AVG_BROKEN_READBUFFER", sTmp);
-        GLenum buf = buffer;
-        if (!buffer) {
-            if (bBroken) {
-                // Workaround for buggy GL_FRONT on some machines.
-                buf = GL_BACK;
-            } else {
-                buf = GL_FRONT;
-            }
-        }
-        glReadBuffer(buf);
+        glReadBuffer(getReadBuffer(buffer));
         GLContext::checkError("Window::screenshot:glReadBuffer()");
         glproc::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
         glReadPixels(0, 0, m_Size.x, m_Size.y, GL_BGRA, GL_UNSIGNED_BYTE, 
@@ -110,6 +100,35 @@ BitmapPtr Window::screenshot(int buffer)
     return pBmp;
 }
 
+void Window::startReadback(ReadbackRing& ring, int buffer)
+{
+    AVG_ASSERT(m_pGLContext && !m_pGLContext->isGLES());
+    AVG_ASSERT(ring.getSize() == m_Size && ring.getPF() == B8G8R8X8);
+#ifndef AVG_ENABLE_EGL
+    m_pGLContext->activate();
+    glproc::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    glReadBuffer(getReadBuffer(buffer));
+    GLContext::checkError("Window::startReadback:glReadBuffer()");
+    ring.startReadback();
+#endif
+}
+
+unsigned Window::getReadBuffer(int buffer) const
+{
+#ifndef AVG_ENABLE_EGL
+    if (!buffer) {
+        string sTmp;
+        if (getEnv("AVG_BROKEN_READBUFFER", sTmp)) {
+            // Workaround for buggy GL_FRONT on some machines.
+            return GL_BACK;
+        } else {
+            return GL_FRONT;
+        }
+    }
+#endif
+    return buffer;
+}
+
 const IntPoint& Window::getPos() const
 {
     return m_Pos;
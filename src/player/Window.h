@@ -44,6 +44,7 @@ namespace avg {
 class Bitmap;
 typedef boost::shared_ptr<class Bitmap> BitmapPtr;
 class GLContext;
+class ReadbackRing;
 
 class AVG_API Window
 {
@@ -54,6 +55,8 @@ class AVG_API Window
         virtual void setTitle(const std::string& sTitle) = 0;
         virtual void swapBuffers() const = 0;
         BitmapPtr screenshot(int buffer=0);
+        // Asynchronous screenshot. The image in the ring is upside down.
+        void startReadback(ReadbackRing& ring, int buffer=0);
 
         const IntPoint& getPos() const;
         const IntPoint& getSize() const;
@@ -76,6 +79,8 @@ class AVG_API Window
         void setGLContext(GLContext* pGLContext);
 
     private:
+        unsigned getReadBuffer(int buffer) const;
+
         bool m_bIsFullscreen;
         IntPoint m_Pos;
         IntPoint m_Size;
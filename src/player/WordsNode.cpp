@@ -24,6 +24,7 @@
 #include "TypeDefinition.h"
 #include "TypeRegistry.h"
 #include "TextEngine.h"
+#include "GlyphAtlas.h"
 #include "Canvas.h"
 
 #include "../base/Logger.h"
@@ -39,10 +40,13 @@
 #include "../graphics/GLContextManager.h"
 #include "../graphics/GLTexture.h"
 #include "../graphics/TextureMover.h"
+#include "../graphics/StandardShader.h"
+#include "../graphics/VertexArray.h"
 
 #include <pango/pangoft2.h>
 
 #include <iostream>
+#include <sstream>
 #include <algorithm>
 
 using namespace std;
@@ -107,6 +111,8 @@ void WordsNode::registerType()
                 offsetof(WordsNode, m_bRawTextMode)))
         .addArg(Arg<float>("letterspacing", 0))
         .addArg(Arg<bool>("hint", true))
+        .addArg(Arg<bool>("glyphatlas", false, false, 
+                offsetof(WordsNode, m_bGlyphAtlas)))
         .addArg(Arg<FontStyle>("fontstyle", FontStyle()))
         ;
     TypeRegistry::get()->registerType(def);
@@ -114,9 +120,14 @@ void WordsNode::registerType()
 
 WordsNode::WordsNode(const ArgList& args)
     : m_LogicalSize(0,0),
+      m_AlignOffset(0),
       m_pFontDescription(0),
       m_pLayout(0),
-      m_bRenderNeeded(true)
+      m_bRenderNeeded(true),
+      m_bGlyphAtlas(false),
+      m_bUsingGlyphAtlas(false),
+      m_GlyphAtlasGeneration(0),
+      m_bGlyphVADirty(true)
 {
     m_bParsedText = false;
     args.setMembers(this);
@@ -221,6 +232,19 @@ void WordsNode::setHint(bool bHint)
     updateLayout();
 }
 
+bool WordsNode::getGlyphAtlas() const
+{
+    return m_bGlyphAtlas;
+}
+
+void WordsNode::setGlyphAtlas(bool bGlyphAtlas)
+{
+    if (bGlyphAtlas != m_bGlyphAtlas) {
+        m_bGlyphAtlas = bGlyphAtlas;
+        m_bRenderNeeded = true;
+    }
+}
+
 float WordsNode::getWidth() const
 {
     return AreaNode::getWidth();
@@ -537,55 +561,17 @@ void WordsNode::updateLayout()
         m_bRenderNeeded = true;
     } else {
         TextEngine& engine = TextEngine::get(m_FontStyle.getHint());
-        PangoContext* pContext = engine.getPangoContext();
-        pango_context_set_font_description(pContext, m_pFontDescription);
-
+        m_sLayoutKey = createLayoutKey(m_bParsedText);
+        PangoLayout* pLayout = engine.getCachedLayout(m_sLayoutKey);
+        if (!pLayout) {
+            pLayout = createLayout(engine.getPangoContext());
+            engine.addCachedLayout(m_sLayoutKey, pLayout);
+        }
         if (m_pLayout) {
             g_object_unref(m_pLayout);
         }
-        m_pLayout = pango_layout_new(pContext);
-
-        PangoAttrList * pAttrList = 0;
-#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2) 
-        PangoAttribute * pLetterSpacing = pango_attr_letter_spacing_new
-            (int(m_FontStyle.getLetterSpacing()*1024));
-#endif
-        if (m_bParsedText) {
-            char * pText = 0;
-            parseString(&pAttrList, &pText);
-#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2) 
-            // Workaround for pango bug.
-            pango_attr_list_insert_before(pAttrList, pLetterSpacing);
-#endif            
-            pango_layout_set_text(m_pLayout, pText, -1);
-            g_free(pText);
-        } else {
-            pAttrList = pango_attr_list_new();
-#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2) 
-            pango_attr_list_insert_before(pAttrList, pLetterSpacing);
-#endif
-            pango_layout_set_text(m_pLayout, m_sText.c_str(), -1);
-        }
-        pango_layout_set_attributes(m_pLayout, pAttrList);
-        pango_attr_list_unref(pAttrList);
+        m_pLayout = pLayout;
 
-        pango_layout_set_wrap(m_pLayout, m_FontStyle.getWrapModeVal());
-        pango_layout_set_alignment(m_pLayout, m_FontStyle.getAlignmentVal());
-        pango_layout_set_justify(m_pLayout, m_FontStyle.getJustify());
-        if (getUserSize().x != 0) {
-            pango_layout_set_width(m_pLayout, int(getUserSize().x * PANGO_SCALE));
-        }
-        int indent = m_FontStyle.getIndent() * PANGO_SCALE;
-        pango_layout_set_indent(m_pLayout, indent);
-        if (indent < 0) {
-            // For hanging indentation, we add a tabstop to support lists
-            PangoTabArray* pTabs = pango_tab_array_new_with_positions(1, false,
-                    PANGO_TAB_LEFT, -indent);
-            pango_layout_set_tabs(m_pLayout, pTabs);
-            pango_tab_array_free(pTabs);
-        }
-        pango_layout_set_spacing(m_pLayout, 
-                (int)(m_FontStyle.getLineSpacing()*PANGO_SCALE));
         PangoRectangle logical_rect;
         PangoRectangle ink_rect;
         pango_layout_get_pixel_extents(m_pLayout, &ink_rect, &logical_rect);
@@ -618,6 +604,70 @@ void WordsNode::updateLayout()
     }
 }
 
+string WordsNode::createLayoutKey(bool bParsedText) const
+{
+    // Everything that influences the layout. Color and gamma are applied later.
+    char* pFontDesc = pango_font_description_to_string(m_pFontDescription);
+    stringstream ss;
+    ss << pFontDesc << "|" << m_FontStyle.getFontSize() << "|" << bParsedText << "|"
+            << getUserSize().x << "|" << m_FontStyle.getAlignment() << "|" 
+            << m_FontStyle.getWrapMode() << "|" << m_FontStyle.getJustify() << "|" 
+            << m_FontStyle.getIndent() << "|" << m_FontStyle.getLineSpacing() << "|" 
+            << m_FontStyle.getLetterSpacing() << "|" << m_sText;
+    g_free(pFontDesc);
+    return ss.str();
+}
+
+PangoLayout * WordsNode::createLayout(PangoContext* pContext)
+{
+    PangoLayout* pLayout = pango_layout_new(pContext);
+    // Cached layouts are shared, so they can't depend on the context font.
+    pango_layout_set_font_description(pLayout, m_pFontDescription);
+
+    PangoAttrList * pAttrList = 0;
+#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2) 
+    PangoAttribute * pLetterSpacing = pango_attr_letter_spacing_new
+        (int(m_FontStyle.getLetterSpacing()*1024));
+#endif
+    if (m_bParsedText) {
+        char * pText = 0;
+        parseString(&pAttrList, &pText);
+#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2) 
+        // Workaround for pango bug.
+        pango_attr_list_insert_before(pAttrList, pLetterSpacing);
+#endif            
+        pango_layout_set_text(pLayout, pText, -1);
+        g_free(pText);
+    } else {
+        pAttrList = pango_attr_list_new();
+#if PANGO_VERSION > PANGO_VERSION_ENCODE(1,18,2) 
+        pango_attr_list_insert_before(pAttrList, pLetterSpacing);
+#endif
+        pango_layout_set_text(pLayout, m_sText.c_str(), -1);
+    }
+    pango_layout_set_attributes(pLayout, pAttrList);
+    pango_attr_list_unref(pAttrList);
+
+    pango_layout_set_wrap(pLayout, m_FontStyle.getWrapModeVal());
+    pango_layout_set_alignment(pLayout, m_FontStyle.getAlignmentVal());
+    pango_layout_set_justify(pLayout, m_FontStyle.getJustify());
+    if (getUserSize().x != 0) {
+        pango_layout_set_width(pLayout, int(getUserSize().x * PANGO_SCALE));
+    }
+    int indent = m_FontStyle.getIndent() * PANGO_SCALE;
+    pango_layout_set_indent(pLayout, indent);
+    if (indent < 0) {
+        // For hanging indentation, we add a tabstop to support lists
+        PangoTabArray* pTabs = pango_tab_array_new_with_positions(1, false,
+                PANGO_TAB_LEFT, -indent);
+        pango_layout_set_tabs(pLayout, pTabs);
+        pango_tab_array_free(pTabs);
+    }
+    pango_layout_set_spacing(pLayout, 
+            (int)(m_FontStyle.getLineSpacing()*PANGO_SCALE));
+    return pLayout;
+}
+
 static ProfilingZoneID RenderTextProfilingZone("WordsNode: render text");
 
 void WordsNode::renderText()
@@ -628,33 +678,15 @@ void WordsNode::renderText()
         return;
     }
     if (m_bRenderNeeded) {
+        invalidateRender();
         if (m_sText.length() != 0) {
             ScopeTimer timer(RenderTextProfilingZone);
             TextEngine& engine = TextEngine::get(m_FontStyle.getHint());
-            PangoContext* pContext = engine.getPangoContext();
-            pango_context_set_font_description(pContext, m_pFontDescription);
-            int maxTexSize = GLContext::getCurrent()->getMaxTexSize();
-            if (m_InkSize.x > maxTexSize || m_InkSize.y > maxTexSize) {
-                throw Exception(AVG_ERR_UNSUPPORTED, 
-                        "WordsNode size exceeded maximum (Size=" 
-                        + toString(m_InkSize) + ", max=" + toString(maxTexSize) + ")");
-            }
-
-            BitmapPtr pBmp(new Bitmap(m_InkSize, A8));
-            FilterFill<unsigned char>(0).applyInPlace(pBmp);
-            FT_Bitmap bitmap;
-            bitmap.rows = m_InkSize.y;
-            bitmap.width = m_InkSize.x;
-            unsigned char * pLines = pBmp->getPixels();
-            bitmap.pitch = pBmp->getStride();
-            bitmap.buffer = pLines;
-            bitmap.num_grays = 256;
-            bitmap.pixel_mode = ft_pixel_mode_grays;
 
             PangoRectangle logical_rect;
             PangoRectangle ink_rect;
             pango_layout_get_pixel_extents(m_pLayout, &ink_rect, &logical_rect);
-            pango_ft2_render_layout(&bitmap, m_pLayout, -ink_rect.x, -ink_rect.y);
+            int oldAlignOffset = m_AlignOffset;
             switch (m_FontStyle.getAlignmentVal()) {
                 case PANGO_ALIGN_LEFT:
                     m_AlignOffset = 0;
@@ -668,12 +700,45 @@ void WordsNode::renderText()
                 default:
                     AVG_ASSERT(false);
             }
+            if (m_AlignOffset != oldAlignOffset) {
+                invalidateHitTestBounds();
+            }
             setRenderColor(m_FontStyle.getColor());
 
-            GLContextManager* pCM = GLContextManager::get();
-            MCTexturePtr pTex = pCM->createTextureFromBmp(pBmp);
-            getSurface()->create(A8, pTex);
-            newSurface();
+            m_bUsingGlyphAtlas = useGlyphAtlas() && layoutGlyphs(logical_rect);
+            if (m_bUsingGlyphAtlas) {
+                getSurface()->create(A8, GlyphAtlas::get()->getTexture());
+            } else {
+                int maxTexSize = GLContext::getCurrent()->getMaxTexSize();
+                if (m_InkSize.x > maxTexSize || m_InkSize.y > maxTexSize) {
+                    throw Exception(AVG_ERR_UNSUPPORTED, 
+                            "WordsNode size exceeded maximum (Size=" 
+                            + toString(m_InkSize) + ", max=" + toString(maxTexSize) 
+                            + ")");
+                }
+
+                BitmapPtr pBmp = engine.getCachedBitmap(m_sLayoutKey);
+                if (!pBmp) {
+                    pBmp = BitmapPtr(new Bitmap(m_InkSize, A8));
+                    FilterFill<unsigned char>(0).applyInPlace(pBmp);
+                    FT_Bitmap bitmap;
+                    bitmap.rows = m_InkSize.y;
+                    bitmap.width = m_InkSize.x;
+                    unsigned char * pLines = pBmp->getPixels();
+                    bitmap.pitch = pBmp->getStride();
+                    bitmap.buffer = pLines;
+                    bitmap.num_grays = 256;
+                    bitmap.pixel_mode = ft_pixel_mode_grays;
+                    pango_ft2_render_layout(&bitmap, m_pLayout, -ink_rect.x, 
+                            -ink_rect.y);
+                    engine.setCachedBitmap(m_sLayoutKey, pBmp);
+                }
+
+                GLContextManager* pCM = GLContextManager::get();
+                MCTexturePtr pTex = pCM->createTextureFromBmp(pBmp);
+                getSurface()->create(A8, pTex);
+                newSurface();
+            }
         }
         m_bRenderNeeded = false;
     }
@@ -683,6 +748,15 @@ void WordsNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
         float parentEffectiveOpacity)
 {
     AreaNode::preRender(pVA, bIsParentActive, parentEffectiveOpacity);
+    if (useGlyphAtlas()) {
+        if (m_GlyphAtlasGeneration != GlyphAtlas::get()->getGeneration()) {
+            // Atlas cleared. This also retries the atlas if it was full last time.
+            m_bRenderNeeded = true;
+        }
+    } else if (m_bUsingGlyphAtlas) {
+        // Mask or effect added.
+        m_bRenderNeeded = true;
+    }
     if (isVisible()) {
         renderText();
         if (hasMask()) {
@@ -692,7 +766,11 @@ void WordsNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
     if (m_sText.length() != 0 && isVisible()) {
         scheduleFXRender();
     }
-    calcVertexArray(pVA);
+    if (m_bUsingGlyphAtlas) {
+        calcGlyphVertexArray(pVA);
+    } else {
+        calcVertexArray(pVA);
+    }
 }
 
 static ProfilingZoneID RenderProfilingZone("WordsNode::render");
@@ -700,7 +778,9 @@ static ProfilingZoneID RenderProfilingZone("WordsNode::render");
 void WordsNode::render(GLContext* pContext, const glm::mat4& transform)
 {
     ScopeTimer timer(RenderProfilingZone);
-    if (m_sText.length() != 0 && isVisible()) {
+    if (m_sText.length() != 0 && isVisible() && m_bUsingGlyphAtlas) {
+        renderGlyphs(pContext, transform);
+    } else if (m_sText.length() != 0 && isVisible()) {
         IntPoint offset = m_InkOffset + IntPoint(m_AlignOffset, 0);
         glm::mat4 totalTransform;
         if (offset == IntPoint(0,0)) {
@@ -712,6 +792,105 @@ void WordsNode::render(GLContext* pContext, const glm::mat4& transform)
     }
 }
 
+bool WordsNode::useGlyphAtlas() const
+{
+    // Masks and effects need the text in a texture of its own.
+    return m_bGlyphAtlas && !hasMask() && !hasEffect();
+}
+
+static ProfilingZoneID LayoutGlyphsProfilingZone("WordsNode: layout glyphs");
+
+bool WordsNode::layoutGlyphs(const PangoRectangle& logicalRect)
+{
+    ScopeTimer timer(LayoutGlyphsProfilingZone);
+    // Moves the layout to the same place the bitmap would have been rendered to.
+    glm::vec2 offset(m_AlignOffset-logicalRect.x, -logicalRect.y);
+    // The atlas is only cleared between frames, so the glyphs stay valid until then.
+    bool bOk = addGlyphQuads(offset);
+    m_GlyphAtlasGeneration = GlyphAtlas::get()->getGeneration();
+    m_bGlyphVADirty = true;
+    return bOk;
+}
+
+bool WordsNode::addGlyphQuads(const glm::vec2& offset)
+{
+    GlyphAtlas* pAtlas = GlyphAtlas::get();
+    m_GlyphQuads.clear();
+    PangoLayoutIter* pIter = pango_layout_get_iter(m_pLayout);
+    bool bOk = true;
+    do {
+        PangoLayoutRun* pRun = pango_layout_iter_get_run(pIter);
+        if (!pRun) {
+            // End of line.
+            continue;
+        }
+        PangoRectangle runRect;
+        pango_layout_iter_get_run_extents(pIter, 0, &runRect);
+        int baseline = pango_layout_iter_get_baseline(pIter);
+        PangoFont* pFont = pRun->item->analysis.font;
+        PangoGlyphString* pGlyphs = pRun->glyphs;
+        int x = runRect.x;
+        for (int i = 0; i < pGlyphs->num_glyphs && bOk; ++i) {
+            const PangoGlyphInfo& info = pGlyphs->glyphs[i];
+            if (info.glyph != PANGO_GLYPH_EMPTY) {
+                const GlyphAtlas::Glyph* pGlyph = pAtlas->getGlyph(pFont, info.glyph);
+                if (!pGlyph) {
+                    bOk = false;
+                } else if (pGlyph->m_Rect.width() > 0) {
+                    glm::vec2 origin(PANGO_PIXELS(x+info.geometry.x_offset),
+                            PANGO_PIXELS(baseline+info.geometry.y_offset));
+                    GlyphQuad quad;
+                    quad.m_Pos = FRect(origin+offset+glm::vec2(pGlyph->m_Rect.tl),
+                            origin+offset+glm::vec2(pGlyph->m_Rect.br));
+                    quad.m_TexRect = pGlyph->m_TexRect;
+                    m_GlyphQuads.push_back(quad);
+                }
+            }
+            x += info.geometry.width;
+        }
+    } while (bOk && pango_layout_iter_next_run(pIter));
+    pango_layout_iter_free(pIter);
+    return bOk;
+}
+
+void WordsNode::calcGlyphVertexArray(const VertexArrayPtr& pVA)
+{
+    if (m_sText.length() == 0 || !isVisible()) {
+        return;
+    }
+    if (!m_bGlyphVADirty && pVA->reuseSubVA(m_GlyphVA)) {
+        return;
+    }
+    m_bGlyphVADirty = false;
+    pVA->startSubVA(m_GlyphVA);
+    Pixel32 color = m_FontStyle.getColor();
+    for (unsigned i = 0; i < m_GlyphQuads.size(); ++i) {
+        const FRect& pos = m_GlyphQuads[i].m_Pos;
+        const FRect& texRect = m_GlyphQuads[i].m_TexRect;
+        int curVertex = m_GlyphVA.getNumVerts();
+        m_GlyphVA.appendPos(pos.tl, texRect.tl, color);
+        m_GlyphVA.appendPos(glm::vec2(pos.br.x, pos.tl.y), 
+                glm::vec2(texRect.br.x, texRect.tl.y), color);
+        m_GlyphVA.appendPos(pos.br, texRect.br, color);
+        m_GlyphVA.appendPos(glm::vec2(pos.tl.x, pos.br.y), 
+                glm::vec2(texRect.tl.x, texRect.br.y), color);
+        m_GlyphVA.appendQuadIndexes(curVertex+1, curVertex, curVertex+2, curVertex+3);
+    }
+}
+
+void WordsNode::renderGlyphs(GLContext* pContext, const glm::mat4& transform)
+{
+    StandardShader* pShader = pContext->getStandardShader();
+    float opacity = getEffectiveOpacity();
+    pContext->setBlendColor(glm::vec4(1.0f, 1.0f, 1.0f, opacity));
+    pShader->setAlpha(opacity);
+    getSurface()->activate(pContext);
+    pContext->setBlendMode(getBlendMode(), getSurface()->isPremultipliedAlpha());
+    pShader->setTransform(transform);
+    pShader->activate();
+    m_GlyphVA.draw();
+}
+
 IntPoint WordsNode::getMediaSize()
 {
     return m_LogicalSize;
@@ -772,12 +951,15 @@ void WordsNode::setParsedText(const UTF8String& sText)
     m_sText = removeExcessSpaces(sText);
 
     // This just does a syntax check and throws an exception if appropriate.
-    // The results are discarded.
-    PangoAttrList * pAttrList = 0;
-    char * pText = 0;
-    parseString(&pAttrList, &pText);
-    pango_attr_list_unref(pAttrList);
-    g_free(pText);
+    // The results are discarded. Cached layouts have been checked before.
+    TextEngine& engine = TextEngine::get(m_FontStyle.getHint());
+    if (!engine.hasCachedLayout(createLayoutKey(true))) {
+        PangoAttrList * pAttrList = 0;
+        char * pText = 0;
+        parseString(&pAttrList, &pText);
+        pango_attr_list_unref(pAttrList);
+        g_free(pText);
+    }
     m_bParsedText = true;
     updateLayout();
 }
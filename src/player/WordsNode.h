@@ -26,6 +26,8 @@
 #include "RasterNode.h"
 #include "FontStyle.h"
 #include "../base/UTF8String.h"
+#include "../base/Rect.h"
+#include "../graphics/SubVertexArray.h"
 
 #include <pango/pango.h>
 
@@ -108,6 +110,9 @@ class AVG_API WordsNode : public RasterNode
         bool getHint() const;
         void setHint(bool bHint);
 
+        bool getGlyphAtlas() const;
+        void setGlyphAtlas(bool bGlyphAtlas);
+
         glm::vec2 getGlyphPos(int i);
         glm::vec2 getGlyphSize(int i);
         virtual IntPoint getMediaSize();
@@ -127,6 +132,13 @@ class AVG_API WordsNode : public RasterNode
         void updateFont();
         void updateLayout();
         void renderText();
+        bool useGlyphAtlas() const;
+        bool layoutGlyphs(const PangoRectangle& logicalRect);
+        bool addGlyphQuads(const glm::vec2& offset);
+        void calcGlyphVertexArray(const VertexArrayPtr& pVA);
+        void renderGlyphs(GLContext* pContext, const glm::mat4& transform);
+        std::string createLayoutKey(bool bParsedText) const;
+        PangoLayout * createLayout(PangoContext* pContext);
         void parseString(PangoAttrList** ppAttrList, char** ppText);
         void setParsedText(const UTF8String& sText);
         UTF8String applyBR(const UTF8String& sText);
@@ -146,8 +158,22 @@ class AVG_API WordsNode : public RasterNode
         int m_AlignOffset;
         PangoFontDescription * m_pFontDescription;
         PangoLayout * m_pLayout;
+        // Identifies m_pLayout in the TextEngine layout cache.
+        std::string m_sLayoutKey;
 
         bool m_bRenderNeeded;
+
+        // Glyph atlas mode: Each glyph is a quad that references the GlyphAtlas.
+        struct GlyphQuad {
+            FRect m_Pos;
+            FRect m_TexRect;
+        };
+        bool m_bGlyphAtlas;
+        bool m_bUsingGlyphAtlas;
+        int m_GlyphAtlasGeneration;
+        std::vector<GlyphQuad> m_GlyphQuads;
+        SubVertexArray m_GlyphVA;
+        bool m_bGlyphVADirty;
 };
 
 }
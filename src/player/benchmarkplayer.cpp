@@ -0,0 +1,119 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "Player.h"
+#include "DivNode.h"
+#include "AreaNode.h"
+
+#include "../base/Exception.h"
+#include "../base/TimeSource.h"
+#include "../base/StringHelper.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace avg;
+using namespace std;
+
+// Hit testing with and without DivNode's spatial index on a scene with many 
+// nodes, 20 touch contacts per frame and a few nodes moving every frame.
+
+const int NUM_NODES = 5000;
+const int NUM_CONTACTS = 20;
+const int NUM_FRAMES = 100;
+const int NUM_MOVING_NODES = 50;
+
+string createSceneXML(bool bSpatialIndex)
+{
+    stringstream ss;
+    ss << "<avg width=\"1280\" height=\"800\">"
+       << "<div id=\"container\" spatialindex=\"" << (bSpatialIndex ? "True" : "False")
+       << "\">";
+    for (int i = 0; i < NUM_NODES; ++i) {
+        float x = float((i*7919) % 1260);
+        float y = float((i*104729) % 780);
+        float angle = float(i % 7)*0.2f;
+        ss << "<div id=\"n" << i << "\" x=\"" << x << "\" y=\"" << y 
+           << "\" width=\"20\" height=\"20\" angle=\"" << angle << "\"/>";
+    }
+    ss << "</div></avg>";
+    return ss.str();
+}
+
+float runHitTests(Player& player, bool bSpatialIndex, vector<string>& results)
+{
+    player.loadString(createSceneXML(bSpatialIndex));
+    DivNodePtr pContainer = boost::dynamic_pointer_cast<DivNode>(
+            player.getElementByID("container"));
+    vector<AreaNodePtr> pMovingNodes;
+    for (int i = 0; i < NUM_MOVING_NODES; ++i) {
+        pMovingNodes.push_back(boost::dynamic_pointer_cast<AreaNode>(
+                pContainer->getChild(i*(NUM_NODES/NUM_MOVING_NODES))));
+    }
+
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    vector<NodePtr> elements;
+    for (int frame = 0; frame < NUM_FRAMES; ++frame) {
+        for (unsigned i = 0; i < pMovingNodes.size(); ++i) {
+            glm::vec2 pos = pMovingNodes[i]->getPos();
+            pMovingNodes[i]->setPos(glm::vec2(fmod(pos.x+3, 1260.f), pos.y));
+        }
+        for (int i = 0; i < NUM_CONTACTS; ++i) {
+            glm::vec2 pos(float((frame*31+i*617) % 1280), float((frame*17+i*397) % 800));
+            elements.clear();
+            pContainer->getElementsByPos(pos, elements);
+            if (elements.empty()) {
+                results.push_back("");
+            } else {
+                results.push_back(elements[0]->getID());
+            }
+        }
+    }
+    return (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+}
+
+int main(int nargs, char** args)
+{
+    try {
+        Player player;
+        player.disablePython();
+        vector<string> linearResults;
+        vector<string> indexedResults;
+        float linearTime = runHitTests(player, false, linearResults);
+        float indexedTime = runHitTests(player, true, indexedResults);
+        cerr << NUM_NODES << " nodes, " << NUM_CONTACTS << " contacts, " 
+                << NUM_MOVING_NODES << " moving nodes per frame:" << endl;
+        cerr << "  Linear walk:   " << linearTime/NUM_FRAMES << " ms/frame" << endl;
+        cerr << "  Spatial index: " << indexedTime/NUM_FRAMES << " ms/frame" << endl;
+        if (linearResults != indexedResults) {
+            cerr << "Error: Hit test results differ." << endl;
+            return 1;
+        }
+    } catch (const Exception& ex) {
+        cerr << ex.getStr() << endl;
+        return 1;
+    }
+    return 0;
+}
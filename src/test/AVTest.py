@@ -20,6 +20,8 @@
 # Current versions can be found at www.libavg.de
 #
 
+import time
+
 from libavg import avg, player
 from testcase import *
 
@@ -108,6 +110,9 @@ class AVTestCase(AVGTestCase):
         root = self.loadEmptyScene()
         node = avg.VideoNode(href="mpeg1-48x48-sound.avi", queuelength=23, parent=root)
         self.assertEqual(node.queuelength, 23)
+        sys.stderr.write("  Nonstandard number of decoder threads\n")
+        node = avg.VideoNode(href="mpeg1-48x48-sound.avi", decoderthreads=4, parent=root)
+        self.assertEqual(node.decoderthreads, 4)
 
     def testVideoFiles(self):
         def testVideoFile(filename, isThreaded):
@@ -637,6 +642,66 @@ class AVTestCase(AVGTestCase):
                 ))
             os.remove("test.mov")    
 
+    def testVideoWriterCodec(self):
+
+        def startWriter():
+            self.videoWriter = avg.VideoWriter(player.getMainCanvas(), "test.mkv", 30,
+                    codec="ffv1", numthreads=2, queuelength=2)
+            self.assertEqual(self.videoWriter.codec, "ffv1")
+            self.assertEqual(self.videoWriter.pixelformat, "yuv420p")
+            self.assertEqual(self.videoWriter.queuelength, 2)
+            self.assertEqual(self.videoWriter.dropframes, False)
+
+        def stopWriter():
+            self.videoWriter.stop()
+            self.assertEqual(self.videoWriter.droppedframes, 0)
+            self.assert_(self.videoWriter.encodelatency >= 0)
+            self.assert_(self.videoWriter.maxencodelatency >= 
+                    self.videoWriter.encodelatency)
+
+        def killWriter():
+            self.videoWriter = None
+
+        def checkVideo():
+            savedVideoNode = avg.VideoNode(href="../test.mkv", threaded=False,
+                    parent=root)
+            savedVideoNode.pause()
+            self.assertEqual(savedVideoNode.getVideoCodec(), "ffv1")
+            self.assertEqual(savedVideoNode.getNumFrames(), 4)
+            self.assertEqual(savedVideoNode.getStreamPixelFormat(), "yuv420p")
+
+        def testCreateException():
+            canvas = player.getMainCanvas()
+            self.assertRaises(avg.Exception,
+                    lambda: avg.VideoWriter(canvas, "test.mkv", codec="nonexistent"))
+            self.assertRaises(avg.Exception,
+                    lambda: avg.VideoWriter(canvas, "test.mkv", pixelformat="foo"))
+            self.assertRaises(avg.Exception,
+                    lambda: avg.VideoWriter(canvas, "test.mkv", queuelength=0))
+            self.assertRaises(avg.Exception,
+                    lambda: avg.VideoWriter(canvas, "test.mkv", encoderoptions="preset"))
+
+        if not(self._isCurrentDirWriteable()):
+            self.skip("Current dir not writeable.")
+            return
+        if player.isUsingGLES():
+            self.skip("VideoWriter not supported under GLES.")
+            return
+
+        player.setFakeFPS(30)
+        root = self.loadEmptyScene()
+        videoNode = avg.VideoNode(href="mpeg1-48x48.mov", threaded=False, parent=root)
+        self.start(False,
+                (videoNode.play,
+                 startWriter,
+                 lambda: self.delay(100),
+                 stopWriter,
+                 killWriter,
+                 checkVideo,
+                 testCreateException,
+                ))
+        os.remove("test.mkv")
+
     def test2VideosAtOnce(self):
         player.setFakeFPS(25)
         self.loadEmptyScene()
@@ -648,6 +713,66 @@ class AVTestCase(AVGTestCase):
         self.start(False,
                 [lambda: self.compareImage("test2VideosAtOnce1"),])
 
+    def testSharedDecoder(self):
+        def getNumDecoders():
+            return player.getTestHelper().getObjectCount().get(
+                    "avg::AsyncVideoDecoder", 0)
+
+        def getVideoBmps():
+            bmp = player.screenshot()
+            return [avg.Bitmap(bmp, pos, (pos[0]+48, pos[1]+48)) for pos in positions]
+
+        def checkInSync():
+            self.assertEqual(videos[0].getCurFrame(), videos[1].getCurFrame())
+            self.assertEqual(getNumDecoders(), numDecoders+1)
+            bmps = getVideoBmps()
+            self.assert_(self.areSimilarBmps(bmps[0], bmps[1], 0, 0))
+
+        def recordPaused():
+            # The paused node has a decoder of its own now.
+            self.assertEqual(getNumDecoders(), numDecoders+2)
+            self.pausedFrame = videos[1].getCurFrame()
+            self.pausedBmp = getVideoBmps()[1]
+
+        def checkPaused():
+            self.assertEqual(videos[1].getCurFrame(), self.pausedFrame)
+            self.assert_(videos[0].getCurFrame() > self.pausedFrame)
+            self.assert_(self.areSimilarBmps(getVideoBmps()[1], self.pausedBmp, 0, 0))
+
+        def checkOutOfSync():
+            self.assert_(videos[0].getCurFrame() > videos[1].getCurFrame()+10)
+
+        player.setFakeFPS(25)
+        root = self.loadEmptyScene()
+        numDecoders = getNumDecoders()
+        positions = ((0,0), (80,0))
+        videos = []
+        for pos in positions:
+            video = avg.VideoNode(pos=pos, loop=True, shareddecoder=True, 
+                    href="mjpeg-48x48.avi", parent=root)
+            video.play()
+            self.assertEqual(video.shareddecoder, True)
+            videos.append(video)
+        self.assertRaises(avg.Exception, lambda: avg.VideoNode(threaded=False, 
+                shareddecoder=True, href="mjpeg-48x48.avi"))
+        self.start(False,
+                (None,
+                 None,
+                 checkInSync,
+                 videos[1].pause,
+                 None,
+                 None,
+                 recordPaused,
+                 None,
+                 None,
+                 checkPaused,
+                 videos[1].play,
+                 lambda: videos[0].seekToFrame(60),
+                 None,
+                 None,
+                 checkOutOfSync,
+                ))
+
     # noinspection PyArgumentList
     def testVideoAccel(self):
         accelConfig = avg.VideoNode.getVideoAccelConfig()
@@ -658,6 +783,56 @@ class AVTestCase(AVGTestCase):
         video.play()
         self.assertEqual(video.accelerated, (accelConfig != avg.NO_ACCELERATION))
 
+    def testFakeCamera(self):
+        def checkFrames(camNode):
+            self.assert_(camNode.framenum > 0)
+            self.assert_(camNode.droppedframes >= 0)
+            self.assert_(camNode.capturelatency >= 0)
+            bmp = camNode.getBitmap()
+            self.assertEqual(bmp.getSize(), (80, 60))
+            camNode.brightness = 100
+
+        def blockMainThread():
+            # The camera produces frames that are never fetched.
+            time.sleep(0.2)
+
+        def checkDroppedFrames(camNode, threaded):
+            if threaded:
+                # Only the newest frame in the slot survives the stall.
+                self.assert_(camNode.droppedframes > 0)
+            else:
+                # Without a capture thread, frames are only grabbed when asked for.
+                self.assertEqual(camNode.droppedframes, 0)
+
+        def stopCamera(camNode):
+            camNode.stop()
+            self.frameNum = camNode.framenum
+
+        def checkStopped(camNode):
+            self.assertEqual(camNode.framenum, self.frameNum)
+
+        for threaded in (False, True):
+            root = self.loadEmptyScene()
+            camNode = avg.CameraNode(driver="fake", framerate=60, capturewidth=80,
+                    captureheight=60, pixelformat="I8", threadedcapture=threaded,
+                    parent=root)
+            self.assertEqual(camNode.isAvailable(), False)
+            camNode.play()
+            self.start(False,
+                    (lambda: self.delay(200),
+                     lambda: checkFrames(camNode),
+                     blockMainThread,
+                     None,
+                     lambda: checkDroppedFrames(camNode, threaded),
+                     lambda: stopCamera(camNode),
+                     lambda: self.delay(100),
+                     lambda: checkStopped(camNode),
+                     camNode.play,
+                     lambda: self.delay(100),
+                     lambda: self.assert_(camNode.framenum > self.frameNum),
+                     lambda: camNode.unlink(True),
+                    ))
+
 
 def AVTestSuite(tests):
     availableTests = [
@@ -681,8 +856,11 @@ def AVTestSuite(tests):
             "testVideoSeekAfterEOF",
             "testException",
             "testVideoWriter",
+            "testVideoWriterCodec",
             "test2VideosAtOnce",
+            "testSharedDecoder",
             "testVideoAccel",
+            "testFakeCamera",
             ]
     return createAVGTestSuite(availableTests, AVTestCase, tests)
 
@@ -995,6 +995,90 @@ class EventTestCase(AVGTestCase):
         # The order of callbacks is unspecified, so onContact2 might be called once.
         self.assert_(self.numContact2Callbacks <= 1)
 
+    def testMotionCoalescing(self):
+
+        def onMotion(event):
+            self.motionEvents.append(event)
+
+        def checkCoalesced():
+            self.assertEqual(len(self.motionEvents), 2)
+            event1 = [e for e in self.motionEvents if e.pos.y == 10][0]
+            self.assertEqual(event1.pos, (40,10))
+            self.assertEqual([e.pos for e in event1.history], [(20,10), (30,10)])
+            self.assertEqual(len(event1.contact.events), 4)
+            event2 = [e for e in self.motionEvents if e.pos.y == 20][0]
+            self.assertEqual(event2.pos, (60,20))
+            self.assertEqual(len(event2.history), 0)
+
+        root = self.loadEmptyScene()
+        root.subscribe(avg.Node.CURSOR_MOTION, onMotion)
+        player.enableMotionCoalescing(True)
+        self.motionEvents = []
+        self.start(False,
+                (lambda: self._sendTouchEvent(1, avg.Event.CURSOR_DOWN, 10, 10),
+                 lambda: self._sendTouchEvents((
+                        (1, avg.Event.CURSOR_MOTION, 20, 10),
+                        (2, avg.Event.CURSOR_DOWN, 50, 20),
+                        (1, avg.Event.CURSOR_MOTION, 30, 10),
+                        (2, avg.Event.CURSOR_MOTION, 60, 20),
+                        (1, avg.Event.CURSOR_MOTION, 40, 10),
+                        )),
+                 checkCoalesced,
+                 lambda: self._sendTouchEvents((
+                        (1, avg.Event.CURSOR_UP, 40, 10),
+                        (2, avg.Event.CURSOR_UP, 60, 20),
+                        )),
+                ))
+        player.enableMotionCoalescing(False)
+
+    def testEventRecording(self):
+
+        def onEvent(event):
+            self.events.append((event.type, event.pos, 
+                    player.getFrameTime()-self.startTime))
+
+        def startRecording():
+            player.startEventRecording(fileName)
+            self.startTime = player.getFrameTime()
+
+        def startReplay():
+            player.stopEventRecording()
+            self.recordedEvents = self.events
+            self.events = []
+            player.startEventReplay(fileName)
+            self.startTime = player.getFrameTime()
+            self.assert_(player.isReplayingEvents())
+
+        def checkReplay():
+            self.assert_(not(player.isReplayingEvents()))
+            self.assertEqual(len(self.recordedEvents), 3)
+            self.assertEqual(self.events, self.recordedEvents)
+            os.unlink(fileName)
+
+        import tempfile
+        fileName = os.path.join(tempfile.gettempdir(), "testeventrecording.avgevents")
+        root = self.loadEmptyScene()
+        for eventType in (avg.Node.CURSOR_DOWN, avg.Node.CURSOR_MOTION, 
+                avg.Node.CURSOR_UP):
+            root.subscribe(eventType, onEvent)
+        player.setFakeFPS(25)
+        self.events = []
+        self.start(False,
+                (startRecording,
+                 lambda: self._sendTouchEvent(1, avg.Event.CURSOR_DOWN, 10, 10),
+                 lambda: self._sendTouchEvent(1, avg.Event.CURSOR_MOTION, 20, 10),
+                 None,
+                 lambda: self._sendTouchEvent(1, avg.Event.CURSOR_UP, 30, 10),
+                 None,
+                 startReplay,
+                 None,
+                 None,
+                 None,
+                 None,
+                 None,
+                 checkReplay,
+                ))
+
     def testPlaybackMessages(self):
 
         self.loadEmptyScene()
@@ -1117,6 +1201,8 @@ def eventTestSuite(tests):
             "testContacts",
             "testContactRegistration",
             "testMultiContactRegistration",
+            "testMotionCoalescing",
+            "testEventRecording",
             "testPlaybackMessages",
             "testImageSizeChanged",
             "testWordsSizeChanged",
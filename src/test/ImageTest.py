@@ -385,6 +385,85 @@ class ImageTestCase(AVGTestCase):
             player.play()
         avg.BitmapManager.get().setNumThreads(1)
         
+    def testBitmapManagerPrefetch(self):
+        WAIT_TIMEOUT = 5000
+        def checkPrefetched():
+            numImages = cache.getNumImages()[0]
+            if numImages >= 2:
+                # Nodes use the prefetched images instead of loading them again.
+                avg.ImageNode(href="rgb24-65x65.png", parent=root)
+                avg.ImageNode(href="rgb24alpha-64x64.png", parent=root)
+                self.assertEqual(cache.getNumImages()[0], numImages)
+                player.stop()
+
+        def reportStuck():
+            raise RuntimeError("BitmapManager didn't prefetch "
+                    "within %dms timeout" % WAIT_TIMEOUT)
+
+        root = self.loadEmptyScene()
+        cache = player.imageCache
+        oldCapacity = cache.capacity
+        cache.capacity = (0, 0)
+        cache.capacity = oldCapacity
+        bitmapManager = avg.BitmapManager.get()
+        self.assertRaises(avg.Exception,
+                lambda: bitmapManager.prefetch(["rgb24-65x65.png"], [1, 2]))
+        bitmapManager.prefetch(["rgb24-65x65.png", "rgb24alpha-64x64.png"], [1, 2])
+        bitmapManager.prefetch(["freidrehen.jpg", "nonexistent.png"])
+        bitmapManager.cancelPrefetch("freidrehen.jpg")
+        player.subscribe(player.ON_FRAME, checkPrefetched)
+        player.setTimeout(WAIT_TIMEOUT, reportStuck)
+        player.play()
+
+    def testImageAsyncLoad(self):
+        WAIT_TIMEOUT = 5000
+        def onLoaded(node):
+            self.loadedNodes.append(node)
+
+        def onLoadError(message):
+            self.numErrors += 1
+
+        def checkLoaded():
+            if len(self.loadedNodes) == 2 and self.numErrors == 1:
+                self.assert_(imageNode in self.loadedNodes)
+                self.assert_(rectNode in self.loadedNodes)
+                self.assertEqual(imageNode.size, (65,65))
+                # Cached images are displayed immediately.
+                cachedNode = avg.ImageNode(href="rgb24-65x65.png", asyncload=True,
+                        parent=root)
+                self.assertEqual(cachedNode.size, (65,65))
+                cachedNode.subscribe(avg.Node.IMAGE_LOADED, 
+                        lambda: onLoaded(cachedNode))
+            elif len(self.loadedNodes) == 3:
+                player.stop()
+
+        def reportStuck():
+            raise RuntimeError("Images not loaded within %dms timeout" % WAIT_TIMEOUT)
+
+        root = self.loadEmptyScene()
+        cache = player.imageCache
+        oldCapacity = cache.capacity
+        cache.capacity = (0, 0)
+        cache.capacity = oldCapacity
+        self.loadedNodes = []
+        self.numErrors = 0
+        imageNode = avg.ImageNode(href="rgb24-65x65.png", asyncload=True, parent=root)
+        self.assertEqual(imageNode.size, (0,0))
+        imageNode.subscribe(avg.Node.IMAGE_LOADED, lambda: onLoaded(imageNode))
+        rectNode = avg.RectNode(size=(64,64), texhref="rgb24alpha-64x64.png",
+                asyncload=True, parent=root)
+        rectNode.subscribe(avg.Node.IMAGE_LOADED, lambda: onLoaded(rectNode))
+        errorNode = avg.ImageNode(href="nonexistent.png", asyncload=True, parent=root)
+        errorNode.subscribe(avg.Node.IMAGE_LOAD_ERROR, onLoadError)
+        # Changing the href cancels the request.
+        canceledNode = avg.ImageNode(href="freidrehen.jpg", asyncload=True, 
+                parent=root)
+        canceledNode.subscribe(avg.Node.IMAGE_LOADED, lambda: onLoaded(canceledNode))
+        canceledNode.href = ""
+        player.subscribe(player.ON_FRAME, checkLoaded)
+        player.setTimeout(WAIT_TIMEOUT, reportStuck)
+        player.play()
+
     def testBitmapManagerException(self):
         def bitmapCb(bitmap):
             raise RuntimeError
@@ -593,6 +672,119 @@ class ImageTestCase(AVGTestCase):
                  checkAlpha,
                 ])
 
+    def testBlockCompression(self):
+        def tryInsertNode(compression):
+            try:
+                avg.ImageNode(href="rgb24alpha-64x64.png", compression=compression, 
+                        parent=root)
+                self.supported.append(compression)
+            except avg.Exception:
+                pass
+
+        def setBitmap():
+            for node in nodes:
+                node.setBitmap(avg.Bitmap("media/rgb24-65x65.png"))
+
+        def checkBitmaps(size):
+            for node in nodes:
+                bmp = node.getBitmap()
+                self.assertEqual(bmp.getSize(), size)
+                self.assert_(bmp.getFormat() == avg.R8G8B8A8 or 
+                        bmp.getFormat() == avg.B8G8R8A8)
+
+        def showImages(compression):
+            while root.getNumChildren() > 0:
+                root.removeChild(0)
+            # An opaque image and one with alpha, so both formats of each compression
+            # are rendered.
+            avg.ImageNode(href="rgb24-64x64.png", compression=compression, parent=root)
+            avg.ImageNode(pos=(64,0), href="rgb24alpha-64x64.png", 
+                    compression=compression, parent=root)
+
+        def saveUncompressedImage():
+            self.uncompressedBmp = player.screenshot()
+
+        def compareToUncompressed():
+            # Same tolerance as compareImage().
+            self.assert_(self.areSimilarBmps(player.screenshot(), self.uncompressedBmp,
+                    2, 6))
+
+        root = self.loadEmptyScene()
+        self.supported = []
+        self.start(False,
+                (lambda: tryInsertNode("BC"),
+                 lambda: tryInsertNode("ETC2"),
+                ))
+        if not(self.supported):
+            self.skip("Block texture compression not supported.")
+            return
+        root = self.loadEmptyScene()
+        nodes = [avg.ImageNode(href="rgb24alpha-64x64.png", compression=compression, 
+                parent=root) for compression in self.supported]
+        for node, compression in zip(nodes, self.supported):
+            self.assertEqual(node.compression, compression)
+        self.start(False,
+                (lambda: checkBitmaps((64,64)),
+                 setBitmap,
+                 lambda: checkBitmaps((65,65)),
+                ))
+
+        root = self.loadEmptyScene()
+        actions = [lambda: showImages("none"), saveUncompressedImage]
+        for compression in self.supported:
+            actions += [lambda compression=compression: showImages(compression),
+                    compareToUncompressed]
+        self.start(False, actions)
+
+    def testImageBatching(self):
+        def addNodes(useBitmaps):
+            while root.getNumChildren() > 0:
+                root.removeChild(0)
+            for i in xrange(300):
+                # Alternating files, so the nodes need the atlas to share a texture.
+                href = ("rgb24-32x32.png", "rgb24alpha-32x32.png")[i%2]
+                node = avg.ImageNode(pos=((i%20)*8, (i//20)*8), size=(8,8), parent=root)
+                if useBitmaps:
+                    # Images set from bitmaps have textures of their own.
+                    node.setBitmap(avg.Bitmap("media/"+href))
+                else:
+                    node.href = href
+
+        def moveNode():
+            node = root.getChild(0)
+            node.pos = (76, 56)
+            node.size = (16, 16)
+
+        def saveBatchedImage():
+            self.assert_(mainCanvas.getNumDrawCalls() < 10)
+            self.batchedBmp = player.screenshot()
+
+        def checkUnbatchedImage():
+            self.assert_(mainCanvas.getNumDrawCalls() >= 300)
+            self.assert_(self.areSimilarBmps(self.batchedBmp, player.screenshot(), 0, 0))
+
+        root = self.loadEmptyScene()
+        mainCanvas = player.getMainCanvas()
+        self.start(False,
+                (lambda: addNodes(False),
+                 None,
+                 saveBatchedImage,
+                 lambda: addNodes(True),
+                 None,
+                 # Batched and unbatched rendering must produce the same image.
+                 checkUnbatchedImage,
+                 lambda: addNodes(False),
+                 None,
+                 # Changing the transform of a batched node updates its vertices.
+                 moveNode,
+                 None,
+                 saveBatchedImage,
+                 lambda: addNodes(True),
+                 moveNode,
+                 None,
+                 checkUnbatchedImage,
+                ))
+
     def testSpline(self):
         spline = avg.CubicSpline([(0,3),(1,2),(2,1),(3,0)])
         self.assertAlmostEqual(spline.interpolate(0), 3)
@@ -618,6 +810,8 @@ def imageTestSuite(tests):
             "testImageCache",
             "testBitmap",
             "testBitmapManager",
+            "testBitmapManagerPrefetch",
+            "testImageAsyncLoad",
             "testBitmapManagerException",
             "testBlendMode",
             "testImageMask",
@@ -625,6 +819,8 @@ def imageTestSuite(tests):
             "testImageMaskPos",
             "testImageMipmap",
             "testImageCompression",
+            "testBlockCompression",
+            "testImageBatching",
             "testSpline",
             )
     return createAVGTestSuite(availableTests, ImageTestCase, tests)
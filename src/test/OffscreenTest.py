@@ -158,6 +158,33 @@ class OffscreenTestCase(AVGTestCase):
                 (checkMainScreenshot,
                  checkCanvasScreenshot))
 
+    def testCanvasRequestScreenshot(self):
+        def requestScreenshots():
+            for i in range(3):
+                offscreenCanvas.requestScreenshot()
+
+        def collectScreenshots():
+            bmp = offscreenCanvas.getRequestedScreenshot()
+            while bmp is not None:
+                self.__screenshots.append(bmp)
+                bmp = offscreenCanvas.getRequestedScreenshot()
+
+        def checkScreenshots():
+            self.assertEqual(len(self.__screenshots), 3)
+            for bmp in self.__screenshots:
+                self.compareBitmapToFile(bmp, "testOffscreenScreenshot")
+            self.assertEqual(offscreenCanvas.getRequestedScreenshot(), None)
+
+        self.loadEmptyScene()
+        offscreenCanvas = self.__createOffscreenCanvas("offscreencanvas", False)
+        self.__screenshots = []
+        self.start(False,
+                (requestScreenshots,
+                 collectScreenshots,
+                 collectScreenshots,
+                 collectScreenshots,
+                 checkScreenshots))
+
     def testCanvasEvents(self):
         def onOffscreenImageDown(event):
             self.__offscreenImageDownCalled = True
@@ -283,6 +310,50 @@ class OffscreenTestCase(AVGTestCase):
                  lambda: self.compareImage("testOffscreenAutoRender2")
                 ))
 
+    def testCanvasDamageTracking(self):
+        def createCanvases():
+            self.offscreen1 = self.__createOffscreenCanvas("offscreencanvas1", False)
+            self.offscreen2 = self.__createOffscreenCanvas("offscreencanvas2", False)
+            self.offscreen2.getElementByID("test1").href = "canvas:offscreencanvas1"
+            avg.ImageNode(parent=root, href="canvas:offscreencanvas2")
+
+        def saveNumRenders():
+            self.numRenders = (self.offscreen1.getNumRenders(),
+                    self.offscreen2.getNumRenders())
+
+        def checkNumRenders(expected1, expected2):
+            self.assertEqual(self.offscreen1.getNumRenders(), 
+                    self.numRenders[0]+expected1)
+            self.assertEqual(self.offscreen2.getNumRenders(), 
+                    self.numRenders[1]+expected2)
+            saveNumRenders()
+
+        def changeCanvas1():
+            self.offscreen1.getElementByID("test1").opacity = 0.5
+
+        def changeCanvas2():
+            self.offscreen2.getElementByID("test1").x = 10
+
+        root = self.loadEmptyScene()
+        createCanvases()
+        self.start(False,
+                (None,
+                 None,
+                 None,
+                 saveNumRenders,
+                 lambda: checkNumRenders(0, 0),
+                 changeCanvas2,
+                 lambda: checkNumRenders(0, 1),
+                 changeCanvas1,
+                 lambda: checkNumRenders(1, 1),
+                 None,
+                 lambda: checkNumRenders(0, 0),
+                 self.offscreen1.render,
+                 lambda: checkNumRenders(1, 1),
+                ))
+        self.offscreen1 = None
+        self.offscreen2 = None
+
     def testCanvasCrop(self):
         root = self.loadEmptyScene()
         canvas = player.createCanvas(id="testcanvas", size=(160,120), 
@@ -463,10 +534,12 @@ def offscreenTestSuite(tests):
                 "testCanvasResize",
                 "testCanvasErrors",
                 "testCanvasAPI",
+                "testCanvasRequestScreenshot",
                 "testCanvasEvents",
                 "testCanvasEventCapture",
                 "testCanvasRender",
                 "testCanvasAutoRender",
+                "testCanvasDamageTracking",
                 "testCanvasCrop",
                 "testCanvasAlpha",
                 "testCanvasBlendModes",
@@ -501,6 +501,77 @@ class PlayerTestCase(AVGTestCase):
                  checkRelPos
                 ))
 
+    def testSpatialIndex(self):
+        def createDiv(bSpatialIndex):
+            div = avg.DivNode(size=(160,120), spatialindex=bSpatialIndex, parent=root)
+            for i in xrange(60):
+                avg.DivNode(pos=((i*37)%150, (i*23)%110), size=(12,12), angle=(i%5)*0.3,
+                        parent=div)
+            return div
+
+        def getHitIndex(div, pos):
+            node = div.getElementByPos(pos)
+            if node is None or node == div:
+                return -1
+            else:
+                return div.indexOf(node)
+
+        def compareHits():
+            for x in xrange(-5, 170, 3):
+                for y in xrange(-5, 130, 3):
+                    self.assertEqual(getHitIndex(linearDiv, (x,y)),
+                            getHitIndex(indexedDiv, (x,y)))
+
+        def changeChildren():
+            for div in (linearDiv, indexedDiv):
+                div.getChild(3).pos = (100, 100)
+                div.getChild(7).angle += 1
+                div.getChild(11).size = (40, 40)
+                div.reorderChild(0, 40)
+                div.removeChild(20)
+                avg.DivNode(pos=(50,50), size=(30,30), parent=div)
+
+        root = self.loadEmptyScene()
+        linearDiv = createDiv(False)
+        indexedDiv = createDiv(True)
+        self.assert_(indexedDiv.spatialindex and not(linearDiv.spatialindex))
+        self.start(False,
+                (compareHits,
+                 changeChildren,
+                 compareHits,
+                 lambda: setattr(indexedDiv, "spatialindex", False),
+                 compareHits,
+                ))
+
+    def testVertexArrayUpdate(self):
+        def checkNothingWritten():
+            self.assertEqual(canvas.getNumVertsWritten(), 0)
+            self.assertEqual(canvas.getNumVertexBytesUploaded(), 0)
+
+        def checkRectWritten():
+            self.assert_(canvas.getNumVertsWritten() > 0)
+            self.assert_(canvas.getNumVertexBytesUploaded() > 0)
+
+        def changeRect():
+            rect.color = "FF0000"
+
+        root = self.loadEmptyScene()
+        div = avg.DivNode(size=(80,60), crop=True, parent=root)
+        avg.WordsNode(pos=(2,2), text="Static text", parent=div)
+        rect = avg.RectNode(pos=(10,30), size=(20,20), parent=div)
+        avg.LineNode(pos1=(0,0), pos2=(80,60), parent=root)
+        canvas = player.getMainCanvas()
+        self.start(False,
+                (None,
+                 None,
+                 checkNothingWritten,
+                 changeRect,
+                 None,
+                 checkRectWritten,
+                 None,
+                 checkNothingWritten,
+                ))
+
     def testCropImage(self):
         def moveTLCrop():
             node = player.getElementByID("img")
@@ -718,6 +789,34 @@ class PlayerTestCase(AVGTestCase):
     def testMemoryQuery(self):
         self.assertNotEqual(player.getMemoryUsage(), 0)
 
+    def testTracing(self):
+        def writeTrace():
+            player.writeTrace(fileName)
+            player.enableTracing(False)
+            f = open(fileName)
+            trace = json.load(f)
+            f.close()
+            os.remove(fileName)
+            events = trace["traceEvents"]
+            threadNames = [event["args"]["name"] for event in events 
+                    if event["ph"] == "M"]
+            self.assert_("main" in threadNames)
+            frameMarkers = [event for event in events if event["ph"] == "i"]
+            self.assertEqual(len(frameMarkers), 3)
+            zoneNames = set([event["name"] for event in events if event["ph"] == "B"])
+            self.assert_("Dispatch events" in zoneNames)
+
+        import json
+        import tempfile
+        fileName = os.path.join(tempfile.gettempdir(), "testtrace.json")
+        self.loadEmptyScene()
+        self.start(False,
+                (lambda: player.enableTracing(True),
+                 None,
+                 None,
+                 writeTrace
+                ))
+
     def testStopOnEscape(self):
         def pressEscape():
             Helper = player.getTestHelper()
@@ -913,11 +1012,14 @@ def playerTestSuite(tests):
             "testAVGFile",
             "testBroken",
             "testMove",
+            "testSpatialIndex",
+            "testVertexArrayUpdate",
             "testCropImage",
             "testCropMovie",
             "testWarp",
             "testMediaDir",
             "testMemoryQuery",
+            "testTracing",
             "testStopOnEscape",
             "testScreenDimensions",
             "testSVG",
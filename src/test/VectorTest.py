@@ -86,6 +86,49 @@ class VectorTestCase(AVGTestCase):
                  lambda: self.compareImage("testlotsoflines"), 
                 ))
 
+    def testDrawCallBatching(self):
+        def addLines(blendModes):
+            # Same geometry as testLotsOfLines, so the baseline image can be reused.
+            for i in xrange(500):
+                y = i+2.5
+                avg.LineNode(pos1=(2, y), pos2=(10, y), 
+                        blendmode=blendModes[i%len(blendModes)], parent=canvas)
+
+        def removeLines():
+            while canvas.getNumChildren() > 0:
+                canvas.removeChild(0)
+
+        def splitBatch():
+            # Empty divs between the lines flush the batch without changing the image.
+            for i in xrange(canvas.getNumChildren()-1, 0, -1):
+                canvas.insertChild(avg.DivNode(), i)
+
+        def saveBatchedImage():
+            self.batchedBmp = player.screenshot()
+
+        def checkUnbatchedImage():
+            self.assert_(mainCanvas.getNumDrawCalls() >= 500)
+            self.assert_(self.areSimilarBmps(self.batchedBmp, player.screenshot(), 0, 0))
+
+        canvas = self.makeEmptyCanvas()
+        mainCanvas = player.getMainCanvas()
+        self.start(False,
+                (lambda: addLines(("blend",)),
+                 None,
+                 # Lines that share all state need a single draw call.
+                 lambda: self.assert_(mainCanvas.getNumDrawCalls() < 10),
+                 lambda: self.compareImage("testlotsoflines"),
+                 saveBatchedImage,
+                 splitBatch,
+                 None,
+                 # Batched and unbatched rendering must produce the same image.
+                 checkUnbatchedImage,
+                 removeLines,
+                 lambda: addLines(("blend", "add")),
+                 None,
+                 lambda: self.assert_(mainCanvas.getNumDrawCalls() >= 500),
+                ))
+
     def testTexturedLine(self):
         def addLine():
             line = avg.LineNode(pos1=(2, 20), pos2=(100, 20), texhref="rgb24-64x64.png",
@@ -754,6 +797,7 @@ def vectorTestSuite(tests):
     availableTests = (
             "testLine",
             "testLotsOfLines",
+            "testDrawCallBatching",
             "testLineOpacity",
             "testTexturedLine",
             "testRect",
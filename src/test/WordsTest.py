@@ -648,6 +648,105 @@ class WordsTestCase(AVGTestCase):
                  lambda: self.compareImage("testWordsGamma2"),
                 ))
 
+    def testLayoutCache(self):
+
+        def toggleText():
+            for text in ("OK", "Cancel", "OK", "<b>OK</b>", "OK"):
+                node.text = text
+                self.assertEqual(node.size, sizes[text])
+            node.rawtextmode = True
+            node.text = "<b>OK</b>"
+            self.assertNotEqual(node.size, sizes["<b>OK</b>"])
+            node.rawtextmode = False
+
+        def changeWidth():
+            node.text = "Cancel Cancel"
+            oldLines = node.getNumLines()
+            node.width = 30
+            self.assertNotEqual(node.getNumLines(), oldLines)
+            node.width = 0
+            self.assertEqual(node.getNumLines(), oldLines)
+
+        def setText(text):
+            node.text = text
+
+        def storeHits():
+            self.layoutHits = helper.getNumTextLayoutHits()
+            self.bitmapHits = helper.getNumTextBitmapHits()
+
+        def checkHitsIncreased():
+            # Rerendering a cached text reuses both the layout and the bitmap.
+            self.assert_(helper.getNumTextLayoutHits() > self.layoutHits)
+            self.assert_(helper.getNumTextBitmapHits() > self.bitmapHits)
+
+        helper = player.getTestHelper()
+        root = self.loadEmptyScene()
+        sizes = {}
+        for text in ("OK", "Cancel", "<b>OK</b>"):
+            sizes[text] = avg.WordsNode(font="Bitstream Vera Sans", fontsize=12,
+                    text=text).size
+        node = avg.WordsNode(font="Bitstream Vera Sans", fontsize=12, text="OK",
+                parent=root)
+        self.start(True,
+                (toggleText,
+                 changeWidth,
+                 lambda: setText("OK"),
+                 storeHits,
+                 lambda: setText("Cancel"),
+                 lambda: setText("OK"),
+                 checkHitsIncreased,
+                ))
+
+    def testGlyphAtlas(self):
+
+        def checkSizes():
+            self.assertEqual(atlasNode.size, bmpNode.size)
+            self.assertEqual(atlasNode.getNumLines(), bmpNode.getNumLines())
+
+        def changeText(text):
+            atlasNode.text = text
+            bmpNode.text = text
+
+        def toggleGlyphAtlas():
+            atlasNode.glyphatlas = not(atlasNode.glyphatlas)
+
+        def addMask():
+            atlasNode.maskhref = "mask4.png"
+
+        def showAtlasNodeOnly():
+            bmpNode.opacity = 0
+
+        def storeAtlasBmp():
+            self.atlasBmp = player.screenshot()
+
+        def compareWithAtlasBmp():
+            # The bitmap path needs to render the same pixels as the atlas path.
+            bmp = player.screenshot()
+            self.assert_(self.areSimilarBmps(self.atlasBmp, bmp, 0.5, 4))
+            bmpNode.opacity = 1
+
+        root = self.loadEmptyScene()
+        atlasNode = avg.WordsNode(pos=(1,1), fontsize=12, font="Bitstream Vera Sans",
+                width=100, text="lorem ipsum dolor sit amet", glyphatlas=True,
+                parent=root)
+        bmpNode = avg.WordsNode(pos=(1,60), fontsize=12, font="Bitstream Vera Sans",
+                width=100, text="lorem ipsum dolor sit amet", parent=root)
+        self.assert_(atlasNode.glyphatlas)
+        self.assert_(not(bmpNode.glyphatlas))
+        self.start(True,
+                (checkSizes,
+                 lambda: changeText(u"föa <b>bold</b> <i>italic</i>"),
+                 checkSizes,
+                 showAtlasNodeOnly,
+                 storeAtlasBmp,
+                 toggleGlyphAtlas,
+                 compareWithAtlasBmp,
+                 checkSizes,
+                 toggleGlyphAtlas,
+                 addMask,
+                 checkSizes,
+                ))
+
 
 def wordsTestSuite(tests):
     availableTests = (
@@ -676,5 +775,7 @@ def wordsTestSuite(tests):
             "testSetWidth",
             "testTooWide",
             "testWordsGamma",
+            "testLayoutCache",
+            "testGlyphAtlas",
             )
     return createAVGTestSuite(availableTests, WordsTestCase, tests)
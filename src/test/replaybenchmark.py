@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# libavg - Media Playback Engine.
+# Copyright (C) 2003-2014 Ulrich von Zadow
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2 of the License, or (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Current versions can be found at www.libavg.de
+#
+
+# Records the input of an interactive session and replays it deterministically to
+# get reproducible per-zone frame time statistics.
+#
+# Usage: replaybenchmark.py record|replay EVENTFILE [SCENEFILE]
+
+import optparse
+
+from libavg import avg, player
+
+def parseCmdLine():
+    parser = optparse.OptionParser(usage=
+"""%prog record|replay EVENTFILE [SCENEFILE]
+Records the input of an interactive session or replays it and prints per-zone
+frame time percentiles.""")
+    parser.add_option('--fps', dest='fps', type='float', default=60,
+            help='Frame rate used during replay.')
+    (options, args) = parser.parse_args()
+    if len(args) < 2 or args[0] not in ('record', 'replay'):
+        parser.error("Must be invoked with mode and event file as arguments")
+    return options, args
+
+
+def loadScene(sceneFile):
+    if sceneFile:
+        player.loadFile(sceneFile)
+    else:
+        canvas = player.createMainCanvas(size=(640,480))
+        root = canvas.getRootNode()
+        for i in xrange(100):
+            avg.RectNode(pos=((i%10)*64, (i//10)*48), size=(60,44), fillopacity=1,
+                    fillcolor="%02X8080" % (i*2), parent=root)
+
+
+def percentile(sortedTimes, p):
+    index = min(int(len(sortedTimes)*p/100.), len(sortedTimes)-1)
+    return sortedTimes[index]
+
+
+def printFrameTimes():
+    zoneTimes = player.getZoneFrameTimes()
+    print "%-40s %10s %10s %10s" % ("Zone", "50%", "90%", "99%")
+    for zone, times in sorted(zoneTimes.iteritems()):
+        if times:
+            times = sorted(times)
+            print "%-40s %10i %10i %10i" % (zone, percentile(times, 50), 
+                    percentile(times, 90), percentile(times, 99))
+    print "(times in microseconds)"
+
+
+def checkReplayFinished():
+    if not player.isReplayingEvents():
+        player.stop()
+
+
+(options, args) = parseCmdLine()
+mode = args[0]
+eventFile = args[1]
+sceneFile = args[2] if len(args) > 2 else None
+
+loadScene(sceneFile)
+if mode == 'record':
+    player.setFramerate(options.fps)
+    player.startEventRecording(eventFile)
+    player.play()
+    player.stopEventRecording()
+else:
+    player.setFakeFPS(options.fps)
+    player.enableFrameTimeHistory(True)
+    player.startEventReplay(eventFile)
+    player.subscribe(player.ON_FRAME, checkReplayFinished)
+    player.play()
+    printFrameTimes()
@@ -49,9 +49,6 @@ namespace avg {
 
 AsyncVideoDecoder::AsyncVideoDecoder(int queueLength)
     : m_QueueLength(queueLength),
-      m_pDemuxThread(0),
-      m_pVDecoderThread(0),
-      m_pADecoderThread(0),
       m_bUseStreamFPS(true),
       m_FPS(0)
 {
@@ -110,9 +107,9 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
         m_pVMsgQ = VideoMsgQueuePtr(new VideoMsgQueue(m_QueueLength));
         VideoMsgQueue& packetQ = *m_PacketQs[getVStreamIndex()];
 
-        m_pVDecoderThread = new boost::thread(VideoDecoderThread(
+        m_pVDecoderThread = startWorkerThread(VideoDecoderThread(
                 *m_pVCmdQ, *m_pVMsgQ, packetQ, getVideoStream(), 
-                getSize(), getPixelFormat(), usesVDPAU()));
+                getSize(), getPixelFormat(), usesVDPAU(), usesFramePool()));
     }
     
     if (getVideoInfo().m_bHasAudio) {
@@ -120,7 +117,7 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
         m_pAMsgQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_MSG_QUEUE_LENGTH));
         m_pAStatusQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_STATUS_QUEUE_LENGTH));
         VideoMsgQueue& packetQ = *m_PacketQs[getAStreamIndex()];
-        m_pADecoderThread = new boost::thread(
+        m_pADecoderThread = startWorkerThread(
                 AudioDecoderThread(*m_pACmdQ, *m_pAMsgQ, packetQ, getAudioStream(),
                         *pAP));
     }
@@ -138,16 +135,14 @@ void AsyncVideoDecoder::close()
     if (m_pVDecoderThread) {
         m_pVMsgQ->clear();
         m_pVDecoderThread->join();
-        delete m_pVDecoderThread;
-        m_pVDecoderThread = 0;
+        m_pVDecoderThread = WorkerHandlePtr();
         m_pVMsgQ = VideoMsgQueuePtr();
     }
     if (m_pADecoderThread) {
         m_pAMsgQ->clear();
         m_pAStatusQ->clear();
         m_pADecoderThread->join();
-        delete m_pADecoderThread;
-        m_pADecoderThread = 0;
+        m_pADecoderThread = WorkerHandlePtr();
         m_pAStatusQ = AudioMsgQueuePtr();
         m_pAMsgQ = AudioMsgQueuePtr();
     }
@@ -303,14 +298,13 @@ void AsyncVideoDecoder::setupDemuxer(vector<int> streamIndexes)
         VideoMsgQueuePtr pPacketQ(new VideoMsgQueue(PACKET_QUEUE_LENGTH));
         m_PacketQs[streamIndexes[i]] = pPacketQ;
     }
-    m_pDemuxThread = new boost::thread(VideoDemuxerThread(*m_pDemuxCmdQ,
+    m_pDemuxThread = startWorkerThread(VideoDemuxerThread(*m_pDemuxCmdQ,
             getFormatContext(), m_PacketQs));
 }
 
 void AsyncVideoDecoder::deleteDemuxer()
 {
-    delete m_pDemuxThread;
-    m_pDemuxThread = 0;
+    m_pDemuxThread = WorkerHandlePtr();
     map<int, VideoMsgQueuePtr>::iterator it;
     for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
         VideoMsgQueuePtr pPacketQ = it->second;
@@ -29,6 +29,7 @@
 #include "AudioDecoderThread.h"
 #include "VideoMsg.h"
 
+#include "../base/WorkerHandle.h"
 #include "../graphics/Bitmap.h"
 #include "../audio/AudioParams.h"
 
@@ -80,15 +81,15 @@ private:
 
     int m_QueueLength;
 
-    boost::thread* m_pDemuxThread;
+    WorkerHandlePtr m_pDemuxThread;
     std::map<int, VideoMsgQueuePtr> m_PacketQs;
     VideoDemuxerThread::CQueuePtr m_pDemuxCmdQ;
 
-    boost::thread* m_pVDecoderThread;
+    WorkerHandlePtr m_pVDecoderThread;
     VideoDecoderThread::CQueuePtr m_pVCmdQ;
     VideoMsgQueuePtr m_pVMsgQ;
 
-    boost::thread* m_pADecoderThread;
+    WorkerHandlePtr m_pADecoderThread;
     AudioDecoderThread::CQueuePtr m_pACmdQ;
     AudioMsgQueuePtr m_pAMsgQ;
     AudioMsgQueuePtr m_pAStatusQ;
@@ -22,6 +22,7 @@
 //
 
 #include "AudioDecoderThread.h"
+#include "PacketPool.h"
 
 #include "../base/Logger.h"
 #include "../base/TimeSource.h"
@@ -37,6 +38,8 @@
 
 using namespace std;
 
+#define MIN_FREE_MSGS 8
+
 namespace avg {
 
 AudioDecoderThread::AudioDecoderThread(CQueue& cmdQ, AudioMsgQueue& msgQ, 
@@ -72,6 +75,20 @@ AudioDecoderThread::~AudioDecoderThread()
     }
 }
 
+void AudioDecoderThread::addQueueListener(IQueueListener* pListener)
+{
+    WorkerThread<AudioDecoderThread>::addQueueListener(pListener);
+    m_PacketQ.addPushListener(pListener);
+    m_MsgQ.addPopListener(pListener);
+}
+
+void AudioDecoderThread::removeQueueListener(IQueueListener* pListener)
+{
+    WorkerThread<AudioDecoderThread>::removeQueueListener(pListener);
+    m_PacketQ.removeListener(pListener);
+    m_MsgQ.removeListener(pListener);
+}
+
 static ProfilingZoneID DecoderProfilingZone("Audio Decoder Thread", true);
 static ProfilingZoneID PacketWaitProfilingZone("Audio Wait for packet", true);
 
@@ -79,7 +96,19 @@ bool AudioDecoderThread::work()
 {
     ScopeTimer timer(DecoderProfilingZone);
     VideoMsgPtr pMsg;
-    {
+    if (isScheduled()) {
+        // A packet can decode to several audio messages. Only take a packet if there is
+        // enough space left that pushing them won't block the scheduler's worker.
+        if (m_MsgQ.getMaxSize() == -1 || 
+                m_MsgQ.size() + MIN_FREE_MSGS <= m_MsgQ.getMaxSize())
+        {
+            pMsg = m_PacketQ.pop(false);
+        }
+        if (!pMsg) {
+            setIdle();
+            return true;
+        }
+    } else {
         ScopeTimer timer(PacketWaitProfilingZone);
         pMsg = m_PacketQ.pop(true);
     }
@@ -99,8 +128,7 @@ bool AudioDecoderThread::work()
                 default:
                     AVG_ASSERT(false);
             }
-            av_free_packet(pPacket);
-            delete pPacket;
+            PacketPool::get()->release(pPacket);
             break;
         }
         case VideoMsg::SEEK_DONE:
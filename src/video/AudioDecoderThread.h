@@ -45,6 +45,8 @@ class AVG_API AudioDecoderThread : public WorkerThread<AudioDecoderThread> {
         virtual ~AudioDecoderThread();
         
         bool work();
+        virtual void addQueueListener(IQueueListener* pListener);
+        virtual void removeQueueListener(IQueueListener* pListener);
 
     private:
         void decodePacket(AVPacket* pPacket);
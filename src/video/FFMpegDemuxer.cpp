@@ -20,6 +20,7 @@
 //
 
 #include "FFMpegDemuxer.h"
+#include "PacketPool.h"
 
 #include "../base/ScopeTimer.h"
 #include "../base/ObjectCounter.h"
@@ -33,82 +34,102 @@ using namespace std;
 
 namespace avg {
 
-FFMpegDemuxer::FFMpegDemuxer(AVFormatContext * pFormatContext, vector<int> streamIndexes)
+FFMpegDemuxer::FFMpegDemuxer(AVFormatContext * pFormatContext, vector<int> streamIndexes,
+        int maxCachedPackets)
     : m_pFormatContext(pFormatContext)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     for (unsigned i = 0; i < streamIndexes.size(); ++i) {
-        m_PacketLists[streamIndexes[i]] = PacketList();
+        m_PacketRings[streamIndexes[i]].init(maxCachedPackets);
     }
 }
 
 FFMpegDemuxer::~FFMpegDemuxer()
 {
-    clearPacketCache();
+    map<int, PacketRing>::iterator it;
+    for (it = m_PacketRings.begin(); it != m_PacketRings.end(); ++it) {
+        it->second.freePackets();
+    }
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
-AVPacket * FFMpegDemuxer::getPacket(int streamIndex)
+AVPacket * FFMpegDemuxer::getPacket(int streamIndex, bool* pbCacheFull)
 {
     // Make sure enableStream was called on streamIndex.
-    AVG_ASSERT(m_PacketLists.size() > 0);
+    AVG_ASSERT(m_PacketRings.size() > 0);
     AVG_ASSERT(streamIndex > -1 && streamIndex < 10);
 
-    if (m_PacketLists.find(streamIndex) == m_PacketLists.end()) {
-        cerr << this << ": getPacket: Stream " << streamIndex << " not found." << endl;
-        dump();
-        AVG_ASSERT(false);
+    if (pbCacheFull) {
+        *pbCacheFull = false;
     }
-
-    PacketList& curPacketList = m_PacketLists.find(streamIndex)->second;
-    AVPacket* pPacket;
-    if (!curPacketList.empty()) {
+    PacketRing& curPacketRing = getPacketRing(streamIndex);
+    AVPacket* pPacket = PacketPool::get()->alloc();
+    if (!curPacketRing.empty()) {
         // The stream has packets queued already.
-        pPacket = curPacketList.front();
-        curPacketList.pop_front();
-    } else {
-        // No packets queued for this stream -> read and queue packets until we get one
-        // that is meant for this stream.
-        do {
-            pPacket = new AVPacket;
-            memset(pPacket, 0, sizeof(AVPacket));
-            int err = av_read_frame(m_pFormatContext, pPacket);
-            if (err < 0) {
-                // EOF or error
-                if (err != int(AVERROR_EOF)) {
-                    char sz[256];
-                    av_strerror(err, sz, 256);
-                    AVG_TRACE(Logger::category::PLAYER, Logger::severity::ERROR,
-                            "Error decoding video: " << sz);
-                }
-                av_free_packet(pPacket);
-                delete pPacket;
-                pPacket = 0;
-                return 0;
+        curPacketRing.pop(pPacket);
+        return pPacket;
+    }
+
+    // No packets queued for this stream -> read and queue packets until we get one
+    // that is meant for this stream.
+    while (true) {
+        if (pbCacheFull && isCacheFull()) {
+            // Another stream is too far ahead in the file.
+            *pbCacheFull = true;
+            PacketPool::get()->release(pPacket);
+            return 0;
+        }
+        int err = av_read_frame(m_pFormatContext, pPacket);
+        if (err < 0) {
+            // EOF or error
+            if (err != int(AVERROR_EOF)) {
+                char sz[256];
+                av_strerror(err, sz, 256);
+                AVG_TRACE(Logger::category::PLAYER, Logger::severity::ERROR,
+                        "Error decoding video: " << sz);
             }
-            if (pPacket->stream_index != streamIndex) {
-                if (m_PacketLists.find(pPacket->stream_index) != m_PacketLists.end()) {
-                    // Relevant stream, but not ours
-                    av_dup_packet(pPacket);
-                    PacketList& otherPacketList = 
-                            m_PacketLists.find(pPacket->stream_index)->second;
-                    otherPacketList.push_back(pPacket);
-                } else {
-                    // Disabled stream
-                    av_free_packet(pPacket);
-                    delete pPacket;
-                    pPacket = 0;
-                } 
-            } else {
-                // Our stream
-                av_dup_packet(pPacket);
+            PacketPool::get()->release(pPacket);
+            return 0;
+        }
+        if (pPacket->stream_index == streamIndex) {
+            // Our stream
+            av_dup_packet(pPacket);
+            return pPacket;
+        }
+        map<int, PacketRing>::iterator it = m_PacketRings.find(pPacket->stream_index);
+        if (it != m_PacketRings.end()) {
+            // Relevant stream, but not ours
+            av_dup_packet(pPacket);
+            PacketRing& otherPacketRing = it->second;
+            if (otherPacketRing.full()) {
+                otherPacketRing.grow();
             }
-        } while (!pPacket || pPacket->stream_index != streamIndex);
+            otherPacketRing.push(pPacket);
+        } else {
+            // Disabled stream
+            av_free_packet(pPacket);
+        }
     }
+}
 
-    return pPacket;
+int FFMpegDemuxer::getNumCachedPackets(int streamIndex) const
+{
+    map<int, PacketRing>::const_iterator it = m_PacketRings.find(streamIndex);
+    AVG_ASSERT(it != m_PacketRings.end());
+    return it->second.size();
 }
-        
+
+bool FFMpegDemuxer::isCacheFull() const
+{
+    map<int, PacketRing>::const_iterator it;
+    for (it = m_PacketRings.begin(); it != m_PacketRings.end(); ++it) {
+        if (it->second.full()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void FFMpegDemuxer::seek(float destTime)
 {
     av_seek_frame(m_pFormatContext, -1, (long long)(destTime*AV_TIME_BASE),
@@ -118,26 +139,121 @@ void FFMpegDemuxer::seek(float destTime)
 
 void FFMpegDemuxer::clearPacketCache()
 {
-    map<int, PacketList>::iterator it;
-    for (it = m_PacketLists.begin(); it != m_PacketLists.end(); ++it) {
-        PacketList::iterator it2;
-        PacketList* pPacketList = &(it->second);
-        for (it2 = pPacketList->begin(); it2 != pPacketList->end(); ++it2) {
-            av_free_packet(*it2);
-            delete *it2;
-        }
-        pPacketList->clear();
+    map<int, PacketRing>::iterator it;
+    for (it = m_PacketRings.begin(); it != m_PacketRings.end(); ++it) {
+        it->second.clear();
+    }
+}
+
+FFMpegDemuxer::PacketRing& FFMpegDemuxer::getPacketRing(int streamIndex)
+{
+    map<int, PacketRing>::iterator it = m_PacketRings.find(streamIndex);
+    if (it == m_PacketRings.end()) {
+        cerr << this << ": getPacket: Stream " << streamIndex << " not found." << endl;
+        dump();
+        AVG_ASSERT(false);
     }
+    return it->second;
 }
 
 void FFMpegDemuxer::dump()
 {
-    map<int, PacketList>::iterator it;
+    map<int, PacketRing>::iterator it;
     cerr << "FFMpegDemuxer " << this << endl;
-    cerr << "packetlists.size(): " << int(m_PacketLists.size()) << endl;
-    for (it = m_PacketLists.begin(); it != m_PacketLists.end(); ++it) {
-        cerr << "  " << it->first << ":  " << int(it->second.size()) << endl;
+    cerr << "packetrings.size(): " << int(m_PacketRings.size()) << endl;
+    for (it = m_PacketRings.begin(); it != m_PacketRings.end(); ++it) {
+        cerr << "  " << it->first << ":  " << it->second.size() << endl;
+    }
+}
+
+static void resetPacket(AVPacket* pPacket)
+{
+    memset(pPacket, 0, sizeof(AVPacket));
+    av_init_packet(pPacket);
+}
+
+FFMpegDemuxer::PacketRing::PacketRing()
+    : m_Head(0),
+      m_Size(0)
+{
+}
+
+void FFMpegDemuxer::PacketRing::init(int capacity)
+{
+    AVG_ASSERT(capacity > 0);
+    m_Packets.resize(capacity);
+    for (unsigned i = 0; i < m_Packets.size(); ++i) {
+        resetPacket(&m_Packets[i]);
+    }
+}
+
+bool FFMpegDemuxer::PacketRing::empty() const
+{
+    return m_Size == 0;
+}
+
+bool FFMpegDemuxer::PacketRing::full() const
+{
+    return m_Size == int(m_Packets.size());
+}
+
+int FFMpegDemuxer::PacketRing::size() const
+{
+    return m_Size;
+}
+
+void FFMpegDemuxer::PacketRing::push(AVPacket* pPacket)
+{
+    AVG_ASSERT(!full());
+    AVPacket& slot = m_Packets[(m_Head+m_Size) % m_Packets.size()];
+    // Frees stale data left over from before a seek.
+    av_free_packet(&slot);
+    slot = *pPacket;
+    resetPacket(pPacket);
+    m_Size++;
+}
+
+void FFMpegDemuxer::PacketRing::pop(AVPacket* pPacket)
+{
+    AVG_ASSERT(!empty());
+    AVPacket& slot = m_Packets[m_Head];
+    *pPacket = slot;
+    resetPacket(&slot);
+    m_Head = (m_Head+1) % m_Packets.size();
+    m_Size--;
+}
+
+void FFMpegDemuxer::PacketRing::grow()
+{
+    vector<AVPacket> newPackets(m_Packets.size()*2);
+    int capacity = m_Packets.size();
+    for (int i = 0; i < capacity; ++i) {
+        AVPacket& slot = m_Packets[(m_Head+i) % capacity];
+        if (i < m_Size) {
+            newPackets[i] = slot;
+        } else {
+            av_free_packet(&slot);
+        }
+    }
+    for (unsigned i = m_Size; i < newPackets.size(); ++i) {
+        resetPacket(&newPackets[i]);
+    }
+    m_Packets.swap(newPackets);
+    m_Head = 0;
+}
+
+void FFMpegDemuxer::PacketRing::clear()
+{
+    m_Head = 0;
+    m_Size = 0;
+}
+
+void FFMpegDemuxer::PacketRing::freePackets()
+{
+    for (unsigned i = 0; i < m_Packets.size(); ++i) {
+        av_free_packet(&m_Packets[i]);
     }
+    clear();
 }
 
 }
@@ -26,7 +26,6 @@
 
 #include "WrapFFMpeg.h"
 
-#include <list>
 #include <vector>
 #include <map>
 
@@ -36,19 +35,51 @@ namespace avg {
 
 class AVG_API FFMpegDemuxer {
     public:
-        FFMpegDemuxer(AVFormatContext * pFormatContext, std::vector<int> streamIndexes);
+        // Packets that are read for other streams than the one requested are cached
+        // until they are requested. maxCachedPackets bounds each stream's cache.
+        FFMpegDemuxer(AVFormatContext * pFormatContext, std::vector<int> streamIndexes,
+                int maxCachedPackets=256);
         virtual ~FFMpegDemuxer();
        
-        AVPacket * getPacket(int streamIndex);
+        // Returns the next packet of the stream or 0 at EOF. Packets come from the
+        // PacketPool and should be returned using PacketPool::release().
+        // If pbCacheFull is given, getPacket() returns 0 and sets *pbCacheFull instead
+        // of reading past a full cache. The caller should then fetch the cached packets
+        // of the other streams first. Otherwise, the caches grow as needed.
+        AVPacket * getPacket(int streamIndex, bool* pbCacheFull=0);
+        int getNumCachedPackets(int streamIndex) const;
+        bool isCacheFull() const;
         void seek(float destTime);
         void dump();
         
+        // Ring buffer of packets that haven't been delivered yet. Slots outside of the
+        // valid range may still hold data from before a seek; this is freed when the slot
+        // is reused, so clear() doesn't need to touch the packets.
+        class PacketRing {
+            public:
+                PacketRing();
+                void init(int capacity);
+                bool empty() const;
+                bool full() const;
+                int size() const;
+                // Takes over the packet data and resets pPacket.
+                void push(AVPacket* pPacket);
+                void pop(AVPacket* pPacket);
+                void grow();
+                void clear();
+                void freePackets();
+
+            private:
+                std::vector<AVPacket> m_Packets;
+                int m_Head;
+                int m_Size;
+        };
+
     private:
         void clearPacketCache();
+        PacketRing& getPacketRing(int streamIndex);
 
-        // Packets that haven't been delivered yet.
-        typedef std::list<AVPacket *> PacketList;
-        std::map<int, PacketList> m_PacketLists;
+        std::map<int, PacketRing> m_PacketRings;
        
         AVFormatContext * m_pFormatContext;
 };
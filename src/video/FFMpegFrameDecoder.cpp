@@ -21,6 +21,7 @@
 
 #include "FFMpegFrameDecoder.h"
 #include "FFMpegDemuxer.h"
+#include "PacketPool.h"
 #include "VideoInfo.h"
 #ifdef AVG_ENABLE_VDPAU
 #include "VDPAUDecoder.h"
@@ -32,10 +33,12 @@
 #include "../base/ObjectCounter.h"
 #include "../base/ProfilingZoneID.h"
 #include "../base/StringHelper.h"
+#include "../base/TimeSource.h"
 #include "../graphics/Bitmap.h"
 
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #ifndef _WIN32
 #include <unistd.h>
 #endif
@@ -50,7 +53,16 @@ FFMpegFrameDecoder::FFMpegFrameDecoder(AVStream* pStream)
       m_bEOF(false),
       m_StartTimestamp(-1),
       m_LastFrameTime(-1),
-      m_bUseStreamFPS(true)
+      m_bUseStreamFPS(true),
+      m_NumCodecThreads(0),
+      m_CodecThreadType(0),
+      m_NumDecodedFrames(0),
+      m_FirstDecodeTime(-1),
+      m_LastDecodeTime(-1),
+      m_DecodeStartTime(0),
+      m_DecodeStartCPUTime(0),
+      m_DecodeTime(0),
+      m_DecodeCPUTime(0)
 {
     m_TimeUnitsPerSecond = float(1.0/av_q2d(pStream->time_base));
     m_FPS = getStreamFPS(pStream);
@@ -60,6 +72,7 @@ FFMpegFrameDecoder::FFMpegFrameDecoder(AVStream* pStream)
 
 FFMpegFrameDecoder::~FFMpegFrameDecoder()
 {
+    logUtilization();
     if (m_pSwsContext) {
         sws_freeContext(m_pSwsContext);
         m_pSwsContext = 0;
@@ -67,34 +80,50 @@ FFMpegFrameDecoder::~FFMpegFrameDecoder()
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
+// Separate zones per threading mode make it possible to compare the time the
+// decoder thread spends in libavcodec with and without helper threads.
 static ProfilingZoneID DecodePacketProfilingZone("Decode packet", true);
+static ProfilingZoneID DecodePacketFrameThreadsProfilingZone(
+        "Decode packet (frame threads)", true);
+static ProfilingZoneID DecodePacketSliceThreadsProfilingZone(
+        "Decode packet (slice threads)", true);
 
 bool FFMpegFrameDecoder::decodePacket(AVPacket* pPacket, AVFrame* pFrame,
         bool bFrameAfterSeek)
 {
-    ScopeTimer timer(DecodePacketProfilingZone);
+    ScopeTimer timer(getDecodeProfilingZone());
     int bGotPicture = 0;
     AVCodecContext* pContext = m_pStream->codec;
     AVG_ASSERT(pPacket);
+    startDecodeTimer();
     avcodec_decode_video2(pContext, pFrame, &bGotPicture, pPacket);
+    stopDecodeTimer(bGotPicture != 0);
     if (bGotPicture) {
-        m_LastFrameTime = getFrameTime(pPacket->dts, bFrameAfterSeek);
+        long long dts = pPacket->dts;
+        if (pContext->active_thread_type & FF_THREAD_FRAME) {
+            // With frame threading, the picture returned belongs to a packet sent
+            // several calls earlier.
+            dts = pFrame->pkt_dts;
+        }
+        m_LastFrameTime = getFrameTime(dts, bFrameAfterSeek);
     }
-    av_free_packet(pPacket);
-    delete pPacket;
+    PacketPool::get()->release(pPacket);
     return (bGotPicture != 0);
 }
 
 bool FFMpegFrameDecoder::decodeLastFrame(AVFrame* pFrame)
 {
     // EOF. Decode the last data we got.
+    ScopeTimer timer(getDecodeProfilingZone());
     int bGotPicture = 0;
     AVCodecContext* pContext = m_pStream->codec;
     AVPacket packet;
     av_init_packet(&packet);
     packet.data = 0;
     packet.size = 0;
+    startDecodeTimer();
     avcodec_decode_video2(pContext, pFrame, &bGotPicture, &packet);
+    stopDecodeTimer(bGotPicture != 0);
     m_bEOF = true;
 
     // We don't have a timestamp for the last frame, so we'll
@@ -232,6 +261,69 @@ bool FFMpegFrameDecoder::isEOF() const
     return m_bEOF;
 }
 
+ProfilingZoneID& FFMpegFrameDecoder::getDecodeProfilingZone() const
+{
+    int threadType = m_pStream->codec->active_thread_type;
+    if (threadType & FF_THREAD_FRAME) {
+        return DecodePacketFrameThreadsProfilingZone;
+    } else if (threadType & FF_THREAD_SLICE) {
+        return DecodePacketSliceThreadsProfilingZone;
+    } else {
+        return DecodePacketProfilingZone;
+    }
+}
+
+void FFMpegFrameDecoder::startDecodeTimer()
+{
+    TimeSource* pTimeSource = TimeSource::get();
+    m_DecodeStartTime = pTimeSource->getCurrentMicrosecs();
+    m_DecodeStartCPUTime = pTimeSource->getThreadCPUMicrosecs();
+    if (m_FirstDecodeTime == -1) {
+        m_FirstDecodeTime = m_DecodeStartTime;
+        m_NumCodecThreads = m_pStream->codec->thread_count;
+        m_CodecThreadType = m_pStream->codec->active_thread_type;
+    }
+}
+
+void FFMpegFrameDecoder::stopDecodeTimer(bool bGotPicture)
+{
+    TimeSource* pTimeSource = TimeSource::get();
+    m_LastDecodeTime = pTimeSource->getCurrentMicrosecs();
+    m_DecodeTime += m_LastDecodeTime-m_DecodeStartTime;
+    m_DecodeCPUTime += pTimeSource->getThreadCPUMicrosecs()-m_DecodeStartCPUTime;
+    if (bGotPicture) {
+        m_NumDecodedFrames++;
+    }
+}
+
+void FFMpegFrameDecoder::logUtilization() const
+{
+    if (m_NumDecodedFrames == 0 || 
+            !Logger::get()->shouldLog(Logger::category::PROFILE_VIDEO, 
+                    Logger::severity::INFO))
+    {
+        return;
+    }
+    string sThreadType;
+    if (m_CodecThreadType & FF_THREAD_FRAME) {
+        sThreadType = "frame";
+    } else if (m_CodecThreadType & FF_THREAD_SLICE) {
+        sThreadType = "slice";
+    } else {
+        sThreadType = "none";
+    }
+    long long totalTime = max(m_LastDecodeTime-m_FirstDecodeTime, 1LL);
+    long long waitTime = max(m_DecodeTime-m_DecodeCPUTime, 0LL);
+    AVG_TRACE(Logger::category::PROFILE_VIDEO, Logger::severity::INFO,
+            "Video decoder utilization (codec threads: " << m_NumCodecThreads << 
+            ", threading: " << sThreadType << "): " << m_NumDecodedFrames << 
+            " frames in " << totalTime/1000 << " ms. Busy: " << m_DecodeTime/1000 << 
+            " ms (" << 100*m_DecodeTime/totalTime << "%), idle: " << 
+            (totalTime-m_DecodeTime)/1000 << " ms, waiting for codec threads: " << 
+            waitTime/1000 << " ms, " << 
+            float(m_DecodeTime)/m_NumDecodedFrames/1000 << " ms per frame.");
+}
+
 float FFMpegFrameDecoder::getFrameTime(long long dts, bool bFrameAfterSeek)
 {
     bool bUseStreamFPS = m_bUseStreamFPS;
@@ -32,6 +32,7 @@ namespace avg {
 
 class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
+class ProfilingZoneID;
 
 class AVG_API FFMpegFrameDecoder
 {
@@ -54,6 +55,10 @@ class AVG_API FFMpegFrameDecoder
         
     private:
         float getFrameTime(long long dts, bool bFrameAfterSeek);
+        ProfilingZoneID& getDecodeProfilingZone() const;
+        void startDecodeTimer();
+        void stopDecodeTimer(bool bGotPicture);
+        void logUtilization() const;
 
         SwsContext * m_pSwsContext;
         AVStream* m_pStream;
@@ -66,6 +71,19 @@ class AVG_API FFMpegFrameDecoder
 
         bool m_bUseStreamFPS;
         float m_FPS;
+
+        // Decoder thread utilization, all times in microseconds. Time spent in
+        // libavcodec that isn't cpu time of the decoding thread is spent waiting for
+        // codec threads.
+        int m_NumCodecThreads;
+        int m_CodecThreadType;
+        int m_NumDecodedFrames;
+        long long m_FirstDecodeTime;
+        long long m_LastDecodeTime;
+        long long m_DecodeStartTime;
+        long long m_DecodeStartCPUTime;
+        long long m_DecodeTime;
+        long long m_DecodeCPUTime;
 };
 
 typedef boost::shared_ptr<FFMpegFrameDecoder> FFMpegFrameDecoderPtr;
@@ -0,0 +1,213 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "FFMpegFramePool.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+#include "../graphics/Bitmap.h"
+
+#ifdef AVG_ENABLE_FRAME_POOL
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+#endif
+
+using namespace std;
+
+// Line lengths are padded to this so SIMD conversion and texture upload code can work
+// on whole cache lines.
+#define PLANE_ALIGNMENT 64
+
+namespace avg {
+
+#ifdef AVG_ENABLE_FRAME_POOL
+// Deletes a Bitmap that wraps pool memory and releases the memory to the pool.
+class PlaneBufferDeleter
+{
+public:
+    PlaneBufferDeleter(AVBufferRef* pBufRef)
+        : m_pBufRef(pBufRef)
+    {
+    }
+
+    void operator()(Bitmap* pBmp) const
+    {
+        delete pBmp;
+        AVBufferRef* pBufRef = m_pBufRef;
+        av_buffer_unref(&pBufRef);
+    }
+
+private:
+    AVBufferRef* m_pBufRef;
+};
+#endif
+
+FFMpegFramePool::FFMpegFramePool()
+{
+#ifdef AVG_ENABLE_FRAME_POOL
+    for (int i = 0; i < 4; ++i) {
+        m_pPools[i] = 0;
+        m_PoolSizes[i] = 0;
+    }
+#endif
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+FFMpegFramePool::~FFMpegFramePool()
+{
+#ifdef AVG_ENABLE_FRAME_POOL
+    // Buffers that are still in use keep their pool alive until they are released.
+    for (int i = 0; i < 4; ++i) {
+        av_buffer_pool_uninit(&m_pPools[i]);
+    }
+#endif
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+bool FFMpegFramePool::isSupported()
+{
+#ifdef AVG_ENABLE_FRAME_POOL
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FFMpegFramePool::attach(AVCodecContext* pContext)
+{
+#ifdef AVG_ENABLE_FRAME_POOL
+    pContext->opaque = this;
+    pContext->get_buffer2 = FFMpegFramePool::getBuffer2;
+#ifdef CODEC_FLAG_EMU_EDGE
+    // Pool buffers don't have room for the borders some codecs draw around frames.
+    pContext->flags |= CODEC_FLAG_EMU_EDGE;
+#endif
+#else
+    AVG_ASSERT(false);
+#endif
+}
+
+bool FFMpegFramePool::canWrap(AVFrame* pFrame)
+{
+#ifdef AVG_ENABLE_FRAME_POOL
+    return pFrame->buf[0] != 0;
+#else
+    return false;
+#endif
+}
+
+BitmapPtr FFMpegFramePool::wrapPlane(AVFrame* pFrame, int plane, const IntPoint& size)
+{
+#ifdef AVG_ENABLE_FRAME_POOL
+    AVBufferRef* pPlaneBuf = av_frame_get_plane_buffer(pFrame, plane);
+    AVG_ASSERT(pPlaneBuf);
+    AVBufferRef* pBufRef = av_buffer_ref(pPlaneBuf);
+    if (!pBufRef) {
+        throw Exception(AVG_ERR_VIDEO_GENERAL, "FFMpegFramePool: Out of memory.");
+    }
+    return BitmapPtr(new Bitmap(size, I8, pFrame->data[plane], pFrame->linesize[plane],
+            false), PlaneBufferDeleter(pBufRef));
+#else
+    AVG_ASSERT(false);
+    return BitmapPtr();
+#endif
+}
+
+#ifdef AVG_ENABLE_FRAME_POOL
+int FFMpegFramePool::getBuffer2(AVCodecContext* pContext, AVFrame* pFrame, int flags)
+{
+    bool bFormatSupported;
+    switch (pFrame->format) {
+        case PIX_FMT_YUV420P:
+        case PIX_FMT_YUVJ420P:
+        case PIX_FMT_YUVA420P:
+            bFormatSupported = true;
+            break;
+        default:
+            bFormatSupported = false;
+    }
+    if (!bFormatSupported || !(pContext->codec->capabilities & CODEC_CAP_DR1)) {
+        return avcodec_default_get_buffer2(pContext, pFrame, flags);
+    }
+    FFMpegFramePool* pPool = (FFMpegFramePool*)pContext->opaque;
+    return pPool->allocFrame(pContext, pFrame);
+}
+
+int FFMpegFramePool::allocFrame(AVCodecContext* pContext, AVFrame* pFrame)
+{
+    AVPixelFormat pixFmt = AVPixelFormat(pFrame->format);
+    int width = pFrame->width;
+    int height = pFrame->height;
+    int linesizeAlign[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(pContext, &width, &height, linesizeAlign);
+
+    int linesizes[4];
+    int rc = av_image_fill_linesizes(linesizes, pixFmt, width);
+    if (rc < 0) {
+        return rc;
+    }
+    const AVPixFmtDescriptor* pDesc = av_pix_fmt_desc_get(pixFmt);
+    int numPlanes = av_pix_fmt_count_planes(pixFmt);
+
+    boost::mutex::scoped_lock lock(m_Mutex);
+    for (int i = 0; i < AV_NUM_DATA_POINTERS; ++i) {
+        pFrame->buf[i] = 0;
+        pFrame->data[i] = 0;
+        pFrame->linesize[i] = 0;
+    }
+    for (int i = 0; i < numPlanes; ++i) {
+        int linesize = FFALIGN(linesizes[i], PLANE_ALIGNMENT);
+        int planeHeight = height;
+        if (i == 1 || i == 2) {
+            planeHeight = -((-height) >> pDesc->log2_chroma_h);
+        }
+        // Optimized decoder code may read up to 16 bytes past the end of a plane.
+        AVBufferPool* pPool = getPlanePool(i, linesize*planeHeight + 16);
+        if (pPool) {
+            pFrame->buf[i] = av_buffer_pool_get(pPool);
+        }
+        if (!pFrame->buf[i]) {
+            for (int j = 0; j < i; ++j) {
+                av_buffer_unref(&pFrame->buf[j]);
+            }
+            return AVERROR(ENOMEM);
+        }
+        pFrame->data[i] = pFrame->buf[i]->data;
+        pFrame->linesize[i] = linesize;
+    }
+    pFrame->extended_data = pFrame->data;
+    return 0;
+}
+
+AVBufferPool* FFMpegFramePool::getPlanePool(int plane, int size)
+{
+    if (!m_pPools[plane] || m_PoolSizes[plane] != size) {
+        // Frame size changed.
+        av_buffer_pool_uninit(&m_pPools[plane]);
+        m_pPools[plane] = av_buffer_pool_init(size, av_buffer_alloc);
+        m_PoolSizes[plane] = size;
+    }
+    return m_pPools[plane];
+}
+#endif
+
+}
@@ -0,0 +1,77 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _FFMpegFramePool_H_
+#define _FFMpegFramePool_H_
+
+#include "../api.h"
+#include "../avgconfigwrapper.h"
+#include "../base/GLMHelper.h"
+
+#include "WrapFFMpeg.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(55, 0, 0)
+#define AVG_ENABLE_FRAME_POOL
+#endif
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// Makes libavcodec decode planar YUV frames directly into pooled, aligned buffers.
+// Decoded planes can then be handed to other threads as Bitmaps without copying; the
+// buffers go back to the pool when the last Bitmap referencing them is deleted. Pool
+// memory stays valid after the FFMpegFramePool itself has been deleted.
+class AVG_API FFMpegFramePool
+{
+public:
+    FFMpegFramePool();
+    virtual ~FFMpegFramePool();
+
+    static bool isSupported();
+    // Also sets pContext->opaque, so this can't be combined with VDPAU.
+    void attach(AVCodecContext* pContext);
+
+    // True if the frame's planes are reference counted, i.e. can be wrapped.
+    static bool canWrap(AVFrame* pFrame);
+    static BitmapPtr wrapPlane(AVFrame* pFrame, int plane, const IntPoint& size);
+
+private:
+#ifdef AVG_ENABLE_FRAME_POOL
+    static int getBuffer2(AVCodecContext* pContext, AVFrame* pFrame, int flags);
+    int allocFrame(AVCodecContext* pContext, AVFrame* pFrame);
+    AVBufferPool* getPlanePool(int plane, int size);
+
+    boost::mutex m_Mutex;
+    AVBufferPool* m_pPools[4];
+    int m_PoolSizes[4];
+#endif
+};
+
+typedef boost::shared_ptr<FFMpegFramePool> FFMpegFramePoolPtr;
+
+}
+#endif
+
@@ -0,0 +1,92 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "PacketPool.h"
+
+#include <stdlib.h>
+#include <cstring>
+
+using namespace std;
+
+// Upper bound for the number of unused packets kept around.
+#define MAX_FREE_PACKETS 1024
+
+namespace avg {
+
+PacketPool* PacketPool::s_pPacketPool = 0;
+
+void deletePacketPool()
+{
+    delete PacketPool::s_pPacketPool;
+    PacketPool::s_pPacketPool = 0;
+}
+
+PacketPool* PacketPool::get()
+{
+    // The first call happens in the main thread (see VideoDecoder::initVideoSupport()).
+    if (!s_pPacketPool) {
+        s_pPacketPool = new PacketPool();
+        atexit(deletePacketPool);
+    }
+    return s_pPacketPool;
+}
+
+PacketPool::PacketPool()
+{
+}
+
+PacketPool::~PacketPool()
+{
+    for (unsigned i = 0; i < m_pFreePackets.size(); ++i) {
+        delete m_pFreePackets[i];
+    }
+}
+
+AVPacket* PacketPool::alloc()
+{
+    AVPacket* pPacket = 0;
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        if (!m_pFreePackets.empty()) {
+            pPacket = m_pFreePackets.back();
+            m_pFreePackets.pop_back();
+        }
+    }
+    if (!pPacket) {
+        pPacket = new AVPacket;
+    }
+    memset(pPacket, 0, sizeof(AVPacket));
+    av_init_packet(pPacket);
+    return pPacket;
+}
+
+void PacketPool::release(AVPacket* pPacket)
+{
+    av_free_packet(pPacket);
+    boost::mutex::scoped_lock lock(m_Mutex);
+    if (m_pFreePackets.size() < MAX_FREE_PACKETS) {
+        m_pFreePackets.push_back(pPacket);
+    } else {
+        delete pPacket;
+    }
+}
+
+}
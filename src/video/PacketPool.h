@@ -0,0 +1,59 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _PacketPool_H_
+#define _PacketPool_H_
+
+#include "../api.h"
+#include "WrapFFMpeg.h"
+
+#include <boost/thread/mutex.hpp>
+
+#include <vector>
+
+namespace avg {
+
+// Recycles AVPacket structs so demuxing doesn't need a heap allocation per packet.
+// Packets can be released from any thread.
+class AVG_API PacketPool
+{
+public:
+    static PacketPool* get();
+    virtual ~PacketPool();
+
+    // Returns an initialized, empty packet.
+    AVPacket* alloc();
+    // Frees the packet data and keeps the struct for reuse.
+    void release(AVPacket* pPacket);
+
+private:
+    PacketPool();
+
+    boost::mutex m_Mutex;
+    std::vector<AVPacket*> m_pFreePackets;
+
+    static PacketPool* s_pPacketPool;
+    friend void deletePacketPool();
+};
+
+}
+#endif
+
@@ -20,10 +20,12 @@
 //
 
 #include "VideoDecoder.h"
+#include "PacketPool.h"
 #ifdef AVG_ENABLE_VDPAU
 #include "VDPAUDecoder.h"
 #endif
 
+#include "../base/ConfigMgr.h"
 #include "../base/Exception.h"
 #include "../base/Logger.h"
 #include "../base/ObjectCounter.h"
@@ -57,6 +59,8 @@ VideoDecoder::VideoDecoder()
 #ifdef AVG_ENABLE_VDPAU
       m_pVDPAUDecoder(0),
 #endif
+      m_bUseFramePool(ConfigMgr::get()->getBoolOption("video", "framepool", false)),
+      m_NumDecoderThreads(-1),
       m_AStreamIndex(-1),
       m_pAStream(0)
 {
@@ -212,6 +216,7 @@ void VideoDecoder::close()
         m_pVStream = 0;
         m_VStreamIndex = -1;
     }
+    m_pFramePool = FFMpegFramePoolPtr();
 
     if (m_pAStream) {
         avcodec_close(m_pAStream->codec);
@@ -230,6 +235,18 @@ VideoDecoder::DecoderState VideoDecoder::getState() const
     return m_State;
 }
 
+void VideoDecoder::setNumDecoderThreads(int numThreads)
+{
+    AVG_ASSERT(m_State == CLOSED);
+    m_NumDecoderThreads = numThreads;
+}
+
+void VideoDecoder::setUseFramePool(bool bUseFramePool)
+{
+    AVG_ASSERT(m_State == CLOSED);
+    m_bUseFramePool = bUseFramePool;
+}
+
 VideoInfo VideoDecoder::getVideoInfo() const
 {
     AVG_ASSERT(m_State != CLOSED);
@@ -319,6 +336,11 @@ bool VideoDecoder::usesVDPAU() const
 #endif
 }
 
+bool VideoDecoder::usesFramePool() const
+{
+    return m_pFramePool.get() != 0;
+}
+
 AVCodecContext const* VideoDecoder::getCodecContext() const
 {
     return m_pVStream->codec;
@@ -369,6 +391,7 @@ void VideoDecoder::initVideoSupport()
 {
     if (!s_bInitialized) {
         av_register_all();
+        PacketPool::get();
         s_bInitialized = true;
         // Tune libavcodec console spam.
 //        av_log_set_level(AV_LOG_DEBUG);
@@ -390,20 +413,62 @@ int VideoDecoder::openCodec(int streamIndex, bool bUseHardwareAcceleration)
         pCodec = m_pVDPAUDecoder->openCodec(pContext);
     } 
 #endif
+    bool bUseVDPAU = (pCodec != 0);
     if (!pCodec) {
         pCodec = avcodec_find_decoder(pContext->codec_id);
+        if (streamIndex == m_VStreamIndex && FFMpegFramePool::isSupported() &&
+                m_bUseFramePool)
+        {
+            m_pFramePool = FFMpegFramePoolPtr(new FFMpegFramePool());
+            m_pFramePool->attach(pContext);
+        }
     }
     if (!pCodec) {
         return -1;
     }
+    if (streamIndex == m_VStreamIndex && !bUseVDPAU) {
+        setupThreading(pContext);
+    }
     int rc = avcodec_open2(pContext, pCodec, 0);
 
     if (rc < 0) {
         return -1;
     }
+    if (streamIndex == m_VStreamIndex) {
+        string sThreadType;
+        if (pContext->active_thread_type & FF_THREAD_FRAME) {
+            sThreadType = "frame";
+        } else if (pContext->active_thread_type & FF_THREAD_SLICE) {
+            sThreadType = "slice";
+        } else {
+            sThreadType = "none";
+        }
+        AVG_TRACE(Logger::category::VIDEO, Logger::severity::INFO, m_sFilename <<
+                ": Decoder threads: " << pContext->thread_count << ", threading: " <<
+                sThreadType);
+    }
     return 0;
 }
 
+void VideoDecoder::setupThreading(AVCodecContext* pContext)
+{
+    int numThreads = m_NumDecoderThreads;
+    if (numThreads == -1) {
+        numThreads = ConfigMgr::get()->getIntOption("video", "decoderthreads", 1);
+    }
+    if (numThreads < 0) {
+        numThreads = 0;
+    }
+    pContext->thread_count = numThreads;
+    if (numThreads == 1) {
+        pContext->thread_type = 0;
+    } else {
+        // libavcodec picks frame threading if the codec supports it. That decodes
+        // several frames in parallel at the cost of a few frames latency.
+        pContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    }
+}
+
 float VideoDecoder::getDuration(StreamSelect streamSelect) const
 {
     AVG_ASSERT(m_State != CLOSED);
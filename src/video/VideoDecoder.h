@@ -26,6 +26,7 @@
 #include "../avgconfigwrapper.h"
 
 #include "VideoInfo.h"
+#include "FFMpegFramePool.h"
 
 #include "../graphics/PixelFormat.h"
 
@@ -62,6 +63,12 @@ class AVG_API VideoDecoder
         virtual void startDecoding(bool bDeliverYCbCr, const AudioParams* pAP);
         virtual void close();
         virtual DecoderState getState() const;
+        // Number of threads libavcodec uses to decode the video stream. 0 lets
+        // libavcodec choose, -1 uses the avgrc setting. Must be called before open().
+        void setNumDecoderThreads(int numThreads);
+        // Overrides the video:framepool avgrc setting. Must be called before open().
+        void setUseFramePool(bool bUseFramePool);
+        bool usesFramePool() const;
         VideoInfo getVideoInfo() const;
         PixelFormat getPixelFormat() const;
         IntPoint getSize() const;
@@ -102,6 +109,7 @@ class AVG_API VideoDecoder
     private:
         void initVideoSupport();
         int openCodec(int streamIndex, bool bUseHardwareAcceleration);
+        void setupThreading(AVCodecContext* pContext);
         float getDuration(StreamSelect streamSelect) const;
         PixelFormat calcPixelFormat(bool bUseYCbCr);
         std::string getStreamPF() const;
@@ -118,6 +126,9 @@ class AVG_API VideoDecoder
 #ifdef AVG_ENABLE_VDPAU
         VDPAUDecoder* m_pVDPAUDecoder;
 #endif
+        FFMpegFramePoolPtr m_pFramePool;
+        bool m_bUseFramePool;
+        int m_NumDecoderThreads;
         
         // Audio
         int m_AStreamIndex;
@@ -21,6 +21,7 @@
 
 #include "VideoDecoderThread.h"
 #include "FFMpegFrameDecoder.h"
+#include "FFMpegFramePool.h"
 
 #include "../base/Logger.h"
 #include "../base/Exception.h"
@@ -37,7 +38,7 @@ namespace avg {
 
 VideoDecoderThread::VideoDecoderThread(CQueue& cmdQ, VideoMsgQueue& msgQ, 
         VideoMsgQueue& packetQ, AVStream* pStream, const IntPoint& size, PixelFormat pf, 
-        bool bUseVDPAU)
+        bool bUseVDPAU, bool bUseFramePool)
     : WorkerThread<VideoDecoderThread>(string("Video Decoder"), cmdQ, 
             Logger::category::PROFILE_VIDEO),
       m_MsgQ(msgQ),
@@ -47,6 +48,7 @@ VideoDecoderThread::VideoDecoderThread(CQueue& cmdQ, VideoMsgQueue& msgQ,
       m_Size(size),
       m_PF(pf),
       m_bUseVDPAU(bUseVDPAU),
+      m_bUseFramePool(bUseFramePool),
       m_bSeekDone(false),
       m_bProcessingLastFrames(false)
 {
@@ -76,6 +78,20 @@ void VideoDecoderThread::deinit()
 #endif
 }
 
+void VideoDecoderThread::addQueueListener(IQueueListener* pListener)
+{
+    WorkerThread<VideoDecoderThread>::addQueueListener(pListener);
+    m_PacketQ.addPushListener(pListener);
+    m_MsgQ.addPopListener(pListener);
+}
+
+void VideoDecoderThread::removeQueueListener(IQueueListener* pListener)
+{
+    WorkerThread<VideoDecoderThread>::removeQueueListener(pListener);
+    m_PacketQ.removeListener(pListener);
+    m_MsgQ.removeListener(pListener);
+}
+
 static ProfilingZoneID DecoderProfilingZone("Video Decoder Thread", true);
 static ProfilingZoneID PacketWaitProfilingZone("Video wait for packet", true);
 
@@ -84,11 +100,25 @@ bool VideoDecoderThread::work()
     ScopeTimer timer(DecoderProfilingZone);
     if (m_bProcessingLastFrames) {
         // EOF received, but last frames still need to be decoded.
+        if (isScheduled() && isMsgQFull()) {
+            setIdle();
+            return true;
+        }
         handleEOF();
     } else {
         // Standard decoding.
         VideoMsgPtr pMsg;
-        {
+        if (isScheduled()) {
+            // Only this thread pushes to m_MsgQ, so if there is space now, the push
+            // after decoding won't block.
+            if (!isMsgQFull()) {
+                pMsg = m_PacketQ.pop(false);
+            }
+            if (!pMsg) {
+                setIdle();
+                return true;
+            }
+        } else {
             ScopeTimer timer(PacketWaitProfilingZone);
             pMsg = m_PacketQ.pop(true);
         }
@@ -122,6 +152,10 @@ void VideoDecoderThread::setFPS(float fps)
 
 void VideoDecoderThread::returnFrame(VideoMsgPtr pMsg)
 {
+    if (!pMsg->getFrameBitmap(0)->ownsBits()) {
+        // Frame pool memory is recycled when the bitmaps are deleted.
+        return;
+    }
     m_pBmpQ->push(pMsg->getFrameBitmap(0));
     if (pixelFormatIsPlanar(m_PF)) {
         m_pHalfBmpQ->push(pMsg->getFrameBitmap(1));
@@ -163,6 +197,7 @@ void VideoDecoderThread::handleSeekDone(VideoMsgPtr pMsg)
 }
 
 static ProfilingZoneID CopyImageProfilingZone("Copy image", true);
+static ProfilingZoneID WrapImageProfilingZone("Wrap pooled image", true);
 
 void VideoDecoderThread::sendFrame(AVFrame* pFrame)
 {
@@ -172,7 +207,19 @@ void VideoDecoderThread::sendFrame(AVFrame* pFrame)
         pMsg->setVDPAUFrame(pRenderState, m_pFrameDecoder->getCurTime());
     } else {
         vector<BitmapPtr> pBmps;
-        if (pixelFormatIsPlanar(m_PF)) {
+        if (pixelFormatIsPlanar(m_PF) && m_bUseFramePool &&
+                FFMpegFramePool::canWrap(pFrame))
+        {
+            // Zero-copy: The bitmaps reference the decoder's buffers directly.
+            ScopeTimer timer(WrapImageProfilingZone);
+            IntPoint halfSize(m_Size.x/2, m_Size.y/2);
+            pBmps.push_back(FFMpegFramePool::wrapPlane(pFrame, 0, m_Size));
+            pBmps.push_back(FFMpegFramePool::wrapPlane(pFrame, 1, halfSize));
+            pBmps.push_back(FFMpegFramePool::wrapPlane(pFrame, 2, halfSize));
+            if (m_PF == YCbCrA420p) {
+                pBmps.push_back(FFMpegFramePool::wrapPlane(pFrame, 3, m_Size));
+            }
+        } else if (pixelFormatIsPlanar(m_PF)) {
             ScopeTimer timer(CopyImageProfilingZone);
             IntPoint halfSize(m_Size.x/2, m_Size.y/2);
             pBmps.push_back(getBmp(m_pBmpQ, m_Size, I8));
@@ -212,6 +259,11 @@ BitmapPtr VideoDecoderThread::getBmp(BitmapQueuePtr pBmpQ, const IntPoint& size,
     }
 }
 
+bool VideoDecoderThread::isMsgQFull() const
+{
+    return m_MsgQ.getMaxSize() != -1 && m_MsgQ.size() >= m_MsgQ.getMaxSize();
+}
+
 static ProfilingZoneID PushMsgProfilingZone("Push message", true);
 
 void VideoDecoderThread::pushMsg(VideoMsgPtr pMsg)
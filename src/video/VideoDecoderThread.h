@@ -47,12 +47,15 @@ typedef boost::shared_ptr<FFMpegFrameDecoder> FFMpegFrameDecoderPtr;
 class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
     public:
         VideoDecoderThread(CQueue& cmdQ, VideoMsgQueue& msgQ, VideoMsgQueue& packetQ, 
-                AVStream* pStream, const IntPoint& size, PixelFormat pf, bool bUseVDPAU);
+                AVStream* pStream, const IntPoint& size, PixelFormat pf, bool bUseVDPAU,
+                bool bUseFramePool);
         virtual ~VideoDecoderThread();
         virtual bool init();
         virtual void deinit();
         
         bool work();
+        virtual void addQueueListener(IQueueListener* pListener);
+        virtual void removeQueueListener(IQueueListener* pListener);
         void setFPS(float fps);
         void returnFrame(VideoMsgPtr pMsg);
 
@@ -64,6 +67,7 @@ class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
         void close();
         BitmapPtr getBmp(BitmapQueuePtr pBmpQ, const IntPoint& size, PixelFormat pf);
         void pushMsg(VideoMsgPtr pMsg);
+        bool isMsgQFull() const;
 
         VideoMsgQueue& m_MsgQ;
         FFMpegFrameDecoderPtr m_pFrameDecoder;
@@ -75,6 +79,7 @@ class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
         IntPoint m_Size;
         PixelFormat m_PF;
         bool m_bUseVDPAU;
+        bool m_bUseFramePool;
 
         bool m_bSeekDone;
         bool m_bProcessingLastFrames;
@@ -58,6 +58,25 @@ bool VideoDemuxerThread::init()
     return true;
 }
 
+void VideoDemuxerThread::addQueueListener(IQueueListener* pListener)
+{
+    WorkerThread<VideoDemuxerThread>::addQueueListener(pListener);
+    // Full packet queues make the demuxer idle.
+    map<int, VideoMsgQueuePtr>::iterator it;
+    for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
+        it->second->addPopListener(pListener);
+    }
+}
+
+void VideoDemuxerThread::removeQueueListener(IQueueListener* pListener)
+{
+    WorkerThread<VideoDemuxerThread>::removeQueueListener(pListener);
+    map<int, VideoMsgQueuePtr>::iterator it;
+    for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
+        it->second->removeListener(pListener);
+    }
+}
+
 bool VideoDemuxerThread::work() 
 {
     if (m_bEOF) {
@@ -66,10 +85,14 @@ bool VideoDemuxerThread::work()
         map<int, VideoMsgQueuePtr>::iterator it;
         int shortestQ = -1;
         int shortestLength = INT_MAX;
+        // If one stream is too far ahead of the others, the demuxer can't read on until
+        // some of that stream's cached packets have been delivered.
+        bool bCacheFull = m_pDemuxer->isCacheFull();
         for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
             if (it->second->size() < shortestLength && 
                     it->second->size() < it->second->getMaxSize() &&
-                    !m_PacketQEOFMap[it->first])
+                    !m_PacketQEOFMap[it->first] &&
+                    (!bCacheFull || m_pDemuxer->getNumCachedPackets(it->first) > 0))
             {
                 shortestLength = it->second->size();
                 shortestQ = it->first;
@@ -77,15 +100,23 @@ bool VideoDemuxerThread::work()
         }
         
         if (shortestQ < 0) {
-            // All queues are at their max capacity. Take a nap and try again later.
+            // All queues we can deliver to are at their max capacity. Take a nap and try
+            // again later.
             // Note that we can't wait on the queue. If decoding is paused, the queues can
             // remain full indefinitely and commands from the application (seek() and 
             // close() must still be processed.
-            msleep(10);
+            if (isScheduled()) {
+                setIdle();
+            } else {
+                msleep(10);
+            }
             return true;
         }
 
-        AVPacket * pPacket = m_pDemuxer->getPacket(shortestQ);
+        AVPacket * pPacket = m_pDemuxer->getPacket(shortestQ, &bCacheFull);
+        if (bCacheFull) {
+            return true;
+        }
         VideoMsgPtr pMsg(new VideoMsg);
         if (pPacket == 0) {
             onStreamEOF(shortestQ);
@@ -94,7 +125,9 @@ bool VideoDemuxerThread::work()
             pMsg->setPacket(pPacket);
         }
         m_PacketQs[shortestQ]->push(pMsg);
-        msleep(0);
+        if (!isScheduled()) {
+            msleep(0);
+        }
     }
     return true;
 }
@@ -43,6 +43,8 @@ class AVG_API VideoDemuxerThread: public WorkerThread<VideoDemuxerThread> {
         virtual ~VideoDemuxerThread();
         bool init();
         bool work();
+        virtual void addQueueListener(IQueueListener* pListener);
+        virtual void removeQueueListener(IQueueListener* pListener);
 
         void seek(int seqNum, float DestTime);
         void close();
@@ -21,6 +21,7 @@
 
 #include "VideoMsg.h"
 #include "WrapFFMpeg.h"
+#include "PacketPool.h"
 
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
@@ -66,8 +67,7 @@ AVPacket * VideoMsg::getPacket()
 void VideoMsg::freePacket()
 {
     if (getType() == PACKET) {
-        av_free_packet(m_pPacket);
-        delete m_pPacket;
+        PacketPool::get()->release(m_pPacket);
         m_pPacket = 0;
     }
 }
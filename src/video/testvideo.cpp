@@ -21,6 +21,8 @@
 
 #include "AsyncVideoDecoder.h"
 #include "SyncVideoDecoder.h"
+#include "FFMpegDemuxer.h"
+#include "PacketPool.h"
 #ifdef AVG_ENABLE_VDPAU
 #include "VDPAUDecoder.h"
 #endif
@@ -40,6 +42,7 @@
 
 #include <string>
 #include <sstream>
+#include <set>
 #include <cmath>
 
 #include <glib-object.h>
@@ -174,6 +177,11 @@ class VideoDecoderTest: public DecoderTest {
         void runTests()
         {
             basicFileTest("mpeg1-48x48.mov", 30);
+            testDecoderThreads("mpeg1-48x48.mov");
+            testDecoderThreads("h264-48x48.h264");
+            if (isThreaded() && !useHardwareAcceleration()) {
+                testFramePool("mpeg1-48x48.mov");
+            }
 #ifndef AVG_ENABLE_RPI
             basicFileTest("mjpeg-48x48.avi", 202);
             testSeeks("mjpeg-48x48.avi");
@@ -246,6 +254,110 @@ class VideoDecoderTest: public DecoderTest {
 
         }
 
+        void testDecoderThreads(const string& sFilename)
+        {
+            // Decoding with several libavcodec threads must deliver the same frames
+            // at the same times as single-threaded decoding.
+            cerr << "    Testing " << sFilename << " (decoder threads)" << endl;
+            vector<BitmapPtr> pSingleThreadBmps;
+            vector<BitmapPtr> pMultiThreadBmps;
+            readAllFrames(sFilename, 1, pSingleThreadBmps);
+            readAllFrames(sFilename, 4, pMultiThreadBmps);
+            TEST(!pSingleThreadBmps.empty());
+            TEST(pSingleThreadBmps.size() == pMultiThreadBmps.size());
+            unsigned numFrames = min(pSingleThreadBmps.size(), pMultiThreadBmps.size());
+            for (unsigned i = 0; i < numFrames; ++i) {
+                testEqual(*pMultiThreadBmps[i], *pSingleThreadBmps[i],
+                        sFilename+"_threads_"+toString(i));
+            }
+        }
+
+        void testFramePool(const string& sFilename)
+        {
+            // Planes decoded into pool buffers must be identical to copied planes, and
+            // the pool must hand out the same buffers again once frames are released.
+            if (!FFMpegFramePool::isSupported()) {
+                cerr << "    Skipping frame pool test: Not supported by libavcodec." 
+                        << endl;
+                return;
+            }
+            cerr << "    Testing " << sFilename << " (frame pool)" << endl;
+            vector<BitmapPtr> pCopiedBmps;
+            vector<BitmapPtr> pPooledBmps;
+            set<const unsigned char*> pPoolBuffers;
+            readYCbCrFrames(sFilename, false, pCopiedBmps, pPoolBuffers);
+            TEST(pPoolBuffers.empty());
+            readYCbCrFrames(sFilename, true, pPooledBmps, pPoolBuffers);
+            TEST(!pCopiedBmps.empty());
+            TEST(pCopiedBmps.size() == pPooledBmps.size());
+            unsigned numBmps = min(pCopiedBmps.size(), pPooledBmps.size());
+            for (unsigned i = 0; i < numBmps; ++i) {
+                testEqual(*pPooledBmps[i], *pCopiedBmps[i], 
+                        sFilename+"_pool_"+toString(i), 0, 0);
+            }
+            // Only a queue's worth of frames is in flight at any time.
+            TEST(!pPoolBuffers.empty());
+            TEST(pPoolBuffers.size() < pPooledBmps.size()/2);
+        }
+
+        // Reads the Y planes of all frames. If bUseFramePool is set, the addresses of
+        // the pool buffers the planes were delivered in are collected in pPoolBuffers.
+        void readYCbCrFrames(const string& sFilename, bool bUseFramePool,
+                vector<BitmapPtr>& pYBmps, set<const unsigned char*>& pPoolBuffers)
+        {
+            VideoDecoderPtr pDecoder = createDecoder();
+            pDecoder->setUseFramePool(bUseFramePool);
+            pDecoder->open(getMediaLoc(sFilename), useHardwareAcceleration(), true);
+            TEST(pDecoder->usesFramePool() == bUseFramePool);
+            float timePerFrame = 1.0f/pDecoder->getFPS();
+            pDecoder->startDecoding(true, getAudioParams());
+            TEST(pDecoder->getPixelFormat() == YCbCr420p);
+            float curTime = 0;
+            while (!pDecoder->isEOF()) {
+                vector<BitmapPtr> pBmps(3);
+                FrameAvailableCode frameAvailable = 
+                        pDecoder->getRenderedBmps(pBmps, curTime);
+                if (frameAvailable == FA_NEW_FRAME) {
+                    pYBmps.push_back(BitmapPtr(new Bitmap(*pBmps[0])));
+                    if (bUseFramePool) {
+                        pPoolBuffers.insert(pBmps[0]->getPixels());
+                    }
+                } else {
+                    msleep(0);
+                }
+                if (frameAvailable == FA_NEW_FRAME || frameAvailable == FA_USE_LAST_FRAME)
+                { 
+                    curTime += timePerFrame;
+                }
+            }
+            pDecoder->close();
+        }
+
+        void readAllFrames(const string& sFilename, int numDecoderThreads,
+                vector<BitmapPtr>& pBmps)
+        {
+            VideoDecoderPtr pDecoder = createDecoder();
+            pDecoder->setNumDecoderThreads(numDecoderThreads);
+            pDecoder->open(getMediaLoc(sFilename), useHardwareAcceleration(), true);
+            float timePerFrame = 1.0f/pDecoder->getFPS();
+            pDecoder->startDecoding(false, getAudioParams());
+            BitmapPtr pBmp;
+            float curTime = 0;
+            while (!pDecoder->isEOF()) {
+                FrameAvailableCode frameAvailable = pDecoder->getRenderedBmp(pBmp, curTime);
+                if (frameAvailable == FA_NEW_FRAME) {
+                    pBmps.push_back(BitmapPtr(new Bitmap(*pBmp)));
+                } else {
+                    msleep(0);
+                }
+                if (frameAvailable == FA_NEW_FRAME || frameAvailable == FA_USE_LAST_FRAME)
+                { 
+                    curTime += timePerFrame;
+                }
+            }
+            pDecoder->close();
+        }
+
         void readWholeFile(const string& sFilename, float speedFactor, 
                 int expectedNumFrames)
         {
@@ -472,11 +584,169 @@ class AVDecoderTest: public DecoderTest {
 };
 
 
+class DemuxerTest: public Test {
+    public:
+        DemuxerTest()
+          : Test("DemuxerTest", 2)
+        {}
+
+        void runTests()
+        {
+            av_register_all();
+            testPacketRing();
+            testCacheFull();
+        }
+
+    private:
+        void testPacketRing()
+        {
+            cerr << "    Testing PacketRing" << endl;
+            FFMpegDemuxer::PacketRing ring;
+            ring.init(4);
+            TEST(ring.empty());
+            TEST(!ring.full());
+            int numPushed = 0;
+            int numPopped = 0;
+            // Fill and partially drain the ring several times so the packets wrap around
+            // the end of the slot array.
+            for (int i = 0; i < 5; ++i) {
+                while (!ring.full()) {
+                    pushPacket(ring, numPushed++);
+                }
+                TEST(ring.size() == 4);
+                for (int j = 0; j < 3; ++j) {
+                    popPacket(ring, numPopped++);
+                }
+                TEST(ring.size() == 1);
+            }
+            // Growing a full ring keeps the order of the packets.
+            while (!ring.full()) {
+                pushPacket(ring, numPushed++);
+            }
+            ring.grow();
+            TEST(ring.size() == 4);
+            TEST(!ring.full());
+            while (!ring.full()) {
+                pushPacket(ring, numPushed++);
+            }
+            TEST(ring.size() == 8);
+            while (!ring.empty()) {
+                popPacket(ring, numPopped++);
+            }
+            TEST(numPopped == numPushed);
+            // Slots that still contain data from before clear() are reused.
+            pushPacket(ring, numPushed++);
+            ring.clear();
+            TEST(ring.empty());
+            pushPacket(ring, numPushed);
+            popPacket(ring, numPushed);
+            ring.freePackets();
+        }
+
+        void pushPacket(FFMpegDemuxer::PacketRing& ring, int i)
+        {
+            AVPacket packet;
+            av_init_packet(&packet);
+            av_new_packet(&packet, 16);
+            packet.pts = i;
+            packet.data[0] = (unsigned char)i;
+            ring.push(&packet);
+            // The ring has taken over the packet data.
+            TEST(packet.data == 0);
+        }
+
+        void popPacket(FFMpegDemuxer::PacketRing& ring, int i)
+        {
+            AVPacket packet;
+            ring.pop(&packet);
+            TEST(packet.pts == i);
+            TEST(packet.data[0] == (unsigned char)i);
+            av_free_packet(&packet);
+        }
+
+        void testCacheFull()
+        {
+            // If nobody fetches the packets of one stream, the demuxer must stop reading
+            // once that stream's cache is full, and read on once the packets have been
+            // fetched.
+            cerr << "    Testing demuxer backpressure" << endl;
+            string sFilename = getSrcDirName()+"../test/media/mpeg1-48x48-sound.avi";
+            AVFormatContext* pFormatContext = 0;
+            int err = avformat_open_input(&pFormatContext, sFilename.c_str(), 0, 0);
+            TEST(err >= 0);
+            if (err < 0) {
+                return;
+            }
+            avformat_find_stream_info(pFormatContext, 0);
+            int videoIndex = -1;
+            int audioIndex = -1;
+            for (unsigned i = 0; i < pFormatContext->nb_streams; i++) {
+                switch (pFormatContext->streams[i]->codec->codec_type) {
+                    case AVMEDIA_TYPE_VIDEO:
+                        videoIndex = i;
+                        break;
+                    case AVMEDIA_TYPE_AUDIO:
+                        audioIndex = i;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            TEST(videoIndex != -1 && audioIndex != -1);
+            vector<int> streamIndexes;
+            streamIndexes.push_back(videoIndex);
+            streamIndexes.push_back(audioIndex);
+            {
+                FFMpegDemuxer demuxer(pFormatContext, streamIndexes, 4);
+                bool bCacheFull = false;
+                int numVideoPackets = 0;
+                AVPacket* pPacket = demuxer.getPacket(videoIndex, &bCacheFull);
+                while (pPacket) {
+                    numVideoPackets++;
+                    PacketPool::get()->release(pPacket);
+                    pPacket = demuxer.getPacket(videoIndex, &bCacheFull);
+                }
+                // Stalled before the end of the file.
+                TEST(bCacheFull);
+                TEST(numVideoPackets > 0);
+                TEST(demuxer.isCacheFull());
+                TEST(demuxer.getNumCachedPackets(audioIndex) == 4);
+                TEST(demuxer.getNumCachedPackets(videoIndex) == 0);
+                TEST(demuxer.getPacket(videoIndex, &bCacheFull) == 0);
+                TEST(bCacheFull);
+
+                // Fetching the cached audio packets resumes demuxing.
+                for (int i = 0; i < 4; ++i) {
+                    pPacket = demuxer.getPacket(audioIndex, &bCacheFull);
+                    TEST(pPacket != 0);
+                    TEST(!bCacheFull);
+                    PacketPool::get()->release(pPacket);
+                }
+                TEST(!demuxer.isCacheFull());
+                pPacket = demuxer.getPacket(videoIndex, &bCacheFull);
+                TEST(pPacket != 0);
+                TEST(!bCacheFull);
+                PacketPool::get()->release(pPacket);
+
+                // Without backpressure, the cache grows instead.
+                pPacket = demuxer.getPacket(videoIndex);
+                while (pPacket) {
+                    PacketPool::get()->release(pPacket);
+                    pPacket = demuxer.getPacket(videoIndex);
+                }
+                TEST(demuxer.getNumCachedPackets(audioIndex) > 4);
+            }
+            avformat_close_input(&pFormatContext);
+        }
+};
+
+
 class VideoTestSuite: public TestSuite {
 public:
     VideoTestSuite() 
         : TestSuite("VideoTestSuite")
     {
+        addTest(TestPtr(new DemuxerTest()));
         addAudioTests();
         addVideoTests(false);
         
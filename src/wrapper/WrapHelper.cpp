@@ -25,6 +25,7 @@
 #include "../base/Exception.h"
 #include "../base/MathHelper.h"
 #include "../base/ObjectCounter.h"
+#include "../base/ThreadProfiler.h"
 
 #include "../player/PythonLogSink.h"
 #include "../player/PublisherDefinitionRegistry.h"
@@ -495,11 +496,14 @@ void export_base()
   
     from_python_sequence<vector<float> >();
     from_python_sequence<vector<int> >();
+    to_python_converter<vector<long long>, to_list<vector<long long> > >();
 
     to_python_converter<std::type_info, type_info_to_string>();
     //Maps
     to_python_converter<TypeMap, to_dict<TypeMap> >();
     to_python_converter<CatToSeverityMap, to_dict<CatToSeverityMap> >();
+    to_python_converter<ThreadProfiler::FrameTimeMap, 
+            to_dict<ThreadProfiler::FrameTimeMap> >();
 }
 
 namespace {
@@ -165,6 +165,17 @@ BOOST_PYTHON_MODULE(avg)
             .def("createNode", &Player::createNode, Player_createNode_overloads())
             .def("getTouchUserBmp", &Player::getTouchUserBmp)
             .def("enableMouse", &Player::enableMouse)
+            .def("enableMotionCoalescing", &Player::enableMotionCoalescing)
+            .def("startEventRecording", &Player::startEventRecording)
+            .def("stopEventRecording", &Player::stopEventRecording)
+            .def("startEventReplay", &Player::startEventReplay)
+            .def("isReplayingEvents", &Player::isReplayingEvents)
+            .def("enableFrameTimeHistory", &Player::enableFrameTimeHistory)
+            .def("getZoneFrameTimes", &Player::getZoneFrameTimes)
+            .def("enableTracing", &Player::enableTracing,
+                    (bp::arg("enable"), bp::arg("ringsize")=65536))
+            .def("writeTrace", &Player::writeTrace)
+            .def("setTraceFrameThreshold", &Player::setTraceFrameThreshold)
             .def("setInterval", &Player::setInterval)
             .def("setTimeout", &Player::setTimeout)
             .def("callFromThread", &Player::callFromThread)
@@ -205,6 +216,11 @@ BOOST_PYTHON_MODULE(avg)
             .def("getRootNode", &Canvas::getRootNode)
             .def("getElementByID", &Canvas::getElementByID)
             .def("screenshot", &Canvas::screenshot)
+            .def("requestScreenshot", &Canvas::requestScreenshot)
+            .def("getRequestedScreenshot", &Canvas::getRequestedScreenshot)
+            .def("getNumVertsWritten", &Canvas::getNumVertsWritten)
+            .def("getNumVertexBytesUploaded", &Canvas::getNumVertexBytesUploaded)
+            .def("getNumDrawCalls", &Canvas::getNumDrawCalls)
         ;
 
         class_<OffscreenCanvas, boost::shared_ptr<OffscreenCanvas>, bases<Canvas>,
@@ -219,6 +235,7 @@ BOOST_PYTHON_MODULE(avg)
             .add_property("autorender", &OffscreenCanvas::getAutoRender,
                     &OffscreenCanvas::setAutoRender)
             .def("getNumDependentCanvases", &OffscreenCanvas::getNumDependentCanvases)
+            .def("getNumRenders", &OffscreenCanvas::getNumRenders)
             .def("isSupported", &OffscreenCanvas::isSupported)
             .staticmethod("isSupported")
             .def("isMultisampleSupported", &OffscreenCanvas::isMultisampleSupported)
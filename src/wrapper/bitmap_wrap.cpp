@@ -184,6 +184,7 @@ BitmapPtr createBitmapWithRect(BitmapPtr pBmp,
 
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(loadBitmap_overloads, BitmapManager::loadBitmapPy, 
         2, 3);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(prefetch_overloads, BitmapManager::prefetch, 1, 2);
 
 static bp::object ImageCache_GetCapacity(ImageCache* pCache)
 {
@@ -280,6 +281,10 @@ void export_bitmap()
         .value("BAYER8_BGGR", BAYER8_BGGR)
         .value("R32G32B32A32F", R32G32B32A32F)
         .value("I32F", I32F)
+        .value("BC1", BC1)
+        .value("BC3", BC3)
+        .value("ETC2_RGB8", ETC2_RGB8)
+        .value("ETC2_RGBA8", ETC2_RGBA8)
         .export_values();
 
     def("getSupportedPixelFormats", &getSupportedPixelFormatsDeprecated);
@@ -321,6 +326,9 @@ void export_bitmap()
         .staticmethod("get")
         .def("loadBitmap", &BitmapManager::loadBitmapPy, loadBitmap_overloads())
         .def("setNumThreads", &BitmapManager::setNumThreads)
+        .def("prefetch", &BitmapManager::prefetch, prefetch_overloads())
+        .def("cancelPrefetch", &BitmapManager::cancelPrefetch)
+        .def("cancelAllPrefetches", &BitmapManager::cancelAllPrefetches)
     ;
 
     class_<CubicSpline, boost::noncopyable>("CubicSpline", no_init)
@@ -116,6 +116,8 @@ void export_event()
         .add_property("speed", make_function(&CursorEvent::getSpeed,
                 return_value_policy<copy_const_reference>()))
         .add_property("contact", &CursorEvent::getContact)
+        .add_property("history", make_function(&CursorEvent::getHistory,
+                return_value_policy<copy_const_reference>()))
     ;
 
     class_<KeyEvent, bases<Event> >("KeyEvent", no_init)
@@ -128,13 +128,20 @@ void export_misc()
         .def("fakeKeyEvent", &TestHelper::fakeKeyEvent)
         .def("dumpObjects", &TestHelper::dumpObjects)
         .def("getObjectCount", &TestHelper::getObjectCount)
+        .def("getNumTextLayoutHits", &TestHelper::getNumTextLayoutHits)
+        .def("getNumTextBitmapHits", &TestHelper::getNumTextBitmapHits)
     ;
 
     class_<VideoWriter, boost::shared_ptr<VideoWriter>, boost::noncopyable>
             ("VideoWriter", no_init)
-        .def(init<CanvasPtr, const std::string&, int, int, int, bool>())
-        .def(init<CanvasPtr, const std::string&, int, int, int>())
-        .def(init<CanvasPtr, const std::string&, int>())
+        .def(init<CanvasPtr, const std::string&, int, int, int, bool, 
+                const std::string&, const std::string&, const std::string&, int, int,
+                bool>(
+                (bp::arg("canvas"), bp::arg("filename"), bp::arg("framerate")=30,
+                 bp::arg("qmin")=3, bp::arg("qmax")=5, bp::arg("synctoplayback")=true,
+                 bp::arg("codec")="mjpeg", bp::arg("pixelformat")="",
+                 bp::arg("encoderoptions")="", bp::arg("numthreads")=0,
+                 bp::arg("queuelength")=8, bp::arg("dropframes")=false)))
         .def("stop", &VideoWriter::stop)
         .def("pause", &VideoWriter::pause)
         .def("play", &VideoWriter::play)
@@ -142,6 +149,16 @@ void export_misc()
         .add_property("framerate", &VideoWriter::getFramerate)
         .add_property("qmin", &VideoWriter::getQMin)
         .add_property("qmax", &VideoWriter::getQMax)
+        .add_property("codec", &VideoWriter::getCodec)
+        .add_property("pixelformat", &VideoWriter::getPixelFormat)
+        .add_property("encoderoptions", &VideoWriter::getEncoderOptions)
+        .add_property("numthreads", &VideoWriter::getNumThreads)
+        .add_property("queuelength", &VideoWriter::getQueueLength)
+        .add_property("dropframes", &VideoWriter::getDropFrames)
+        .add_property("droppedframes", &VideoWriter::getNumDroppedFrames)
+        .add_property("encodedframes", &VideoWriter::getNumEncodedFrames)
+        .add_property("encodelatency", &VideoWriter::getEncodeLatency)
+        .add_property("maxencodelatency", &VideoWriter::getMaxEncodeLatency)
     ;
 
     BitmapPtr (SVG::*renderElement1)(const UTF8String&) = &SVG::renderElement;
@@ -48,6 +48,8 @@ void export_raster2()
                 return_value_policy<copy_const_reference>()))
         .add_property("framerate", &CameraNode::getFrameRate)
         .add_property("framenum", &CameraNode::getFrameNum)
+        .add_property("droppedframes", &CameraNode::getNumDroppedFrames)
+        .add_property("capturelatency", &CameraNode::getCaptureLatency)
         .add_property("brightness", &CameraNode::getBrightness, 
                 &CameraNode::setBrightness)
         .add_property("sharpness", &CameraNode::getSharpness, &CameraNode::setSharpness)
@@ -138,6 +140,7 @@ void export_raster2()
         .staticmethod("getVideoAccelConfig")
         .add_property("fps", &VideoNode::getFPS)
         .add_property("queuelength", &VideoNode::getQueueLength)
+        .add_property("decoderthreads", &VideoNode::getNumDecoderThreads)
         .add_property("href", 
                 make_function(&VideoNode::getHRef,
                         return_value_policy<copy_const_reference>()),
@@ -145,6 +148,7 @@ void export_raster2()
         .add_property("loop", &VideoNode::getLoop)
         .add_property("volume", &VideoNode::getVolume, &VideoNode::setVolume)
         .add_property("threaded", &VideoNode::isThreaded)
+        .add_property("shareddecoder", &VideoNode::usesSharedDecoder)
         .add_property("accelerated", &VideoNode::isAccelerated)
         .add_property("duration", &VideoNode::getDuration)
     ;
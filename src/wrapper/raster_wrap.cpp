@@ -91,6 +91,7 @@ void export_raster()
                 &ImageNode::setHRef)
         .add_property("compression",
                 &ImageNode::getCompression)
+        .add_property("asyncload", &ImageNode::getAsyncLoad, &ImageNode::setAsyncLoad)
     ;
 
     class_<FontStyle, bases<ExportedObject> >("FontStyle", no_init)
@@ -163,6 +164,8 @@ void export_raster()
         .add_property("letterspacing", &WordsNode::getLetterSpacing, 
                 &WordsNode::setLetterSpacing)
         .add_property("hint", &WordsNode::getHint, &WordsNode::setHint)
+        .add_property("glyphatlas", &WordsNode::getGlyphAtlas, 
+                &WordsNode::setGlyphAtlas)
         .def("getGlyphPos", &WordsNode::getGlyphPos)
         .def("getGlyphSize", &WordsNode::getGlyphSize)
         .def("getNumLines", &WordsNode::getNumLines)
@@ -60,6 +60,8 @@ void export_vector()
                 make_function(&VectorNode::getBlendModeStr, 
                         return_value_policy<copy_const_reference>()),
                 &VectorNode::setBlendModeStr)
+        .add_property("asyncload", &VectorNode::getAsyncLoad, 
+                &VectorNode::setAsyncLoad)
         .def("setBitmap", &VectorNode::setBitmap)
     ;
 